@@ -0,0 +1,67 @@
+/**
+ * @file csrf_bench.c
+ * @brief Benchmarks for CSRF token generation/validation and hex coding.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/csrf/csrf.h"
+#include "/app/backend/lib/hex/hex.h"
+
+/** @brief Shared buffers for the hex benchmarks. */
+typedef struct {
+        unsigned char raw[CSRF_TOKEN_RAW_SIZE]; /**< Binary token */
+        char hex[CSRF_TOKEN_HEX_SIZE + 1];      /**< Encoded token */
+} hex_ctx_t;
+
+static void run_hex_encode(void* ctx) {
+        hex_ctx_t* h = ctx;
+        hex_encode(h->raw, sizeof(h->raw), h->hex);
+        bench_sink += (uintptr_t)h->hex[0];
+}
+
+static void run_hex_decode(void* ctx) {
+        hex_ctx_t* h = ctx;
+        bench_sink += hex_decode(h->hex, h->raw, sizeof(h->raw));
+}
+
+static void run_generate(void* ctx) {
+        (void)ctx;
+        char* token  = NULL;
+        result_t res = csrf_generate_token(&token);
+        bench_sink += (uintptr_t)res.code;
+        free(token);
+}
+
+static void run_validate(void* ctx) {
+        result_t res = csrf_validate_token((const char*)ctx);
+        bench_sink += (uintptr_t)res.code;
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        hex_ctx_t h;
+        for (size_t i = 0; i < sizeof(h.raw); ++i)
+                h.raw[i] = (unsigned char)(i * 37);
+        hex_encode(h.raw, sizeof(h.raw), h.hex);
+
+        bench_run("hex_encode_72", run_hex_encode, &h, 2000, 1000);
+        bench_run("hex_decode_72", run_hex_decode, &h, 2000, 100);
+
+        char* token  = NULL;
+        result_t res = csrf_generate_token(&token);
+        if (res.code != RESULT_SUCCESS) {
+                bench_skip("csrf_generate_token", "csrf secret unavailable");
+                bench_skip("csrf_validate_token", "csrf secret unavailable");
+                return 0;
+        }
+
+        bench_run("csrf_generate_token", run_generate, NULL, 1000, 20);
+        bench_run("csrf_validate_token", run_validate, token, 1000, 20);
+
+        free(token);
+        return 0;
+}
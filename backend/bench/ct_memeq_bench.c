@@ -0,0 +1,172 @@
+/**
+ * @file ct_memeq_bench.c
+ * @brief Microbenchmark and timing-leak check for ct_memeq().
+ *
+ * The benchmarks report ct_memeq() next to libc memcmp() at a few sizes.
+ * The leak check follows the dudect approach: it times ct_memeq() on two
+ * input classes (equal buffers vs. buffers differing in the first byte) in
+ * random interleaved order and runs Welch's t-test on the samples. A |t|
+ * above CT_LEAK_T_THRESHOLD means the running time depends on the data,
+ * and the program exits non-zero.
+ *
+ * Usage: ct_memeq_bench [filter]; CT_LEAK_SAMPLES overrides the number of
+ * leak-check samples.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/ct_memeq/ct_memeq.h"
+
+/** @brief Calls per timed sample, to rise well above clock resolution. */
+#define CT_BATCH 64
+
+/** @brief |t| beyond which the leak check fails (dudect uses 10). */
+#define CT_LEAK_T_THRESHOLD 10.0
+
+/** @brief Buffer size used by the leak check (an HMAC-SHA256 tag). */
+#define CT_LEAK_SIZE 32
+
+/** @brief Default number of leak-check samples. */
+#define CT_LEAK_SAMPLES 200000
+
+/** @brief Pair of equal buffers for the throughput benchmarks. */
+typedef struct {
+        unsigned char* a; /**< First buffer */
+        unsigned char* b; /**< Second buffer */
+        size_t size;      /**< Bytes in each buffer */
+} buffers_t;
+
+static void run_ct_memeq(void* ctx) {
+        buffers_t* bufs = ctx;
+        bench_sink += ct_memeq(bufs->a, bufs->b, bufs->size);
+}
+
+static void run_memcmp(void* ctx) {
+        buffers_t* bufs = ctx;
+        bench_sink += memcmp(bufs->a, bufs->b, bufs->size) == 0;
+}
+
+/**
+ * @brief Benchmark ct_memeq() and memcmp() on equal buffers of one size.
+ * @param size Buffer size in bytes.
+ */
+static void bench_size(size_t size) {
+        buffers_t bufs = {malloc(size), malloc(size), size};
+        if (!bufs.a || !bufs.b) {
+                free(bufs.a);
+                free(bufs.b);
+                return;
+        }
+        memset(bufs.a, 0x5a, size);
+        memset(bufs.b, 0x5a, size);
+
+        char name[32];
+        snprintf(name, sizeof(name), "ct_memeq_%zu", size);
+        bench_run(name, run_ct_memeq, &bufs, 1000, 1000);
+        snprintf(name, sizeof(name), "memcmp_%zu", size);
+        bench_run(name, run_memcmp, &bufs, 1000, 1000);
+
+        free(bufs.a);
+        free(bufs.b);
+}
+
+/**
+ * @struct welch_t
+ * @brief Running mean/variance (Welford) for one input class.
+ */
+typedef struct {
+        double n;    /**< Sample count */
+        double mean; /**< Running mean */
+        double m2;   /**< Sum of squared deviations */
+} welch_t;
+
+/**
+ * @brief Add a sample to a running accumulator.
+ * @param w Accumulator.
+ * @param x Sample value.
+ */
+static void welch_push(welch_t* w, double x) {
+        w->n += 1.0;
+        double delta = x - w->mean;
+        w->mean += delta / w->n;
+        w->m2 += delta * (x - w->mean);
+}
+
+/**
+ * @brief Welch's t statistic between two accumulators.
+ * @param a First class.
+ * @param b Second class.
+ * @return t value (0 when undefined).
+ */
+static double welch_t_value(const welch_t* a, const welch_t* b) {
+        if (a->n < 2 || b->n < 2) return 0.0;
+        double va = a->m2 / (a->n - 1.0);
+        double vb = b->m2 / (b->n - 1.0);
+        double se = sqrt(va / a->n + vb / b->n);
+        return se > 0.0 ? (a->mean - b->mean) / se : 0.0;
+}
+
+/**
+ * @brief Run the two-class timing test.
+ * @param samples Number of timed batches.
+ * @param use_memcmp Time libc memcmp() instead, as a positive control.
+ * @return Welch t statistic.
+ */
+static double leak_test(size_t samples, int use_memcmp) {
+        unsigned char secret[CT_LEAK_SIZE];
+        unsigned char equal[CT_LEAK_SIZE];
+        unsigned char differ[CT_LEAK_SIZE];
+        for (size_t i = 0; i < CT_LEAK_SIZE; ++i)
+                secret[i] = (unsigned char)(rand() & 0xff);
+        memcpy(equal, secret, sizeof(equal));
+        memcpy(differ, secret, sizeof(differ));
+        differ[0] ^= 0x01;
+
+        welch_t classes[2] = {{0, 0, 0}, {0, 0, 0}};
+        for (size_t s = 0; s < samples; ++s) {
+                int cls                  = rand() & 1;
+                const unsigned char* cand = cls ? differ : equal;
+
+                uint64_t start = bench_now_ns();
+                for (int i = 0; i < CT_BATCH; ++i) {
+                        bench_sink += use_memcmp
+                                    ? memcmp(secret, cand, CT_LEAK_SIZE) == 0
+                                    : ct_memeq(secret, cand, CT_LEAK_SIZE);
+                }
+                welch_push(&classes[cls], (double)(bench_now_ns() - start));
+        }
+
+        return welch_t_value(&classes[0], &classes[1]);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+        srand((unsigned)bench_now_ns());
+
+        bench_size(32);
+        bench_size(256);
+        bench_size(4096);
+
+        if (argc > 1 && !strstr("ct_memeq_leak", argv[1])) return 0;
+
+        const char* env = getenv("CT_LEAK_SAMPLES");
+        size_t samples  = env ? strtoul(env, NULL, 10) : CT_LEAK_SAMPLES;
+        if (samples == 0) samples = CT_LEAK_SAMPLES;
+
+        double t_ct   = leak_test(samples, 0);
+        double t_libc = leak_test(samples, 1);
+        int leak      = fabs(t_ct) > CT_LEAK_T_THRESHOLD;
+
+        printf("{\"bench\":\"ct_memeq_leak\",\"samples\":%zu,\"t\":%.2f,"
+               "\"memcmp_t\":%.2f,\"threshold\":%.1f,\"leak\":%s}\n",
+               samples, t_ct, t_libc, CT_LEAK_T_THRESHOLD,
+               leak ? "true" : "false");
+        fflush(stdout);
+
+        return leak ? 1 : 0;
+}
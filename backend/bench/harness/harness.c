@@ -0,0 +1,284 @@
+/**
+ * @file harness.c
+ * @brief Timing, percentile and allocation-counting implementation.
+ */
+
+#define _GNU_SOURCE
+
+#include "harness.h"
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+volatile uintptr_t bench_sink;
+
+static const char* bench_filter = NULL;
+static double bench_scale       = 1.0;
+
+/* Records go to a private copy of stdout so benchmarks may redirect fd 1. */
+static FILE* bench_out = NULL;
+
+/* Reason given by bench_fail() during the current bench_run(). */
+static const char* bench_failure = NULL;
+
+/* Allocation counters, only advanced while a timed batch runs. */
+static bool counting     = false;
+static uint64_t n_allocs = 0;
+static uint64_t n_bytes  = 0;
+
+static void* (*real_malloc)(size_t)         = NULL;
+static void* (*real_calloc)(size_t, size_t) = NULL;
+static void* (*real_realloc)(void*, size_t) = NULL;
+static void (*real_free)(void*)             = NULL;
+
+/*
+ * glibc's dlsym() may itself call calloc() before real_calloc is known;
+ * serve those few requests from a static block that free() ignores.
+ */
+static unsigned char bootstrap[4096] __attribute__((aligned(16)));
+static size_t bootstrap_used = 0;
+static bool resolving        = false;
+
+/**
+ * @brief Resolve the libc allocator entry points once.
+ */
+static void resolve_allocator(void) {
+        if (real_malloc || resolving) return;
+        resolving    = true;
+        real_malloc  = (void* (*)(size_t))dlsym(RTLD_NEXT, "malloc");
+        real_calloc  = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+        real_realloc = (void* (*)(void*, size_t))dlsym(RTLD_NEXT, "realloc");
+        real_free    = (void (*)(void*))dlsym(RTLD_NEXT, "free");
+        resolving    = false;
+        if (!real_malloc || !real_calloc || !real_realloc || !real_free) {
+                fputs("bench: cannot resolve libc allocator\n", stderr);
+                abort();
+        }
+}
+
+/**
+ * @brief Allocate from the bootstrap block.
+ * @param size Requested size.
+ * @return Zeroed memory or NULL when exhausted.
+ */
+static void* bootstrap_alloc(size_t size) {
+        size = (size + 15) & ~(size_t)15;
+        if (bootstrap_used + size > sizeof(bootstrap)) return NULL;
+        void* p = bootstrap + bootstrap_used;
+        bootstrap_used += size;
+        return p;
+}
+
+/**
+ * @brief Whether a pointer came from the bootstrap block.
+ * @param p Pointer to test.
+ * @return true if @p p lies inside the block.
+ */
+static bool from_bootstrap(const void* p) {
+        const unsigned char* c = (const unsigned char*)p;
+        return c >= bootstrap && c < bootstrap + sizeof(bootstrap);
+}
+
+/**
+ * @brief Record one allocation.
+ * @param size Bytes requested.
+ */
+static void note_alloc(size_t size) {
+        if (!counting) return;
+        n_allocs++;
+        n_bytes += size;
+}
+
+void* malloc(size_t size) {
+        if (!real_malloc) {
+                if (resolving) return bootstrap_alloc(size);
+                resolve_allocator();
+        }
+        note_alloc(size);
+        return real_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+        if (!real_calloc) {
+                if (resolving) return bootstrap_alloc(n * size);
+                resolve_allocator();
+        }
+        note_alloc(n * size);
+        return real_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+        if (!real_realloc) resolve_allocator();
+        if (from_bootstrap(p)) {
+                /* Bootstrap sizes are not recorded; copy no further than
+                 * the end of the block, which bounds the old allocation. */
+                size_t room = (size_t)(bootstrap + sizeof(bootstrap) -
+                                       (const unsigned char*)p);
+                void* q     = malloc(size);
+                if (q) memcpy(q, p, size < room ? size : room);
+                return q;
+        }
+        note_alloc(size);
+        return real_realloc(p, size);
+}
+
+void free(void* p) {
+        if (!p || from_bootstrap(p)) return;
+        if (!real_free) resolve_allocator();
+        real_free(p);
+}
+
+/**
+ * @brief Parse the command line and environment.
+ * @param argc Argument count from main().
+ * @param argv Argument vector from main().
+ */
+void bench_init(int argc, char** argv) {
+        resolve_allocator();
+        if (argc > 1 && argv[1][0] != '\0') bench_filter = argv[1];
+
+        int fd    = dup(STDOUT_FILENO);
+        bench_out = fd >= 0 ? fdopen(fd, "w") : NULL;
+        if (!bench_out) bench_out = stdout;
+
+        const char* scale = getenv("BENCH_SCALE");
+        if (scale) {
+                double s = strtod(scale, NULL);
+                if (s > 0.0) bench_scale = s;
+        }
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ * @return Current time in ns.
+ */
+uint64_t bench_now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief qsort comparator for doubles.
+ * @param a First element.
+ * @param b Second element.
+ * @return Ordering.
+ */
+static int cmp_double(const void* a, const void* b) {
+        double x = *(const double*)a;
+        double y = *(const double*)b;
+        return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array.
+ * @param sorted Sorted samples.
+ * @param n Sample count (non-zero).
+ * @param pct Percentile in [0, 100].
+ * @return Sample at that rank.
+ */
+static double percentile(const double* sorted, size_t n, double pct) {
+        size_t rank = (size_t)(pct / 100.0 * (double)n + 0.5);
+        if (rank == 0) rank = 1;
+        if (rank > n) rank = n;
+        return sorted[rank - 1];
+}
+
+/**
+ * @brief Time @p fn and print its JSON record.
+ *
+ * Runs one untimed warm-up batch, then @p samples timed batches of
+ * @p batch calls each. Skipped when the name does not match the filter.
+ * If @p fn calls bench_fail(), timing stops at the end of that batch and
+ * a failed record is printed instead.
+ *
+ * @param name Benchmark name (a plain identifier, not escaped).
+ * @param fn Operation under test.
+ * @param ctx State passed to @p fn.
+ * @param samples Number of timed batches (scaled by BENCH_SCALE).
+ * @param batch Calls per batch.
+ * @return false if @p fn failed.
+ */
+bool bench_run(const char* name, bench_fn_t fn, void* ctx, size_t samples,
+               size_t batch) {
+        if (bench_filter && !strstr(name, bench_filter)) return true;
+
+        samples = (size_t)((double)samples * bench_scale);
+        if (samples == 0) samples = 1;
+        if (batch == 0) batch = 1;
+
+        double* per_op = malloc(samples * sizeof(double));
+        if (!per_op) {
+                bench_skip(name, "out of memory");
+                return true;
+        }
+
+        bench_failure = NULL;
+        for (size_t i = 0; i < batch; ++i) fn(ctx);
+
+        n_allocs       = 0;
+        n_bytes        = 0;
+        uint64_t total = 0;
+        for (size_t s = 0; s < samples && !bench_failure; ++s) {
+                counting       = true;
+                uint64_t start = bench_now_ns();
+                for (size_t i = 0; i < batch; ++i) fn(ctx);
+                uint64_t elapsed = bench_now_ns() - start;
+                counting         = false;
+
+                total += elapsed;
+                per_op[s] = (double)elapsed / (double)batch;
+        }
+
+        if (bench_failure) {
+                fprintf(bench_out,
+                        "{\"bench\":\"%s\",\"failed\":\"%s\"}\n", name,
+                        bench_failure);
+                fflush(bench_out);
+                free(per_op);
+                return false;
+        }
+
+        qsort(per_op, samples, sizeof(double), cmp_double);
+        double ops = (double)samples * (double)batch;
+
+        fprintf(bench_out,
+                "{\"bench\":\"%s\",\"ops\":%.0f,\"ns_per_op\":%.1f,"
+                "\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,"
+                "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+                name, ops, (double)total / ops,
+                percentile(per_op, samples, 50.0),
+                percentile(per_op, samples, 90.0),
+                percentile(per_op, samples, 99.0), (double)n_allocs / ops,
+                (double)n_bytes / ops);
+        fflush(bench_out);
+
+        free(per_op);
+        return true;
+}
+
+/**
+ * @brief Print a record for a benchmark that could not run.
+ * @param name Benchmark name.
+ * @param reason Short explanation (a plain string, not escaped).
+ */
+void bench_skip(const char* name, const char* reason) {
+        if (bench_filter && !strstr(name, bench_filter)) return;
+        fprintf(bench_out, "{\"bench\":\"%s\",\"skipped\":\"%s\"}\n", name,
+                reason);
+        fflush(bench_out);
+}
+
+/**
+ * @brief Mark the running benchmark as failed; called from the operation.
+ * @param reason Short explanation (a plain string, not escaped); the first
+ * one of a run is reported.
+ */
+void bench_fail(const char* reason) {
+        if (!bench_failure) bench_failure = reason;
+}
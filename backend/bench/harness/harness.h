@@ -0,0 +1,84 @@
+/**
+ * @file harness.h
+ * @brief Minimal microbenchmark harness shared by every bench/ program.
+ *
+ * A benchmark is a function run in timed batches. For each one the harness
+ * prints a JSON line to stdout with the mean ns/op, the p50/p90/p99 of the
+ * per-batch ns/op, and the number of heap allocations (and bytes) per op.
+ * Allocations are counted by interposing malloc/calloc/realloc, so calls
+ * made inside sqlite, json-c, OpenSSL and libsodium are included.
+ *
+ * Records are written to a private duplicate of the original stdout, so a
+ * benchmark may point fd 1 elsewhere (e.g. to /dev/null) without losing
+ * them.
+ *
+ * An operation that gets an error calls bench_fail(); its benchmark then
+ * prints a "failed" record instead of timings, so a broken setup (e.g. a
+ * schema that no longer matches the DAL) cannot pass for a fast result.
+ *
+ * Every bench program accepts an optional substring filter as argv[1];
+ * BENCH_SCALE (a float, default 1) scales the number of samples.
+ */
+
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Operation under test.
+ * @param ctx Benchmark-specific state.
+ */
+typedef void (*bench_fn_t)(void* ctx);
+
+/** @brief Sink for results the compiler must not optimize away. */
+extern volatile uintptr_t bench_sink;
+
+/**
+ * @brief Parse the command line and environment.
+ * @param argc Argument count from main().
+ * @param argv Argument vector from main().
+ */
+void bench_init(int argc, char** argv);
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ * @return Current time in ns.
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * @brief Time @p fn and print its JSON record.
+ *
+ * Runs one untimed warm-up batch, then @p samples timed batches of
+ * @p batch calls each. Skipped when the name does not match the filter.
+ * If @p fn calls bench_fail(), timing stops at the end of that batch and
+ * a failed record is printed instead.
+ *
+ * @param name Benchmark name (a plain identifier, not escaped).
+ * @param fn Operation under test.
+ * @param ctx State passed to @p fn.
+ * @param samples Number of timed batches (scaled by BENCH_SCALE).
+ * @param batch Calls per batch.
+ * @return false if @p fn failed.
+ */
+bool bench_run(const char* name, bench_fn_t fn, void* ctx, size_t samples,
+               size_t batch);
+
+/**
+ * @brief Print a record for a benchmark that could not run.
+ * @param name Benchmark name.
+ * @param reason Short explanation (a plain string, not escaped).
+ */
+void bench_skip(const char* name, const char* reason);
+
+/**
+ * @brief Mark the running benchmark as failed; called from the operation.
+ * @param reason Short explanation (a plain string, not escaped); the first
+ * one of a run is reported.
+ */
+void bench_fail(const char* reason);
+
+#endif// BENCH_HARNESS_H_
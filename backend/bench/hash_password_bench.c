@@ -0,0 +1,67 @@
+/**
+ * @file hash_password_bench.c
+ * @brief Benchmarks for password hashing at each Argon2id cost profile.
+ *
+ * These are slow by design (tens of ms to seconds per op), so sample counts
+ * are tiny; use BENCH_SCALE to trade time for tighter percentiles.
+ */
+
+#include <stdlib.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/hash_password/hash_password.h"
+
+static void run_hash(void* ctx) {
+        hash_password_profile_t profile = *(hash_password_profile_t*)ctx;
+        char* hash                      = NULL;
+        result_t res =
+            hash_password_with_profile("hunter22", profile, &hash, NULL);
+        bench_sink += (uintptr_t)res.code;
+        free(hash);
+}
+
+static void run_verify(void* ctx) {
+        result_t res = verify_password("hunter22", (const char*)ctx);
+        bench_sink += (uintptr_t)res.code;
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        static const struct {
+                const char* name;
+                const char* verify_name;
+                hash_password_profile_t profile;
+                size_t samples;
+        } profiles[] = {
+            {"hash_password_interactive", "verify_password_interactive",
+             HASH_PROFILE_INTERACTIVE, 20},
+            {"hash_password_moderate", "verify_password_moderate",
+             HASH_PROFILE_MODERATE, 5},
+            {"hash_password_sensitive", "verify_password_sensitive",
+             HASH_PROFILE_SENSITIVE, 2},
+        };
+
+        for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); ++i) {
+                hash_password_profile_t profile = profiles[i].profile;
+
+                /* A profile the host cannot afford (e.g. 1 GiB for
+                 * SENSITIVE) fails fast and would report bogus timings. */
+                char* hash = NULL;
+                result_t res =
+                    hash_password_with_profile("hunter22", profile, &hash,
+                                               NULL);
+                if (res.code != RESULT_SUCCESS) {
+                        bench_skip(profiles[i].name, "hashing failed");
+                        bench_skip(profiles[i].verify_name, "hashing failed");
+                        continue;
+                }
+
+                bench_run(profiles[i].name, run_hash, &profile,
+                          profiles[i].samples, 1);
+                bench_run(profiles[i].verify_name, run_verify, hash,
+                          profiles[i].samples, 1);
+                free(hash);
+        }
+        return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file jwt_bench.c
+ * @brief Benchmarks for issuing and validating JWTs.
+ */
+
+#include <json-c/json.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/jwt/jwt.h"
+#include "/app/backend/lib/revoke/revoke.h"
+
+/** @brief Private revocation segment, so the live one is never touched. */
+#define BENCH_REVOKE_FILE "/tmp/sfe_revoke_bench"
+
+static void run_issue(void* ctx) {
+        (void)ctx;
+        char* token  = NULL;
+        result_t res = issue_jwt("42", 0, &token);
+        bench_sink += (uintptr_t)res.code;
+        free(token);
+}
+
+static void run_validate(void* ctx) {
+        struct json_object* claims = NULL;
+        result_t res               = val_jwt((const char*)ctx, &claims);
+        bench_sink += (uintptr_t)res.code;
+        if (claims) json_object_put(claims);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        /* val_jwt() is measured with its revocation check. */
+        setenv("SFE_REVOKE_FILE", BENCH_REVOKE_FILE, 1);
+        revoke_mark_loaded();
+
+        char* token  = NULL;
+        result_t res = issue_jwt("42", 0, &token);
+        if (res.code != RESULT_SUCCESS) {
+                bench_skip("issue_jwt", "jwt secret unavailable");
+                bench_skip("val_jwt", "jwt secret unavailable");
+                unlink(BENCH_REVOKE_FILE);
+                return 0;
+        }
+
+        bench_run("issue_jwt", run_issue, NULL, 1000, 10);
+        bench_run("val_jwt", run_validate, token, 1000, 10);
+
+        free(token);
+        unlink(BENCH_REVOKE_FILE);
+        return 0;
+}
@@ -0,0 +1,563 @@
+/**
+ * @file post_bench.c
+ * @brief Benchmarks for thread and post listing on a large synthetic
+ * database.
+ *
+ * The database lives in a fresh mkdtemp() directory, uses the threads and
+ * posts schema from sqlite_entrypoint.sh and is seeded with BENCH_POSTS
+ * posts (2 million by default; the BENCH_POSTS environment variable
+ * overrides it). Half of them go to one hot thread, the rest are spread
+ * over BENCH_THREADS threads.
+ *
+ * post_list_page_1, _page_5000 and _last_page should cost the same; the
+ * post_offset_page_5000 record runs the equivalent LIMIT/OFFSET query for
+ * comparison. Likewise thread_post_count_counter reads the hot thread's
+ * materialized post count and thread_post_count_scan counts its rows.
+ *
+ * One more thread holds BENCH_TREE_POSTS nested replies. post_subtree reads
+ * the first page of a subtree off the materialized path; post_subtree_cte
+ * gets the same page with a recursive CTE over parent_id.
+ */
+
+#include <sqlite3.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/dal/post/post.h"
+#include "/app/backend/lib/dal/stats/stats.h"
+#include "/app/backend/lib/dal/thread/thread.h"
+
+/** @brief Posts seeded when BENCH_POSTS is unset. */
+#define BENCH_POSTS 2000000
+
+/** @brief Threads seeded; thread 1 is the hot one. */
+#define BENCH_THREADS 1000
+
+/** @brief Page size used by every listing benchmark. */
+#define BENCH_PAGE 20
+
+/** @brief Deep page used to show that depth does not matter. */
+#define BENCH_DEEP_PAGE 5000
+
+/** @brief Size of the stack block backing the per-op arena. */
+#define BENCH_ARENA_SIZE 16384
+
+/** @brief Replies in the nested thread. */
+#define BENCH_TREE_POSTS 20000
+
+/** @brief Top-level posts of the nested thread. */
+#define BENCH_TREE_ROOTS 20
+
+/** @brief Creation time of the first seeded row. */
+#define BENCH_EPOCH 1700000000
+
+/** @brief Shared benchmark state. */
+typedef struct {
+        sqlite3* db;          /**< Open connection */
+        sqlite3_stmt* offset; /**< LIMIT/OFFSET comparison query */
+        sqlite3_stmt* count;  /**< COUNT(*) comparison query */
+        sqlite3_stmt* cte;    /**< Recursive CTE comparison query */
+        int tree_thread;      /**< Thread holding the nested replies */
+        int tree_root;        /**< First top-level post of that thread */
+        db_cursor_t deep;     /**< Cursor before page BENCH_DEEP_PAGE */
+        db_cursor_t last;     /**< Cursor before the hot thread's end */
+        db_cursor_t old;      /**< Cursor near the oldest threads */
+        long hot_posts;       /**< Posts in thread 1 */
+        unsigned int next;    /**< Counter for inserts */
+} post_ctx_t;
+
+/**
+ * @brief Create the threads, posts and counter tables (mirrors
+ * sqlite_entrypoint.sh).
+ * @param db Open connection.
+ * @return SQLITE_OK on success.
+ */
+static int create_schema(sqlite3* db) {
+        return sqlite3_exec(
+            db,
+            "CREATE TABLE IF NOT EXISTS threads ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "user_id INTEGER NOT NULL,"
+            "title TEXT NOT NULL,"
+            "created_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')),"
+            "post_count INTEGER NOT NULL DEFAULT 0);"
+            "CREATE INDEX IF NOT EXISTS threads_created "
+            "ON threads (created_at, id);"
+            "CREATE TABLE IF NOT EXISTS posts ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "thread_id INTEGER NOT NULL,"
+            "user_id INTEGER NOT NULL,"
+            "body TEXT NOT NULL,"
+            "created_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')),"
+            "parent_id INTEGER,"
+            "depth INTEGER NOT NULL DEFAULT 0,"
+            "path TEXT NOT NULL DEFAULT '',"
+            "body_html TEXT NOT NULL DEFAULT '',"
+            "render_version INTEGER NOT NULL DEFAULT 0);"
+            "CREATE INDEX IF NOT EXISTS posts_thread_created "
+            "ON posts (thread_id, created_at, id);"
+            "CREATE TABLE IF NOT EXISTS user_stats ("
+            "user_id INTEGER PRIMARY KEY,"
+            "thread_count INTEGER NOT NULL DEFAULT 0,"
+            "post_count INTEGER NOT NULL DEFAULT 0);"
+            "CREATE TABLE IF NOT EXISTS forum_stats ("
+            "id INTEGER PRIMARY KEY CHECK (id = 1),"
+            "thread_count INTEGER NOT NULL DEFAULT 0,"
+            "post_count INTEGER NOT NULL DEFAULT 0);",
+            NULL, NULL, NULL);
+}
+
+/**
+ * @brief Fill the counters, reply paths and full-text index of the seeded
+ * rows, then add the indexes and triggers that keep them (mirrors
+ * sqlite_entrypoint.sh) so post_insert pays for them.
+ *
+ * Left out are the triggers that only fire when posts are updated or
+ * deleted or threads are written, which no timed operation does.
+ *
+ * @param db Open connection.
+ * @return SQLITE_OK on success.
+ */
+static int add_derived(sqlite3* db) {
+        return sqlite3_exec(
+            db,
+            "UPDATE posts SET path = printf('%08x', id);"
+            "CREATE INDEX posts_thread_path ON posts (thread_id, path, depth);"
+            "CREATE TRIGGER posts_path AFTER INSERT ON posts BEGIN "
+            "UPDATE posts SET path = COALESCE((SELECT path FROM posts "
+            "WHERE id = new.parent_id), '') || printf('%08x', new.id) "
+            "WHERE id = new.id;"
+            "END;"
+            "UPDATE threads SET post_count = (SELECT COUNT(*) FROM posts p "
+            "WHERE p.thread_id = threads.id);"
+            "INSERT INTO user_stats (user_id, post_count) "
+            "SELECT user_id, COUNT(*) FROM posts GROUP BY user_id;"
+            "INSERT INTO forum_stats (id, thread_count, post_count) VALUES "
+            "(1, (SELECT COUNT(*) FROM threads), (SELECT COUNT(*) FROM "
+            "posts));"
+            "CREATE TRIGGER posts_count_insert AFTER INSERT ON posts BEGIN "
+            "UPDATE threads SET post_count = post_count + 1 "
+            "WHERE id = new.thread_id;"
+            "INSERT INTO user_stats (user_id, post_count) "
+            "VALUES (new.user_id, 1) ON CONFLICT (user_id) "
+            "DO UPDATE SET post_count = post_count + 1;"
+            "UPDATE forum_stats SET post_count = post_count + 1 WHERE id = 1;"
+            "END;"
+            "CREATE INDEX posts_render_version ON posts (render_version);"
+            "CREATE VIRTUAL TABLE posts_fts USING fts5 (body,"
+            "content = 'posts', content_rowid = 'id',"
+            "tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3');"
+            "INSERT INTO posts_fts (posts_fts) VALUES ('rebuild');"
+            "INSERT INTO posts_fts (posts_fts, rank) VALUES ('automerge', 0);"
+            "INSERT INTO posts_fts (posts_fts, rank) "
+            "VALUES ('crisismerge', 64);"
+            "CREATE TRIGGER posts_fts_insert AFTER INSERT ON posts BEGIN "
+            "INSERT INTO posts_fts (rowid, body) VALUES (new.id, new.body);"
+            "END;"
+            "CREATE TRIGGER posts_fts_delete AFTER DELETE ON posts BEGIN "
+            "INSERT INTO posts_fts (posts_fts, rowid, body) "
+            "VALUES ('delete', old.id, old.body);"
+            "END;"
+            "CREATE TRIGGER posts_fts_update AFTER UPDATE OF body ON posts "
+            "BEGIN "
+            "INSERT INTO posts_fts (posts_fts, rowid, body) "
+            "VALUES ('delete', old.id, old.body);"
+            "INSERT INTO posts_fts (rowid, body) VALUES (new.id, new.body);"
+            "END;",
+            NULL, NULL, NULL);
+}
+
+/**
+ * @brief Fill the database with threads and posts.
+ *
+ * Rows go in through one prepared statement in a single transaction with
+ * journaling off; the DAL is only timed, not used to seed.
+ *
+ * @param db Open connection.
+ * @param posts Number of posts.
+ * @return SQLITE_OK on success.
+ */
+static int seed(sqlite3* db, long posts) {
+        sqlite3_exec(db,
+                     "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;"
+                     "BEGIN;",
+                     NULL, NULL, NULL);
+
+        sqlite3_stmt* stmt = NULL;
+        int rc             = sqlite3_prepare_v2(db,
+                                                "INSERT INTO threads (user_id, "
+                                                "title, created_at) VALUES "
+                                                "(?, ?, ?);",
+                                                -1, &stmt, NULL);
+        for (int t = 1; rc == SQLITE_OK && t <= BENCH_THREADS; ++t) {
+                char title[32];
+                snprintf(title, sizeof(title), "Thread %d", t);
+                sqlite3_bind_int(stmt, 1, t);
+                sqlite3_bind_text(stmt, 2, title, -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(stmt, 3, BENCH_EPOCH + t / 4);
+                if (sqlite3_step(stmt) != SQLITE_DONE) rc = SQLITE_ERROR;
+                sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        if (rc == SQLITE_OK)
+                rc = sqlite3_prepare_v2(
+                    db,
+                    "INSERT INTO posts (thread_id, user_id, body, created_at) "
+                    "VALUES (?, ?, ?, ?);",
+                    -1, &stmt, NULL);
+        for (long i = 0; rc == SQLITE_OK && i < posts; ++i) {
+                /* Even posts go to the hot thread; ten posts per second so
+                 * created_at has ties the cursor must break by id. */
+                int thread =
+                    i % 2 == 0 ? 1 : 2 + (int)(i % (BENCH_THREADS - 1));
+                char body[96];
+                snprintf(body, sizeof(body),
+                         "Post %ld. Lorem ipsum dolor sit amet, consectetur "
+                         "adipiscing elit.",
+                         i);
+                sqlite3_bind_int(stmt, 1, thread);
+                sqlite3_bind_int(stmt, 2, (int)(i % 997) + 1);
+                sqlite3_bind_text(stmt, 3, body, -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(stmt, 4, BENCH_EPOCH + i / 10);
+                if (sqlite3_step(stmt) != SQLITE_DONE) rc = SQLITE_ERROR;
+                sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        sqlite3_exec(db, rc == SQLITE_OK ? "COMMIT;" : "ROLLBACK;", NULL,
+                     NULL, NULL);
+        return rc;
+}
+
+/**
+ * @brief Add a thread of nested replies through the DAL.
+ *
+ * Each reply after the first BENCH_TREE_ROOTS answers a random earlier one,
+ * which gives a random recursive tree about ten levels deep. An index on
+ * parent_id, which the schema itself does not need, gives
+ * post_subtree_cte its best case.
+ *
+ * @param c Benchmark state; tree_thread and tree_root are set.
+ * @return SQLITE_OK on success.
+ */
+static int seed_tree(post_ctx_t* c) {
+        int* ids = malloc(sizeof(int) * BENCH_TREE_POSTS);
+        if (!ids) return SQLITE_NOMEM;
+
+        int rc = sqlite3_exec(c->db,
+                              "CREATE INDEX posts_parent ON posts (parent_id);"
+                              "BEGIN;",
+                              NULL, NULL, NULL);
+        thread_t thread = {.id = -1, .user_id = 1, .title = "Nested"};
+        thread_t* t     = NULL;
+        if (rc == SQLITE_OK &&
+            thread_insert(c->db, &thread, &t, NULL).code != RESULT_SUCCESS)
+                rc = SQLITE_ERROR;
+        if (t) c->tree_thread = t->id;
+        thread_free(t);
+
+        uint32_t seed = 12345;
+        for (int i = 0; rc == SQLITE_OK && i < BENCH_TREE_POSTS; ++i) {
+                seed        = seed * 1103515245u + 12345u;
+                post_t post = {
+                    .id        = -1,
+                    .thread_id = c->tree_thread,
+                    .user_id   = 1 + i % 997,
+                    .body      = "Nested reply. Lorem ipsum dolor sit amet.",
+                    .parent_id = i < BENCH_TREE_ROOTS
+                                     ? 0
+                                     : ids[(seed >> 8) % (uint32_t)i],
+                };
+                post_t* inserted = NULL;
+                if (post_insert(c->db, &post, &inserted, NULL).code !=
+                    RESULT_SUCCESS) {
+                        rc = SQLITE_ERROR;
+                        break;
+                }
+                ids[i] = inserted->id;
+                post_free(inserted);
+        }
+        c->tree_root = ids[0];
+        free(ids);
+
+        sqlite3_exec(c->db, rc == SQLITE_OK ? "COMMIT;" : "ROLLBACK;", NULL,
+                     NULL, NULL);
+        return rc;
+}
+
+/**
+ * @brief Sort key of the n-th row (0-based) of an ordered query.
+ * @param db Open connection.
+ * @param sql Query returning created_at, id with one OFFSET parameter.
+ * @param n Row index.
+ * @param out Cursor to fill.
+ */
+static void cursor_at(sqlite3* db, const char* sql, long n,
+                      db_cursor_t* out) {
+        sqlite3_stmt* stmt = NULL;
+        *out               = (db_cursor_t){0};
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return;
+        sqlite3_bind_int64(stmt, 1, n);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+                out->created_at = sqlite3_column_int64(stmt, 0);
+                out->id         = sqlite3_column_int64(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+}
+
+/**
+ * @brief List one page of the hot thread.
+ * @param c Benchmark state.
+ * @param after Cursor, NULL for the first page.
+ */
+static void list_hot(post_ctx_t* c, const db_cursor_t* after) {
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        post_page_t page;
+        result_t res =
+            post_list_by_thread(c->db, 1, after, BENCH_PAGE, &page, &arena);
+        if (res.code != RESULT_SUCCESS)
+                bench_fail("post_list_by_thread failed");
+        bench_sink += (uintptr_t)res.code + page.count;
+        arena_destroy(&arena);
+}
+
+static void run_post_list_first(void* ctx) {
+        list_hot(ctx, NULL);
+}
+
+static void run_post_list_deep(void* ctx) {
+        post_ctx_t* c = ctx;
+        list_hot(c, &c->deep);
+}
+
+static void run_post_list_last(void* ctx) {
+        post_ctx_t* c = ctx;
+        list_hot(c, &c->last);
+}
+
+static void run_post_offset_deep(void* ctx) {
+        post_ctx_t* c = ctx;
+        sqlite3_reset(c->offset);
+        int rc;
+        while ((rc = sqlite3_step(c->offset)) == SQLITE_ROW)
+                bench_sink += (uintptr_t)sqlite3_column_int(c->offset, 0);
+        if (rc != SQLITE_DONE) bench_fail("OFFSET query failed");
+}
+
+/**
+ * @brief List one page of threads.
+ * @param c Benchmark state.
+ * @param before Cursor, NULL for the first page.
+ */
+static void list_threads(post_ctx_t* c, const db_cursor_t* before) {
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        thread_page_t page;
+        result_t res = thread_list(c->db, before, BENCH_PAGE, &page, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("thread_list failed");
+        bench_sink += (uintptr_t)res.code + page.count;
+        arena_destroy(&arena);
+}
+
+static void run_thread_list_first(void* ctx) {
+        list_threads(ctx, NULL);
+}
+
+static void run_thread_list_old(void* ctx) {
+        post_ctx_t* c = ctx;
+        list_threads(c, &c->old);
+}
+
+static void run_thread_post_count_counter(void* ctx) {
+        post_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        thread_t* thread = NULL;
+        result_t res     = thread_fetch_by_id(c->db, 1, &thread, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("thread_fetch_by_id failed");
+        bench_sink += (uintptr_t)res.code + (thread ? thread->post_count : 0);
+        arena_destroy(&arena);
+}
+
+static void run_thread_post_count_scan(void* ctx) {
+        post_ctx_t* c = ctx;
+        sqlite3_reset(c->count);
+        if (sqlite3_step(c->count) == SQLITE_ROW)
+                bench_sink += (uintptr_t)sqlite3_column_int(c->count, 0);
+        else
+                bench_fail("COUNT(*) query failed");
+}
+
+static void run_post_tree_first(void* ctx) {
+        post_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        post_page_t page;
+        result_t res = post_list_tree(c->db, c->tree_thread, -1, NULL,
+                                      BENCH_PAGE, &page, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("post_list_tree failed");
+        bench_sink += (uintptr_t)res.code + page.count;
+        arena_destroy(&arena);
+}
+
+static void run_post_subtree(void* ctx) {
+        post_ctx_t* c = ctx;
+        post_page_t page;
+        result_t res = post_list_subtree(c->db, c->tree_root, -1, NULL,
+                                         DB_PAGE_MAX, &page, NULL);
+        if (res.code != RESULT_SUCCESS) bench_fail("post_list_subtree failed");
+        bench_sink += (uintptr_t)res.code + page.count;
+        post_page_free(&page);
+}
+
+static void run_post_subtree_cte(void* ctx) {
+        post_ctx_t* c = ctx;
+        sqlite3_reset(c->cte);
+        int rc;
+        while ((rc = sqlite3_step(c->cte)) == SQLITE_ROW)
+                bench_sink += (uintptr_t)sqlite3_column_int(c->cte, 0);
+        if (rc != SQLITE_DONE) bench_fail("recursive CTE failed");
+}
+
+static void run_user_counts(void* ctx) {
+        post_ctx_t* c = ctx;
+        stats_counts_t counts;
+        result_t res = stats_fetch_user(c->db, 1, &counts);
+        if (res.code != RESULT_SUCCESS) bench_fail("stats_fetch_user failed");
+        bench_sink += (uintptr_t)res.code + (uintptr_t)counts.post_count;
+}
+
+static void run_post_insert(void* ctx) {
+        post_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        char body[48];
+        snprintf(body, sizeof(body), "New post %u", c->next++);
+        post_t post = {
+            .id         = -1,
+            .thread_id  = 1 + (int)(c->next % BENCH_THREADS),
+            .user_id    = 1,
+            .body       = body,
+            .created_at = 0,
+        };
+        post_t* inserted = NULL;
+        result_t res     = post_insert(c->db, &post, &inserted, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("post_insert failed");
+        bench_sink += (uintptr_t)res.code;
+        arena_destroy(&arena);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        const char* env = getenv("BENCH_POSTS");
+        long posts      = env && *env ? atol(env) : BENCH_POSTS;
+        if (posts < 2L * BENCH_PAGE * (BENCH_DEEP_PAGE + 1))
+                posts = 2L * BENCH_PAGE * (BENCH_DEEP_PAGE + 1);
+
+        char dir[] = "/tmp/sfe-bench-XXXXXX";
+        if (!mkdtemp(dir)) {
+                bench_skip("post_dal", "mkdtemp failed");
+                return 1;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "%s/sfe.db", dir);
+
+        post_ctx_t c = {0};
+        if (sqlite3_open(path, &c.db) != SQLITE_OK ||
+            create_schema(c.db) != SQLITE_OK ||
+            seed(c.db, posts) != SQLITE_OK ||
+            add_derived(c.db) != SQLITE_OK || seed_tree(&c) != SQLITE_OK) {
+                bench_skip("post_dal", "cannot create database");
+                sqlite3_close(c.db);
+                unlink(path);
+                rmdir(dir);
+                return 1;
+        }
+        c.hot_posts = (posts + 1) / 2;
+
+        const char* hot_sql =
+            "SELECT created_at, id FROM posts WHERE thread_id = 1 "
+            "ORDER BY created_at, id LIMIT 1 OFFSET ?;";
+        cursor_at(c.db, hot_sql, (long)BENCH_PAGE * BENCH_DEEP_PAGE - 1,
+                  &c.deep);
+        cursor_at(c.db, hot_sql, c.hot_posts - BENCH_PAGE - 1, &c.last);
+        cursor_at(c.db,
+                  "SELECT created_at, id FROM threads "
+                  "ORDER BY created_at DESC, id DESC LIMIT 1 OFFSET ?;",
+                  BENCH_THREADS - BENCH_PAGE - 1, &c.old);
+
+        char offset_sql[256];
+        snprintf(offset_sql, sizeof(offset_sql),
+                 "SELECT id, thread_id, user_id, body, created_at FROM posts "
+                 "WHERE thread_id = 1 ORDER BY created_at, id "
+                 "LIMIT %d OFFSET %ld;",
+                 BENCH_PAGE + 1, (long)BENCH_PAGE * BENCH_DEEP_PAGE);
+        sqlite3_prepare_v2(c.db, offset_sql, -1, &c.offset, NULL);
+        sqlite3_prepare_v2(c.db,
+                           "SELECT COUNT(*) FROM posts WHERE thread_id = 1;",
+                           -1, &c.count, NULL);
+
+        char cte_sql[512];
+        snprintf(cte_sql, sizeof(cte_sql),
+                 "WITH RECURSIVE t (id, path) AS ("
+                 "SELECT id, printf('%%08x', id) FROM posts WHERE id = %d "
+                 "UNION ALL SELECT p.id, t.path || printf('%%08x', p.id) "
+                 "FROM posts p JOIN t ON p.parent_id = t.id) "
+                 "SELECT p.id, p.thread_id, p.user_id, p.body, p.created_at "
+                 "FROM t JOIN posts p ON p.id = t.id ORDER BY t.path "
+                 "LIMIT %d;",
+                 c.tree_root, DB_PAGE_MAX + 1);
+        sqlite3_prepare_v2(c.db, cte_sql, -1, &c.cte, NULL);
+
+        bool ok = bench_run("post_list_page_1", run_post_list_first, &c, 1000,
+                            20);
+        ok &= bench_run("post_list_page_5000", run_post_list_deep, &c, 1000,
+                        20);
+        ok &= bench_run("post_list_last_page", run_post_list_last, &c, 1000,
+                        20);
+        if (c.offset)
+                ok &= bench_run("post_offset_page_5000", run_post_offset_deep,
+                                &c, 50, 1);
+        ok &= bench_run("thread_list_page_1", run_thread_list_first, &c, 1000,
+                        20);
+        ok &= bench_run("thread_list_old_page", run_thread_list_old, &c, 1000,
+                        20);
+        ok &= bench_run("thread_post_count_counter",
+                        run_thread_post_count_counter, &c, 1000, 20);
+        if (c.count)
+                ok &= bench_run("thread_post_count_scan",
+                                run_thread_post_count_scan, &c, 50, 1);
+        ok &= bench_run("user_counts", run_user_counts, &c, 1000, 20);
+        ok &= bench_run("post_tree_page_1", run_post_tree_first, &c, 1000, 20);
+        ok &= bench_run("post_subtree", run_post_subtree, &c, 200, 5);
+        if (c.cte)
+                ok &= bench_run("post_subtree_cte", run_post_subtree_cte, &c,
+                                200, 1);
+        ok &= bench_run("post_insert", run_post_insert, &c, 50, 2);
+
+        sqlite3_finalize(c.offset);
+        sqlite3_finalize(c.count);
+        sqlite3_finalize(c.cte);
+        sqlite3_close(c.db);
+        unlink(path);
+        rmdir(dir);
+        return ok ? 0 : 1;
+}
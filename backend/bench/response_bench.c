@@ -0,0 +1,76 @@
+/**
+ * @file response_bench.c
+ * @brief Benchmarks for response building and serialization.
+ *
+ * response_send() writes to stdout, so fd 1 is pointed at /dev/null once the
+ * harness has taken its own copy for the JSON records.
+ */
+
+#include <fcntl.h>
+#include <json-c/json.h>
+#include <unistd.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/response/response.h"
+
+/** @brief Size of the stack block backing the per-op arena. */
+#define BENCH_ARENA_SIZE 8192
+
+static void fill_and_send(response_t* resp) {
+        response_append_str(resp, "User registered successfully.");
+        response_append_str(resp, "Quotes \"and\" slashes / get escaped.");
+        response_append_str(resp, "Third message");
+        response_send(resp);
+}
+
+static void run_heap(void* ctx) {
+        (void)ctx;
+        response_t resp = {0};
+        response_init(&resp, 200);
+        fill_and_send(&resp);
+        response_free(&resp);
+}
+
+static void run_arena(void* ctx) {
+        (void)ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        response_t resp;
+        response_init_arena(&resp, &arena, 200);
+        fill_and_send(&resp);
+        arena_destroy(&arena);
+}
+
+static void run_append_json(void* ctx) {
+        response_t resp = {0};
+        response_init(&resp, 200);
+        response_append_json(&resp, (struct json_object*)ctx);
+        response_send(&resp);
+        response_free(&resp);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        struct json_object* obj = json_object_new_object();
+        json_object_object_add(obj, "id", json_object_new_int(42));
+        json_object_object_add(obj, "username", json_object_new_string("bob"));
+
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull < 0 || dup2(devnull, STDOUT_FILENO) < 0) {
+                bench_skip("response_send", "cannot redirect stdout");
+                json_object_put(obj);
+                return 1;
+        }
+        close(devnull);
+
+        bench_run("response_send_heap", run_heap, NULL, 2000, 50);
+        bench_run("response_send_arena", run_arena, NULL, 2000, 50);
+        bench_run("response_append_json", run_append_json, obj, 2000, 50);
+
+        json_object_put(obj);
+        return 0;
+}
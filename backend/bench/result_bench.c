@@ -0,0 +1,52 @@
+/**
+ * @file result_bench.c
+ * @brief Benchmarks for building, annotating and serializing results.
+ */
+
+#include <json-c/json.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/result/result.h"
+
+static void run_success(void* ctx) {
+        (void)ctx;
+        result_t res = result_success();
+        bench_sink += (uintptr_t)res.code;
+}
+
+static void run_failure(void* ctx) {
+        (void)ctx;
+        result_t res = result_failure("bench failure", NULL, ERR_TEST_FAIL);
+        bench_sink += (uintptr_t)res.error;
+}
+
+static void run_failure_extra(void* ctx) {
+        (void)ctx;
+        result_t res = result_failure("bench failure", NULL, ERR_TEST_FAIL);
+        result_add_extra(&res, "user_id=%d, name=%s", 42, "alice");
+        bench_sink += (uintptr_t)res.extra_info[0];
+}
+
+static void run_to_json(void* ctx) {
+        (void)ctx;
+        result_t res = result_failure("bench failure", NULL, ERR_TEST_FAIL);
+        result_add_extra(&res, "user_id=%d", 42);
+        struct json_object* obj = result_to_json(&res);
+        bench_sink += (uintptr_t)obj;
+        json_object_put(obj);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        bench_run("result_success", run_success, NULL, 2000, 1000);
+        bench_run("result_failure", run_failure, NULL, 2000, 1000);
+
+        result_set_log_extra(false);
+        bench_run("result_add_extra_off", run_failure_extra, NULL, 2000, 1000);
+        result_set_log_extra(true);
+        bench_run("result_add_extra_on", run_failure_extra, NULL, 2000, 100);
+
+        bench_run("result_to_json", run_to_json, NULL, 2000, 20);
+        return 0;
+}
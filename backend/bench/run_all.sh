@@ -0,0 +1,13 @@
+#!/bin/sh
+# run_all.sh - Run every built benchmark and print one JSON record per line.
+#
+# Usage: bench/run_all.sh [filter]   (run from backend/ after `ninja bench`)
+
+set -u
+
+status=0
+for bin in bench/*_bench; do
+    [ -x "$bin" ] || continue
+    "$bin" "$@" || status=1
+done
+exit "$status"
@@ -0,0 +1,151 @@
+/**
+ * @file user_bench.c
+ * @brief Benchmarks for the user DAL against a throwaway database.
+ *
+ * The database lives in a fresh mkdtemp() directory, uses the same users
+ * schema as sqlite_entrypoint.sh and is pre-seeded with BENCH_USERS rows.
+ * Every operation must succeed: an error fails the benchmark rather than
+ * timing the error path.
+ */
+
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/bench/harness/harness.h"
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/dal/user/user.h"
+
+/** @brief Rows inserted before timing starts. */
+#define BENCH_USERS 10000
+
+/** @brief Size of the stack block backing the per-op arena. */
+#define BENCH_ARENA_SIZE 4096
+
+/** @brief Placeholder hash; the DAL never parses it. */
+#define BENCH_HASH "$argon2id$v=19$m=65536,t=2,p=1$c2FsdA$aGFzaA"
+
+/** @brief Shared benchmark state. */
+typedef struct {
+        sqlite3* db;       /**< Open connection */
+        unsigned int next; /**< Counter for ids, names and inserts */
+} user_ctx_t;
+
+/**
+ * @brief Create the users table (mirrors sqlite_entrypoint.sh).
+ * @param db Open connection.
+ * @return SQLITE_OK on success.
+ */
+static int create_schema(sqlite3* db) {
+        return sqlite3_exec(db,
+                            "CREATE TABLE IF NOT EXISTS users ("
+                            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                            "username TEXT NOT NULL UNIQUE,"
+                            "password_hash TEXT NOT NULL,"
+                            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+                            "token_generation INTEGER NOT NULL DEFAULT 0);"
+                            "CREATE INDEX IF NOT EXISTS users_username_nocase "
+                            "ON users (username COLLATE NOCASE);"
+                            "CREATE INDEX IF NOT EXISTS users_revoked "
+                            "ON users (token_generation) "
+                            "WHERE token_generation > 0;",
+                            NULL, NULL, NULL);
+}
+
+static void run_fetch_by_id(void* ctx) {
+        user_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        user_t* user = NULL;
+        int id       = (int)(c->next++ % BENCH_USERS) + 1;
+        result_t res = user_fetch_by_id(c->db, id, &user, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("user_fetch_by_id failed");
+        bench_sink += (uintptr_t)res.code;
+        arena_destroy(&arena);
+}
+
+static void run_fetch_by_username(void* ctx) {
+        user_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        char name[16];
+        snprintf(name, sizeof(name), "user%u", c->next++ % BENCH_USERS);
+        user_t* user = NULL;
+        result_t res = user_fetch_by_username(c->db, name, &user, &arena);
+        if (res.code != RESULT_SUCCESS)
+                bench_fail("user_fetch_by_username failed");
+        bench_sink += (uintptr_t)res.code;
+        arena_destroy(&arena);
+}
+
+static void run_insert(void* ctx) {
+        user_ctx_t* c = ctx;
+        unsigned char buf[BENCH_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, buf, sizeof(buf));
+
+        char name[16];
+        snprintf(name, sizeof(name), "new%u", c->next++);
+        user_t user = {
+            .id            = -1,
+            .username      = name,
+            .password_hash = BENCH_HASH,
+        };
+        user_t* inserted = NULL;
+        result_t res     = user_insert(c->db, &user, &inserted, &arena);
+        if (res.code != RESULT_SUCCESS) bench_fail("user_insert failed");
+        bench_sink += (uintptr_t)res.code;
+        arena_destroy(&arena);
+}
+
+int main(int argc, char** argv) {
+        bench_init(argc, argv);
+
+        char dir[] = "/tmp/sfe-bench-XXXXXX";
+        if (!mkdtemp(dir)) {
+                bench_skip("user_dal", "mkdtemp failed");
+                return 1;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "%s/sfe.db", dir);
+
+        user_ctx_t c = {.db = NULL, .next = 0};
+        if (sqlite3_open(path, &c.db) != SQLITE_OK ||
+            create_schema(c.db) != SQLITE_OK) {
+                bench_skip("user_dal", "cannot create database");
+                sqlite3_close(c.db);
+                rmdir(dir);
+                return 1;
+        }
+
+        sqlite3_exec(c.db, "BEGIN;", NULL, NULL, NULL);
+        for (unsigned int i = 0; i < BENCH_USERS; ++i) {
+                char name[16];
+                snprintf(name, sizeof(name), "user%u", i);
+                user_t user = {
+                    .id            = -1,
+                    .username      = name,
+                    .password_hash = BENCH_HASH,
+                };
+                user_t* inserted = NULL;
+                user_insert(c.db, &user, &inserted, NULL);
+                user_free(inserted);
+        }
+        sqlite3_exec(c.db, "COMMIT;", NULL, NULL, NULL);
+
+        bool ok = bench_run("user_fetch_by_id", run_fetch_by_id, &c, 1000, 20);
+        ok &= bench_run("user_fetch_by_username", run_fetch_by_username, &c,
+                        1000, 20);
+        ok &= bench_run("user_insert", run_insert, &c, 50, 2);
+
+        sqlite3_close(c.db);
+        unlink(path);
+        rmdir(dir);
+        return ok ? 0 : 1;
+}
@@ -5,13 +5,41 @@
 #include <string.h>
 
 #include "/app/backend/lib/result/result.h"
+#include "lib/admission/admission.h"
+#include "lib/arena/arena.h"
 #include "lib/read_post_data/read_post_data.h"
 #include "lib/response/response.h"
+#include "lib/timing/timing.h"
 
 #define DEBUG 0
 
+/** @brief Size of the stack block backing the request arena. */
+#define REQUEST_ARENA_SIZE 8192
+
 int main(void) {
+        timing_t timing;
+        timing_init(&timing, "csrf");
+
+        unsigned char arena_buf[REQUEST_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, arena_buf, sizeof(arena_buf));
+#if DEBUG
+        result_set_log_extra(true);
+#endif
+
         response_t resp;
+        response_init_arena(&resp, &arena, 200);
+        response_set_timing(&resp, &timing);
+
+        uint32_t retry_after = 0;
+        size_t span          = timing_begin(&timing, "queue");
+        bool admitted = admission_enter(ADMISSION_CHEAP, &retry_after);
+        timing_end(&timing, span);
+        if (!admitted) {
+                admission_send_503(&timing, retry_after);
+                return 0;
+        }
+
         const char* method = getenv("REQUEST_METHOD");
 
         if (!method) {
@@ -23,12 +51,14 @@ int main(void) {
         }
 
         if (strcmp(method, "GET") == 0) {
-                char* token   = NULL;
-                result_t* res = csrf_generate_token(&token);
-                if (res->code != RESULT_SUCCESS) {
+                char* token  = NULL;
+                size_t span  = timing_begin(&timing, "generate");
+                result_t res = csrf_generate_token(&token);
+                timing_end(&timing, span);
+                if (res.code != RESULT_SUCCESS) {
                         response_init(&resp, 500);
 #if DEBUG
-                        struct json_object* res_json = result_to_json(res);
+                        struct json_object* res_json = result_to_json(&res);
                         if (res_json) {
                                 response_append_json(&resp, res_json);
                                 json_object_put(res_json);
@@ -42,29 +72,27 @@ int main(void) {
 #endif
                         response_send(&resp);
                         response_free(&resp);
-                        result_free(res);
                         return 0;
                 }
 
                 response_init(&resp, 200);
                 response_append_str(&resp, token ? token : "");
                 free(token);
-                result_free(res);
                 response_send(&resp);
                 response_free(&resp);
                 return 0;
         }
 
         if (strcmp(method, "POST") == 0) {
-                char* body   = NULL;
-                result_t* rc = read_post_data(&body);
-                if (rc->code != RESULT_SUCCESS) {
-                        response_init(&resp, rc->data.error.code ==
-                                                     ERR_INVALID_CONTENT_LENGTH
-                                                 ? 400
-                                                 : 500);
+                char* body  = NULL;
+                size_t span = timing_begin(&timing, "read");
+                result_t rc = read_post_data(&body, &arena);
+                timing_end(&timing, span);
+                if (rc.code != RESULT_SUCCESS) {
 #if DEBUG
-                        struct json_object* json_err = result_to_json(rc);
+                        response_init(&resp,
+                                      result_error_info(&rc)->http_status);
+                        struct json_object* json_err = result_to_json(&rc);
                         if (json_err) {
                                 response_append_json(&resp, json_err);
                                 json_object_put(json_err);
@@ -73,22 +101,16 @@ int main(void) {
                                                     "Error reading POST data.");
                         }
 #else
-                        if (rc->data.error.code == ERR_INVALID_CONTENT_LENGTH) {
-                                response_append_str(
-                                    &resp, "Invalid Content Length for POST");
-                        } else {
-                                response_append_str(&resp,
-                                                    "Internal Server Error");
-                        }
+                        response_from_result(&resp, &rc);
 #endif
                         response_send(&resp);
                         response_free(&resp);
-                        result_free(rc);
                         return 0;
                 }
 
+                span                     = timing_begin(&timing, "parse");
                 struct json_object* jobj = json_tokener_parse(body);
-                free(body);
+                timing_end(&timing, span);
                 if (!jobj) {
                         response_init(&resp, 400);
                         response_append_str(&resp, "Malformed JSON.");
@@ -118,18 +140,21 @@ int main(void) {
                         return 0;
                 }
 
-                result_t* res = csrf_validate_token(token);
+                span         = timing_begin(&timing, "validate");
+                result_t res = csrf_validate_token(token);
+                timing_end(&timing, span);
                 json_object_put(jobj);
 
-                if (res->code == RESULT_SUCCESS) {
+                if (res.code == RESULT_SUCCESS) {
                         response_init(&resp, 200);
                         response_append_str(&resp, "CSRF token is valid.");
                         response_send(&resp);
                         response_free(&resp);
                 } else {
 #if DEBUG
-                        struct json_object* res_json = result_to_json(res);
-                        response_init(&resp, 400);
+                        struct json_object* res_json = result_to_json(&res);
+                        response_init(&resp,
+                                      result_error_info(&res)->http_status);
                         if (res_json) {
                                 response_append_json(&resp, res_json);
                                 json_object_put(res_json);
@@ -138,32 +163,12 @@ int main(void) {
                                                     "JSON conversion failed.");
                         }
 #else
-                        switch (res->data.error.code) {
-                                case ERR_TOKEN_LENGTH_MISMATCH:
-                                        response_init(&resp, 400);
-                                        response_append_str(
-                                            &resp, "Token Length Mismatch.");
-                                case ERR_NULL_TOKEN:
-                                case ERR_TOKEN_EXPIRED:
-                                case ERR_TOKEN_FUTURE_TIMESTAMP:
-                                case ERR_CSRF_SECRET_EMPTY:
-                                        response_init(&resp, 400);
-                                        response_append_str(
-                                            &resp, "Invalid csrf Token.");
-
-                                        break;
-                                default:
-                                        response_init(&resp, 500);
-                                        response_append_str(
-                                            &resp, "Internal Server Error");
-                                        break;
-                        }
+                        response_from_result(&resp, &res);
 #endif
                         response_send(&resp);
                         response_free(&resp);
                 }
 
-                result_free(res);
                 return 0;
         }
 
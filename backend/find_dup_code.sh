@@ -3,7 +3,7 @@
 code=$1
 
 if [ -n "$code" ]; then
-    grep -RE "#define\s+\w+\s+$code" .
+    grep -RnE "(#define\s+\w+\s+$code\b|X\(\w+, $code,)" .
 else
     echo "usage:
     ./find_dup_code.sh 1510"
@@ -1,20 +1,80 @@
 #!/bin/sh
 
+# Usage: generate_build.sh [dev|release]
+#
+#   dev      (default) one tcc-compiled executable per CGI; fast to build.
+#   release  one optimized multi-call binary, release/sfe, built with
+#            $RELEASE_CC (default gcc; clang works too) and $RELEASE_CFLAGS
+#            (default -O2); every <name>.cgi is a symlink to it (see
+#            multicall/multicall.c). SFE_STATIC=1 links it statically, which
+#            needs static archives of every library.
+
+mode="${1:-dev}"
+case "$mode" in
+  dev|release) ;;
+  *) echo "usage: $0 [dev|release]" >&2; exit 1 ;;
+esac
+
 output_file="build.ninja"
 
+libs="-lsqlite3 -ljson-c -lcrypto -ljwtc -lsanitizec -lsodium"
+
 cat > "$output_file" << 'EOF'
 # Autogenerated Ninja build file
 
+# rm first: a release build leaves the .cgi names as symlinks to release/sfe.
 rule compile
-  command = tcc -L./ $in -o $out -lsqlite3 -ljson-c -lcrypto -ljwtc -lsanitizec -lsodium
+  command = rm -f $out && tcc -L./ $in -o $out $libs
   description = Compiling $in to $out
 
+# Release build: objects, the multi-call link and the .cgi symlinks.
+rule compile_release
+  command = $${RELEASE_CC:-gcc} $${RELEASE_CFLAGS:--O2} $defines -c $in -o $out
+  description = Compiling $in (release)
+
+rule link_release
+  command = $${RELEASE_CC:-gcc} $${RELEASE_CFLAGS:--O2} $${SFE_STATIC:+-static} -L./ $in -o $out $libs
+  description = Linking $out
+
+rule symlink
+  command = ln -sf $target $out
+  description = Linking $out -> $target
+
+# Benchmarks default to tcc like the CGIs; set BENCH_CC=gcc to measure an
+# optimizing build.
+rule compile_bench
+  command = $${BENCH_CC:-tcc} -O2 -rdynamic -L./ $in -o $out -lsqlite3 -ljson-c -lcrypto -ljwtc -lsanitizec -lsodium -lm -ldl
+  description = Compiling benchmark $in to $out
+
+# Standalone developer tools (load generator, trace tools); not linked
+# against lib/.
+rule compile_tool
+  command = $${TOOLS_CC:-tcc} -O2 $in -o $out -lpthread -lm
+  description = Compiling tool $in to $out
+
+# LD_PRELOAD libraries (one per tools/<name>/ directory), e.g. allocprof.
+rule compile_preload
+  command = $${TOOLS_CC:-tcc} -O2 -shared -fPIC $in -o $out -ldl
+  description = Compiling preload library $out
+
 EOF
 
+printf "libs = %s\n\n" "$libs" >> "$output_file"
+
 cgi_sources=$(find . -maxdepth 1 -type f -name "*.c" ! -name "*_entrypoint.sh" | sort)
 
 lib_sources=$(find ./lib -type f -name "*.c" ! -name "test_*.c" | sort)
 
+bench_sources=$(find ./bench -maxdepth 1 -type f -name "*.c" 2>/dev/null | sort)
+
+tool_sources=$(find ./tools -maxdepth 1 -type f -name "*.c" 2>/dev/null | sort)
+
+preload_dirs=$(find ./tools -mindepth 1 -maxdepth 1 -type d 2>/dev/null | sort)
+
+maint_sources=$(find ./maint -maxdepth 1 -type f -name "*.c" 2>/dev/null | sort)
+
+harness_sources_list=$(printf "%s " $(find ./bench/harness -type f -name "*.c" 2>/dev/null | sort))
+
 if [ -z "$lib_sources" ]; then
   echo "# No library sources found in ./lib" >> "$output_file"
   lib_sources_list=""
@@ -22,11 +82,107 @@ else
   lib_sources_list=$(printf "%s " $lib_sources)
 fi
 
-for cgi_src in $cgi_sources; do
-  cgi_name=$(basename "$cgi_src" .c)
-  cgi_out="${cgi_name}.cgi"
+cgi_outputs=""
+if [ "$mode" = "dev" ]; then
+  for cgi_src in $cgi_sources; do
+    cgi_name=$(basename "$cgi_src" .c)
+    cgi_out="${cgi_name}.cgi"
+    cgi_outputs="$cgi_outputs $cgi_out"
+
+    {
+      printf "build %s: compile %s %s\n" "$cgi_out" "$cgi_src" "$lib_sources_list"
+    } >> "$output_file"
+  done
+else
+  # Each CGI's main() becomes sfe_applet_<name>() for multicall.c.
+  release_objects=""
+  applets=""
+  for cgi_src in $cgi_sources; do
+    cgi_name=$(basename "$cgi_src" .c)
+    cgi_obj="release/obj/${cgi_name}.o"
+    release_objects="$release_objects $cgi_obj"
+    applets="${applets}APPLET(${cgi_name}) "
+
+    {
+      printf "build %s: compile_release %s\n" "$cgi_obj" "$cgi_src"
+      printf "  defines = -Dmain=sfe_applet_%s\n" "$cgi_name"
+    } >> "$output_file"
+  done
+
+  for lib_src in $lib_sources; do
+    lib_obj="release/obj/${lib_src#./}"
+    lib_obj="${lib_obj%.c}.o"
+    release_objects="$release_objects $lib_obj"
+
+    printf "build %s: compile_release %s\n" "$lib_obj" "$lib_src" >> "$output_file"
+  done
 
   {
-    printf "build %s: compile %s %s\n" "$cgi_out" "$cgi_src" "$lib_sources_list"
+    printf "build release/obj/multicall.o: compile_release ./multicall/multicall.c\n"
+    printf "  defines = -DSFE_APPLETS='%s'\n" "$applets"
+    printf "build release/sfe: link_release release/obj/multicall.o%s\n" "$release_objects"
+  } >> "$output_file"
+
+  for cgi_src in $cgi_sources; do
+    cgi_out="$(basename "$cgi_src" .c).cgi"
+    cgi_outputs="$cgi_outputs $cgi_out"
+
+    {
+      printf "build %s: symlink | release/sfe\n" "$cgi_out"
+      printf "  target = release/sfe\n"
+    } >> "$output_file"
+  done
+fi
+
+# Maintenance programs (maint/*.c) run next to the server, e.g. from
+# entrypoint.sh, so they are linked against lib/ and built by default.
+for maint_src in $maint_sources; do
+  maint_out="maint/$(basename "$maint_src" .c)"
+  cgi_outputs="$cgi_outputs $maint_out"
+
+  {
+    printf "build %s: compile %s %s\n" "$maint_out" "$maint_src" "$lib_sources_list"
   } >> "$output_file"
 done
+
+# Benchmarks are opt-in: `ninja bench` builds them, plain `ninja` does not.
+bench_outputs=""
+for bench_src in $bench_sources; do
+  bench_name=$(basename "$bench_src" .c)
+  bench_out="bench/${bench_name}"
+  bench_outputs="$bench_outputs $bench_out"
+
+  {
+    printf "build %s: compile_bench %s %s%s\n" "$bench_out" "$bench_src" "$harness_sources_list" "$lib_sources_list"
+  } >> "$output_file"
+done
+
+# Tools are opt-in as well: `ninja tools`.
+tool_outputs=""
+for tool_src in $tool_sources; do
+  tool_name=$(basename "$tool_src" .c)
+  tool_out="tools/${tool_name}"
+  tool_outputs="$tool_outputs $tool_out"
+
+  {
+    printf "build %s: compile_tool %s\n" "$tool_out" "$tool_src"
+  } >> "$output_file"
+done
+
+for preload_dir in $preload_dirs; do
+  preload_name=$(basename "$preload_dir")
+  preload_out="tools/${preload_name}.so"
+  preload_sources_list=$(printf "%s " $(find "$preload_dir" -type f -name "*.c" | sort))
+  [ -n "$preload_sources_list" ] || continue
+  tool_outputs="$tool_outputs $preload_out"
+
+  {
+    printf "build %s: compile_preload %s\n" "$preload_out" "$preload_sources_list"
+  } >> "$output_file"
+done
+
+{
+  printf "build bench: phony%s\n" "$bench_outputs"
+  printf "build tools: phony%s\n" "$tool_outputs"
+  printf "default%s\n" "$cgi_outputs"
+} >> "$output_file"
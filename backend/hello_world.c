@@ -12,7 +12,7 @@
 #include "lib/response/response.h"
 
 int main(void) {
-        response_t my_response;
+        response_t my_response = {0};
 
         const char* method = getenv("REQUEST_METHOD");
 
@@ -0,0 +1,293 @@
+/**
+ * @file admission.c
+ * @brief Shared in-flight counters with crash recovery.
+ *
+ * Each class has an in-flight and a waiting counter. Admission is a
+ * fetch-add on the in-flight counter that is undone when it overshoots the
+ * budget, so budgets are exact. Each process also records itself in a slot
+ * word (pid, class, state); when a budget looks full, slots of processes
+ * that no longer exist (killed by the CGI timeout, crashed) are reclaimed
+ * and their counts given back.
+ */
+
+#include "admission.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @brief Segment layout version; bump on any layout change. */
+#define ADMISSION_VERSION 1
+
+/** @brief Magic word ("SFA" + version) marking an initialized segment. */
+#define ADMISSION_MAGIC (0x53464100u | ADMISSION_VERSION)
+
+/** @brief Longest sleep between admission attempts. */
+#define ADMISSION_MAX_POLL_US 10000
+
+/**
+ * @enum admission_state
+ * @brief What a slot's process is doing.
+ */
+enum admission_state {
+        ADMISSION_FREE     = 0, /**< Slot unused */
+        ADMISSION_CLAIMED  = 1, /**< Trying, not counted yet */
+        ADMISSION_WAITING  = 2, /**< Queued, counted in waiting */
+        ADMISSION_ADMITTED = 3  /**< Counted in inflight */
+};
+
+/**
+ * @struct admission_policy_t
+ * @brief Budget and queueing of one class.
+ */
+typedef struct {
+        const char* env;      /**< Variable overriding max_inflight */
+        int32_t max_inflight; /**< Concurrent requests admitted */
+        uint32_t queue_ms;    /**< Longest wait before shedding */
+        uint32_t retry_after; /**< Retry-After sent when shed */
+} admission_policy_t;
+
+/** @brief Per-class policies, indexed by admission_class_t. */
+static const admission_policy_t policies[ADMISSION_CLASSES] = {
+    [ADMISSION_CHEAP]     = {"SFE_ADMISSION_CHEAP_MAX", 32, 250, 1},
+    [ADMISSION_EXPENSIVE] = {"SFE_ADMISSION_EXPENSIVE_MAX", 4, 2000, 5},
+};
+
+/**
+ * @struct admission_segment_t
+ * @brief The whole shared segment.
+ */
+typedef struct {
+        _Atomic uint32_t magic; /**< ADMISSION_MAGIC once initialized */
+        uint32_t reserved;      /**< Zero */
+        _Atomic int32_t inflight[ADMISSION_CLASSES]; /**< Admitted */
+        _Atomic int32_t waiting[ADMISSION_CLASSES];  /**< Queued */
+        _Atomic uint64_t slots[ADMISSION_SLOTS];     /**< See slot_word() */
+} admission_segment_t;
+
+/** @brief This process's mapping, NULL if unavailable. */
+static admission_segment_t* segment = NULL;
+
+/** @brief Whether mapping was already attempted. */
+static bool segment_tried = false;
+
+/** @brief This process's slot, NULL if it holds none. */
+static _Atomic uint64_t* own_slot = NULL;
+
+/**
+ * @brief Map the segment on first use.
+ * @return Mapped segment, or NULL if admission control is off.
+ */
+static admission_segment_t* segment_get(void) {
+        if (segment_tried) return segment;
+        segment_tried = true;
+
+        const char* enabled = getenv("SFE_ADMISSION");
+        if (enabled && strcmp(enabled, "0") == 0) return NULL;
+
+        const char* path = getenv("SFE_ADMISSION_FILE");
+        if (!path) path = ADMISSION_DEFAULT_FILE;
+        if (!*path) return NULL;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        bool sized = false;
+        if (fstat(fd, &st) == 0) {
+                if (st.st_size == 0)
+                        sized =
+                            ftruncate(fd, sizeof(admission_segment_t)) == 0;
+                else
+                        sized = st.st_size == sizeof(admission_segment_t);
+        }
+        void* p = sized ? mmap(NULL, sizeof(admission_segment_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED) return NULL;
+
+        admission_segment_t* seg = p;
+        uint32_t magic           = 0;
+        if (!atomic_compare_exchange_strong(&seg->magic, &magic,
+                                            ADMISSION_MAGIC) &&
+            magic != ADMISSION_MAGIC) {
+                munmap(p, sizeof(admission_segment_t));
+                return NULL;
+        }
+
+        segment = seg;
+        return segment;
+}
+
+/**
+ * @brief Pack a slot word: pid << 16 | class << 8 | state.
+ */
+static uint64_t slot_word(pid_t pid, admission_class_t cls,
+                          enum admission_state state) {
+        return ((uint64_t)(uint32_t)pid << 16) | ((uint64_t)cls << 8) |
+               (uint64_t)state;
+}
+
+/**
+ * @brief Give back the counts held by a slot word.
+ * @param seg Mapped segment.
+ * @param word Slot word that was just cleared.
+ */
+static void slot_uncount(admission_segment_t* seg, uint64_t word) {
+        unsigned cls   = (unsigned)(word >> 8) & 0xff;
+        unsigned state = (unsigned)word & 0xff;
+        if (cls >= ADMISSION_CLASSES) return;
+        if (state == ADMISSION_ADMITTED)
+                atomic_fetch_sub(&seg->inflight[cls], 1);
+        else if (state == ADMISSION_WAITING)
+                atomic_fetch_sub(&seg->waiting[cls], 1);
+}
+
+/**
+ * @brief Reclaim the slots of processes that have exited.
+ * @param seg Mapped segment.
+ */
+static void slots_reap(admission_segment_t* seg) {
+        for (size_t i = 0; i < ADMISSION_SLOTS; ++i) {
+                uint64_t word = atomic_load(&seg->slots[i]);
+                if (word == 0 || &seg->slots[i] == own_slot) continue;
+                pid_t pid = (pid_t)(uint32_t)(word >> 16);
+                if (kill(pid, 0) == 0 || errno != ESRCH) continue;
+                if (atomic_compare_exchange_strong(&seg->slots[i], &word, 0))
+                        slot_uncount(seg, word);
+        }
+}
+
+/**
+ * @brief Claim a free slot.
+ * @param seg Mapped segment.
+ * @param cls Class.
+ * @return Slot, or NULL if all are taken.
+ */
+static _Atomic uint64_t* slot_claim(admission_segment_t* seg,
+                                    admission_class_t cls) {
+        uint64_t word = slot_word(getpid(), cls, ADMISSION_CLAIMED);
+        size_t start  = (size_t)getpid() % ADMISSION_SLOTS;
+        for (size_t i = 0; i < ADMISSION_SLOTS; ++i) {
+                _Atomic uint64_t* s =
+                    &seg->slots[(start + i) % ADMISSION_SLOTS];
+                uint64_t free_word = 0;
+                if (atomic_compare_exchange_strong(s, &free_word, word))
+                        return s;
+        }
+        return NULL;
+}
+
+/**
+ * @brief Release this process's slot; registered with atexit().
+ */
+static void admission_release(void) {
+        if (!segment || !own_slot) return;
+        uint64_t word = atomic_exchange(own_slot, 0);
+        own_slot      = NULL;
+        if (word) slot_uncount(segment, word);
+}
+
+/**
+ * @brief Budget of a class, honouring its environment override.
+ */
+static int32_t class_budget(admission_class_t cls) {
+        const char* v = getenv(policies[cls].env);
+        int32_t max = v && *v ? (int32_t)atoi(v) : policies[cls].max_inflight;
+        return max > 0 ? max : 1;
+}
+
+/**
+ * @brief Whether a higher-priority class has requests queued.
+ */
+static bool higher_waiting(admission_segment_t* seg, admission_class_t cls) {
+        for (int c = 0; c < (int)cls; ++c)
+                if (atomic_load(&seg->waiting[c]) > 0) return true;
+        return false;
+}
+
+/**
+ * @brief Wait for a slot in the class's budget.
+ * @param cls Cost class of this request.
+ * @param retry_after_s Set to the class's suggested back-off in seconds
+ * when refused (nullable).
+ * @return true if admitted; the slot is released at exit.
+ */
+bool admission_enter(admission_class_t cls, uint32_t* retry_after_s) {
+        if ((unsigned)cls >= ADMISSION_CLASSES) cls = ADMISSION_EXPENSIVE;
+
+        admission_segment_t* seg = segment_get();
+        if (!seg || own_slot) return true;
+
+        const admission_policy_t* policy = &policies[cls];
+        if (retry_after_s) *retry_after_s = policy->retry_after;
+
+        _Atomic uint64_t* slot = slot_claim(seg, cls);
+        if (!slot) {
+                slots_reap(seg);
+                slot = slot_claim(seg, cls);
+                if (!slot) return false;
+        }
+        own_slot = slot;
+        atexit(admission_release);
+
+        int32_t budget    = class_budget(cls);
+        uint64_t deadline = timing_now_ns() + policy->queue_ms * 1000000ull;
+        useconds_t poll   = 500;
+        bool queued       = false;
+
+        for (;;) {
+                if (higher_waiting(seg, cls)) break;
+
+                if (atomic_fetch_add(&seg->inflight[cls], 1) < budget) {
+                        atomic_store(slot,
+                                     slot_word(getpid(), cls,
+                                               ADMISSION_ADMITTED));
+                        if (queued) atomic_fetch_sub(&seg->waiting[cls], 1);
+                        return true;
+                }
+                atomic_fetch_sub(&seg->inflight[cls], 1);
+
+                /* Over budget: reclaim dead processes' slots once, then
+                 * queue, which makes lower classes shed. */
+                if (!queued) {
+                        slots_reap(seg);
+                        atomic_fetch_add(&seg->waiting[cls], 1);
+                        atomic_store(slot, slot_word(getpid(), cls,
+                                                     ADMISSION_WAITING));
+                        queued = true;
+                        continue;
+                }
+                if (timing_now_ns() >= deadline) break;
+
+                usleep(poll);
+                if (poll < ADMISSION_MAX_POLL_US) poll *= 2;
+        }
+
+        admission_release();
+        return false;
+}
+
+/**
+ * @brief Send the canned 503 response and finish the request timing.
+ * @param timing Request timing (nullable).
+ * @param retry_after_s Value for the Retry-After header.
+ */
+void admission_send_503(timing_t* timing, uint32_t retry_after_s) {
+        printf("Status: 503\r\n"
+               "Content-Type: application/json\r\n"
+               "Retry-After: %u\r\n"
+               "\r\n"
+               "{\"status\":503,\"messages\":[\"Server busy.\"]}\n",
+               retry_after_s ? retry_after_s : 1);
+        timing_finish(timing, 503);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file admission.h
+ * @brief Cross-process admission control by endpoint cost class.
+ *
+ * Each class has its own concurrency budget and queue deadline, kept in a
+ * shared-memory segment (SFE_ADMISSION_FILE, default /dev/shm/sfe_admission)
+ * so every CGI process sees the same counts. A request over budget waits
+ * until its deadline and is then shed. Requests of a lower-priority class
+ * are shed at once while a higher-priority class has requests waiting, so
+ * an Argon2 flood cannot starve cheap endpoints.
+ *
+ * Handlers call admission_enter() before doing any work and answer with
+ * admission_send_503() when it refuses. The slot is given back when the
+ * process exits. When the segment cannot be mapped, or SFE_ADMISSION=0,
+ * every request is admitted.
+ */
+
+#ifndef ADMISSION_H_
+#define ADMISSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Segment path used when SFE_ADMISSION_FILE is unset. */
+#define ADMISSION_DEFAULT_FILE "/dev/shm/sfe_admission"
+
+/** @brief Requests tracked at once (admitted plus waiting). */
+#define ADMISSION_SLOTS 256
+
+/**
+ * @enum admission_class
+ * @brief Cost classes, highest priority first.
+ */
+typedef enum admission_class {
+        ADMISSION_CHEAP     = 0, /**< Token issue/validation, metrics */
+        ADMISSION_EXPENSIVE = 1, /**< Argon2 hashing */
+        ADMISSION_CLASSES   = 2  /**< Number of classes */
+} admission_class_t;
+
+/**
+ * @brief Wait for a slot in the class's budget.
+ *
+ * Budgets default to 32 cheap and 4 expensive requests in flight, and can
+ * be changed with SFE_ADMISSION_CHEAP_MAX / SFE_ADMISSION_EXPENSIVE_MAX.
+ * Cheap requests queue for up to 250 ms, expensive ones for up to 2 s.
+ *
+ * @param cls Cost class of this request.
+ * @param retry_after_s Set to the class's suggested back-off in seconds
+ * when refused (nullable).
+ * @return true if admitted; the slot is released at exit.
+ */
+bool admission_enter(admission_class_t cls, uint32_t* retry_after_s);
+
+/**
+ * @brief Send the canned 503 response and finish the request timing.
+ * @param timing Request timing (nullable).
+ * @param retry_after_s Value for the Retry-After header.
+ */
+void admission_send_503(timing_t* timing, uint32_t retry_after_s);
+
+#endif// ADMISSION_H_
@@ -0,0 +1,232 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the request arena allocator.
+ */
+
+#include "arena.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct arena_chunk
+ * @brief Heap block chained onto an arena once its current block is full.
+ */
+struct arena_chunk {
+        arena_chunk_t* next; /**< Previously allocated chunk */
+        size_t cap;          /**< Usable bytes following the header */
+};
+
+/** @brief Size of the chunk header, rounded up to keep data aligned. */
+#define CHUNK_HEADER_SIZE                                    \
+        ((sizeof(arena_chunk_t) + ARENA_ALIGNMENT - 1) &     \
+         ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/**
+ * @brief Round @p n up to the arena alignment.
+ * @param n Size to round.
+ * @return Aligned size, or 0 on overflow.
+ */
+static size_t align_up(size_t n) {
+        size_t aligned = (n + ARENA_ALIGNMENT - 1) &
+                         ~(size_t)(ARENA_ALIGNMENT - 1);
+        return aligned < n ? 0 : aligned;
+}
+
+/**
+ * @brief Allocate a new heap chunk large enough for @p size bytes and make it
+ * the current block.
+ * @param arena Target arena.
+ * @param size  Minimum usable size.
+ * @return true on success, false on allocation failure.
+ */
+static bool arena_grow(arena_t* arena, size_t size) {
+        size_t cap = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        if (cap > SIZE_MAX - CHUNK_HEADER_SIZE) return false;
+
+        arena_chunk_t* chunk = malloc(CHUNK_HEADER_SIZE + cap);
+        if (!chunk) return false;
+
+        chunk->next   = arena->chunks;
+        chunk->cap    = cap;
+        arena->chunks = chunk;
+        arena->buf    = (unsigned char*)chunk + CHUNK_HEADER_SIZE;
+        arena->cap    = cap;
+        arena->used   = 0;
+        return true;
+}
+
+/**
+ * @brief Initialize an arena, aligning the optional caller-provided block.
+ *
+ * @param arena Arena to initialize.
+ * @param buf   Optional first block (nullable).
+ * @param cap   Size of @p buf in bytes.
+ */
+void arena_init(arena_t* arena, void* buf, size_t cap) {
+        if (!arena) return;
+
+        unsigned char* base = buf;
+        if (base && cap > 0) {
+                uintptr_t addr = (uintptr_t)base;
+                size_t skew    = (size_t)(-addr & (ARENA_ALIGNMENT - 1));
+                if (skew >= cap) {
+                        base = NULL;
+                        cap  = 0;
+                } else {
+                        base += skew;
+                        cap -= skew;
+                }
+        } else {
+                base = NULL;
+                cap  = 0;
+        }
+
+        arena->initial     = base;
+        arena->initial_cap = cap;
+        arena->buf         = base;
+        arena->cap         = cap;
+        arena->used        = 0;
+        arena->chunks      = NULL;
+}
+
+/**
+ * @brief Bump-allocate @p size bytes, chaining a new chunk when needed.
+ *
+ * @param arena Arena to allocate from, or NULL for malloc().
+ * @param size  Number of bytes.
+ * @return Aligned pointer, or NULL on allocation failure.
+ */
+void* arena_alloc(arena_t* arena, size_t size) {
+        if (!arena) return malloc(size ? size : 1);
+
+        size_t need = align_up(size ? size : 1);
+        if (need == 0) return NULL;
+
+        if (!arena->buf || arena->cap - arena->used < need) {
+                if (!arena_grow(arena, need)) return NULL;
+        }
+
+        void* ptr = arena->buf + arena->used;
+        arena->used += need;
+        return ptr;
+}
+
+/**
+ * @brief Allocate zeroed memory from the arena.
+ *
+ * @param arena Arena to allocate from, or NULL for calloc().
+ * @param size  Number of bytes.
+ * @return Zeroed pointer, or NULL on allocation failure.
+ */
+void* arena_calloc(arena_t* arena, size_t size) {
+        if (!arena) return calloc(1, size ? size : 1);
+
+        void* ptr = arena_alloc(arena, size);
+        if (ptr) memset(ptr, 0, size);
+        return ptr;
+}
+
+/**
+ * @brief Copy at most @p n bytes of @p s into the arena.
+ *
+ * @param arena Arena to allocate from, or NULL for the heap.
+ * @param s     Source string (nullable).
+ * @param n     Maximum number of bytes to copy.
+ * @return NUL-terminated copy, or NULL.
+ */
+char* arena_strndup(arena_t* arena, const char* s, size_t n) {
+        if (!s) return NULL;
+
+        size_t len = strnlen(s, n);
+        char* copy = arena_alloc(arena, len + 1);
+        if (!copy) return NULL;
+
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+        return copy;
+}
+
+/**
+ * @brief Copy @p s into the arena.
+ *
+ * @param arena Arena to allocate from, or NULL for the heap.
+ * @param s     Source string (nullable).
+ * @return NUL-terminated copy, or NULL.
+ */
+char* arena_strdup(arena_t* arena, const char* s) {
+        if (!s) return NULL;
+        return arena_strndup(arena, s, strlen(s));
+}
+
+/**
+ * @brief Format into a buffer sized exactly for the output.
+ *
+ * @param arena  Arena to allocate from, or NULL for the heap.
+ * @param format printf-style format string.
+ * @param args   Format arguments (consumed).
+ * @return Formatted string, or NULL on failure.
+ */
+char* arena_vsprintf(arena_t* arena, const char* format, va_list args) {
+        if (!format) return NULL;
+
+        va_list args_copy;
+        va_copy(args_copy, args);
+        int size = vsnprintf(NULL, 0, format, args_copy);
+        va_end(args_copy);
+        if (size < 0) return NULL;
+
+        char* buffer = arena_alloc(arena, (size_t)size + 1);
+        if (!buffer) return NULL;
+
+        vsnprintf(buffer, (size_t)size + 1, format, args);
+        return buffer;
+}
+
+/**
+ * @brief Free heap memory; arena memory is left for arena_reset().
+ *
+ * @param arena Arena the pointer came from (nullable).
+ * @param ptr   Pointer to release (nullable).
+ */
+void arena_free(arena_t* arena, void* ptr) {
+        if (!arena) free(ptr);
+}
+
+/**
+ * @brief Free all heap chunks and rewind to the first block.
+ *
+ * @param arena Arena to reset (nullable).
+ */
+void arena_reset(arena_t* arena) {
+        if (!arena) return;
+
+        arena_chunk_t* chunk = arena->chunks;
+        while (chunk) {
+                arena_chunk_t* next = chunk->next;
+                free(chunk);
+                chunk = next;
+        }
+
+        arena->chunks = NULL;
+        arena->buf    = arena->initial;
+        arena->cap    = arena->initial_cap;
+        arena->used   = 0;
+}
+
+/**
+ * @brief Release all memory and detach the caller-provided block.
+ *
+ * @param arena Arena to destroy (nullable).
+ */
+void arena_destroy(arena_t* arena) {
+        if (!arena) return;
+        arena_reset(arena);
+        arena->initial     = NULL;
+        arena->initial_cap = 0;
+        arena->buf         = NULL;
+        arena->cap         = 0;
+}
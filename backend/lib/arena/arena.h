@@ -0,0 +1,132 @@
+/**
+ * @file arena.h
+ * @brief Bump-pointer arena allocator scoped to a single request.
+ *
+ * An arena hands out memory by advancing a pointer inside a block and
+ * releases everything at once with arena_reset() or arena_destroy(). The
+ * first block may be caller-provided (typically a stack buffer), so small
+ * requests never reach malloc at all; larger requests spill into heap
+ * chunks that are chained and released together.
+ *
+ * Every allocating function accepts a NULL arena and then falls back to the
+ * C heap, which lets library APIs take an optional arena without duplicating
+ * code paths. Pair such allocations with arena_free(), which is a no-op for
+ * arena memory and free() otherwise.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/** @brief Default size of heap chunks allocated once the arena overflows. */
+#define ARENA_CHUNK_SIZE 8192
+
+/** @brief Alignment guaranteed for every allocation. */
+#define ARENA_ALIGNMENT 16
+
+typedef struct arena_chunk arena_chunk_t;
+
+/**
+ * @struct arena_t
+ * @brief Request arena state.
+ *
+ * Treat the fields as private; they are exposed only so an arena can live on
+ * the stack without a heap allocation of its own.
+ */
+typedef struct {
+        unsigned char* buf;      /**< Block currently being carved */
+        size_t cap;              /**< Capacity of the current block */
+        size_t used;             /**< Bytes used in the current block */
+        unsigned char* initial;  /**< Caller-provided first block (nullable) */
+        size_t initial_cap;      /**< Capacity of the first block */
+        arena_chunk_t* chunks;   /**< Heap chunks, newest first */
+} arena_t;
+
+/**
+ * @brief Initialize an arena.
+ *
+ * @param arena Arena to initialize.
+ * @param buf   Optional caller-owned first block (nullable). It must outlive
+ *              the arena.
+ * @param cap   Size of @p buf in bytes (ignored when @p buf is NULL).
+ */
+void arena_init(arena_t* arena, void* buf, size_t cap);
+
+/**
+ * @brief Allocate @p size bytes aligned to ARENA_ALIGNMENT.
+ *
+ * @param arena Arena to allocate from, or NULL to use malloc().
+ * @param size  Number of bytes.
+ * @return Pointer to uninitialized memory, or NULL on allocation failure.
+ */
+void* arena_alloc(arena_t* arena, size_t size);
+
+/**
+ * @brief Allocate zero-initialized memory.
+ *
+ * @param arena Arena to allocate from, or NULL to use calloc().
+ * @param size  Number of bytes.
+ * @return Pointer to zeroed memory, or NULL on allocation failure.
+ */
+void* arena_calloc(arena_t* arena, size_t size);
+
+/**
+ * @brief Duplicate a string into the arena.
+ *
+ * @param arena Arena to allocate from, or NULL to use the heap.
+ * @param s     String to copy (nullable).
+ * @return Copy of @p s, or NULL if @p s is NULL or allocation fails.
+ */
+char* arena_strdup(arena_t* arena, const char* s);
+
+/**
+ * @brief Duplicate at most @p n bytes of a string into the arena.
+ *
+ * @param arena Arena to allocate from, or NULL to use the heap.
+ * @param s     String to copy (nullable).
+ * @param n     Maximum number of bytes to copy.
+ * @return NUL-terminated copy, or NULL if @p s is NULL or allocation fails.
+ */
+char* arena_strndup(arena_t* arena, const char* s, size_t n);
+
+/**
+ * @brief printf-style formatting into arena memory.
+ *
+ * @param arena  Arena to allocate from, or NULL to use the heap.
+ * @param format Format string.
+ * @param args   Format arguments.
+ * @return Formatted string, or NULL on failure.
+ */
+char* arena_vsprintf(arena_t* arena, const char* format, va_list args);
+
+/**
+ * @brief Release memory obtained from arena_alloc() and friends.
+ *
+ * No-op when @p arena is non-NULL (memory is reclaimed by arena_reset());
+ * otherwise forwards to free().
+ *
+ * @param arena Arena the pointer came from (nullable).
+ * @param ptr   Pointer to release (nullable).
+ */
+void arena_free(arena_t* arena, void* ptr);
+
+/**
+ * @brief Release every allocation at once, keeping the arena usable.
+ *
+ * Heap chunks are returned to the system and the caller-provided first block
+ * is rewound, so a persistent server can reuse one arena across requests.
+ *
+ * @param arena Arena to reset (nullable).
+ */
+void arena_reset(arena_t* arena);
+
+/**
+ * @brief Release all memory owned by the arena.
+ *
+ * @param arena Arena to destroy (nullable).
+ */
+void arena_destroy(arena_t* arena);
+
+#endif// ARENA_H_
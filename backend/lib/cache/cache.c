@@ -0,0 +1,392 @@
+/**
+ * @file cache.c
+ * @brief Response entries in a shared segment, guarded by seqlocks.
+ *
+ * A key hashes to exactly one slot; a different key landing there simply
+ * replaces the entry, so the segment never grows and needs no eviction.
+ * Slots are read without locks: the writer makes the slot's sequence
+ * number odd while it copies, and a reader that sees an odd or changed
+ * number treats the entry as a miss. Only the holder of the slot's fill
+ * lock (one byte of the segment file, locked with F_SETLK) writes a slot.
+ *
+ * Scope generations are plain counters in a second table. Distinct scopes
+ * hashing to one counter only make each other's entries miss more often.
+ * They restart at zero with a new segment, so ETags also hash the
+ * segment's epoch, its creation time.
+ */
+
+#include "cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Segment layout version; bump on any layout change. */
+#define CACHE_VERSION 2
+
+/** @brief Magic word ("SFC" + version) marking an initialized segment. */
+#define CACHE_MAGIC (0x53464300u | CACHE_VERSION)
+
+/** @brief Longest sleep between fill lock attempts. */
+#define CACHE_MAX_POLL_US 8000
+
+/**
+ * @struct cache_slot_t
+ * @brief One entry.
+ */
+typedef struct {
+        _Atomic uint64_t seq;            /**< Odd while being written */
+        uint64_t hash;                   /**< Hash of the key, 0 if empty */
+        uint64_t gens[CACHE_MAX_SCOPES]; /**< Generations it was built at */
+        uint32_t status;                 /**< HTTP status */
+        uint32_t key_len;                /**< Key bytes at the start of data */
+        uint32_t body_len;               /**< Payload bytes after the key */
+        uint32_t reserved;               /**< Zero */
+        char data[CACHE_ENTRY_SIZE];     /**< Key, then payload */
+} cache_slot_t;
+
+/**
+ * @struct cache_segment_t
+ * @brief The whole shared segment.
+ */
+typedef struct {
+        _Atomic uint32_t magic; /**< CACHE_MAGIC once initialized */
+        uint32_t reserved;      /**< Zero */
+        _Atomic uint64_t epoch; /**< Creation time in ns, 0 until set */
+        _Atomic uint64_t gens[CACHE_GENERATIONS];
+        cache_slot_t slots[CACHE_SLOTS];
+} cache_segment_t;
+
+/** @brief This process's mapping, NULL if unavailable. */
+static cache_segment_t* segment = NULL;
+
+/** @brief Descriptor of the segment file, kept open for the fill locks. */
+static int segment_fd = -1;
+
+/** @brief Whether mapping was already attempted. */
+static bool segment_tried = false;
+
+/**
+ * @brief Map the segment on first use.
+ * @return Mapped segment, or NULL if caching is off.
+ */
+static cache_segment_t* segment_get(void) {
+        if (segment_tried) return segment;
+        segment_tried = true;
+
+        const char* enabled = getenv("SFE_CACHE");
+        if (enabled && strcmp(enabled, "0") == 0) return NULL;
+
+        const char* path = getenv("SFE_CACHE_FILE");
+        if (!path) path = CACHE_DEFAULT_FILE;
+        if (!*path) return NULL;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        bool sized = false;
+        if (fstat(fd, &st) == 0) {
+                if (st.st_size == 0)
+                        sized = ftruncate(fd, sizeof(cache_segment_t)) == 0;
+                else
+                        sized = st.st_size == sizeof(cache_segment_t);
+        }
+        void* p = sized ? mmap(NULL, sizeof(cache_segment_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        if (p == MAP_FAILED) {
+                close(fd);
+                return NULL;
+        }
+
+        cache_segment_t* seg = p;
+        uint32_t magic       = 0;
+        if (!atomic_compare_exchange_strong(&seg->magic, &magic,
+                                            CACHE_MAGIC) &&
+            magic != CACHE_MAGIC) {
+                munmap(p, sizeof(cache_segment_t));
+                close(fd);
+                return NULL;
+        }
+
+        /* Every process that finds no epoch proposes one; the first wins. */
+        uint64_t epoch = 0;
+        if (atomic_load(&seg->epoch) == 0) {
+                struct timespec ts;
+                clock_gettime(CLOCK_REALTIME, &ts);
+                uint64_t now = (uint64_t)ts.tv_sec * 1000000000ull +
+                               (uint64_t)ts.tv_nsec;
+                atomic_compare_exchange_strong(&seg->epoch, &epoch, now | 1);
+        }
+
+        segment    = seg;
+        segment_fd = fd;
+        return segment;
+}
+
+/**
+ * @brief FNV-1a (64-bit) over a byte range.
+ * @param h Hash so far.
+ * @param p Bytes.
+ * @param n Number of bytes.
+ * @return Updated hash.
+ */
+static uint64_t hash_bytes(uint64_t h, const void* p, size_t n) {
+        const unsigned char* b = p;
+        for (size_t i = 0; i < n; ++i) h = (h ^ b[i]) * 1099511628211ull;
+        return h;
+}
+
+/**
+ * @brief Spread every input bit over the whole hash (MurmurHash3 fmix64).
+ *
+ * FNV-1a leaves the last bytes poorly mixed, and keys of one endpoint
+ * differ mostly at the end; slots and counters are picked from the mixed
+ * value.
+ *
+ * @param h Hash.
+ * @return Mixed hash.
+ */
+static uint64_t hash_mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+}
+
+/**
+ * @brief Generation counter of a scope.
+ * @param seg Mapped segment.
+ * @param kind Kind of data.
+ * @param id Thread id or 0.
+ * @return Counter shared by every scope hashing to it.
+ */
+static _Atomic uint64_t* generation(cache_segment_t* seg,
+                                    cache_scope_kind_t kind, int64_t id) {
+        uint64_t h = hash_bytes(14695981039346656037ull, &kind, sizeof(kind));
+        h          = hash_mix(hash_bytes(h, &id, sizeof(id)));
+        return &seg->gens[h & (CACHE_GENERATIONS - 1)];
+}
+
+/**
+ * @brief Try to take or drop a slot's fill lock.
+ * @param slot Slot index.
+ * @param type F_WRLCK or F_UNLCK.
+ * @return true on success; false if another process holds it.
+ */
+static bool fill_lock(uint32_t slot, short type) {
+        struct flock fl = {
+            .l_type   = type,
+            .l_whence = SEEK_SET,
+            .l_start  = (off_t)slot,
+            .l_len    = 1,
+        };
+        return fcntl(segment_fd, F_SETLK, &fl) == 0;
+}
+
+/**
+ * @brief Serve @p entry's key from its slot if it is there and current.
+ *
+ * Copies the payload into @p resp while checking the slot's sequence
+ * number; a concurrent write makes it a miss.
+ *
+ * @param seg Mapped segment.
+ * @param entry Lookup state with key and generations.
+ * @param resp Response to fill.
+ * @return true on a hit; otherwise @p resp keeps its status, no messages.
+ */
+static bool slot_read(cache_segment_t* seg, const cache_entry_t* entry,
+                      response_t* resp) {
+        cache_slot_t* s = &seg->slots[entry->slot];
+
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq & 1) return false;
+
+        if (s->hash != entry->hash || s->key_len != entry->key_len ||
+            s->body_len > CACHE_ENTRY_SIZE - entry->key_len ||
+            memcmp(s->data, entry->key, entry->key_len) != 0)
+                return false;
+        for (size_t i = 0; i < entry->scope_count; ++i)
+                if (s->gens[i] != entry->gens[i]) return false;
+
+        unsigned int prev_status = resp->response_code;
+        unsigned int status      = s->status;
+        size_t body_len          = s->body_len;
+        response_init(resp, status);
+        bool copied =
+            response_append_raw(resp, s->data + entry->key_len, body_len);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (!copied ||
+            atomic_load_explicit(&s->seq, memory_order_relaxed) != seq) {
+                response_init(resp, prev_status);
+                return false;
+        }
+        response_add_header(resp, "X-Cache", "HIT");
+        return true;
+}
+
+/**
+ * @brief Serve a response from the cache, or claim the right to fill it.
+ * @param entry Lookup state to fill
+ * @param key Endpoint plus normalized query
+ * @param scopes Scopes the response is computed from
+ * @param scope_count Number of scopes
+ * @param resp Response to fill on a hit
+ * @return CACHE_HIT, CACHE_MISS or CACHE_OFF
+ */
+cache_status_t cache_lookup(cache_entry_t* entry, const char* key,
+                            const cache_scope_t* scopes, size_t scope_count,
+                            response_t* resp) {
+        if (!entry) return CACHE_OFF;
+        *entry = (cache_entry_t){0};
+
+        cache_segment_t* seg = segment_get();
+        if (!seg || !key || !resp || scope_count > CACHE_MAX_SCOPES ||
+            (scope_count && !scopes))
+                return CACHE_OFF;
+
+        size_t key_len = strlen(key);
+        if (key_len >= CACHE_ENTRY_SIZE) return CACHE_OFF;
+
+        /* Hash 0 marks an empty slot. */
+        entry->key     = key;
+        entry->key_len = key_len;
+        entry->hash =
+            hash_mix(hash_bytes(14695981039346656037ull, key, key_len)) | 1;
+        entry->slot = (uint32_t)(entry->hash >> 32) & (CACHE_SLOTS - 1);
+        entry->scope_count = scope_count;
+
+        /* Generations are read before anything is computed, so a write
+         * that lands while this request computes leaves a stale tag. */
+        uint64_t deadline = timing_now_ns() + CACHE_WAIT_MS * 1000000ull;
+        useconds_t poll   = 500;
+        for (;;) {
+                for (size_t i = 0; i < scope_count; ++i)
+                        entry->gens[i] = atomic_load(generation(
+                            seg, scopes[i].kind, scopes[i].id));
+                if (slot_read(seg, entry, resp)) return CACHE_HIT;
+
+                if (fill_lock(entry->slot, F_WRLCK)) break;
+                if ((errno != EACCES && errno != EAGAIN) ||
+                    timing_now_ns() >= deadline)
+                        return CACHE_MISS;
+
+                usleep(poll);
+                if (poll < CACHE_MAX_POLL_US) poll *= 2;
+        }
+
+        /* The previous holder may have filled the slot just before this
+         * process got the lock. */
+        if (slot_read(seg, entry, resp)) {
+                fill_lock(entry->slot, F_UNLCK);
+                return CACHE_HIT;
+        }
+        entry->locked = true;
+        return CACHE_MISS;
+}
+
+/**
+ * @brief Save a computed response and release the fill lock.
+ * @param entry State from a cache_lookup() that returned CACHE_MISS
+ * @param resp Response about to be sent
+ */
+void cache_store(cache_entry_t* entry, response_t* resp) {
+        if (!entry || !resp) return;
+        if (!entry->key) {
+                cache_release(entry);
+                return;
+        }
+
+        response_add_header(resp, "X-Cache", "MISS");
+
+        size_t body_len = resp->messages_len;
+        if (!entry->locked || resp->response_code != 200 ||
+            body_len > CACHE_ENTRY_SIZE - entry->key_len) {
+                cache_release(entry);
+                return;
+        }
+
+        /* Odd while copying; a writer that died mid-copy left it odd, and
+         * | 1 keeps it so. */
+        cache_slot_t* s = &segment->slots[entry->slot];
+        uint64_t seq =
+            atomic_load_explicit(&s->seq, memory_order_relaxed) | 1;
+        atomic_store_explicit(&s->seq, seq, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        s->hash     = entry->hash;
+        s->status   = resp->response_code;
+        s->key_len  = (uint32_t)entry->key_len;
+        s->body_len = (uint32_t)body_len;
+        for (size_t i = 0; i < CACHE_MAX_SCOPES; ++i)
+                s->gens[i] = i < entry->scope_count ? entry->gens[i] : 0;
+        memcpy(s->data, entry->key, entry->key_len);
+        if (body_len)
+                memcpy(s->data + entry->key_len, resp->messages, body_len);
+
+        atomic_store_explicit(&s->seq, seq + 1, memory_order_release);
+        cache_release(entry);
+}
+
+/**
+ * @brief Release the fill lock without storing.
+ * @param entry Lookup state (nullable)
+ */
+void cache_release(cache_entry_t* entry) {
+        if (!entry || !entry->locked) return;
+        fill_lock(entry->slot, F_UNLCK);
+        entry->locked = false;
+}
+
+/**
+ * @brief Turn every entry computed from a scope into a miss.
+ * @param kind Kind of data changed
+ * @param id Thread id for CACHE_SCOPE_THREAD, otherwise 0
+ */
+void cache_invalidate(cache_scope_kind_t kind, int64_t id) {
+        cache_segment_t* seg = segment_get();
+        if (seg) atomic_fetch_add(generation(seg, kind, id), 1);
+}
+
+/**
+ * @brief Strong ETag of a response, from its key and scopes' generations.
+ * @param key Endpoint plus normalized query
+ * @param scopes Scopes the response is computed from
+ * @param scope_count Number of scopes
+ * @param out Receives the tag, quotes included
+ * @return false if caching is off
+ */
+bool cache_etag(const char* key, const cache_scope_t* scopes,
+                size_t scope_count, char out[CACHE_ETAG_SIZE]) {
+        cache_segment_t* seg = segment_get();
+        if (!seg || !key || !out || scope_count > CACHE_MAX_SCOPES ||
+            (scope_count && !scopes))
+                return false;
+
+        uint64_t epoch = atomic_load(&seg->epoch);
+        uint64_t h     = hash_bytes(14695981039346656037ull, &epoch,
+                                    sizeof(epoch));
+        h              = hash_bytes(h, key, strlen(key) + 1);
+        for (size_t i = 0; i < scope_count; ++i) {
+                uint64_t gen = atomic_load(
+                    generation(seg, scopes[i].kind, scopes[i].id));
+                h = hash_bytes(h, &gen, sizeof(gen));
+        }
+
+        snprintf(out, CACHE_ETAG_SIZE, "\"%016llx\"",
+                 (unsigned long long)hash_mix(h));
+        return true;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file cache.h
+ * @brief Cross-process cache of rendered read responses.
+ *
+ * Every CGI process maps the same file (SFE_CACHE_FILE, default
+ * /dev/shm/sfe_cache) holding a fixed number of entry slots and a table of
+ * scope generations. An entry is the payload of a 200 response, keyed by
+ * endpoint plus normalized query, and tagged with the generations of the
+ * scopes it was computed from (e.g. "all posts", "thread 7"). Writers in
+ * lib/dal bump a scope's generation after they change it, which turns every
+ * entry computed from the scope into a miss; nothing else expires.
+ *
+ * Concurrent misses for one key collapse into one computation: the first
+ * process takes the slot's fill lock, the others wait on it (up to
+ * CACHE_WAIT_MS) and are then served the result. Locks are fcntl() record
+ * locks, so a process that dies while filling releases its lock.
+ *
+ * Handlers call cache_lookup() once the request is validated, then on a
+ * miss build the response and call cache_store(). When the segment cannot
+ * be mapped, or SFE_CACHE=0, every lookup reports CACHE_OFF.
+ *
+ * The same generations version the data for HTTP validators: cache_etag()
+ * turns a key and its scopes' current generations into a strong ETag with
+ * two atomic loads, so a conditional GET is answered before any SQL.
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/response/response.h"
+
+/** @brief Segment path used when SFE_CACHE_FILE is unset. */
+#define CACHE_DEFAULT_FILE "/dev/shm/sfe_cache"
+
+/** @brief Entry slots (power of two); keys map to one slot each. */
+#define CACHE_SLOTS 256
+
+/** @brief Room for one entry's key and payload; larger ones are not kept. */
+#define CACHE_ENTRY_SIZE 65536
+
+/** @brief Generation counters (power of two) that scopes hash into. */
+#define CACHE_GENERATIONS 4096
+
+/** @brief Scopes one entry may depend on. */
+#define CACHE_MAX_SCOPES 2
+
+/** @brief Longest wait for another process filling the same entry. */
+#define CACHE_WAIT_MS 2000
+
+/** @brief Room for a tag from cache_etag(): quotes, 16 hex digits, NUL. */
+#define CACHE_ETAG_SIZE 19
+
+/**
+ * @enum cache_scope_kind
+ * @brief Kinds of data a cached response can be computed from.
+ */
+typedef enum cache_scope_kind {
+        CACHE_SCOPE_POSTS   = 0, /**< Any post (bodies, search index) */
+        CACHE_SCOPE_THREADS = 1, /**< The thread list and its counts */
+        CACHE_SCOPE_THREAD  = 2  /**< One thread and its posts, by id */
+} cache_scope_kind_t;
+
+/**
+ * @struct cache_scope_t
+ * @brief One scope an entry depends on.
+ */
+typedef struct {
+        cache_scope_kind_t kind; /**< Kind of data */
+        int64_t id;              /**< Thread id, 0 for forum-wide kinds */
+} cache_scope_t;
+
+/**
+ * @enum cache_status
+ * @brief Outcome of cache_lookup().
+ */
+typedef enum cache_status {
+        CACHE_OFF  = 0, /**< No cache; compute and send as usual */
+        CACHE_HIT  = 1, /**< The response was filled from the cache */
+        CACHE_MISS = 2  /**< Compute, then call cache_store() */
+} cache_status_t;
+
+/**
+ * @struct cache_entry_t
+ * @brief State of one lookup, from cache_lookup() to cache_store().
+ */
+typedef struct {
+        const char* key;                 /**< Normalized key (borrowed) */
+        size_t key_len;                  /**< Length of key */
+        uint64_t hash;                   /**< Hash of key */
+        uint32_t slot;                   /**< Entry slot of key */
+        size_t scope_count;              /**< Scopes in gens */
+        uint64_t gens[CACHE_MAX_SCOPES]; /**< Generations before computing */
+        bool locked;                     /**< Fill lock held by this process */
+} cache_entry_t;
+
+/**
+ * @brief Serve a response from the cache, or claim the right to fill it.
+ *
+ * On a hit @p resp is re-initialized with the cached status and payload
+ * and an "X-Cache: HIT" header. On a miss the caller holds the entry's fill
+ * lock (unless waiting for another filler timed out) and must end with
+ * cache_store() or cache_release(). An endpoint must pass the same scopes
+ * for every request with the same key.
+ *
+ * @param entry Lookup state to fill.
+ * @param key Endpoint plus normalized query, e.g. "search\n0\n20\nfoo";
+ * must stay valid until cache_store().
+ * @param scopes Scopes the response is computed from.
+ * @param scope_count Number of scopes (at most CACHE_MAX_SCOPES).
+ * @param resp Response to fill on a hit.
+ * @return CACHE_HIT, CACHE_MISS or CACHE_OFF.
+ */
+cache_status_t cache_lookup(cache_entry_t* entry, const char* key,
+                            const cache_scope_t* scopes, size_t scope_count,
+                            response_t* resp);
+
+/**
+ * @brief Save a computed response and release the fill lock.
+ *
+ * Only 200 responses that fit CACHE_ENTRY_SIZE are kept. Adds an
+ * "X-Cache: MISS" header, so call it after the final response_init().
+ *
+ * @param entry State from a cache_lookup() that returned CACHE_MISS.
+ * @param resp Response about to be sent.
+ */
+void cache_store(cache_entry_t* entry, response_t* resp);
+
+/**
+ * @brief Release the fill lock without storing; safe to call repeatedly.
+ * @param entry Lookup state (nullable).
+ */
+void cache_release(cache_entry_t* entry);
+
+/**
+ * @brief Turn every entry computed from a scope into a miss.
+ *
+ * Call after the change is committed: a reader that computed from the old
+ * data then always sees a newer generation. Writes inside a caller's
+ * transaction must be invalidated again after its COMMIT.
+ *
+ * @param kind Kind of data changed.
+ * @param id Thread id for CACHE_SCOPE_THREAD, otherwise 0.
+ */
+void cache_invalidate(cache_scope_kind_t kind, int64_t id);
+
+/**
+ * @brief Strong ETag of a response, from its key and scopes' generations.
+ *
+ * The tag changes whenever a writer invalidates one of the scopes, and
+ * also whenever the segment is recreated (each segment has its own epoch),
+ * so a tag is never reused for different data. Read the tag before
+ * computing the response: a write landing in between then leaves the
+ * response with an older tag, which only costs the client a full reply.
+ *
+ * @param key Endpoint plus normalized query, as for cache_lookup().
+ * @param scopes Scopes the response is computed from.
+ * @param scope_count Number of scopes (at most CACHE_MAX_SCOPES).
+ * @param out Receives the tag, quotes included.
+ * @return false if caching is off; then send no ETag.
+ */
+bool cache_etag(const char* key, const cache_scope_t* scopes,
+                size_t scope_count, char out[CACHE_ETAG_SIZE]);
+
+#endif// CACHE_H_
@@ -0,0 +1,67 @@
+/**
+ * @file ct_memeq.c
+ * @brief Word-wide constant-time equality check.
+ *
+ * Differences are OR-accumulated without data-dependent branches, 16 bytes
+ * at a time with SSE2 when available, then 8 bytes at a time, then a byte
+ * tail. An empty asm barrier keeps optimizing compilers from turning the
+ * accumulation into an early exit.
+ */
+
+#include "ct_memeq.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define CT_BARRIER(x) __asm__ __volatile__("" : "+r"(x))
+#else
+#define CT_BARRIER(x) ((void)0)
+#endif
+
+/**
+ * @brief Compare two buffers in constant time.
+ *
+ * @param a   First buffer.
+ * @param b   Second buffer.
+ * @param len Number of bytes to compare.
+ * @return true if the buffers are equal, false otherwise.
+ */
+bool ct_memeq(const void* a, const void* b, size_t len) {
+        const unsigned char* p1 = (const unsigned char*)a;
+        const unsigned char* p2 = (const unsigned char*)b;
+        uint64_t diff           = 0;
+        size_t i                = 0;
+
+#if defined(__SSE2__)
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(p1 + i));
+                __m128i y = _mm_loadu_si128((const __m128i*)(p2 + i));
+                acc       = _mm_or_si128(acc, _mm_xor_si128(x, y));
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        diff = lanes[0] | lanes[1];
+#endif
+
+        for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+                uint64_t x, y;
+                memcpy(&x, p1 + i, sizeof(x));
+                memcpy(&y, p2 + i, sizeof(y));
+                diff |= x ^ y;
+                CT_BARRIER(diff);
+        }
+
+        for (; i < len; ++i) {
+                diff |= (uint64_t)(p1[i] ^ p2[i]);
+                CT_BARRIER(diff);
+        }
+
+        /* 1 iff diff == 0, computed without a branch. */
+        return (bool)((((diff | (0 - diff)) >> 63) ^ 1) & 1);
+}
@@ -0,0 +1,27 @@
+/**
+ * @file ct_memeq.h
+ * @brief Constant-time equality check for secrets such as MACs.
+ *
+ * Unlike memcmp(), the running time depends only on the length, never on
+ * where (or whether) the buffers differ, and the result is an equality flag
+ * rather than an ordering. Use it only where timing must not leak; plain
+ * comparisons should keep using libc's memcmp().
+ */
+
+#ifndef CT_MEMEQ_H_
+#define CT_MEMEQ_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Compare two buffers in constant time.
+ *
+ * @param a   First buffer.
+ * @param b   Second buffer.
+ * @param len Number of bytes to compare.
+ * @return true if the buffers are equal, false otherwise.
+ */
+bool ct_memeq(const void* a, const void* b, size_t len);
+
+#endif// CT_MEMEQ_H_
@@ -0,0 +1,388 @@
+#include "db.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/**
+ * @file db.c
+ * @brief Connection setup, busy handling and per-statement profiling
+ *
+ * db_open() hooks sqlite3_trace_v2(SQLITE_TRACE_PROFILE), plus STMT and ROW
+ * events for timing and row counts. Every finished statement is reported to
+ * the metrics segment under its normalized text, with its run time, result
+ * rows and the full-scan and sort counters SQLite keeps per statement.
+ * Statements slower than SFE_SLOW_SQL_MS are remembered and written to the
+ * slow log, together with their EXPLAIN QUERY PLAN, when the connection is
+ * closed with db_close(), so the plan query never runs inside a trace
+ * callback.
+ *
+ * Each open connection has a db_conn_t holding its request deadline; the
+ * busy and progress handlers get it as their context.
+ */
+
+/**
+ * @struct db_running_t
+ * @brief Start time and rows so far of a statement that is still running.
+ */
+typedef struct {
+        sqlite3_stmt* stmt; /**< Running statement, NULL if unused */
+        uint64_t start_ns;  /**< Monotonic time of SQLITE_TRACE_STMT */
+        uint64_t rows;      /**< SQLITE_TRACE_ROW events seen */
+} db_running_t;
+
+/**
+ * @struct db_slow_t
+ * @brief A slow statement waiting for db_close().
+ */
+typedef struct {
+        sqlite3* db;                /**< Connection it ran on */
+        char sql[DB_SLOW_SQL_SIZE]; /**< Original SQL text */
+        uint64_t dur_ns;            /**< Execution time */
+        uint64_t rows;              /**< Result rows */
+        int fullscan_steps;         /**< SQLITE_STMTSTATUS_FULLSCAN_STEP */
+        int sorts;                  /**< SQLITE_STMTSTATUS_SORT */
+} db_slow_t;
+
+/**
+ * @struct db_conn_t
+ * @brief Per-connection state for the busy and progress handlers.
+ */
+typedef struct {
+        sqlite3* db;                /**< Connection, NULL if unused */
+        const deadline_t* deadline; /**< Request deadline (nullable) */
+} db_conn_t;
+
+/** @brief Open connections. */
+static db_conn_t conns[DB_MAX_CONNECTIONS];
+
+/** @brief Statements being stepped concurrently. */
+static db_running_t running[DB_MAX_ACTIVE_STMTS];
+
+/** @brief Slowest statements not yet logged. */
+static db_slow_t slow[DB_SLOW_MAX];
+static size_t slow_count = 0;
+
+/** @brief Slow threshold in ns, or -1 when the slow log is off. */
+static int64_t slow_threshold_ns = -1;
+
+/**
+ * @brief Find the state of an open connection
+ * @param db Connection
+ * @return State, or NULL if all DB_MAX_CONNECTIONS entries were in use
+ * when it was opened
+ */
+static db_conn_t* db_conn(sqlite3* db) {
+        for (size_t i = 0; i < DB_MAX_CONNECTIONS; ++i)
+                if (conns[i].db == db) return &conns[i];
+        return NULL;
+}
+
+/**
+ * @brief sqlite3 busy handler: back off and retry a bounded number of times
+ * @param ctx db_conn_t of the connection (nullable)
+ * @param retries Number of times the handler ran for this lock
+ * @return Non-zero to retry, zero to let the statement fail with
+ * SQLITE_BUSY
+ */
+static int db_busy_handler(void* ctx, int retries) {
+        db_conn_t* conn = ctx;
+        if (retries >= DB_BUSY_MAX_RETRIES) return 0;
+
+        useconds_t sleep_us = 1000u << retries;
+        if (sleep_us > DB_BUSY_MAX_SLEEP_US) sleep_us = DB_BUSY_MAX_SLEEP_US;
+
+        uint64_t left_ns = deadline_remaining_ns(conn ? conn->deadline : NULL);
+        if (left_ns == 0) return 0;
+        if (left_ns / 1000 < sleep_us) sleep_us = (useconds_t)(left_ns / 1000);
+
+        metrics_count_sqlite_busy();
+        usleep(sleep_us);
+        return 1;
+}
+
+/**
+ * @brief sqlite3 progress handler: interrupt statements past the deadline
+ * @param ctx db_conn_t of the connection
+ * @return Non-zero to interrupt the running statement
+ */
+static int db_progress_handler(void* ctx) {
+        const db_conn_t* conn = ctx;
+        return deadline_expired(conn->deadline);
+}
+
+/**
+ * @brief Collapse whitespace runs to single spaces and trim the ends
+ * @param sql Statement text
+ * @param out Output buffer
+ * @param cap Capacity of @p out (truncates)
+ */
+static void db_normalize_sql(const char* sql, char* out, size_t cap) {
+        size_t len = 0;
+        bool space = false;
+        for (; *sql && len + 1 < cap; ++sql) {
+                if (isspace((unsigned char)*sql)) {
+                        space = len > 0;
+                        continue;
+                }
+                if (space && len + 2 < cap) out[len++] = ' ';
+                space      = false;
+                out[len++] = *sql;
+        }
+        out[len] = '\0';
+}
+
+/**
+ * @brief Find the entry of a running statement
+ * @param stmt Statement
+ * @param create Claim a free entry if the statement has none
+ * @return Entry, or NULL
+ */
+static db_running_t* db_running(sqlite3_stmt* stmt, bool create) {
+        db_running_t* free_slot = NULL;
+        for (size_t i = 0; i < DB_MAX_ACTIVE_STMTS; ++i) {
+                if (running[i].stmt == stmt) return &running[i];
+                if (!running[i].stmt && !free_slot) free_slot = &running[i];
+        }
+        if (!create || !free_slot) return NULL;
+        free_slot->stmt     = stmt;
+        free_slot->start_ns = timing_now_ns();
+        free_slot->rows     = 0;
+        return free_slot;
+}
+
+/**
+ * @brief Remember a slow statement for db_close()
+ *
+ * When the list is full the fastest entry is replaced, so the slowest
+ * DB_SLOW_MAX statements of the request are kept.
+ *
+ * @param stmt Statement
+ * @param dur_ns Execution time
+ * @param rows Result rows
+ * @param fullscan Full-scan steps
+ * @param sorts Sorts
+ */
+static void db_remember_slow(sqlite3_stmt* stmt, uint64_t dur_ns,
+                             uint64_t rows, int fullscan, int sorts) {
+        db_slow_t* s = NULL;
+        if (slow_count < DB_SLOW_MAX) {
+                s = &slow[slow_count++];
+        } else {
+                for (size_t i = 0; i < DB_SLOW_MAX; ++i)
+                        if (!s || slow[i].dur_ns < s->dur_ns) s = &slow[i];
+                if (s->dur_ns >= dur_ns) return;
+        }
+
+        s->db = sqlite3_db_handle(stmt);
+        snprintf(s->sql, sizeof(s->sql), "%s", sqlite3_sql(stmt));
+        s->dur_ns         = dur_ns;
+        s->rows           = rows;
+        s->fullscan_steps = fullscan;
+        s->sorts          = sorts;
+}
+
+/**
+ * @brief sqlite3_trace_v2 callback: time statements and count their rows
+ *
+ * SQLITE_TRACE_PROFILE's own figure comes from the VFS clock, which has
+ * millisecond resolution, so statements are timed with the monotonic clock
+ * from SQLITE_TRACE_STMT instead.
+ *
+ * @param type SQLITE_TRACE_STMT, SQLITE_TRACE_ROW or SQLITE_TRACE_PROFILE
+ * @param ctx Unused
+ * @param p Statement
+ * @param x Execution time in ns for SQLITE_TRACE_PROFILE
+ * @return Always 0
+ */
+static int db_trace(unsigned type, void* ctx, void* p, void* x) {
+        (void)ctx;
+        sqlite3_stmt* stmt = p;
+
+        if (type == SQLITE_TRACE_STMT) {
+                db_running(stmt, true);
+                return 0;
+        }
+        if (type == SQLITE_TRACE_ROW) {
+                db_running_t* r = db_running(stmt, true);
+                if (r) ++r->rows;
+                return 0;
+        }
+        if (type != SQLITE_TRACE_PROFILE) return 0;
+
+        uint64_t dur_ns = (uint64_t)*(sqlite3_int64*)x;
+        uint64_t rows   = 0;
+        db_running_t* r = db_running(stmt, false);
+        if (r) {
+                dur_ns  = timing_now_ns() - r->start_ns;
+                rows    = r->rows;
+                r->stmt = NULL;
+        }
+        int fullscan =
+            sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+        int sorts = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+
+        const char* sql = sqlite3_sql(stmt);
+        if (!sql) return 0;
+
+        char normalized[METRICS_SQL_SIZE];
+        db_normalize_sql(sql, normalized, sizeof(normalized));
+        metrics_observe_statement(normalized, dur_ns, rows,
+                                  (uint64_t)fullscan, (uint64_t)sorts);
+
+        if (slow_threshold_ns >= 0 && dur_ns >= (uint64_t)slow_threshold_ns)
+                db_remember_slow(stmt, dur_ns, rows, fullscan, sorts);
+        return 0;
+}
+
+/**
+ * @brief Write one slow statement and its query plan to the slow log
+ * @param log Slow log stream
+ * @param s Slow statement
+ */
+static void db_log_slow(FILE* log, const db_slow_t* s) {
+        char normalized[DB_SLOW_SQL_SIZE];
+        db_normalize_sql(s->sql, normalized, sizeof(normalized));
+        fprintf(log,
+                "sfe: slow_sql %.3fms rows=%llu fullscan_steps=%d sorts=%d "
+                "sql=\"%s\"\n",
+                (double)s->dur_ns / 1e6, (unsigned long long)s->rows,
+                s->fullscan_steps, s->sorts, normalized);
+
+        char plan_sql[DB_SLOW_SQL_SIZE + 32];
+        snprintf(plan_sql, sizeof(plan_sql), "EXPLAIN QUERY PLAN %s", s->sql);
+
+        sqlite3_stmt* plan = NULL;
+        if (sqlite3_prepare_v2(s->db, plan_sql, -1, &plan, NULL) !=
+            SQLITE_OK) {
+                fprintf(log, "sfe: slow_sql plan unavailable: %s\n",
+                        sqlite3_errmsg(s->db));
+                return;
+        }
+        while (sqlite3_step(plan) == SQLITE_ROW) {
+                const char* detail = (const char*)sqlite3_column_text(plan, 3);
+                fprintf(log, "sfe: slow_sql plan: %s\n",
+                        detail ? detail : "?");
+        }
+        sqlite3_finalize(plan);
+}
+
+/**
+ * @brief Open a database connection
+ * @param path Database file
+ * @param out_db Pointer to store the connection (caller must db_close)
+ * @return result_t indicating success or failure
+ */
+result_t db_open(const char* path, sqlite3** out_db) {
+        if (out_db) {
+                *out_db = NULL;
+        }
+
+        if (!path || !out_db) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "path=%p, out_db=%p",
+                                 (const void*)path, (const void*)out_db);
+                return res;
+        }
+
+        sqlite3* db = NULL;
+        if (sqlite3_open(path, &db) != SQLITE_OK) {
+                result_t res = result_critical_failure(
+                    "Failed to open database", NULL, ERR_DB_OPEN_FAIL);
+                result_add_extra(&res, "path=%s, sqlite_error=%s", path,
+                                 db ? sqlite3_errmsg(db) : "out of memory");
+                sqlite3_close(db);
+                return res;
+        }
+
+        db_conn_t* conn = db_conn(NULL);
+        if (conn) conn->db = db;
+        sqlite3_busy_handler(db, db_busy_handler, conn);
+
+        const char* threshold = getenv("SFE_SLOW_SQL_MS");
+        double threshold_ms =
+            threshold && *threshold ? strtod(threshold, NULL)
+                                    : DB_SLOW_DEFAULT_MS;
+        slow_threshold_ns =
+            threshold_ms < 0 ? -1 : (int64_t)(threshold_ms * 1e6);
+
+        if (slow_threshold_ns >= 0 || metrics_enabled()) {
+                sqlite3_trace_v2(db,
+                                 SQLITE_TRACE_STMT | SQLITE_TRACE_ROW |
+                                     SQLITE_TRACE_PROFILE,
+                                 db_trace, NULL);
+        }
+
+        *out_db = db;
+        return result_success();
+}
+
+/**
+ * @brief Close a connection opened with db_open(), writing its slow log
+ * @param db Connection (nullable)
+ */
+void db_close(sqlite3* db) {
+        if (!db) return;
+
+        sqlite3_trace_v2(db, 0, NULL, NULL);
+
+        db_conn_t* conn = db_conn(db);
+        if (conn) *conn = (db_conn_t){0};
+
+        FILE* log   = NULL;
+        size_t kept = 0;
+        for (size_t i = 0; i < slow_count; ++i) {
+                if (slow[i].db != db) {
+                        slow[kept++] = slow[i];
+                        continue;
+                }
+                if (!log) {
+                        const char* path = getenv("SFE_SLOW_SQL_LOG");
+                        log = path && *path ? fopen(path, "a") : NULL;
+                        if (!log) log = stderr;
+                }
+                db_log_slow(log, &slow[i]);
+        }
+        slow_count = kept;
+        if (log && log != stderr) fclose(log);
+
+        sqlite3_close(db);
+}
+
+/**
+ * @brief Bound every later statement on a connection by a request deadline
+ * @param db Connection from db_open()
+ * @param deadline Request deadline; must outlive the connection (nullable
+ * to remove it)
+ */
+void db_set_deadline(sqlite3* db, const deadline_t* deadline) {
+        db_conn_t* conn = db ? db_conn(db) : NULL;
+        if (!conn) return;
+
+        conn->deadline = deadline;
+        if (deadline && deadline->at_ns)
+                sqlite3_progress_handler(db, DB_PROGRESS_STEPS,
+                                         db_progress_handler, conn);
+        else
+                sqlite3_progress_handler(db, 0, NULL, NULL);
+}
+
+/**
+ * @brief Whether a failed sqlite3_step() was stopped by the deadline
+ * @param db Connection
+ * @param rc Return code of the step
+ * @return true for SQLITE_INTERRUPT, or SQLITE_BUSY/SQLITE_LOCKED after the
+ * connection's deadline passed
+ */
+bool db_deadline_hit(sqlite3* db, int rc) {
+        if (rc == SQLITE_INTERRUPT) return true;
+        if (rc != SQLITE_BUSY && rc != SQLITE_LOCKED) return false;
+        db_conn_t* conn = db ? db_conn(db) : NULL;
+        return conn && conn->deadline && deadline_expired(conn->deadline);
+}
@@ -0,0 +1,109 @@
+#ifndef DAL_DB_H
+#define DAL_DB_H
+
+#include <sqlite3.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/deadline/deadline.h"
+#include "/app/backend/lib/result/result.h"
+
+/**
+ * @file db.h
+ * @brief Opening and closing database connections with the backend's
+ * shared settings: busy handling, statement profiling and the slow log
+ */
+
+/** @brief SQLITE_BUSY retries before a statement gives up. */
+#define DB_BUSY_MAX_RETRIES 10
+
+/** @brief Longest single back-off between SQLITE_BUSY retries. */
+#define DB_BUSY_MAX_SLEEP_US 50000
+
+/** @brief Slow-log threshold when SFE_SLOW_SQL_MS is unset. */
+#define DB_SLOW_DEFAULT_MS 100
+
+/** @brief Slow statements remembered per process until db_close(). */
+#define DB_SLOW_MAX 8
+
+/** @brief Longest SQL text kept for the slow log. */
+#define DB_SLOW_SQL_SIZE 1024
+
+/** @brief Statements whose result rows can be counted at the same time. */
+#define DB_MAX_ACTIVE_STMTS 8
+
+/** @brief Connections per process that can carry a deadline. */
+#define DB_MAX_CONNECTIONS 4
+
+/** @brief Virtual machine steps between deadline checks. */
+#define DB_PROGRESS_STEPS 1000
+
+/** @brief Largest page a listing function returns. */
+#define DB_PAGE_MAX 100
+
+/**
+ * @struct db_cursor_t
+ * @brief Keyset pagination position: the sort key of a page's last row
+ *
+ * Listings continue strictly after (or before, for newest-first listings)
+ * this key, so every page is one index seek plus LIMIT rows, however deep
+ * it is.
+ */
+typedef struct {
+        int64_t created_at; /**< created_at of the last row returned */
+        int64_t id;         /**< id of the last row, breaks created_at ties */
+} db_cursor_t;
+
+/**
+ * @brief Open a database connection
+ *
+ * Installs a busy handler that retries with exponential back-off (1 ms,
+ * doubling, capped at DB_BUSY_MAX_SLEEP_US) and counts every retry in the
+ * metrics segment.
+ *
+ * Also profiles every statement run on the connection (see db.c). The slow
+ * log is configured through the environment:
+ *  - SFE_SLOW_SQL_MS: threshold in ms (default DB_SLOW_DEFAULT_MS, negative
+ *    disables the slow log)
+ *  - SFE_SLOW_SQL_LOG: file to append to (default stderr)
+ *
+ * @param path Database file
+ * @param out_db Pointer to store the connection (caller must db_close)
+ * @return result_t indicating success or failure
+ */
+result_t db_open(const char* path, sqlite3** out_db);
+
+/**
+ * @brief Close a connection opened with db_open()
+ *
+ * Writes the connection's slow statements, each followed by its
+ * EXPLAIN QUERY PLAN, to the slow log before closing.
+ *
+ * @param db Connection (nullable)
+ */
+void db_close(sqlite3* db);
+
+/**
+ * @brief Bound every later statement on a connection by a request deadline
+ *
+ * Installs a progress handler that interrupts a running statement once the
+ * deadline passes, and makes the busy handler stop retrying at the deadline
+ * (sleeps are clamped to the time left), so lock waits are bounded too.
+ *
+ * @param db Connection from db_open()
+ * @param deadline Request deadline; must outlive the connection (nullable
+ * to remove it)
+ */
+void db_set_deadline(sqlite3* db, const deadline_t* deadline);
+
+/**
+ * @brief Whether a failed sqlite3_step() was stopped by the deadline
+ * @param db Connection
+ * @param rc Return code of the step
+ * @return true for SQLITE_INTERRUPT, or SQLITE_BUSY/SQLITE_LOCKED after the
+ * connection's deadline passed; callers report ERR_DEADLINE_EXCEEDED
+ */
+bool db_deadline_hit(sqlite3* db, int rc);
+
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
+
+#endif// DAL_DB_H
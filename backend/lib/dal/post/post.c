@@ -0,0 +1,934 @@
+#include "post.h"
+
+#include <sqlite3.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "/app/backend/lib/cache/cache.h"
+#include "/app/backend/lib/livefeed/livefeed.h"
+#include "/app/backend/lib/markdown/markdown.h"
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/**
+ * @brief Release a partially built post according to its allocator.
+ * @param post Post to release (nullable)
+ * @param arena Arena the post was allocated from (nullable)
+ */
+static void discard_post(post_t* post, arena_t* arena) {
+        if (!arena) post_free(post);
+}
+
+/** @brief Columns read by post_from_row(), in order. */
+#define POST_COLUMNS                                                      \
+        "id, thread_id, user_id, body, created_at, COALESCE(parent_id, 0), " \
+        "depth, body_html"
+
+/**
+ * @brief Copy the current row (POST_COLUMNS) into a post
+ * @param stmt Statement positioned on a row
+ * @param post Post to fill
+ * @param arena Arena for the body and its HTML (nullable)
+ * @return false if the body or its HTML could not be allocated; neither is
+ * then left allocated
+ */
+static bool post_from_row(sqlite3_stmt* stmt, post_t* post, arena_t* arena) {
+        post->id         = sqlite3_column_int(stmt, 0);
+        post->thread_id  = sqlite3_column_int(stmt, 1);
+        post->user_id    = sqlite3_column_int(stmt, 2);
+        const char* body = (const char*)sqlite3_column_text(stmt, 3);
+        post->created_at = sqlite3_column_int64(stmt, 4);
+        post->parent_id  = sqlite3_column_int(stmt, 5);
+        post->depth      = sqlite3_column_int(stmt, 6);
+        post->body       = arena_strdup(arena, body ? body : "");
+        const char* html = (const char*)sqlite3_column_text(stmt, 7);
+        post->body_html  = arena_strdup(arena, html ? html : "");
+        if (post->body && post->body_html) return true;
+
+        arena_free(arena, post->body);
+        arena_free(arena, post->body_html);
+        post->body      = NULL;
+        post->body_html = NULL;
+        return false;
+}
+
+/**
+ * @brief Insert a new post into an existing thread
+ * @param db SQLite database connection
+ * @param post Pointer to post_t with thread_id, user_id, body and parent_id
+ * filled; created_at of 0 means now
+ * @param out_post Pointer to store inserted post with generated ID and
+ * rendered body (owned by @p arena, or caller must free when @p arena is
+ * NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_insert_impl(sqlite3* db, const post_t* post,
+                                 post_t** out_post, arena_t* arena) {
+        if (out_post) {
+                *out_post = NULL;
+        }
+
+        if (!db || !post || !post->body || !out_post) {
+                result_t res = result_failure("Invalid input parameters", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, post=%p, body=%p, out_post=%p",
+                                 (const void*)db, (const void*)post,
+                                 post ? (const void*)post->body : NULL,
+                                 (const void*)out_post);
+                return res;
+        }
+
+        size_t body_len = strlen(post->body);
+        if (body_len > MARKDOWN_MAX_INPUT) {
+                result_t res = result_failure("Post body too long", NULL,
+                                              ERR_MARKDOWN_TOO_LARGE);
+                result_add_extra(&res, "len=%zu", body_len);
+                return res;
+        }
+
+        /* Rendered once here and stored with the version that produced it,
+         * so reads serve body_html as is. The buffer becomes the output
+         * post's body_html. */
+        size_t html_cap = markdown_bound(body_len);
+        char* html      = arena_alloc(arena, html_cap);
+        if (!html) {
+                return result_critical_failure(
+                    "Failed to allocate memory for post HTML", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+        }
+        size_t html_len = 0;
+        result_t rendered =
+            markdown_render(post->body, body_len, html, html_cap, &html_len);
+        if (rendered.code != RESULT_SUCCESS) {
+                arena_free(arena, html);
+                return rendered;
+        }
+
+        /* The thread and parent checks ride along with the insert: no row
+         * is written, and no second statement runs, when either is missing.
+         * A reply to a post at POST_MAX_DEPTH goes to that post's parent,
+         * so it lands next to it instead of one level deeper. The
+         * posts_path trigger then fills in the path. */
+        const char* sql =
+            "INSERT INTO posts (thread_id, user_id, body, created_at, "
+            "parent_id, depth, body_html, render_version) "
+            "SELECT ?1, ?2, ?3, ?4, "
+            "CASE WHEN p.depth >= ?6 THEN p.parent_id ELSE p.id END, "
+            "CASE WHEN p.id IS NULL THEN 0 WHEN p.depth >= ?6 THEN p.depth "
+            "ELSE p.depth + 1 END, ?7, ?8 "
+            "FROM threads t LEFT JOIN posts p "
+            "ON p.id = ?5 AND p.thread_id = t.id "
+            "WHERE t.id = ?1 AND (?5 = 0 OR p.id IS NOT NULL) "
+            "RETURNING id, COALESCE(parent_id, 0), depth;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_critical_failure("Failed to prepare SQL statement",
+                                            NULL, ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                arena_free(arena, html);
+                return res;
+        }
+
+        int64_t created_at =
+            post->created_at ? post->created_at : (int64_t)time(NULL);
+        sqlite3_bind_int(stmt, 1, post->thread_id);
+        sqlite3_bind_int(stmt, 2, post->user_id);
+        sqlite3_bind_text(stmt, 3, post->body, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 4, created_at);
+        sqlite3_bind_int(stmt, 5, post->parent_id);
+        sqlite3_bind_int(stmt, 6, POST_MAX_DEPTH);
+        sqlite3_bind_text(stmt, 7, html, (int)html_len, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 8, MARKDOWN_VERSION);
+
+        int id = 0, parent_id = 0, depth = 0;
+        rc     = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW) {
+                id        = sqlite3_column_int(stmt, 0);
+                parent_id = sqlite3_column_int(stmt, 1);
+                depth     = sqlite3_column_int(stmt, 2);
+                rc        = sqlite3_step(stmt);
+        }
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in INSERT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                arena_free(arena, html);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                arena_free(arena, html);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (id == 0 && post->parent_id != 0) {
+                result_t res = result_failure("Parent post not found", NULL,
+                                              ERR_POST_NOT_FOUND);
+                result_add_extra(&res, "thread_id=%d, parent_id=%d",
+                                 post->thread_id, post->parent_id);
+                arena_free(arena, html);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (id == 0) {
+                result_t res = result_failure("Thread not found", NULL,
+                                              ERR_THREAD_NOT_FOUND);
+                result_add_extra(&res, "thread_id=%d", post->thread_id);
+                arena_free(arena, html);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        /* The post is committed; the thread's counts changed too, and the
+         * live feed reads new posts when woken. */
+        cache_invalidate(CACHE_SCOPE_POSTS, 0);
+        cache_invalidate(CACHE_SCOPE_THREAD, post->thread_id);
+        cache_invalidate(CACHE_SCOPE_THREADS, 0);
+        livefeed_notify();
+
+        post_t* new_post = arena_alloc(arena, sizeof(post_t));
+        if (!new_post) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for post", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                arena_free(arena, html);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        new_post->id         = id;
+        new_post->thread_id  = post->thread_id;
+        new_post->user_id    = post->user_id;
+        new_post->created_at = created_at;
+        new_post->parent_id  = parent_id;
+        new_post->depth      = depth;
+        new_post->body       = arena_strdup(arena, post->body);
+        new_post->body_html  = html;
+
+        if (!new_post->body) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for post fields", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                discard_post(new_post, arena);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        *out_post = new_post;
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Fetch a post from the database by ID
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_post Pointer to store fetched post (owned by @p arena, or
+ * caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_fetch_by_id_impl(sqlite3* db, int id, post_t** out_post,
+                                      arena_t* arena) {
+        if (out_post) {
+                *out_post = NULL;
+        }
+
+        if (!db || !out_post) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_post=%p", (const void*)db,
+                                 (const void*)out_post);
+                return res;
+        }
+
+        const char* sql =
+            "SELECT " POST_COLUMNS " FROM posts WHERE id = ? LIMIT 1;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, id);
+
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW) {
+                post_t* post = arena_alloc(arena, sizeof(post_t));
+                if (!post) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for post", NULL,
+                            ERR_MEMORY_ALLOC_FAIL);
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+
+                if (!post_from_row(stmt, post, arena)) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for post fields", NULL,
+                            ERR_MEMORY_ALLOC_FAIL);
+                        discard_post(post, arena);
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+
+                *out_post = post;
+                sqlite3_finalize(stmt);
+                return result_success();
+        }
+
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in SELECT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        result_t res =
+            result_failure("Post not found", NULL, ERR_POST_NOT_FOUND);
+        result_add_extra(&res, "id=%d", id);
+        sqlite3_finalize(stmt);
+        return res;
+}
+
+/**
+ * @brief Fill a page from a prepared listing query
+ *
+ * The query must select POST_COLUMNS and ask for @p limit + 1 rows; the
+ * extra row only tells whether another page follows. Finalizes @p stmt.
+ *
+ * @param db SQLite database connection
+ * @param stmt Bound listing query
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t fill_page(sqlite3* db, sqlite3_stmt* stmt, int limit,
+                          post_page_t* out_page, arena_t* arena) {
+        post_t* items = arena_alloc(arena, sizeof(post_t) * (size_t)limit);
+        if (!items) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for post page", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        out_page->items = items;
+
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                if (out_page->count == (size_t)limit) {
+                        out_page->has_more = true;
+                        break;
+                }
+                if (!post_from_row(stmt, &items[out_page->count], arena)) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for post fields", NULL,
+                            ERR_MEMORY_ALLOC_FAIL);
+                        if (!arena) post_page_free(out_page);
+                        *out_page = (post_page_t){0};
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+                ++out_page->count;
+        }
+
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+                result_t res =
+                    db_deadline_hit(db, rc)
+                        ? result_failure("Deadline exceeded in SELECT", NULL,
+                                         ERR_DEADLINE_EXCEEDED)
+                        : result_failure("Failed to execute SQL statement",
+                                         NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                if (!arena) post_page_free(out_page);
+                *out_page = (post_page_t){0};
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        if (out_page->has_more) {
+                const post_t* last = &items[out_page->count - 1];
+                out_page->next =
+                    (db_cursor_t){.created_at = last->created_at,
+                                  .id         = last->id};
+        }
+
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief List a thread's posts oldest first, one keyset page at a time
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_list_by_thread_impl(sqlite3* db, int thread_id,
+                                         const db_cursor_t* after, int limit,
+                                         post_page_t* out_page,
+                                         arena_t* arena) {
+        if (out_page) {
+                *out_page = (post_page_t){0};
+        }
+
+        if (!db || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_page=%p", (const void*)db,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+
+        const char* sql =
+            "SELECT " POST_COLUMNS " FROM posts "
+            "WHERE thread_id = ? AND (created_at, id) > (?, ?) "
+            "ORDER BY created_at, id LIMIT ?;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, thread_id);
+        sqlite3_bind_int64(stmt, 2, after ? after->created_at : INT64_MIN);
+        sqlite3_bind_int64(stmt, 3, after ? after->id : INT64_MIN);
+        sqlite3_bind_int(stmt, 4, limit + 1);
+
+        return fill_page(db, stmt, limit, out_page, arena);
+}
+
+/**
+ * @brief List a thread's posts as a reply tree, one keyset page at a time
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param max_depth Deepest level listed; negative for all
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_list_tree_impl(sqlite3* db, int thread_id,
+                                    int max_depth, const db_cursor_t* after,
+                                    int limit, post_page_t* out_page,
+                                    arena_t* arena) {
+        if (out_page) {
+                *out_page = (post_page_t){0};
+        }
+
+        if (!db || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_page=%p", (const void*)db,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+        if (max_depth < 0 || max_depth > POST_MAX_DEPTH)
+                max_depth = POST_MAX_DEPTH;
+
+        /* The cursor resumes after the path of post ?3; every entry sorts
+         * after '' on the first page. */
+        const char* sql =
+            "SELECT " POST_COLUMNS " FROM posts "
+            "WHERE thread_id = ?1 AND depth <= ?2 AND path > CASE WHEN ?3 = 0 "
+            "THEN '' ELSE (SELECT path FROM posts WHERE id = ?3) END "
+            "ORDER BY path LIMIT ?4;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, thread_id);
+        sqlite3_bind_int(stmt, 2, max_depth);
+        sqlite3_bind_int64(stmt, 3, after ? after->id : 0);
+        sqlite3_bind_int(stmt, 4, limit + 1);
+
+        return fill_page(db, stmt, limit, out_page, arena);
+}
+
+/**
+ * @brief List a post and its replies as a tree, one keyset page at a time
+ * @param db SQLite database connection
+ * @param root_id Post whose subtree to list; it comes first
+ * @param max_depth Levels below the root listed; negative for all
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_list_subtree_impl(sqlite3* db, int root_id,
+                                       int max_depth,
+                                       const db_cursor_t* after, int limit,
+                                       post_page_t* out_page,
+                                       arena_t* arena) {
+        if (out_page) {
+                *out_page = (post_page_t){0};
+        }
+
+        if (!db || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_page=%p", (const void*)db,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+        if (max_depth < 0 || max_depth > POST_MAX_DEPTH)
+                max_depth = POST_MAX_DEPTH;
+
+        /* Path digits are lowercase hex, so every descendant of r sorts
+         * below r.path || 'g'. */
+        const char* sql =
+            "SELECT p.id, p.thread_id, p.user_id, p.body, p.created_at, "
+            "COALESCE(p.parent_id, 0), p.depth, p.body_html "
+            "FROM posts r JOIN posts p "
+            "ON p.thread_id = r.thread_id AND p.path >= r.path "
+            "AND p.path < r.path || 'g' "
+            "WHERE r.id = ?1 AND p.depth <= r.depth + ?2 AND p.path > CASE "
+            "WHEN ?3 = 0 THEN '' ELSE (SELECT path FROM posts WHERE id = ?3) "
+            "END ORDER BY p.path LIMIT ?4;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, root_id);
+        sqlite3_bind_int(stmt, 2, max_depth);
+        sqlite3_bind_int64(stmt, 3, after ? after->id : 0);
+        sqlite3_bind_int(stmt, 4, limit + 1);
+
+        result_t res = fill_page(db, stmt, limit, out_page, arena);
+        if (res.code != RESULT_SUCCESS) return res;
+
+        /* The root is always part of its own first page. */
+        if (!after && out_page->count == 0) {
+                res = result_failure("Post not found", NULL,
+                                     ERR_POST_NOT_FOUND);
+                result_add_extra(&res, "id=%d", root_id);
+                if (!arena) post_page_free(out_page);
+                *out_page = (post_page_t){0};
+        }
+        return res;
+}
+
+/**
+ * @brief List posts written after a given one, oldest first
+ * @param db SQLite database connection
+ * @param after_id Last post already seen; 0 for the first post
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t post_list_since_impl(sqlite3* db, int after_id, int limit,
+                                     post_page_t* out_page, arena_t* arena) {
+        if (out_page) {
+                *out_page = (post_page_t){0};
+        }
+
+        if (!db || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_page=%p", (const void*)db,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+
+        /* A range of the rowid itself: no index beyond the table. */
+        const char* sql = "SELECT " POST_COLUMNS " FROM posts "
+                          "WHERE id > ? ORDER BY id LIMIT ?;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, after_id);
+        sqlite3_bind_int(stmt, 2, limit + 1);
+
+        return fill_page(db, stmt, limit, out_page, arena);
+}
+
+/**
+ * @brief Id of the newest post
+ * @param db SQLite database connection
+ * @param out_id Set to the id, 0 when there are no posts
+ * @return result_t indicating success or failure
+ */
+static result_t post_last_id_impl(sqlite3* db, int* out_id) {
+        if (out_id) *out_id = 0;
+        if (!db || !out_id) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_id=%p", (const void*)db,
+                                 (const void*)out_id);
+                return res;
+        }
+
+        const char* sql    = "SELECT COALESCE(MAX(id), 0) FROM posts;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        rc = sqlite3_step(stmt);
+        if (rc != SQLITE_ROW) {
+                result_t res =
+                    db_deadline_hit(db, rc)
+                        ? result_failure("Deadline exceeded in SELECT", NULL,
+                                         ERR_DEADLINE_EXCEEDED)
+                        : result_failure("Failed to execute SQL statement",
+                                         NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        *out_id = sqlite3_column_int(stmt, 0);
+
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Free a page filled by a post listing without an arena
+ * @param page Page to release (nullable)
+ */
+void post_page_free(post_page_t* page) {
+        if (!page) return;
+        for (size_t i = 0; i < page->count; ++i) {
+                free(page->items[i].body);
+                free(page->items[i].body_html);
+        }
+        free(page->items);
+        *page = (post_page_t){0};
+}
+
+/**
+ * @brief Re-render posts whose HTML is older than MARKDOWN_VERSION
+ * @param db SQLite database connection
+ * @param batch Most posts re-rendered in this call
+ * @param out_rendered Set to the number of posts re-rendered
+ * @return result_t indicating success or failure
+ */
+result_t post_rerender_stale(sqlite3* db, int batch, int* out_rendered) {
+        if (out_rendered) *out_rendered = 0;
+        if (!db || batch <= 0 || !out_rendered) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, batch=%d, out_rendered=%p",
+                                 (const void*)db, batch,
+                                 (const void*)out_rendered);
+                return res;
+        }
+
+        if (sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) !=
+            SQLITE_OK) {
+                result_t res = result_failure("Failed to begin transaction",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        /* Rows leave the render_version range as soon as they are updated,
+         * so the select never returns a post twice. */
+        const char* select_sql =
+            "SELECT id, body, thread_id FROM posts WHERE render_version < ? "
+            "LIMIT ?;";
+        const char* update_sql =
+            "UPDATE posts SET body_html = ?, render_version = ? WHERE id = ?;";
+        sqlite3_stmt* select = NULL;
+        sqlite3_stmt* update = NULL;
+
+        int rc = sqlite3_prepare_v2(db, select_sql, -1, &select, NULL);
+        if (rc == SQLITE_OK)
+                rc = sqlite3_prepare_v2(db, update_sql, -1, &update, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(select);
+                sqlite3_finalize(update);
+                sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+                return res;
+        }
+
+        sqlite3_bind_int(select, 1, MARKDOWN_VERSION);
+        sqlite3_bind_int(select, 2, batch);
+        sqlite3_bind_int(update, 2, MARKDOWN_VERSION);
+
+        /* One buffer, grown to the largest post of the batch, serves every
+         * render. The threads touched are kept to invalidate their cached
+         * pages once the batch is committed. */
+        result_t res    = result_success();
+        char* html      = NULL;
+        size_t html_cap = 0;
+        int rendered    = 0;
+        int* threads    = malloc(sizeof(int) * (size_t)batch);
+        if (!threads)
+                res = result_critical_failure(
+                    "Failed to allocate memory for thread ids", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+        while (threads && (rc = sqlite3_step(select)) == SQLITE_ROW) {
+                const char* body = (const char*)sqlite3_column_text(select, 1);
+                size_t len       = (size_t)sqlite3_column_bytes(select, 1);
+                /* Only bodies written around post_insert() can be longer;
+                 * their leading MARKDOWN_MAX_INPUT bytes are rendered. */
+                if (len > MARKDOWN_MAX_INPUT) len = MARKDOWN_MAX_INPUT;
+
+                size_t need = markdown_bound(len);
+                if (need > html_cap) {
+                        char* grown = realloc(html, need);
+                        if (!grown) {
+                                res = result_critical_failure(
+                                    "Failed to allocate memory for post HTML",
+                                    NULL, ERR_MEMORY_ALLOC_FAIL);
+                                break;
+                        }
+                        html     = grown;
+                        html_cap = need;
+                }
+
+                size_t html_len = 0;
+                res = markdown_render(body ? body : "", len, html, html_cap,
+                                      &html_len);
+                if (res.code != RESULT_SUCCESS) break;
+
+                sqlite3_bind_text(update, 1, html, (int)html_len,
+                                  SQLITE_STATIC);
+                sqlite3_bind_int64(update, 3, sqlite3_column_int64(select, 0));
+                rc = sqlite3_step(update);
+                sqlite3_reset(update);
+                if (rc != SQLITE_DONE) break;
+                threads[rendered++] = sqlite3_column_int(select, 2);
+        }
+        if (res.code == RESULT_SUCCESS && rc != SQLITE_DONE) {
+                res = result_failure("Failed to execute SQL statement", NULL,
+                                     ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+        }
+        sqlite3_finalize(select);
+        sqlite3_finalize(update);
+        free(html);
+
+        if (res.code == RESULT_SUCCESS &&
+            sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+                res = result_failure("Failed to commit transaction", NULL,
+                                     ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+        }
+        if (res.code != RESULT_SUCCESS) {
+                sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+                free(threads);
+                return res;
+        }
+
+        for (int i = 0; i < rendered; ++i)
+                cache_invalidate(CACHE_SCOPE_THREAD, threads[i]);
+        if (rendered > 0) cache_invalidate(CACHE_SCOPE_POSTS, 0);
+        free(threads);
+
+        *out_rendered = rendered;
+        return res;
+}
+
+/**
+ * @brief Insert a new post, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param post Pointer to post_t with thread_id, user_id and body filled
+ * @param out_post Pointer to store inserted post with generated ID
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_insert(sqlite3* db, const post_t* post, post_t** out_post,
+                     arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_insert_impl(db, post, out_post, arena);
+        metrics_observe_dal("post_insert", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Fetch a post by ID, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_post Pointer to store fetched post
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_fetch_by_id(sqlite3* db, int id, post_t** out_post,
+                          arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_fetch_by_id_impl(db, id, out_post, arena);
+        metrics_observe_dal("post_by_id", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief List a page of a thread's posts, recording the call duration in
+ * the metrics segment
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param after Cursor from the previous page, NULL for the first page
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_by_thread(sqlite3* db, int thread_id,
+                             const db_cursor_t* after, int limit,
+                             post_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_list_by_thread_impl(db, thread_id, after, limit,
+                                                  out_page, arena);
+        metrics_observe_dal("post_list", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief List a page of a thread's reply tree, recording the call duration
+ * in the metrics segment
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param max_depth Deepest level listed; negative for all
+ * @param after Cursor from the previous page, NULL for the first page
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_tree(sqlite3* db, int thread_id, int max_depth,
+                        const db_cursor_t* after, int limit,
+                        post_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_list_tree_impl(db, thread_id, max_depth, after,
+                                             limit, out_page, arena);
+        metrics_observe_dal("post_tree", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief List a page of a post's subtree, recording the call duration in
+ * the metrics segment
+ * @param db SQLite database connection
+ * @param root_id Post whose subtree to list
+ * @param max_depth Levels below the root listed; negative for all
+ * @param after Cursor from the previous page, NULL for the first page
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_subtree(sqlite3* db, int root_id, int max_depth,
+                           const db_cursor_t* after, int limit,
+                           post_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_list_subtree_impl(db, root_id, max_depth, after,
+                                                limit, out_page, arena);
+        metrics_observe_dal("post_subtree", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief List posts written after a given one, recording the call duration
+ * in the metrics segment
+ * @param db SQLite database connection
+ * @param after_id Last post already seen; 0 for the first post
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_since(sqlite3* db, int after_id, int limit,
+                         post_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res =
+            post_list_since_impl(db, after_id, limit, out_page, arena);
+        metrics_observe_dal("post_since", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Id of the newest post, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param out_id Set to the id, 0 when there are no posts
+ * @return result_t indicating success or failure
+ */
+result_t post_last_id(sqlite3* db, int* out_id) {
+        uint64_t start = timing_now_ns();
+        result_t res   = post_last_id_impl(db, out_id);
+        metrics_observe_dal("post_last_id", timing_now_ns() - start);
+        return res;
+}
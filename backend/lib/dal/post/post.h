@@ -0,0 +1,189 @@
+#ifndef DAL_POST_H
+#define DAL_POST_H
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/models/post_model/post_model.h"
+#include "/app/backend/lib/result/result.h"
+
+/**
+ * @file post.h
+ * @brief Data access functions for post persistence
+ */
+
+/** @brief Deepest reply level; replies below it join their parent's level. */
+#define POST_MAX_DEPTH 16
+
+/**
+ * @struct post_page_t
+ * @brief One page of a thread's posts in display order
+ */
+typedef struct {
+        post_t* items;    /**< Posts in display order */
+        size_t count;     /**< Number of items */
+        bool has_more;    /**< Whether later posts follow */
+        db_cursor_t next; /**< Cursor for the next page when has_more */
+} post_page_t;
+
+/**
+ * @brief Insert a new post into an existing thread
+ *
+ * A post with a parent_id is a reply to that post and must be in the same
+ * thread. Replies to a post at POST_MAX_DEPTH become its siblings instead,
+ * so out_post's parent_id may differ from the requested one.
+ *
+ * The body is Markdown; it is rendered to body_html (lib/markdown) before
+ * the insert and stored with it, so reads never render. Once inserted, the
+ * live feed daemon is woken up (lib/livefeed); as with cache invalidation,
+ * a caller inserting inside its own transaction should call
+ * livefeed_notify() again after its COMMIT.
+ *
+ * @param db SQLite database connection
+ * @param post Pointer to post_t with thread_id, user_id, body and parent_id
+ * (0 for a top-level post) filled; created_at of 0 means now
+ * @param out_post Pointer to store inserted post with generated ID, parent,
+ * depth and body_html (owned by @p arena, or caller must free when @p arena
+ * is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure (ERR_THREAD_NOT_FOUND if
+ * the thread does not exist, ERR_POST_NOT_FOUND if the parent is not a post
+ * of that thread, ERR_MARKDOWN_TOO_LARGE if the body is longer than
+ * MARKDOWN_MAX_INPUT)
+ */
+result_t post_insert(sqlite3* db, const post_t* post, post_t** out_post,
+                     arena_t* arena);
+
+/**
+ * @brief Fetch a post from the database by ID
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_post Pointer to store fetched post (owned by @p arena, or
+ * caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_fetch_by_id(sqlite3* db, int id, post_t** out_post,
+                          arena_t* arena);
+
+/**
+ * @brief List a thread's posts oldest first, one keyset page at a time
+ *
+ * Seeks the posts_thread_created index to (thread_id, after) and reads
+ * @p limit entries from there, so page 5000 of a busy thread costs the same
+ * as page 1. An unknown thread yields an empty page.
+ *
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_by_thread(sqlite3* db, int thread_id,
+                             const db_cursor_t* after, int limit,
+                             post_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief List a thread's posts as a reply tree, one keyset page at a time
+ *
+ * Posts come depth-first, each followed by its replies, siblings oldest
+ * first: the order a threaded view renders them in. The page is one range
+ * scan of the posts_thread_path index, whatever the depth of the thread.
+ *
+ * @param db SQLite database connection
+ * @param thread_id Thread to list
+ * @param max_depth Deepest level listed (0 for top-level posts only);
+ * negative for all
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page; the listing resumes after the post next.id, and a page after a
+ * deleted post is empty
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_tree(sqlite3* db, int thread_id, int max_depth,
+                        const db_cursor_t* after, int limit,
+                        post_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief List a post and its replies as a tree, one keyset page at a time
+ *
+ * Same order and cursor as post_list_tree(), starting with the root post.
+ *
+ * @param db SQLite database connection
+ * @param root_id Post whose subtree to list
+ * @param max_depth Levels below the root listed (0 for the root only);
+ * negative for all
+ * @param after Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure (ERR_POST_NOT_FOUND if
+ * the root does not exist)
+ */
+result_t post_list_subtree(sqlite3* db, int root_id, int max_depth,
+                           const db_cursor_t* after, int limit,
+                           post_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief List posts written after a given one, oldest first
+ *
+ * Ids grow in commit order (writes are serialized), so following the
+ * page's next.id sees every post exactly once. Used by the live feed to
+ * catch up after a wakeup (maint/livefeed.c).
+ *
+ * @param db SQLite database connection
+ * @param after_id Last post already seen; 0 for the first post
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * post_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t post_list_since(sqlite3* db, int after_id, int limit,
+                         post_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief Id of the newest post
+ * @param db SQLite database connection
+ * @param out_id Set to the id, 0 when there are no posts
+ * @return result_t indicating success or failure
+ */
+result_t post_last_id(sqlite3* db, int* out_id);
+
+/**
+ * @brief Free a page filled by a post listing without an arena
+ * @param page Page to release (nullable)
+ */
+void post_page_free(post_page_t* page);
+
+/**
+ * @brief Re-render posts whose HTML is older than MARKDOWN_VERSION
+ *
+ * Posts keep the HTML they were written with until this brings them up to
+ * date, a batch per write transaction; maint/rerender calls it after a
+ * deploy changes the renderer. Also picks up posts whose body was changed
+ * without their body_html (render_version 0, see sqlite_entrypoint.sh).
+ *
+ * @param db SQLite database connection
+ * @param batch Most posts re-rendered in this call
+ * @param out_rendered Set to the number of posts re-rendered; fewer than
+ * @p batch means none are left
+ * @return result_t indicating success or failure
+ */
+result_t post_rerender_stale(sqlite3* db, int batch, int* out_rendered);
+
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
+
+#endif// DAL_POST_H
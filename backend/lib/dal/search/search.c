@@ -0,0 +1,351 @@
+#include "search.h"
+
+#include <sqlite3.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Room for the MATCH expression: space, quotes, term, '*'. */
+#define SEARCH_MATCH_SIZE (SEARCH_MAX_TERMS * (SEARCH_TERM_MAX + 4) + 1)
+
+/** @brief Snippet markers, replaced by <mark> tags after escaping. */
+#define SEARCH_MARK_OPEN '\x02'
+#define SEARCH_MARK_CLOSE '\x03'
+
+/**
+ * @brief Whether a byte belongs to a search term
+ *
+ * ASCII letters and digits, and every byte of a multi-byte UTF-8 sequence;
+ * the unicode61 tokenizer splits those further if needed.
+ *
+ * @param c Byte
+ * @return true if part of a term
+ */
+static bool is_term_byte(unsigned char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/**
+ * @brief Turn user input into an FTS5 MATCH expression
+ *
+ * Every term is double-quoted, so FTS5 operators and column filters in the
+ * input are plain text. Terms are ANDed; "term*" becomes a prefix query.
+ *
+ * @param text User input
+ * @param out Buffer of SEARCH_MATCH_SIZE bytes
+ * @return Number of terms written
+ */
+static size_t build_match(const char* text, char* out) {
+        const unsigned char* p = (const unsigned char*)text;
+        size_t len = 0, terms = 0;
+
+        while (*p && terms < SEARCH_MAX_TERMS) {
+                if (!is_term_byte(*p)) {
+                        ++p;
+                        continue;
+                }
+
+                const unsigned char* start = p;
+                while (is_term_byte(*p)) ++p;
+                size_t n = (size_t)(p - start);
+                if (n > SEARCH_TERM_MAX) {
+                        /* Cut on a UTF-8 sequence boundary. */
+                        n = SEARCH_TERM_MAX;
+                        while (n > 0 && (start[n] & 0xc0) == 0x80) --n;
+                }
+                bool prefix = *p == '*' && n >= 2;
+
+                if (terms++) out[len++] = ' ';
+                out[len++] = '"';
+                memcpy(out + len, start, n);
+                len += n;
+                out[len++] = '"';
+                if (prefix) out[len++] = '*';
+        }
+
+        out[len] = '\0';
+        return terms;
+}
+
+/**
+ * @brief HTML-escape a snippet and turn its markers into <mark> tags
+ * @param s Snippet from snippet() with SEARCH_MARK_OPEN/CLOSE markers
+ * @param arena Arena for the result (nullable)
+ * @return Escaped snippet, or NULL when out of memory
+ */
+static char* snippet_html(const char* s, arena_t* arena) {
+        static const char* const escapes[256] = {
+            ['&']               = "&amp;",
+            ['<']               = "&lt;",
+            ['>']               = "&gt;",
+            ['"']               = "&quot;",
+            ['\'']              = "&#39;",
+            [SEARCH_MARK_OPEN]  = "<mark>",
+            [SEARCH_MARK_CLOSE] = "</mark>",
+        };
+
+        size_t need = 1;
+        for (const unsigned char* p = (const unsigned char*)s; *p; ++p)
+                need += escapes[*p] ? strlen(escapes[*p]) : 1;
+
+        char* out = arena_alloc(arena, need);
+        if (!out) return NULL;
+
+        char* o = out;
+        for (const unsigned char* p = (const unsigned char*)s; *p; ++p) {
+                if (escapes[*p]) {
+                        size_t n = strlen(escapes[*p]);
+                        memcpy(o, escapes[*p], n);
+                        o += n;
+                } else {
+                        *o++ = (char)*p;
+                }
+        }
+        *o = '\0';
+        return out;
+}
+
+/**
+ * @brief Search posts, ranked by bm25
+ * @param db SQLite database connection
+ * @param text Search text
+ * @param offset Hits to skip, at most SEARCH_MAX_OFFSET
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * search_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t search_posts_impl(sqlite3* db, const char* text, int offset,
+                                  int limit, search_page_t* out_page,
+                                  arena_t* arena) {
+        if (out_page) {
+                *out_page = (search_page_t){0};
+        }
+
+        if (!db || !text || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, text=%p, out_page=%p",
+                                 (const void*)db, (const void*)text,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        char match[SEARCH_MATCH_SIZE];
+        if (build_match(text, match) == 0) {
+                return result_failure("Search query has no terms", NULL,
+                                      ERR_SEARCH_QUERY_EMPTY);
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+        if (offset < 0) offset = 0;
+        if (offset > SEARCH_MAX_OFFSET) offset = SEARCH_MAX_OFFSET;
+
+        /* posts_fts drives the join: MATCH plus ORDER BY rank lets FTS5
+         * rank internally, then each hit is one rowid lookup in posts. One
+         * extra row tells whether another page follows. */
+        const char* sql =
+            "SELECT p.id, p.thread_id, p.user_id, p.created_at, "
+            "posts_fts.rank, "
+            "snippet(posts_fts, 0, char(2), char(3), '\xe2\x80\xa6', ?) "
+            "FROM posts_fts JOIN posts AS p ON p.id = posts_fts.rowid "
+            "WHERE posts_fts MATCH ? ORDER BY posts_fts.rank "
+            "LIMIT ? OFFSET ?;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, SEARCH_SNIPPET_TOKENS);
+        sqlite3_bind_text(stmt, 2, match, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, limit + 1);
+        sqlite3_bind_int(stmt, 4, offset);
+
+        search_hit_t* items =
+            arena_alloc(arena, sizeof(search_hit_t) * (size_t)limit);
+        if (!items) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for search page", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        out_page->items = items;
+
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                if (out_page->count == (size_t)limit) {
+                        out_page->has_more = true;
+                        break;
+                }
+
+                search_hit_t* hit = &items[out_page->count];
+                hit->post_id      = sqlite3_column_int(stmt, 0);
+                hit->thread_id    = sqlite3_column_int(stmt, 1);
+                hit->user_id      = sqlite3_column_int(stmt, 2);
+                hit->created_at   = sqlite3_column_int64(stmt, 3);
+                hit->score        = sqlite3_column_double(stmt, 4);
+                const char* snip  = (const char*)sqlite3_column_text(stmt, 5);
+                hit->snippet      = snippet_html(snip ? snip : "", arena);
+                if (!hit->snippet) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for snippet", NULL,
+                            ERR_MEMORY_ALLOC_FAIL);
+                        if (!arena) search_page_free(out_page);
+                        *out_page = (search_page_t){0};
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+                ++out_page->count;
+        }
+
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+                result_t res =
+                    db_deadline_hit(db, rc)
+                        ? result_failure("Deadline exceeded in SELECT", NULL,
+                                         ERR_DEADLINE_EXCEEDED)
+                        : result_failure("Failed to execute SQL statement",
+                                         NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s, match=%s",
+                                 sqlite3_errmsg(db), match);
+                if (!arena) search_page_free(out_page);
+                *out_page = (search_page_t){0};
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Free a page filled by search_posts() without an arena
+ * @param page Page to release (nullable)
+ */
+void search_page_free(search_page_t* page) {
+        if (!page) return;
+        for (size_t i = 0; i < page->count; ++i) free(page->items[i].snippet);
+        free(page->items);
+        *page = (search_page_t){0};
+}
+
+/**
+ * @brief Run one of the FTS5 special INSERT commands on posts_fts
+ * @param db SQLite database connection
+ * @param command Command name, e.g. "merge"
+ * @param arg Command argument, or NULL for commands without one
+ * @return SQLite result code of the step
+ */
+static int fts_command(sqlite3* db, const char* command, const int* arg) {
+        const char* sql =
+            arg ? "INSERT INTO posts_fts (posts_fts, rank) VALUES (?, ?);"
+                : "INSERT INTO posts_fts (posts_fts) VALUES (?);";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) return rc;
+
+        sqlite3_bind_text(stmt, 1, command, -1, SQLITE_STATIC);
+        if (arg) sqlite3_bind_int(stmt, 2, *arg);
+        rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        return rc;
+}
+
+/**
+ * @brief Do one bounded step of index merging
+ * @param db SQLite database connection
+ * @param pages Merge work budget in index pages
+ * @param out_done Set to true once there is nothing left worth merging
+ * @return result_t indicating success or failure
+ */
+result_t search_merge(sqlite3* db, int pages, bool* out_done) {
+        if (out_done) *out_done = true;
+        if (!db || pages <= 0) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, pages=%d", (const void*)db,
+                                 pages);
+                return res;
+        }
+
+        /* FTS5 reports fewer than two changed rows when a merge found
+         * nothing to do. */
+        int before = sqlite3_total_changes(db);
+        int rc     = fts_command(db, "merge", &pages);
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to merge search index",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+        if (out_done) *out_done = sqlite3_total_changes(db) - before < 2;
+        return result_success();
+}
+
+/**
+ * @brief Merge the whole index into one segment
+ * @param db SQLite database connection
+ * @return result_t indicating success or failure
+ */
+result_t search_optimize(sqlite3* db) {
+        if (!db) {
+                return result_failure("Invalid arguments", NULL,
+                                      ERR_INVALID_INPUT);
+        }
+        if (fts_command(db, "optimize", NULL) != SQLITE_DONE) {
+                result_t res = result_failure(
+                    "Failed to optimize search index", NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+        return result_success();
+}
+
+/**
+ * @brief Rebuild the index from the posts table
+ * @param db SQLite database connection
+ * @return result_t indicating success or failure
+ */
+result_t search_rebuild(sqlite3* db) {
+        if (!db) {
+                return result_failure("Invalid arguments", NULL,
+                                      ERR_INVALID_INPUT);
+        }
+        if (fts_command(db, "rebuild", NULL) != SQLITE_DONE) {
+                result_t res = result_failure(
+                    "Failed to rebuild search index", NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+        return result_success();
+}
+
+/**
+ * @brief Search posts, recording the call duration in the metrics segment
+ * @param db SQLite database connection
+ * @param text Search text
+ * @param offset Hits to skip
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t search_posts(sqlite3* db, const char* text, int offset, int limit,
+                      search_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res =
+            search_posts_impl(db, text, offset, limit, out_page, arena);
+        metrics_observe_dal("search_posts", timing_now_ns() - start);
+        return res;
+}
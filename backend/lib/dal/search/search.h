@@ -0,0 +1,112 @@
+#ifndef DAL_SEARCH_H
+#define DAL_SEARCH_H
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/result/result.h"
+
+/**
+ * @file search.h
+ * @brief Full-text search over posts and upkeep of the search index
+ *
+ * posts_fts is an FTS5 external-content index over posts.body, kept in sync
+ * by triggers on posts (see sqlite_entrypoint.sh), so writers never touch
+ * it directly. Writers also never merge it: automerge is off, and
+ * search_merge() / search_optimize() do that work from maint/fts_maint
+ * outside the request path.
+ */
+
+/** @brief Search terms used from a query; later ones are ignored. */
+#define SEARCH_MAX_TERMS 8
+
+/** @brief Longest search term in bytes; longer ones are cut. */
+#define SEARCH_TERM_MAX 64
+
+/** @brief Deepest result offset served; ranking reads every match. */
+#define SEARCH_MAX_OFFSET 200
+
+/** @brief Tokens of context around the matches in a snippet. */
+#define SEARCH_SNIPPET_TOKENS 12
+
+/**
+ * @struct search_hit_t
+ * @brief One matching post
+ */
+typedef struct {
+        int post_id;        /**< Matching post */
+        int thread_id;      /**< Thread of the post */
+        int user_id;        /**< Author of the post */
+        int64_t created_at; /**< Creation time in Unix seconds */
+        double score;       /**< bm25 rank, lower is better */
+        char* snippet;      /**< HTML-escaped excerpt, matches in <mark> */
+} search_hit_t;
+
+/**
+ * @struct search_page_t
+ * @brief One page of search results, best first
+ */
+typedef struct {
+        search_hit_t* items; /**< Hits, best first */
+        size_t count;        /**< Number of items */
+        bool has_more;       /**< Whether more hits follow */
+} search_page_t;
+
+/**
+ * @brief Search posts, ranked by bm25
+ *
+ * @p text is plain user input, never FTS5 syntax: every run of letters and
+ * digits is one quoted term, all terms must match, and a term directly
+ * followed by '*' (at least two characters long) matches as a prefix.
+ *
+ * @param db SQLite database connection
+ * @param text Search text
+ * @param offset Hits to skip, at most SEARCH_MAX_OFFSET
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * search_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure (ERR_SEARCH_QUERY_EMPTY
+ * when @p text has no terms)
+ */
+result_t search_posts(sqlite3* db, const char* text, int offset, int limit,
+                      search_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief Free a page filled by search_posts() without an arena
+ * @param page Page to release (nullable)
+ */
+void search_page_free(search_page_t* page);
+
+/**
+ * @brief Do one bounded step of index merging
+ * @param db SQLite database connection
+ * @param pages Merge work budget in index pages
+ * @param out_done Set to true once there is nothing left worth merging
+ * @return result_t indicating success or failure
+ */
+result_t search_merge(sqlite3* db, int pages, bool* out_done);
+
+/**
+ * @brief Merge the whole index into one segment
+ *
+ * Rewrites the entire index in one transaction; meant for quiet hours.
+ *
+ * @param db SQLite database connection
+ * @return result_t indicating success or failure
+ */
+result_t search_optimize(sqlite3* db);
+
+/**
+ * @brief Rebuild the index from the posts table
+ * @param db SQLite database connection
+ * @return result_t indicating success or failure
+ */
+result_t search_rebuild(sqlite3* db);
+
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
+
+#endif// DAL_SEARCH_H
@@ -0,0 +1,289 @@
+#include "stats.h"
+
+#include <sqlite3.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/**
+ * @brief How to recompute one counter
+ *
+ * scan returns (key, stored, actual) for every row the counter covers;
+ * repair overwrites the drifted ones in a single statement.
+ */
+typedef struct {
+        const char* name;   /**< Name reported in stats_drift_t */
+        const char* scan;   /**< Query returning key, stored, actual */
+        const char* repair; /**< Statement fixing drifted rows */
+} stats_counter_sql_t;
+
+/* Per-user keys: every user plus any user_stats row left over. */
+#define USER_KEYS                                                          \
+        "k (id) AS (SELECT id FROM users UNION SELECT user_id FROM "       \
+        "user_stats)"
+
+static const stats_counter_sql_t counter_sql[STATS_COUNTER_COUNT] = {
+    [STATS_THREAD_POSTS] =
+        {"thread_posts",
+         "SELECT t.id, t.post_count, (SELECT COUNT(*) FROM posts p "
+         "WHERE p.thread_id = t.id) FROM threads t;",
+         "UPDATE threads SET post_count = (SELECT COUNT(*) FROM posts p "
+         "WHERE p.thread_id = threads.id) WHERE post_count <> (SELECT "
+         "COUNT(*) FROM posts p WHERE p.thread_id = threads.id);"},
+    [STATS_USER_THREADS] =
+        {"user_threads",
+         "WITH " USER_KEYS ", a AS (SELECT user_id, COUNT(*) AS n FROM "
+         "threads GROUP BY user_id) SELECT k.id, COALESCE(s.thread_count, "
+         "0), COALESCE(a.n, 0) FROM k LEFT JOIN user_stats s ON s.user_id "
+         "= k.id LEFT JOIN a ON a.user_id = k.id;",
+         "WITH " USER_KEYS ", a AS (SELECT user_id, COUNT(*) AS n FROM "
+         "threads GROUP BY user_id) INSERT INTO user_stats (user_id, "
+         "thread_count) SELECT k.id, COALESCE(a.n, 0) FROM k LEFT JOIN "
+         "user_stats s ON s.user_id = k.id LEFT JOIN a ON a.user_id = k.id "
+         "WHERE COALESCE(s.thread_count, 0) <> COALESCE(a.n, 0) "
+         "ON CONFLICT (user_id) DO UPDATE SET thread_count = "
+         "excluded.thread_count;"},
+    [STATS_USER_POSTS] =
+        {"user_posts",
+         "WITH " USER_KEYS ", a AS (SELECT user_id, COUNT(*) AS n FROM "
+         "posts GROUP BY user_id) SELECT k.id, COALESCE(s.post_count, 0), "
+         "COALESCE(a.n, 0) FROM k LEFT JOIN user_stats s ON s.user_id = "
+         "k.id LEFT JOIN a ON a.user_id = k.id;",
+         "WITH " USER_KEYS ", a AS (SELECT user_id, COUNT(*) AS n FROM "
+         "posts GROUP BY user_id) INSERT INTO user_stats (user_id, "
+         "post_count) SELECT k.id, COALESCE(a.n, 0) FROM k LEFT JOIN "
+         "user_stats s ON s.user_id = k.id LEFT JOIN a ON a.user_id = k.id "
+         "WHERE COALESCE(s.post_count, 0) <> COALESCE(a.n, 0) "
+         "ON CONFLICT (user_id) DO UPDATE SET post_count = "
+         "excluded.post_count;"},
+    [STATS_FORUM_THREADS] =
+        {"forum_threads",
+         "SELECT 1, COALESCE((SELECT thread_count FROM forum_stats WHERE id "
+         "= 1), 0), (SELECT COUNT(*) FROM threads);",
+         "INSERT INTO forum_stats (id, thread_count) VALUES (1, (SELECT "
+         "COUNT(*) FROM threads)) ON CONFLICT (id) DO UPDATE SET "
+         "thread_count = excluded.thread_count;"},
+    [STATS_FORUM_POSTS] =
+        {"forum_posts",
+         "SELECT 1, COALESCE((SELECT post_count FROM forum_stats WHERE id = "
+         "1), 0), (SELECT COUNT(*) FROM posts);",
+         "INSERT INTO forum_stats (id, post_count) VALUES (1, (SELECT "
+         "COUNT(*) FROM posts)) ON CONFLICT (id) DO UPDATE SET post_count = "
+         "excluded.post_count;"},
+};
+
+/**
+ * @brief Read one (thread_count, post_count) row
+ * @param db SQLite database connection
+ * @param sql Query with at most one integer parameter
+ * @param key Value bound to the parameter
+ * @param out_counts Counts to fill; zero when there is no row
+ * @return result_t indicating success or failure
+ */
+static result_t fetch_counts(sqlite3* db, const char* sql, int key,
+                             stats_counts_t* out_counts) {
+        *out_counts        = (stats_counts_t){0};
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        if (sqlite3_bind_parameter_count(stmt) > 0)
+                sqlite3_bind_int(stmt, 1, key);
+
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW) {
+                out_counts->thread_count = sqlite3_column_int(stmt, 0);
+                out_counts->post_count   = sqlite3_column_int(stmt, 1);
+                sqlite3_finalize(stmt);
+                return result_success();
+        }
+
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in SELECT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Fetch the thread and post counts of a user
+ * @param db SQLite database connection
+ * @param user_id User to look up; unknown users count zero
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+static result_t stats_fetch_user_impl(sqlite3* db, int user_id,
+                                      stats_counts_t* out_counts) {
+        if (!db || !out_counts) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_counts=%p",
+                                 (const void*)db, (const void*)out_counts);
+                return res;
+        }
+
+        return fetch_counts(db,
+                            "SELECT thread_count, post_count FROM user_stats "
+                            "WHERE user_id = ?;",
+                            user_id, out_counts);
+}
+
+/**
+ * @brief Fetch the forum-wide thread and post counts
+ * @param db SQLite database connection
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+static result_t stats_fetch_forum_impl(sqlite3* db,
+                                       stats_counts_t* out_counts) {
+        if (!db || !out_counts) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_counts=%p",
+                                 (const void*)db, (const void*)out_counts);
+                return res;
+        }
+
+        return fetch_counts(db,
+                            "SELECT thread_count, post_count FROM forum_stats "
+                            "WHERE id = 1;",
+                            0, out_counts);
+}
+
+/**
+ * @brief Compare one counter with its recomputed value
+ * @param db SQLite database connection
+ * @param sql How to scan the counter
+ * @param out Drift entry to fill
+ * @return SQLITE_DONE on success, else the failing SQLite code
+ */
+static int scan_counter(sqlite3* db, const stats_counter_sql_t* sql,
+                        stats_drift_t* out) {
+        *out               = (stats_drift_t){.counter = sql->name};
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql->scan, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) return rc;
+
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                int64_t stored = sqlite3_column_int64(stmt, 1);
+                int64_t actual = sqlite3_column_int64(stmt, 2);
+                ++out->checked;
+                if (stored == actual) continue;
+                if (out->drifted++ == 0) {
+                        out->sample_id     = sqlite3_column_int64(stmt, 0);
+                        out->sample_stored = stored;
+                        out->sample_actual = actual;
+                }
+        }
+        sqlite3_finalize(stmt);
+        return rc;
+}
+
+/**
+ * @brief Recompute every counter and compare it with the stored value
+ * @param db SQLite database connection
+ * @param repair Whether to fix drifted counters
+ * @param out_drift One entry per stats_counter_t
+ * @return result_t indicating success or failure
+ */
+result_t stats_check(sqlite3* db, bool repair,
+                     stats_drift_t out_drift[STATS_COUNTER_COUNT]) {
+        if (!db || !out_drift) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_drift=%p", (const void*)db,
+                                 (const void*)out_drift);
+                return res;
+        }
+
+        /* IMMEDIATE takes the write lock up front, so no writer can slip
+         * in between a scan and its repair. */
+        int rc = sqlite3_exec(db, repair ? "BEGIN IMMEDIATE;" : "BEGIN;",
+                              NULL, NULL, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res = result_failure("Failed to begin transaction",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        for (int i = 0; i < STATS_COUNTER_COUNT; ++i) {
+                rc = scan_counter(db, &counter_sql[i], &out_drift[i]);
+                if (rc == SQLITE_DONE && repair && out_drift[i].drifted > 0)
+                        rc = sqlite3_exec(db, counter_sql[i].repair, NULL,
+                                          NULL, NULL) == SQLITE_OK
+                                 ? SQLITE_DONE
+                                 : SQLITE_ERROR;
+                if (rc != SQLITE_DONE) {
+                        result_t res =
+                            result_failure("Failed to check counter", NULL,
+                                           ERR_SQL_STEP_FAIL);
+                        result_add_extra(&res, "counter=%s, sqlite_error=%s",
+                                         counter_sql[i].name,
+                                         sqlite3_errmsg(db));
+                        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+                        return res;
+                }
+        }
+
+        if (sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+                result_t res = result_failure("Failed to commit transaction",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+                return res;
+        }
+        return result_success();
+}
+
+/**
+ * @brief Fetch a user's counts, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param user_id User to look up
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+result_t stats_fetch_user(sqlite3* db, int user_id,
+                          stats_counts_t* out_counts) {
+        uint64_t start = timing_now_ns();
+        result_t res   = stats_fetch_user_impl(db, user_id, out_counts);
+        metrics_observe_dal("stats_user", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Fetch the forum counts, recording the call duration in the
+ * metrics segment
+ * @param db SQLite database connection
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+result_t stats_fetch_forum(sqlite3* db, stats_counts_t* out_counts) {
+        uint64_t start = timing_now_ns();
+        result_t res   = stats_fetch_forum_impl(db, out_counts);
+        metrics_observe_dal("stats_forum", timing_now_ns() - start);
+        return res;
+}
@@ -0,0 +1,92 @@
+#ifndef DAL_STATS_H
+#define DAL_STATS_H
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/result/result.h"
+
+/**
+ * @file stats.h
+ * @brief Materialized thread and post counters
+ *
+ * Counters are columns kept up to date by triggers in the transaction that
+ * inserts, deletes or moves a thread or post (see sqlite_entrypoint.sh):
+ * threads.post_count, user_stats and the single forum_stats row. Reading one
+ * is a primary-key lookup; stats_check() recomputes them all with COUNT(*)
+ * for maint/counters.
+ */
+
+/**
+ * @struct stats_counts_t
+ * @brief Thread and post totals of a user or of the whole forum
+ */
+typedef struct {
+        int thread_count; /**< Threads opened */
+        int post_count;   /**< Posts written */
+} stats_counts_t;
+
+/**
+ * @enum stats_counter_t
+ * @brief Counters checked by stats_check()
+ */
+typedef enum {
+        STATS_THREAD_POSTS,  /**< threads.post_count */
+        STATS_USER_THREADS,  /**< user_stats.thread_count */
+        STATS_USER_POSTS,    /**< user_stats.post_count */
+        STATS_FORUM_THREADS, /**< forum_stats.thread_count */
+        STATS_FORUM_POSTS,   /**< forum_stats.post_count */
+        STATS_COUNTER_COUNT
+} stats_counter_t;
+
+/**
+ * @struct stats_drift_t
+ * @brief Outcome of checking one counter
+ */
+typedef struct {
+        const char* counter;   /**< Counter name, e.g. "thread_posts" */
+        int64_t checked;       /**< Rows compared */
+        int64_t drifted;       /**< Rows whose stored value was wrong */
+        int64_t sample_id;     /**< Key of the first drifted row */
+        int64_t sample_stored; /**< Its stored value */
+        int64_t sample_actual; /**< Its recomputed value */
+} stats_drift_t;
+
+/**
+ * @brief Fetch the thread and post counts of a user
+ * @param db SQLite database connection
+ * @param user_id User to look up; unknown users count zero
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+result_t stats_fetch_user(sqlite3* db, int user_id,
+                          stats_counts_t* out_counts);
+
+/**
+ * @brief Fetch the forum-wide thread and post counts
+ * @param db SQLite database connection
+ * @param out_counts Counts to fill
+ * @return result_t indicating success or failure
+ */
+result_t stats_fetch_forum(sqlite3* db, stats_counts_t* out_counts);
+
+/**
+ * @brief Recompute every counter and compare it with the stored value
+ *
+ * Runs in one transaction so counters and rows are seen at the same point.
+ * It reads every thread and post, so it is meant for maintenance runs, not
+ * for requests. With @p repair the transaction takes the write lock and
+ * drifted counters are overwritten with the recomputed values.
+ *
+ * @param db SQLite database connection
+ * @param repair Whether to fix drifted counters
+ * @param out_drift One entry per stats_counter_t
+ * @return result_t indicating success or failure
+ */
+result_t stats_check(sqlite3* db, bool repair,
+                     stats_drift_t out_drift[STATS_COUNTER_COUNT]);
+
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
+
+#endif// DAL_STATS_H
@@ -0,0 +1,380 @@
+#include "thread.h"
+
+#include <sqlite3.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "/app/backend/lib/cache/cache.h"
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/**
+ * @brief Release a partially built thread according to its allocator.
+ * @param thread Thread to release (nullable)
+ * @param arena Arena the thread was allocated from (nullable)
+ */
+static void discard_thread(thread_t* thread, arena_t* arena) {
+        if (!arena) thread_free(thread);
+}
+
+/**
+ * @brief Copy the current row (id, user_id, title, created_at, post_count)
+ * into a thread
+ * @param stmt Statement positioned on a row
+ * @param thread Thread to fill
+ * @param arena Arena for the title (nullable)
+ * @return false if the title could not be allocated
+ */
+static bool thread_from_row(sqlite3_stmt* stmt, thread_t* thread,
+                            arena_t* arena) {
+        thread->id         = sqlite3_column_int(stmt, 0);
+        thread->user_id    = sqlite3_column_int(stmt, 1);
+        const char* title  = (const char*)sqlite3_column_text(stmt, 2);
+        thread->created_at = sqlite3_column_int64(stmt, 3);
+        thread->post_count = sqlite3_column_int(stmt, 4);
+        thread->title      = arena_strdup(arena, title ? title : "");
+        return thread->title != NULL;
+}
+
+/**
+ * @brief Insert a new thread into the database
+ * @param db SQLite database connection
+ * @param thread Pointer to thread_t with user_id and title filled;
+ * created_at of 0 means now
+ * @param out_thread Pointer to store inserted thread with generated ID
+ * (owned by @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t thread_insert_impl(sqlite3* db, const thread_t* thread,
+                                   thread_t** out_thread, arena_t* arena) {
+        if (out_thread) {
+                *out_thread = NULL;
+        }
+
+        if (!db || !thread || !thread->title || !out_thread) {
+                result_t res = result_failure("Invalid input parameters", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(
+                    &res, "db=%p, thread=%p, title=%p, out_thread=%p",
+                    (const void*)db, (const void*)thread,
+                    thread ? (const void*)thread->title : NULL,
+                    (const void*)out_thread);
+                return res;
+        }
+
+        const char* sql =
+            "INSERT INTO threads (user_id, title, created_at) VALUES (?, ?, "
+            "?);";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_critical_failure("Failed to prepare SQL statement",
+                                            NULL, ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        int64_t created_at =
+            thread->created_at ? thread->created_at : (int64_t)time(NULL);
+        sqlite3_bind_int(stmt, 1, thread->user_id);
+        sqlite3_bind_text(stmt, 2, thread->title, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 3, created_at);
+
+        rc = sqlite3_step(stmt);
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in INSERT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        cache_invalidate(CACHE_SCOPE_THREADS, 0);
+
+        thread_t* new_thread = arena_alloc(arena, sizeof(thread_t));
+        if (!new_thread) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for thread", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        new_thread->id         = (int)sqlite3_last_insert_rowid(db);
+        new_thread->user_id    = thread->user_id;
+        new_thread->created_at = created_at;
+        new_thread->post_count = 0;
+        new_thread->title      = arena_strdup(arena, thread->title);
+
+        if (!new_thread->title) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for thread fields", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                discard_thread(new_thread, arena);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        *out_thread = new_thread;
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Fetch a thread from the database by ID
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_thread Pointer to store fetched thread (owned by @p arena, or
+ * caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t thread_fetch_by_id_impl(sqlite3* db, int id,
+                                        thread_t** out_thread,
+                                        arena_t* arena) {
+        if (out_thread) {
+                *out_thread = NULL;
+        }
+
+        if (!db || !out_thread) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_thread=%p",
+                                 (const void*)db, (const void*)out_thread);
+                return res;
+        }
+
+        const char* sql =
+            "SELECT id, user_id, title, created_at, post_count FROM threads "
+            "WHERE id = ? LIMIT 1;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, id);
+
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW) {
+                thread_t* thread = arena_alloc(arena, sizeof(thread_t));
+                if (!thread) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for thread", NULL,
+                            ERR_MEMORY_ALLOC_FAIL);
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+
+                if (!thread_from_row(stmt, thread, arena)) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for thread fields",
+                            NULL, ERR_MEMORY_ALLOC_FAIL);
+                        discard_thread(thread, arena);
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+
+                *out_thread = thread;
+                sqlite3_finalize(stmt);
+                return result_success();
+        }
+
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in SELECT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        result_t res =
+            result_failure("Thread not found", NULL, ERR_THREAD_NOT_FOUND);
+        result_add_extra(&res, "id=%d", id);
+        sqlite3_finalize(stmt);
+        return res;
+}
+
+/**
+ * @brief List threads newest first, one keyset page at a time
+ * @param db SQLite database connection
+ * @param before Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * thread_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t thread_list_impl(sqlite3* db, const db_cursor_t* before,
+                                 int limit, thread_page_t* out_page,
+                                 arena_t* arena) {
+        if (out_page) {
+                *out_page = (thread_page_t){0};
+        }
+
+        if (!db || !out_page) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_page=%p", (const void*)db,
+                                 (const void*)out_page);
+                return res;
+        }
+
+        if (limit <= 0 || limit > DB_PAGE_MAX) limit = DB_PAGE_MAX;
+
+        /* One extra row tells whether another page follows. */
+        const char* sql =
+            "SELECT id, user_id, title, created_at, post_count FROM threads "
+            "WHERE (created_at, id) < (?, ?) "
+            "ORDER BY created_at DESC, id DESC LIMIT ?;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int64(stmt, 1, before ? before->created_at : INT64_MAX);
+        sqlite3_bind_int64(stmt, 2, before ? before->id : INT64_MAX);
+        sqlite3_bind_int(stmt, 3, limit + 1);
+
+        thread_t* items = arena_alloc(arena, sizeof(thread_t) * (size_t)limit);
+        if (!items) {
+                result_t res = result_critical_failure(
+                    "Failed to allocate memory for thread page", NULL,
+                    ERR_MEMORY_ALLOC_FAIL);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        out_page->items = items;
+
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                if (out_page->count == (size_t)limit) {
+                        out_page->has_more = true;
+                        break;
+                }
+                if (!thread_from_row(stmt, &items[out_page->count], arena)) {
+                        result_t res = result_critical_failure(
+                            "Failed to allocate memory for thread fields",
+                            NULL, ERR_MEMORY_ALLOC_FAIL);
+                        if (!arena) thread_page_free(out_page);
+                        *out_page = (thread_page_t){0};
+                        sqlite3_finalize(stmt);
+                        return res;
+                }
+                ++out_page->count;
+        }
+
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+                result_t res =
+                    db_deadline_hit(db, rc)
+                        ? result_failure("Deadline exceeded in SELECT", NULL,
+                                         ERR_DEADLINE_EXCEEDED)
+                        : result_failure("Failed to execute SQL statement",
+                                         NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                if (!arena) thread_page_free(out_page);
+                *out_page = (thread_page_t){0};
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        if (out_page->has_more) {
+                const thread_t* last = &items[out_page->count - 1];
+                out_page->next =
+                    (db_cursor_t){.created_at = last->created_at,
+                                  .id         = last->id};
+        }
+
+        sqlite3_finalize(stmt);
+        return result_success();
+}
+
+/**
+ * @brief Free a page filled by thread_list() without an arena
+ * @param page Page to release (nullable)
+ */
+void thread_page_free(thread_page_t* page) {
+        if (!page) return;
+        for (size_t i = 0; i < page->count; ++i) free(page->items[i].title);
+        free(page->items);
+        *page = (thread_page_t){0};
+}
+
+/**
+ * @brief Insert a new thread, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param thread Pointer to thread_t with user_id and title filled
+ * @param out_thread Pointer to store inserted thread with generated ID
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_insert(sqlite3* db, const thread_t* thread,
+                       thread_t** out_thread, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = thread_insert_impl(db, thread, out_thread, arena);
+        metrics_observe_dal("thread_insert", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Fetch a thread by ID, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_thread Pointer to store fetched thread
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_fetch_by_id(sqlite3* db, int id, thread_t** out_thread,
+                            arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = thread_fetch_by_id_impl(db, id, out_thread, arena);
+        metrics_observe_dal("thread_by_id", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief List a page of threads, recording the call duration in the
+ * metrics segment
+ * @param db SQLite database connection
+ * @param before Cursor from the previous page, NULL for the first page
+ * @param limit Page size
+ * @param out_page Page to fill
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_list(sqlite3* db, const db_cursor_t* before, int limit,
+                     thread_page_t* out_page, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res = thread_list_impl(db, before, limit, out_page, arena);
+        metrics_observe_dal("thread_list", timing_now_ns() - start);
+        return res;
+}
@@ -0,0 +1,80 @@
+#ifndef DAL_THREAD_H
+#define DAL_THREAD_H
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/models/thread_model/thread_model.h"
+#include "/app/backend/lib/result/result.h"
+
+/**
+ * @file thread.h
+ * @brief Data access functions for thread persistence
+ */
+
+/**
+ * @struct thread_page_t
+ * @brief One page of a thread listing, newest first
+ */
+typedef struct {
+        thread_t* items;  /**< Threads, newest first */
+        size_t count;     /**< Number of items */
+        bool has_more;    /**< Whether older threads follow */
+        db_cursor_t next; /**< Cursor for the next page when has_more */
+} thread_page_t;
+
+/**
+ * @brief Insert a new thread into the database
+ * @param db SQLite database connection
+ * @param thread Pointer to thread_t with user_id and title filled;
+ * created_at of 0 means now
+ * @param out_thread Pointer to store inserted thread with generated ID
+ * (owned by @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_insert(sqlite3* db, const thread_t* thread,
+                       thread_t** out_thread, arena_t* arena);
+
+/**
+ * @brief Fetch a thread from the database by ID
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_thread Pointer to store fetched thread (owned by @p arena, or
+ * caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_fetch_by_id(sqlite3* db, int id, thread_t** out_thread,
+                            arena_t* arena);
+
+/**
+ * @brief List threads newest first, one keyset page at a time
+ *
+ * Reads the threads_created index backwards from @p before, so every page
+ * costs the same however far back it is.
+ *
+ * @param db SQLite database connection
+ * @param before Cursor from the previous page's next, NULL for the first
+ * page
+ * @param limit Page size; values outside 1..DB_PAGE_MAX mean DB_PAGE_MAX
+ * @param out_page Page to fill (items owned by @p arena, or release with
+ * thread_page_free() when @p arena is NULL)
+ * @param arena Request arena to allocate the page from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t thread_list(sqlite3* db, const db_cursor_t* before, int limit,
+                     thread_page_t* out_page, arena_t* arena);
+
+/**
+ * @brief Free a page filled by thread_list() without an arena
+ * @param page Page to release (nullable)
+ */
+void thread_page_free(thread_page_t* page);
+
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
+
+#endif// DAL_THREAD_H
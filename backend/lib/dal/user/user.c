@@ -5,25 +5,40 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/metrics/metrics.h"
+#include "/app/backend/lib/revoke/revoke.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/**
+ * @brief Release a partially built user according to its allocator.
+ * @param user User to release (nullable)
+ * @param arena Arena the user was allocated from (nullable)
+ */
+static void discard_user(user_t* user, arena_t* arena) {
+        if (!arena) user_free(user);
+}
+
 /**
  * @brief Insert a new user into the database
  * @param db SQLite database connection
  * @param user Pointer to user_t with username and password_hash filled
- * @param out_user Pointer to store inserted user with generated ID (caller must
- * free)
+ * @param out_user Pointer to store inserted user with generated ID (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_insert(sqlite3* db, const user_t* user, user_t** out_user) {
+static result_t user_insert_impl(sqlite3* db, const user_t* user,
+                                 user_t** out_user, arena_t* arena) {
         if (out_user) {
                 *out_user = NULL;
         }
 
         if (!db || !user || !user->username || !user->password_hash ||
             !out_user) {
-                result_t* res = result_failure("Invalid input parameters", NULL,
-                                               ERR_INVALID_INPUT);
-                result_add_extra(
-                    res,
+                result_t res = result_failure("Invalid input parameters", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res,
                     "db=%p, user=%p, username=%p, password_hash=%p, "
                     "out_user=%p",
                     (const void*)db, (const void*)user,
@@ -39,10 +54,10 @@ result_t* user_insert(sqlite3* db, const user_t* user, user_t** out_user) {
 
         int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
         if (rc != SQLITE_OK) {
-                result_t* res =
+                result_t res =
                     result_critical_failure("Failed to prepare SQL statement",
                                             NULL, ERR_SQL_PREPARE_FAIL);
-                result_add_extra(res, "sqlite_error=%s", sqlite3_errmsg(db));
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
                 return res;
         }
 
@@ -50,40 +65,44 @@ result_t* user_insert(sqlite3* db, const user_t* user, user_t** out_user) {
         sqlite3_bind_text(stmt, 2, user->password_hash, -1, SQLITE_TRANSIENT);
 
         rc = sqlite3_step(stmt);
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in INSERT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
         if (rc != SQLITE_DONE) {
-                result_t* res = NULL;
-
-                if (rc == SQLITE_CONSTRAINT) {
-                        res = result_failure("Duplicate entry detected", NULL,
-                                             ERR_USER_DUPLICATE);
-                } else {
-                        res = result_failure("Failed to execute SQL statement",
-                                             NULL, ERR_SQL_STEP_FAIL);
-                }
-
-                result_add_extra(res, "sqlite_error=%s", sqlite3_errmsg(db));
+                result_t res =
+                    rc == SQLITE_CONSTRAINT
+                        ? result_failure("Duplicate entry detected", NULL,
+                                         ERR_USER_DUPLICATE)
+                        : result_failure("Failed to execute SQL statement",
+                                         NULL, ERR_SQL_STEP_FAIL);
+
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
                 sqlite3_finalize(stmt);
                 return res;
         }
 
-        user_t* new_user = malloc(sizeof(user_t));
+        user_t* new_user = arena_alloc(arena, sizeof(user_t));
         if (!new_user) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to allocate memory for user", NULL,
                     ERR_MEMORY_ALLOC_FAIL);
                 sqlite3_finalize(stmt);
                 return res;
         }
 
-        new_user->id            = sqlite3_last_insert_rowid(db);
-        new_user->username      = strdup(user->username);
-        new_user->password_hash = strdup(user->password_hash);
+        new_user->id               = sqlite3_last_insert_rowid(db);
+        new_user->username         = arena_strdup(arena, user->username);
+        new_user->password_hash    = arena_strdup(arena, user->password_hash);
+        new_user->token_generation = 0;
 
         if (!new_user->username || !new_user->password_hash) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to allocate memory for user fields", NULL,
                     ERR_MEMORY_ALLOC_FAIL);
-                user_free(new_user);
+                discard_user(new_user, arena);
                 sqlite3_finalize(stmt);
                 return res;
         }
@@ -97,33 +116,36 @@ result_t* user_insert(sqlite3* db, const user_t* user, user_t** out_user) {
  * @brief Fetch a user from the database by ID
  * @param db SQLite database connection
  * @param id ID to search for
- * @param out_user Pointer to store fetched user (caller must free)
+ * @param out_user Pointer to store fetched user (owned by @p arena, or caller
+ * must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user) {
+static result_t user_fetch_by_id_impl(sqlite3* db, int id, user_t** out_user,
+                                      arena_t* arena) {
         if (out_user) {
                 *out_user = NULL;
         }
 
         if (!db || !out_user) {
-                result_t* res = result_failure("Invalid arguments", NULL,
-                                               ERR_INVALID_INPUT);
-                result_add_extra(res, "db=%p, out_user=%p", (const void*)db,
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, out_user=%p", (const void*)db,
                                  (const void*)out_user);
                 return res;
         }
 
         const char* sql =
-            "SELECT id, username, password_hash FROM users WHERE id = ? LIMIT "
-            "1;";
+            "SELECT id, username, password_hash, token_generation FROM users "
+            "WHERE id = ? LIMIT 1;";
         sqlite3_stmt* stmt = NULL;
 
         int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
         if (rc != SQLITE_OK) {
-                result_t* res =
+                result_t res =
                     result_failure("Failed to prepare SQL statement", NULL,
                                    ERR_SQL_PREPARE_FAIL);
-                result_add_extra(res, "sqlite_error=%s", sqlite3_errmsg(db));
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
                 return res;
         }
 
@@ -131,9 +153,9 @@ result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user) {
 
         rc = sqlite3_step(stmt);
         if (rc == SQLITE_ROW) {
-                user_t* user = malloc(sizeof(user_t));
+                user_t* user = arena_alloc(arena, sizeof(user_t));
                 if (!user) {
-                        result_t* res = result_critical_failure(
+                        result_t res = result_critical_failure(
                             "Failed to allocate memory for user", NULL,
                             ERR_MEMORY_ALLOC_FAIL);
                         sqlite3_finalize(stmt);
@@ -143,15 +165,17 @@ result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user) {
                 user->id           = sqlite3_column_int(stmt, 0);
                 const char* uname  = (const char*)sqlite3_column_text(stmt, 1);
                 const char* pwhash = (const char*)sqlite3_column_text(stmt, 2);
+                user->token_generation =
+                    (uint32_t)sqlite3_column_int64(stmt, 3);
 
-                user->username      = uname ? strdup(uname) : NULL;
-                user->password_hash = pwhash ? strdup(pwhash) : NULL;
+                user->username      = arena_strdup(arena, uname);
+                user->password_hash = arena_strdup(arena, pwhash);
 
                 if (!user->username || !user->password_hash) {
-                        result_t* res = result_critical_failure(
+                        result_t res = result_critical_failure(
                             "Failed to allocate memory for user fields", NULL,
                             ERR_MEMORY_ALLOC_FAIL);
-                        user_free(user);
+                        discard_user(user, arena);
                         sqlite3_finalize(stmt);
                         return res;
                 }
@@ -161,9 +185,23 @@ result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user) {
                 return result_success();
         }
 
-        result_t* res =
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in SELECT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        result_t res =
             result_failure("User not found", NULL, ERR_USER_NOT_FOUND);
-        result_add_extra(res, "id=%d", id);
+        result_add_extra(&res, "id=%d", id);
         sqlite3_finalize(stmt);
         return res;
 }
@@ -172,52 +210,56 @@ result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user) {
  * @brief Fetch a user from the database by username
  * @param db SQLite database connection
  * @param username Username to search for
- * @param out_user Pointer to store fetched user (caller must free)
+ * @param out_user Pointer to store fetched user (owned by @p arena, or caller
+ * must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_fetch_by_username(sqlite3* db, const char* username,
-                                 user_t** out_user) {
+static result_t user_fetch_by_username_impl(sqlite3* db,
+                                            const char* username,
+                                            user_t** out_user,
+                                            arena_t* arena) {
         if (out_user) {
                 *out_user = NULL;
         }
 
         if (!db || !username || !out_user) {
-                result_t* res = result_failure("Invalid arguments", NULL,
-                                               ERR_INVALID_INPUT);
-                result_add_extra(res, "db=%p, username=%p, out_user=%p",
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, username=%p, out_user=%p",
                                  (const void*)db, (const void*)username,
                                  (const void*)out_user);
                 return res;
         }
 
         const char* sql =
-            "SELECT id, username, password_hash FROM users WHERE username = ? "
-            "COLLATE NOCASE LIMIT 1;";
+            "SELECT id, username, password_hash, token_generation FROM users "
+            "WHERE username = ? COLLATE NOCASE LIMIT 1;";
         sqlite3_stmt* stmt = NULL;
 
         int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
         if (rc != SQLITE_OK) {
-                result_t* res =
+                result_t res =
                     result_failure("Failed to prepare SQL statement", NULL,
                                    ERR_SQL_PREPARE_FAIL);
-                result_add_extra(res, "sqlite_error=%s", sqlite3_errmsg(db));
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
                 return res;
         }
 
         rc = sqlite3_bind_text(stmt, 1, username, -1, SQLITE_TRANSIENT);
         if (rc != SQLITE_OK) {
-                result_t* res = result_failure("Failed to bind SQL parameters",
-                                               NULL, ERR_SQL_BIND_FAIL);
-                result_add_extra(res, "sqlite_error=%s", sqlite3_errmsg(db));
+                result_t res = result_failure("Failed to bind SQL parameters",
+                                              NULL, ERR_SQL_BIND_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
                 sqlite3_finalize(stmt);
                 return res;
         }
 
         rc = sqlite3_step(stmt);
         if (rc == SQLITE_ROW) {
-                user_t* user = malloc(sizeof(user_t));
+                user_t* user = arena_alloc(arena, sizeof(user_t));
                 if (!user) {
-                        result_t* res = result_critical_failure(
+                        result_t res = result_critical_failure(
                             "Failed to allocate memory for user", NULL,
                             ERR_MEMORY_ALLOC_FAIL);
                         sqlite3_finalize(stmt);
@@ -230,27 +272,29 @@ result_t* user_fetch_by_username(sqlite3* db, const char* username,
                 user->id           = sqlite3_column_int(stmt, 0);
                 const char* uname  = (const char*)sqlite3_column_text(stmt, 1);
                 const char* pwhash = (const char*)sqlite3_column_text(stmt, 2);
+                user->token_generation =
+                    (uint32_t)sqlite3_column_int64(stmt, 3);
 
                 if (uname) {
-                        user->username = strdup(uname);
+                        user->username = arena_strdup(arena, uname);
                         if (!user->username) {
-                                result_t* res = result_critical_failure(
+                                result_t res = result_critical_failure(
                                     "Failed to allocate memory for username",
                                     NULL, ERR_MEMORY_ALLOC_FAIL);
-                                user_free(user);
+                                discard_user(user, arena);
                                 sqlite3_finalize(stmt);
                                 return res;
                         }
                 }
 
                 if (pwhash) {
-                        user->password_hash = strdup(pwhash);
+                        user->password_hash = arena_strdup(arena, pwhash);
                         if (!user->password_hash) {
-                                result_t* res = result_critical_failure(
+                                result_t res = result_critical_failure(
                                     "Failed to allocate memory for "
                                     "password_hash",
                                     NULL, ERR_MEMORY_ALLOC_FAIL);
-                                user_free(user);
+                                discard_user(user, arena);
                                 sqlite3_finalize(stmt);
                                 return res;
                         }
@@ -261,9 +305,249 @@ result_t* user_fetch_by_username(sqlite3* db, const char* username,
                 return result_success();
         }
 
-        result_t* res =
+        if (db_deadline_hit(db, rc)) {
+                result_t res = result_failure("Deadline exceeded in SELECT",
+                                              NULL, ERR_DEADLINE_EXCEEDED);
+                sqlite3_finalize(stmt);
+                return res;
+        }
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        result_t res =
             result_failure("User not found", NULL, ERR_USER_NOT_FOUND);
-        result_add_extra(res, "username=%s", username);
+        result_add_extra(&res, "username=%s", username);
+        sqlite3_finalize(stmt);
+        return res;
+}
+
+/**
+ * @brief Revoke every JWT issued to a user so far
+ * @param db SQLite database connection
+ * @param id User ID
+ * @param out_generation Set to the user's new token generation (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t user_revoke_sessions_impl(sqlite3* db, int id,
+                                          uint32_t* out_generation) {
+        if (out_generation) *out_generation = 0;
+
+        if (!db || id <= 0) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "db=%p, id=%d", (const void*)db, id);
+                return res;
+        }
+
+        /* Such an id has no entry in the segment; bumping its generation
+         * would report a revocation that val_jwt() never sees. */
+        if ((uint32_t)id >= REVOKE_MAX_USERS) {
+                result_t res = result_failure("User id beyond revocation range",
+                                              NULL, ERR_JWT_REVOKE_FAIL);
+                result_add_extra(&res, "id=%d, max=%u", id, REVOKE_MAX_USERS);
+                return res;
+        }
+
+        const char* sql =
+            "UPDATE users SET token_generation = token_generation + 1 "
+            "WHERE id = ? RETURNING token_generation;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        sqlite3_bind_int(stmt, 1, id);
+
+        rc = sqlite3_step(stmt);
+        if (rc != SQLITE_ROW) {
+                result_t res;
+                if (db_deadline_hit(db, rc)) {
+                        res = result_failure("Deadline exceeded in UPDATE",
+                                             NULL, ERR_DEADLINE_EXCEEDED);
+                } else if (rc == SQLITE_DONE) {
+                        res = result_failure("User not found", NULL,
+                                             ERR_USER_NOT_FOUND);
+                        result_add_extra(&res, "id=%d", id);
+                } else {
+                        res = result_failure("Failed to execute SQL statement",
+                                             NULL, ERR_SQL_STEP_FAIL);
+                        result_add_extra(&res, "sqlite_error=%s",
+                                         sqlite3_errmsg(db));
+                }
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        uint32_t generation = (uint32_t)sqlite3_column_int64(stmt, 0);
+
+        /* Outside a transaction the UPDATE commits when the statement
+         * completes; run it to the end before the segment moves. */
+        rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+                result_t res = result_failure("Failed to execute SQL statement",
+                                              NULL, ERR_SQL_STEP_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        if (out_generation) *out_generation = generation;
+        /* Committed but not published: the old tokens stay valid until the
+         * next maint/revoke -l. */
+        if (!revoke_set(id, generation)) {
+                result_t res = result_failure("Revocation segment unavailable",
+                                              NULL, ERR_JWT_REVOKE_FAIL);
+                result_add_extra(&res, "id=%d, generation=%u", id, generation);
+                return res;
+        }
+        return result_success();
+}
+
+/**
+ * @brief Copy every non-zero token generation into the revocation segment
+ * @param db SQLite database connection
+ * @param out_count Set to the number of users copied (nullable)
+ * @return result_t indicating success or failure
+ */
+static result_t user_load_generations_impl(sqlite3* db, size_t* out_count) {
+        if (out_count) *out_count = 0;
+
+        if (!db) {
+                return result_failure("Invalid arguments", NULL,
+                                      ERR_INVALID_INPUT);
+        }
+
+        /* Served by the partial index users_revoked: only users who ever
+         * revoked their sessions are read. */
+        const char* sql =
+            "SELECT id, token_generation FROM users "
+            "WHERE token_generation > 0;";
+        sqlite3_stmt* stmt = NULL;
+
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        if (rc != SQLITE_OK) {
+                result_t res =
+                    result_failure("Failed to prepare SQL statement", NULL,
+                                   ERR_SQL_PREPARE_FAIL);
+                result_add_extra(&res, "sqlite_error=%s", sqlite3_errmsg(db));
+                return res;
+        }
+
+        size_t count = 0;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                if (revoke_set(sqlite3_column_int64(stmt, 0),
+                               (uint32_t)sqlite3_column_int64(stmt, 1)))
+                        ++count;
+        }
+
+        if (rc != SQLITE_DONE) {
+                result_t res;
+                if (db_deadline_hit(db, rc)) {
+                        res = result_failure("Deadline exceeded in SELECT",
+                                             NULL, ERR_DEADLINE_EXCEEDED);
+                } else {
+                        res = result_failure("Failed to execute SQL statement",
+                                             NULL, ERR_SQL_STEP_FAIL);
+                        result_add_extra(&res, "sqlite_error=%s",
+                                         sqlite3_errmsg(db));
+                }
+                sqlite3_finalize(stmt);
+                return res;
+        }
+
+        sqlite3_finalize(stmt);
+        if (out_count) *out_count = count;
+        return result_success();
+}
+
+/**
+ * @brief Insert a new user into the database, recording the call duration
+ * in the metrics segment
+ * @param db SQLite database connection
+ * @param user Pointer to user_t with username and password_hash filled
+ * @param out_user Pointer to store inserted user with generated ID
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_insert(sqlite3* db, const user_t* user, user_t** out_user,
+                     arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = user_insert_impl(db, user, out_user, arena);
+        metrics_observe_dal("user_insert", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Fetch a user by ID, recording the call duration in the metrics
+ * segment
+ * @param db SQLite database connection
+ * @param id ID to search for
+ * @param out_user Pointer to store fetched user
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_fetch_by_id(sqlite3* db, int id, user_t** out_user,
+                          arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res   = user_fetch_by_id_impl(db, id, out_user, arena);
+        metrics_observe_dal("user_by_id", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Fetch a user by username, recording the call duration in the
+ * metrics segment
+ * @param db SQLite database connection
+ * @param username Username to search for
+ * @param out_user Pointer to store fetched user
+ * @param arena Request arena to allocate the output from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_fetch_by_username(sqlite3* db, const char* username,
+                                user_t** out_user, arena_t* arena) {
+        uint64_t start = timing_now_ns();
+        result_t res =
+            user_fetch_by_username_impl(db, username, out_user, arena);
+        metrics_observe_dal("user_by_name", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Revoke every JWT issued to a user so far, recording the call
+ * duration in the metrics segment
+ * @param db SQLite database connection
+ * @param id User ID
+ * @param out_generation Set to the user's new token generation (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_revoke_sessions(sqlite3* db, int id, uint32_t* out_generation) {
+        uint64_t start = timing_now_ns();
+        result_t res   = user_revoke_sessions_impl(db, id, out_generation);
+        metrics_observe_dal("user_revoke", timing_now_ns() - start);
+        return res;
+}
+
+/**
+ * @brief Copy every non-zero token generation into the revocation segment,
+ * recording the call duration in the metrics segment
+ * @param db SQLite database connection
+ * @param out_count Set to the number of users copied (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_load_generations(sqlite3* db, size_t* out_count) {
+        uint64_t start = timing_now_ns();
+        result_t res   = user_load_generations_impl(db, out_count);
+        metrics_observe_dal("user_load_gens", timing_now_ns() - start);
         return res;
 }
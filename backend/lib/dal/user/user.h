@@ -2,7 +2,10 @@
 #define DAL_USER_H
 
 #include <sqlite3.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "/app/backend/lib/arena/arena.h"
 #include "/app/backend/lib/models/user_model/user_model.h"
 #include "/app/backend/lib/result/result.h"
 
@@ -15,36 +18,65 @@
  * @brief Insert a new user into the database
  * @param db SQLite database connection
  * @param user Pointer to user_t with username and password_hash filled
- * @param out_user Pointer to store inserted user with generated ID (caller must
- * free)
+ * @param out_user Pointer to store inserted user with generated ID (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_insert(sqlite3* db, const user_t* user, user_t** out_user);
+result_t user_insert(sqlite3* db, const user_t* user, user_t** out_user,
+                     arena_t* arena);
 
 /**
  * @brief Fetch a user from the database by ID
  * @param db SQLite database connection
  * @param id ID to search for
- * @param out_user Pointer to store fetched user (caller must free)
+ * @param out_user Pointer to store fetched user (owned by @p arena, or caller
+ * must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_fetch_by_id(sqlite3* db, int id, user_t** out_user);
+result_t user_fetch_by_id(sqlite3* db, int id, user_t** out_user,
+                          arena_t* arena);
 
 /**
  * @brief Fetch a user from the database by username
  * @param db SQLite database connection
  * @param username Username to search for
- * @param out_user Pointer to store fetched user (caller must free)
+ * @param out_user Pointer to store fetched user (owned by @p arena, or caller
+ * must free when @p arena is NULL)
+ * @param arena Request arena to allocate the output from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* user_fetch_by_username(sqlite3* db, const char* username,
-                                 user_t** out_user);
-// Library-specific error codes (1300-1399)
-#define ERR_INVALID_INPUT 1301
-#define ERR_SQL_PREPARE_FAIL 1302
-#define ERR_SQL_BIND_FAIL 1303
-#define ERR_SQL_STEP_FAIL 1304
-#define ERR_USER_NOT_FOUND 1305
-#define ERR_USER_DUPLICATE 1306
+result_t user_fetch_by_username(sqlite3* db, const char* username,
+                                user_t** out_user, arena_t* arena);
+
+/**
+ * @brief Revoke every JWT issued to a user so far
+ *
+ * Bumps users.token_generation, then raises the user's entry in the
+ * revocation segment (lib/revoke), so tokens carrying an older generation
+ * are rejected by val_jwt() from then on. Fails with ERR_JWT_REVOKE_FAIL,
+ * before touching the row, for an id of REVOKE_MAX_USERS or above, and
+ * after the commit if the segment cannot take the new generation (off or
+ * unmapped); maint/revoke -l publishes it later.
+ *
+ * @param db SQLite database connection
+ * @param id User ID
+ * @param out_generation Set to the user's new token generation (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_revoke_sessions(sqlite3* db, int id, uint32_t* out_generation);
+
+/**
+ * @brief Copy every non-zero token generation into the revocation segment
+ *
+ * Used by maint/revoke at start, before the segment is marked loaded.
+ *
+ * @param db SQLite database connection
+ * @param out_count Set to the number of users copied (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t user_load_generations(sqlite3* db, size_t* out_count);
+// Library-specific error codes (1300-1399) live in lib/errors/errors.h
 
 #endif// DAL_USER_H
@@ -0,0 +1,41 @@
+/**
+ * @file deadline.c
+ * @brief Deadline setup and checks.
+ */
+
+#include "deadline.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Start a deadline @p budget_ms from now.
+ * @param d Deadline to initialize.
+ * @param budget_ms Time the request may take.
+ */
+void deadline_init(deadline_t* d, uint32_t budget_ms) {
+        if (!d) return;
+
+        const char* env = getenv("SFE_DEADLINE_MS");
+        if (env && *env) budget_ms = (uint32_t)strtoul(env, NULL, 10);
+
+        d->at_ns =
+            budget_ms ? timing_now_ns() + (uint64_t)budget_ms * 1000000ull
+                      : 0;
+}
+
+/**
+ * @brief Fail unless at least @p min_ms remain.
+ * @param d Deadline (nullable).
+ * @param min_ms Time the next step needs.
+ * @return Success, or ERR_DEADLINE_EXCEEDED.
+ */
+result_t deadline_check(const deadline_t* d, uint32_t min_ms) {
+        uint64_t left = deadline_remaining_ns(d);
+        if (left > (uint64_t)min_ms * 1000000ull) return result_success();
+
+        result_t res = result_failure("Request deadline exceeded", NULL,
+                                      ERR_DEADLINE_EXCEEDED);
+        result_add_extra(&res, "remaining_ms=%llu, needed_ms=%u",
+                         (unsigned long long)(left / 1000000ull), min_ms);
+        return res;
+}
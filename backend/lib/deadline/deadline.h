@@ -0,0 +1,74 @@
+/**
+ * @file deadline.h
+ * @brief Per-request time budget shared by the handler and the libraries.
+ *
+ * A handler starts a deadline_t when the request arrives and passes it to
+ * every layer that can block: db_set_deadline() makes SQLite interrupt
+ * statements and stop retrying locks once it expires, and deadline_check()
+ * guards work that cannot be interrupted, such as Argon2. Expiry surfaces
+ * as ERR_DEADLINE_EXCEEDED, which response_from_result() turns into a 503.
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/result/result.h"
+#include "/app/backend/lib/timing/timing.h"
+
+// Library-specific error codes (3100-3199) live in lib/errors/errors.h
+
+/**
+ * @struct deadline_t
+ * @brief Absolute monotonic expiry time of a request.
+ */
+typedef struct {
+        uint64_t at_ns; /**< CLOCK_MONOTONIC expiry, 0 for no deadline */
+} deadline_t;
+
+/**
+ * @brief Start a deadline @p budget_ms from now.
+ *
+ * SFE_DEADLINE_MS overrides the budget for every handler; 0 disables
+ * deadlines.
+ *
+ * @param d Deadline to initialize.
+ * @param budget_ms Time the request may take.
+ */
+void deadline_init(deadline_t* d, uint32_t budget_ms);
+
+/**
+ * @brief Nanoseconds left before expiry.
+ * @param d Deadline (nullable).
+ * @return Time left, 0 once expired, UINT64_MAX without a deadline.
+ */
+static inline uint64_t deadline_remaining_ns(const deadline_t* d) {
+        if (!d || !d->at_ns) return UINT64_MAX;
+        uint64_t now = timing_now_ns();
+        return now < d->at_ns ? d->at_ns - now : 0;
+}
+
+/**
+ * @brief Whether the deadline has passed.
+ * @param d Deadline (nullable).
+ * @return true once expired.
+ */
+static inline bool deadline_expired(const deadline_t* d) {
+        return deadline_remaining_ns(d) == 0;
+}
+
+/**
+ * @brief Fail unless at least @p min_ms remain.
+ *
+ * Call before work that cannot be interrupted, with roughly the time it
+ * takes, so it is not started only to be abandoned.
+ *
+ * @param d Deadline (nullable).
+ * @param min_ms Time the next step needs.
+ * @return Success, or ERR_DEADLINE_EXCEEDED.
+ */
+result_t deadline_check(const deadline_t* d, uint32_t min_ms);
+
+#endif// DEADLINE_H_
@@ -0,0 +1,69 @@
+/**
+ * @file errors.c
+ * @brief Lookup tables generated from ERROR_REGISTRY.
+ *
+ * error_table holds one entry per registered error, preceded by the generic
+ * fallback. error_slot maps a numeric code straight to its table index, so a
+ * lookup is two indexed loads with no search or branching on the code.
+ */
+
+#include "errors.h"
+
+#include <stddef.h>
+
+/** @brief Dense table indices, one per registered error. */
+enum error_index {
+        ERROR_INDEX_UNKNOWN = 0,
+#define ERROR_INDEX_ENUM(name, code, status, severity, message) \
+        ERROR_INDEX_##name,
+        ERROR_REGISTRY(ERROR_INDEX_ENUM)
+#undef ERROR_INDEX_ENUM
+            ERROR_INDEX_COUNT
+};
+
+_Static_assert(ERROR_INDEX_COUNT <= 256,
+               "error_slot stores indices as unsigned char");
+
+/** @brief Registry entries, indexed by enum error_index. */
+static const error_info_t error_table[ERROR_INDEX_COUNT] = {
+    [ERROR_INDEX_UNKNOWN] = {0, "ERR_UNKNOWN", 500, ERROR_SEVERITY_ERROR,
+                             ERROR_MSG_INTERNAL},
+#define ERROR_TABLE_ENTRY(name, code, status, severity, message) \
+        [ERROR_INDEX_##name] = {code, #name, status, severity, message},
+    ERROR_REGISTRY(ERROR_TABLE_ENTRY)
+#undef ERROR_TABLE_ENTRY
+};
+
+/** @brief Numeric code to table index; zero means unregistered. */
+static const unsigned char error_slot[ERROR_CODE_LIMIT] = {
+#define ERROR_SLOT_ENTRY(name, code, status, severity, message) \
+        [code] = ERROR_INDEX_##name,
+    ERROR_REGISTRY(ERROR_SLOT_ENTRY)
+#undef ERROR_SLOT_ENTRY
+};
+
+/**
+ * @brief Look up the registry entry for an error code.
+ *
+ * @param code Numeric error code.
+ * @return Registry entry, or the generic 500 entry for unknown codes.
+ */
+const error_info_t* error_lookup(int code) {
+        if (code < 0 || code >= ERROR_CODE_LIMIT)
+                return &error_table[ERROR_INDEX_UNKNOWN];
+        return &error_table[error_slot[code]];
+}
+
+/**
+ * @brief Human-readable name of a severity level.
+ *
+ * @param severity Severity level.
+ * @return Static string.
+ */
+const char* error_severity_name(error_severity_t severity) {
+        static const char* const names[] = {"info", "warning", "error",
+                                            "critical"};
+        if ((unsigned)severity >= sizeof(names) / sizeof(names[0]))
+                return "unknown";
+        return names[severity];
+}
@@ -0,0 +1,211 @@
+/**
+ * @file errors.h
+ * @brief Declarative registry of every error code in the backend.
+ *
+ * ERROR_REGISTRY is an X-macro: each entry lists the symbolic name, numeric
+ * code, HTTP status, log severity and the public message clients see. The
+ * same list generates the code constants below and the lookup tables in
+ * errors.c, so adding an error is a one-line change here.
+ *
+ * Codes are grouped per library in blocks of 100; run
+ * `./find_dup_code.sh <code>` before picking a new one.
+ */
+
+#ifndef ERRORS_H_
+#define ERRORS_H_
+
+/**
+ * @enum error_severity
+ * @brief Log severity attached to each error code.
+ */
+typedef enum error_severity {
+        ERROR_SEVERITY_INFO     = 0, /**< Expected client mistake */
+        ERROR_SEVERITY_WARNING  = 1, /**< Suspicious or degraded request */
+        ERROR_SEVERITY_ERROR    = 2, /**< Server-side failure */
+        ERROR_SEVERITY_CRITICAL = 3  /**< Misconfiguration or resource loss */
+} error_severity_t;
+
+/** @brief Public message used for every server-side failure. */
+#define ERROR_MSG_INTERNAL "Internal Server Error"
+
+/** @brief Public message for any rejected CSRF token. */
+#define ERROR_MSG_CSRF "Invalid csrf Token."
+
+/** @brief Public message for any rejected JWT. */
+#define ERROR_MSG_JWT "Invalid token."
+
+/* clang-format off */
+/**
+ * @def ERROR_REGISTRY
+ * @brief X(name, code, http_status, severity, public_message) for every
+ * error.
+ */
+#define ERROR_REGISTRY(X)                                                     \
+        /* Common (998-999, 9999) */                                          \
+        X(ERR_HEX_DECODE_FAIL, 998, 400, ERROR_SEVERITY_INFO,                 \
+          "Malformed hex input.")                                             \
+        X(ERR_MEMORY_ALLOC_FAIL, 999, 500, ERROR_SEVERITY_CRITICAL,           \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_TEST_FAIL, 9999, 500, ERROR_SEVERITY_INFO, "Test failure.")     \
+        /* lib/secrets (1000-1099) */                                         \
+        X(ERR_SECRET_INVALID_INPUT, 1001, 500, ERROR_SEVERITY_ERROR,          \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_FILE_OPEN, 1002, 500, ERROR_SEVERITY_CRITICAL,                  \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_FILE_SEEK, 1003, 500, ERROR_SEVERITY_CRITICAL,                  \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_INVALID_SIZE, 1004, 500, ERROR_SEVERITY_CRITICAL,               \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_MEMORY_ALLOC, 1005, 500, ERROR_SEVERITY_CRITICAL,               \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_FILE_READ, 1006, 500, ERROR_SEVERITY_CRITICAL,                  \
+          ERROR_MSG_INTERNAL)                                                 \
+        /* lib/jwt (1100-1199) */                                             \
+        X(ERR_JWT_INVALID_ID, 1101, 500, ERROR_SEVERITY_ERROR,                \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JWT_SECRET_FAIL, 1102, 500, ERROR_SEVERITY_CRITICAL,            \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JWT_JSON_FAIL, 1103, 500, ERROR_SEVERITY_ERROR,                 \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JWT_GENERATE_FAIL, 1104, 500, ERROR_SEVERITY_ERROR,             \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JWT_INVALID_ARGS, 1105, 401, ERROR_SEVERITY_INFO,               \
+          ERROR_MSG_JWT)                                                      \
+        X(ERR_JWT_MALFORMED, 1106, 401, ERROR_SEVERITY_INFO,                  \
+          ERROR_MSG_JWT)                                                      \
+        X(ERR_JWT_SECRET_EMPTY, 1107, 500, ERROR_SEVERITY_CRITICAL,           \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JWT_VALIDATE_FAIL, 1108, 401, ERROR_SEVERITY_INFO,              \
+          ERROR_MSG_JWT)                                                      \
+        X(ERR_JWT_REVOKED, 1109, 401, ERROR_SEVERITY_INFO, ERROR_MSG_JWT)     \
+        X(ERR_JWT_REVOCATION_UNLOADED, 1110, 503, ERROR_SEVERITY_CRITICAL,    \
+          "Server busy.")                                                     \
+        X(ERR_JWT_REVOKE_FAIL, 1111, 500, ERROR_SEVERITY_CRITICAL,            \
+          ERROR_MSG_INTERNAL)                                                 \
+        /* lib/models/user_model (1200-1299) */                               \
+        X(ERR_USER_NULL, 1201, 500, ERROR_SEVERITY_ERROR, ERROR_MSG_INTERNAL) \
+        X(ERR_JSON_CREATE_FAIL, 1202, 500, ERROR_SEVERITY_ERROR,              \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_JSON_PARSE_FAIL, 1203, 400, ERROR_SEVERITY_INFO,                \
+          "Malformed JSON")                                                   \
+        X(ERR_MANDATORY_FIELDS_MISSING, 1204, 400, ERROR_SEVERITY_INFO,       \
+          "Missing required fields.")                                         \
+        /* lib/dal (1300-1399) */                                             \
+        X(ERR_INVALID_INPUT, 1301, 500, ERROR_SEVERITY_ERROR,                 \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_SQL_PREPARE_FAIL, 1302, 500, ERROR_SEVERITY_CRITICAL,           \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_SQL_BIND_FAIL, 1303, 500, ERROR_SEVERITY_ERROR,                 \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_SQL_STEP_FAIL, 1304, 500, ERROR_SEVERITY_ERROR,                 \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_USER_NOT_FOUND, 1305, 404, ERROR_SEVERITY_INFO,                 \
+          "User not found.")                                                  \
+        X(ERR_USER_DUPLICATE, 1306, 400, ERROR_SEVERITY_INFO,                 \
+          "Username already exists.")                                         \
+        X(ERR_DB_OPEN_FAIL, 1307, 500, ERROR_SEVERITY_CRITICAL,               \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_THREAD_NOT_FOUND, 1308, 404, ERROR_SEVERITY_INFO,               \
+          "Thread not found.")                                                \
+        X(ERR_POST_NOT_FOUND, 1309, 404, ERROR_SEVERITY_INFO,                 \
+          "Post not found.")                                                  \
+        X(ERR_SEARCH_QUERY_EMPTY, 1310, 400, ERROR_SEVERITY_INFO,             \
+          "Search query has no searchable terms.")                            \
+        /* lib/hash_password (1400-1499) */                                   \
+        X(ERR_NULL_INPUT, 1401, 500, ERROR_SEVERITY_ERROR, ERROR_MSG_INTERNAL) \
+        X(ERR_SALT_GENERATION_FAIL, 1402, 500, ERROR_SEVERITY_CRITICAL,       \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_HASHING_FAIL, 1403, 500, ERROR_SEVERITY_CRITICAL,               \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_INVALID_HASH_FORMAT, 1404, 500, ERROR_SEVERITY_ERROR,           \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_INVALID_ITERATION_COUNT, 1405, 500, ERROR_SEVERITY_ERROR,       \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_HASH_MISMATCH, 1406, 401, ERROR_SEVERITY_INFO,                  \
+          "Invalid username or password.")                                    \
+        X(ERR_HASH_OUTPUT_PTR_NULL, 1407, 500, ERROR_SEVERITY_ERROR,          \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_LIBSODIUM_FAIL, 1408, 500, ERROR_SEVERITY_CRITICAL,             \
+          ERROR_MSG_INTERNAL)                                                 \
+        /* lib/csrf (1500-1599) */                                            \
+        X(ERR_RAND_BYTES_FAIL, 1501, 500, ERROR_SEVERITY_CRITICAL,            \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_CSRF_SECRET_FAIL, 1502, 500, ERROR_SEVERITY_CRITICAL,           \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_CSRF_SECRET_EMPTY, 1503, 500, ERROR_SEVERITY_CRITICAL,          \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_HMAC_GENERATION_FAIL, 1504, 500, ERROR_SEVERITY_ERROR,          \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_HMAC_LENGTH_MISMATCH, 1505, 500, ERROR_SEVERITY_ERROR,          \
+          ERROR_MSG_INTERNAL)                                                 \
+        X(ERR_NULL_TOKEN, 1506, 400, ERROR_SEVERITY_INFO, ERROR_MSG_CSRF)     \
+        X(ERR_TOKEN_LENGTH_MISMATCH, 1508, 400, ERROR_SEVERITY_INFO,          \
+          ERROR_MSG_CSRF)                                                     \
+        X(ERR_TOKEN_FUTURE_TIMESTAMP, 1509, 400, ERROR_SEVERITY_WARNING,      \
+          ERROR_MSG_CSRF)                                                     \
+        X(ERR_TOKEN_EXPIRED, 1510, 400, ERROR_SEVERITY_INFO, ERROR_MSG_CSRF)  \
+        X(ERR_HMAC_MISMATCH, 1511, 400, ERROR_SEVERITY_WARNING,               \
+          ERROR_MSG_CSRF)                                                     \
+        X(ERR_INVALID_TOKEN, 1512, 400, ERROR_SEVERITY_INFO, ERROR_MSG_CSRF)  \
+        /* lib/read_post_data (2000-2099) */                                  \
+        X(ERR_INVALID_CONTENT_LENGTH, 2001, 400, ERROR_SEVERITY_INFO,         \
+          "Invalid Content Length for POST")                                  \
+        X(ERR_READ_FAIL, 2002, 500, ERROR_SEVERITY_ERROR, ERROR_MSG_INTERNAL) \
+        /* lib/read_get_data (3000-3099) */                                   \
+        X(ERR_GET_NULL_INPUT, 3001, 400, ERROR_SEVERITY_INFO,                 \
+          "Missing query string.")                                            \
+        X(ERR_GET_PARAM_MISSING, 3002, 400, ERROR_SEVERITY_INFO,              \
+          "Missing query parameter.")                                         \
+        X(ERR_GET_PARAM_TOO_LONG, 3003, 400, ERROR_SEVERITY_INFO,             \
+          "Query parameter too long.")                                        \
+        /* lib/deadline (3100-3199) */                                        \
+        X(ERR_DEADLINE_EXCEEDED, 3101, 503, ERROR_SEVERITY_WARNING,           \
+          "Server busy.")                                                     \
+        /* lib/markdown (3200-3299) */                                        \
+        X(ERR_MARKDOWN_TOO_LARGE, 3201, 400, ERROR_SEVERITY_INFO,             \
+          "Post is too long.")                                                \
+        X(ERR_MARKDOWN_OVERFLOW, 3202, 500, ERROR_SEVERITY_CRITICAL,          \
+          ERROR_MSG_INTERNAL)
+/* clang-format on */
+
+/** @brief Error code constants generated from ERROR_REGISTRY. */
+enum error_code {
+#define ERROR_CODE_ENUM(name, code, status, severity, message) name = code,
+        ERROR_REGISTRY(ERROR_CODE_ENUM)
+#undef ERROR_CODE_ENUM
+};
+
+/** @brief Exclusive upper bound for registered numeric codes. */
+#define ERROR_CODE_LIMIT 10000
+
+/**
+ * @struct error_info_t
+ * @brief Registry entry describing how an error is reported.
+ */
+typedef struct {
+        int code;                   /**< Numeric error code */
+        const char* name;           /**< Symbolic name, e.g. "ERR_NULL_TOKEN" */
+        unsigned short http_status; /**< HTTP status sent to the client */
+        error_severity_t severity;  /**< Log severity */
+        const char* public_message; /**< Message safe to show to clients */
+} error_info_t;
+
+/**
+ * @brief Look up the registry entry for an error code in constant time.
+ *
+ * Unknown codes map to a generic 500 entry, so the result is never NULL.
+ *
+ * @param code Numeric error code.
+ * @return Registry entry.
+ */
+const error_info_t* error_lookup(int code);
+
+/**
+ * @brief Human-readable name of a severity level.
+ *
+ * @param severity Severity level.
+ * @return Static string such as "error".
+ */
+const char* error_severity_name(error_severity_t severity);
+
+#endif// ERRORS_H_
@@ -1,6 +1,7 @@
 #include "hash_password.h"
 
 #include <sodium.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,7 +9,44 @@
 #include "/app/backend/lib/result/result.h"
 
 /**
- * @brief Hash a password using libsodium's recommended Argon2id algorithm.
+ * @brief Argon2id hash of 32 random bytes (discarded) at the MODERATE
+ * profile; regenerate it whenever HASH_PROFILE_DEFAULT changes.
+ */
+static const char dummy_hash[] =
+    "$argon2id$v=19$m=262144,t=3,p=1$dY4Ib5kzUNaBmPbUCSidrw$"
+    "MXIlPzCihg18pw9Qw1a3Wix+Spfmk40i6QO4FOqkFlM";
+
+_Static_assert(HASH_PROFILE_DEFAULT == HASH_PROFILE_MODERATE,
+               "dummy_hash must use the default profile");
+
+/**
+ * @brief Resolve a cost profile to libsodium limits.
+ * @param profile Cost profile
+ * @param opslimit Output operations limit
+ * @param memlimit Output memory limit
+ * @return true if the profile is known
+ */
+static bool profile_limits(hash_password_profile_t profile,
+                           unsigned long long* opslimit, size_t* memlimit) {
+        switch (profile) {
+                case HASH_PROFILE_INTERACTIVE:
+                        *opslimit = crypto_pwhash_OPSLIMIT_INTERACTIVE;
+                        *memlimit = crypto_pwhash_MEMLIMIT_INTERACTIVE;
+                        return true;
+                case HASH_PROFILE_MODERATE:
+                        *opslimit = crypto_pwhash_OPSLIMIT_MODERATE;
+                        *memlimit = crypto_pwhash_MEMLIMIT_MODERATE;
+                        return true;
+                case HASH_PROFILE_SENSITIVE:
+                        *opslimit = crypto_pwhash_OPSLIMIT_SENSITIVE;
+                        *memlimit = crypto_pwhash_MEMLIMIT_SENSITIVE;
+                        return true;
+        }
+        return false;
+}
+
+/**
+ * @brief Hash a password with an explicit Argon2id cost profile.
  *
  * Libsodium's crypto_pwhash_str() function handles:
  * 1. Generating a cryptographically secure random salt.
@@ -17,10 +55,15 @@
  * string.
  *
  * @param password Input password to hash
- * @param out_hash Pointer to store the resulting hash string (caller must free)
+ * @param profile Cost profile
+ * @param out_hash Pointer to store the resulting hash string (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the hash string from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* hash_password(const char* password, char** out_hash) {
+result_t hash_password_with_profile(const char* password,
+                                    hash_password_profile_t profile,
+                                    char** out_hash, arena_t* arena) {
         if (out_hash) {
                 *out_hash = NULL;
         }
@@ -34,30 +77,36 @@ result_t* hash_password(const char* password, char** out_hash) {
                                       ERR_HASH_OUTPUT_PTR_NULL);
         }
 
+        unsigned long long opslimit = 0;
+        size_t memlimit             = 0;
+        if (!profile_limits(profile, &opslimit, &memlimit)) {
+                result_t res = result_failure("Unknown hash cost profile", NULL,
+                                              ERR_INVALID_ITERATION_COUNT);
+                result_add_extra(&res, "profile=%d", (int)profile);
+                return res;
+        }
+
         if (sodium_init() == -1) {
                 return result_critical_failure(
                     "Libsodium initialization failed", NULL,
                     ERR_LIBSODIUM_FAIL);
         }
 
-        char* encoded_hash = malloc(PWHASH_STR_LEN);
+        char* encoded_hash = arena_alloc(arena, PWHASH_STR_LEN);
         if (!encoded_hash) {
                 return result_critical_failure("Out of memory for hash string",
                                                NULL, ERR_MEMORY_ALLOC_FAIL);
         }
 
         if (crypto_pwhash_str(encoded_hash, password, strlen(password),
-                              crypto_pwhash_OPSLIMIT_MODERATE,
-                              crypto_pwhash_MEMLIMIT_MODERATE) != 0) {
-                free(encoded_hash);
-                result_t* res =
+                              opslimit, memlimit) != 0) {
+                arena_free(arena, encoded_hash);
+                result_t res =
                     result_critical_failure("Libsodium password hashing failed",
                                             NULL, ERR_HASHING_FAIL);
                 result_add_extra(
-                    res, "password_len=%zu, opslimit=%lu, memlimit=%lu",
-                    strlen(password),
-                    (unsigned long)crypto_pwhash_OPSLIMIT_MODERATE,
-                    (unsigned long)crypto_pwhash_MEMLIMIT_MODERATE);
+                    &res, "password_len=%zu, opslimit=%llu, memlimit=%zu",
+                    strlen(password), opslimit, memlimit);
                 return res;
         }
 
@@ -65,6 +114,21 @@ result_t* hash_password(const char* password, char** out_hash) {
         return result_success();
 }
 
+/**
+ * @brief Hash a password using libsodium's recommended Argon2id algorithm
+ * with HASH_PROFILE_DEFAULT.
+ * @param password Input password to hash
+ * @param out_hash Pointer to store the resulting hash string (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the hash string from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t hash_password(const char* password, char** out_hash,
+                       arena_t* arena) {
+        return hash_password_with_profile(password, HASH_PROFILE_DEFAULT,
+                                          out_hash, arena);
+}
+
 /**
  * @brief Verify a password against a stored hash using libsodium's function.
  *
@@ -78,11 +142,11 @@ result_t* hash_password(const char* password, char** out_hash) {
  * @param stored_hash Stored hash string (in libsodium's encoded format)
  * @return result_t indicating success (match) or failure (mismatch or error)
  */
-result_t* verify_password(const char* password, const char* stored_hash) {
+result_t verify_password(const char* password, const char* stored_hash) {
         if (!password || !stored_hash) {
-                result_t* res = result_failure(
+                result_t res = result_failure(
                     "Password or stored hash is NULL", NULL, ERR_NULL_INPUT);
-                result_add_extra(res, "password=%p, stored_hash=%p",
+                result_add_extra(&res, "password=%p, stored_hash=%p",
                                  (const void*)password,
                                  (const void*)stored_hash);
                 return res;
@@ -103,3 +167,20 @@ result_t* verify_password(const char* password, const char* stored_hash) {
 
         return result_success();
 }
+
+/**
+ * @brief Verify a password against a fixed hash that no password matches.
+ *
+ * The hash is checked exactly like a stored one, so the cost (memory, passes,
+ * parsing) is that of a real HASH_PROFILE_DEFAULT verification. A match is
+ * still reported as a mismatch.
+ *
+ * @param password Input password
+ * @return ERR_HASH_MISMATCH, or another failure if the check itself failed
+ */
+result_t verify_password_dummy(const char* password) {
+        result_t res = verify_password(password, dummy_hash);
+        if (res.code != RESULT_SUCCESS) return res;
+        return result_failure("Password hash mismatch or invalid format", NULL,
+                              ERR_HASH_MISMATCH);
+}
@@ -3,18 +3,10 @@
 
 #include <sodium.h>
 
+#include "/app/backend/lib/arena/arena.h"
 #include "/app/backend/lib/result/result.h"
 
-// Library-specific error codes (1400-1499)
-#define ERR_NULL_INPUT 1401
-#define ERR_NULL_OUTPUT_PTR 1407
-#define ERR_SALT_GENERATION_FAIL 1402
-#define ERR_HASHING_FAIL 1403
-#define ERR_INVALID_HASH_FORMAT 1404
-#define ERR_INVALID_ITERATION_COUNT 1405
-#define ERR_HASH_MISMATCH 1406
-#define ERR_HASH_OUTPUT_PTR_NULL 1407
-#define ERR_LIBSODIUM_FAIL 1408
+// Library-specific error codes (1400-1499) live in lib/errors/errors.h
 
 /**
  * @brief The maximum length required to store the full encoded hash string
@@ -25,13 +17,42 @@
 #define PWHASH_STR_LEN crypto_pwhash_STRBYTES
 
 /**
- * @brief Hash a password using libsodium's recommended Argon2id algorithm.
+ * @enum hash_password_profile
+ * @brief Argon2id cost presets, mapped onto libsodium's limits.
+ */
+typedef enum hash_password_profile {
+        HASH_PROFILE_INTERACTIVE = 0, /**< OPSLIMIT/MEMLIMIT_INTERACTIVE */
+        HASH_PROFILE_MODERATE    = 1, /**< OPSLIMIT/MEMLIMIT_MODERATE */
+        HASH_PROFILE_SENSITIVE   = 2  /**< OPSLIMIT/MEMLIMIT_SENSITIVE */
+} hash_password_profile_t;
+
+/** @brief Profile used by hash_password(). */
+#define HASH_PROFILE_DEFAULT HASH_PROFILE_MODERATE
+
+/**
+ * @brief Hash a password with an explicit Argon2id cost profile.
+ * @param password Input password to hash
+ * @param profile Cost profile
+ * @param out_hash Pointer to store the resulting encoded hash string (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the hash string from (nullable)
+ * @return result_t indicating success or failure
+ */
+result_t hash_password_with_profile(const char* password,
+                                    hash_password_profile_t profile,
+                                    char** out_hash, arena_t* arena);
+
+/**
+ * @brief Hash a password using libsodium's recommended Argon2id algorithm
+ * with HASH_PROFILE_DEFAULT.
  * @param password Input password to hash
- * @param out_hash Pointer to store the resulting encoded hash string (caller
- * must free)
+ * @param out_hash Pointer to store the resulting encoded hash string (owned by
+ * @p arena, or caller must free when @p arena is NULL)
+ * @param arena Request arena to allocate the hash string from (nullable)
  * @return result_t indicating success or failure
  */
-result_t* hash_password(const char* password, char** out_hash);
+result_t hash_password(const char* password, char** out_hash,
+                       arena_t* arena);
 
 /**
  * @brief Verify a password against a stored hash using libsodium's function.
@@ -40,6 +61,18 @@ result_t* hash_password(const char* password, char** out_hash);
  * format)
  * @return result_t indicating success (match) or failure (mismatch or error)
  */
-result_t* verify_password(const char* password, const char* stored_hash);
+result_t verify_password(const char* password, const char* stored_hash);
+
+/**
+ * @brief Verify a password against a fixed hash that no password matches.
+ *
+ * Costs the same as verify_password() against a hash made with
+ * HASH_PROFILE_DEFAULT, so a login for an unknown user takes as long as a
+ * wrong password for a real one.
+ *
+ * @param password Input password
+ * @return ERR_HASH_MISMATCH, or another failure if the check itself failed
+ */
+result_t verify_password_dummy(const char* password);
 
 #endif
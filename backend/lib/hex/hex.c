@@ -0,0 +1,52 @@
+/**
+ * @file hex.c
+ * @brief Lowercase hexadecimal encoding and decoding.
+ */
+
+#include "hex.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Convert a nibble to a hexadecimal character
+ * @param c Input nibble
+ * @return Hexadecimal character
+ */
+static char hex_char(unsigned char c) { return "0123456789abcdef"[c & 0x0f]; }
+
+/**
+ * @brief Convert binary data to hexadecimal string
+ * @param src Binary input data
+ * @param len Length of binary data
+ * @param dest Output buffer for hex string
+ */
+void hex_encode(const unsigned char* src, size_t len, char* dest) {
+        for (size_t i = 0; i < len; ++i) {
+                unsigned char hi = (unsigned char)(src[i] >> 4);
+                unsigned char lo = (unsigned char)(src[i] & 0x0f);
+                dest[i * 2]      = hex_char(hi);
+                dest[i * 2 + 1]  = hex_char(lo);
+        }
+        dest[len * 2] = '\0';
+}
+
+/**
+ * @brief Convert hexadecimal string to binary data
+ * @param src Hexadecimal input string
+ * @param dest Output buffer for binary data
+ * @param len Expected length of output
+ * @return true on success, false on failure
+ */
+bool hex_decode(const char* src, unsigned char* dest, size_t len) {
+        char buf[3] = {0, 0, 0};
+        for (size_t i = 0; i < len; ++i) {
+                buf[0]            = src[i * 2];
+                buf[1]            = src[i * 2 + 1];
+                unsigned int byte = 0;
+                if (sscanf(buf, "%2x", &byte) != 1) {
+                        return false;
+                }
+                dest[i] = (unsigned char)byte;
+        }
+        return true;
+}
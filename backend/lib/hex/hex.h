@@ -0,0 +1,29 @@
+/**
+ * @file hex.h
+ * @brief Lowercase hexadecimal encoding and decoding.
+ */
+
+#ifndef HEX_H_
+#define HEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Convert binary data to a NUL-terminated hexadecimal string
+ * @param src Binary input data
+ * @param len Length of binary data
+ * @param dest Output buffer of at least len * 2 + 1 bytes
+ */
+void hex_encode(const unsigned char* src, size_t len, char* dest);
+
+/**
+ * @brief Convert a hexadecimal string to binary data
+ * @param src Hexadecimal input string of at least len * 2 characters
+ * @param dest Output buffer for binary data
+ * @param len Expected length of output
+ * @return true on success, false on failure
+ */
+bool hex_decode(const char* src, unsigned char* dest, size_t len);
+
+#endif// HEX_H_
@@ -1,11 +1,12 @@
 #include "jwt.h"
 
-#include <sanitizec.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "/app/backend/lib/revoke/revoke.h"
 #include "/app/backend/lib/secrets/secrets.h"
+#include "/app/backend/lib/validate/validate.h"
 #include "jwtc.h"
 
 /**
@@ -14,46 +15,48 @@
  */
 
 /**
- * @brief Issues a JWT token with a single "id" claim, valid for one week
+ * @brief Issues a JWT token with "id" and "gen" claims, valid for one week
  * @param id The user or entity ID to include in the token
+ * @param generation The user's token generation (users.token_generation);
+ * the token is revoked once the generation moves past it
  * @param out_token Pointer to store the malloc'd JWT string (caller must free)
  * @return result_t indicating success or failure
  */
-result_t* issue_jwt(const char* id, char** out_token) {
+result_t issue_jwt(const char* id, uint32_t generation, char** out_token) {
         if (out_token) {
                 *out_token = NULL;
         }
 
         if (!id) {
-                result_t* res = result_failure("User ID cannot be NULL", NULL,
-                                               ERR_JWT_INVALID_ID);
-                result_add_extra(res, "id=%p", (const void*)id);
+                result_t res = result_failure("User ID cannot be NULL", NULL,
+                                              ERR_JWT_INVALID_ID);
+                result_add_extra(&res, "id=%p", (const void*)id);
                 return res;
         }
 
         char* secret = NULL;
-        result_t* sc = get_jwt_secret(&secret);
-        if (sc->code != RESULT_SUCCESS) {
+        result_t sc = get_jwt_secret(&secret);
+        if (sc.code != RESULT_SUCCESS) {
                 return sc;
         }
 
         if (strlen(secret) == 0) {
-                result_t* res = result_failure("JWT secret is empty", NULL,
-                                               ERR_JWT_SECRET_EMPTY);
-                result_free(sc);
+                result_t res = result_failure("JWT secret is empty", NULL,
+                                              ERR_JWT_SECRET_EMPTY);
                 return res;
         }
 
         struct json_object* claims = json_object_new_object();
         if (!claims) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to create JSON object for claims", NULL,
                     ERR_JWT_JSON_FAIL);
-                result_free(sc);
                 return res;
         }
 
         json_object_object_add(claims, "id", json_object_new_string(id));
+        json_object_object_add(claims, "gen",
+                               json_object_new_int64(generation));
         time_t now = time(NULL);
         json_object_object_add(claims, "iat", json_object_new_int64(now));
         json_object_object_add(claims, "exp",
@@ -63,13 +66,12 @@ result_t* issue_jwt(const char* id, char** out_token) {
         char* token     = jwtc_generate(secret, 604800, claims, &jwt_error);
 
         json_object_put(claims);
-        result_free(sc);
 
         if (!token) {
-                result_t* res = result_failure("JWT generation failed", NULL,
-                                               ERR_JWT_GENERATE_FAIL);
+                result_t res = result_failure("JWT generation failed", NULL,
+                                              ERR_JWT_GENERATE_FAIL);
                 if (jwt_error) {
-                        result_add_extra(res, "jwt_error=%s", jwt_error);
+                        result_add_extra(&res, "jwt_error=%s", jwt_error);
                         free(jwt_error);
                 }
                 return res;
@@ -83,6 +85,28 @@ result_t* issue_jwt(const char* id, char** out_token) {
         return result_success();
 }
 
+/**
+ * @brief Check that a token is three non-empty base64url segments joined by
+ * '.', without copying it
+ * @param token Token bytes
+ * @param len Token length
+ * @return true if the token has the compact JWS shape
+ */
+static bool jwt_is_well_formed(const char* token, size_t len) {
+        const char* seg = token;
+        const char* end = token + len;
+        for (int i = 0; i < 3; ++i) {
+                const char* dot = memchr(seg, '.', (size_t)(end - seg));
+                if (i < 2 && !dot) return false;
+                if (i == 2 && dot) return false;
+                const char* seg_end = dot ? dot : end;
+                size_t seg_len      = (size_t)(seg_end - seg);
+                if (seg_len == 0 || !is_base64url(seg, seg_len)) return false;
+                seg = seg_end + 1;
+        }
+        return true;
+}
+
 /**
  * @brief Validates a JWT token and extracts its claims
  * @param token The JWT token string to validate
@@ -90,48 +114,43 @@ result_t* issue_jwt(const char* id, char** out_token) {
  * json_object_put)
  * @return result_t indicating success or failure
  */
-result_t* val_jwt(const char* token, struct json_object** claims_out) {
+result_t val_jwt(const char* token, struct json_object** claims_out) {
         if (claims_out) {
                 *claims_out = NULL;
         }
 
         if (!token || !claims_out) {
-                result_t* res = result_failure("Invalid arguments", NULL,
-                                               ERR_JWT_INVALID_ARGS);
-                result_add_extra(res, "token=%p, claims_out=%p",
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_JWT_INVALID_ARGS);
+                result_add_extra(&res, "token=%p, claims_out=%p",
                                  (const void*)token, (const void*)claims_out);
                 return res;
         }
 
-        char* sanitized_token =
-            sanitizec_apply(token, SANITIZEC_RULE_ALPHANUMERIC_ONLY, NULL);
-        if (!sanitized_token) {
-                result_t* res = result_failure("Token sanitization failed",
-                                               NULL, ERR_JWT_SANITIZE_FAIL);
+        size_t token_len = strnlen(token, JWT_MAX_LENGTH + 1);
+        if (token_len > JWT_MAX_LENGTH ||
+            !jwt_is_well_formed(token, token_len)) {
+                result_t res = result_failure("Malformed token", NULL,
+                                              ERR_JWT_MALFORMED);
+                result_add_extra(&res, "token_length=%zu", token_len);
                 return res;
         }
 
         char* secret = NULL;
-        result_t* sc = get_jwt_secret(&secret);
-        if (sc->code != RESULT_SUCCESS) {
-                free(sanitized_token);
+        result_t sc = get_jwt_secret(&secret);
+        if (sc.code != RESULT_SUCCESS) {
                 return sc;
         }
 
         if (strlen(secret) == 0) {
-                result_t* res = result_failure("JWT secret is empty", NULL,
-                                               ERR_JWT_SECRET_EMPTY);
-                free(sanitized_token);
-                result_free(sc);
+                result_t res = result_failure("JWT secret is empty", NULL,
+                                              ERR_JWT_SECRET_EMPTY);
                 return res;
         }
 
         char* jwt_lib_error = NULL;
-        int valid = jwtc_validate(sanitized_token, secret, 0, claims_out,
-                                  &jwt_lib_error);
-
-        free(sanitized_token);
-        result_free(sc);
+        int valid =
+            jwtc_validate(token, secret, 0, claims_out, &jwt_lib_error);
 
         if (!valid) {
                 if (*claims_out) {
@@ -139,10 +158,10 @@ result_t* val_jwt(const char* token, struct json_object** claims_out) {
                         *claims_out = NULL;
                 }
 
-                result_t* res = result_failure("JWT validation failed", NULL,
-                                               ERR_JWT_VALIDATE_FAIL);
+                result_t res = result_failure("JWT validation failed", NULL,
+                                              ERR_JWT_VALIDATE_FAIL);
                 if (jwt_lib_error) {
-                        result_add_extra(res, "jwt_error=%s", jwt_lib_error);
+                        result_add_extra(&res, "jwt_error=%s", jwt_lib_error);
                         free(jwt_lib_error);
                 }
                 return res;
@@ -152,5 +171,34 @@ result_t* val_jwt(const char* token, struct json_object** claims_out) {
                 free(jwt_lib_error);
         }
 
+        /* Tokens issued before generations existed carry no "gen": they
+         * count as generation 0 and fall to the first revocation. */
+        struct json_object* field = NULL;
+        int64_t user_id           = 0;
+        int64_t generation        = 0;
+        if (json_object_object_get_ex(*claims_out, "id", &field))
+                user_id = json_object_get_int64(field);
+        if (json_object_object_get_ex(*claims_out, "gen", &field))
+                generation = json_object_get_int64(field);
+        if (generation < 0 || generation > UINT32_MAX) generation = 0;
+
+        revoke_status_t status = revoke_check(user_id, (uint32_t)generation);
+        if (status == REVOKE_REVOKED || status == REVOKE_UNLOADED) {
+                json_object_put(*claims_out);
+                *claims_out = NULL;
+
+                result_t res;
+                if (status == REVOKE_REVOKED)
+                        res = result_failure("JWT revoked", NULL,
+                                             ERR_JWT_REVOKED);
+                else
+                        res = result_critical_failure(
+                            "Revocation list not loaded", NULL,
+                            ERR_JWT_REVOCATION_UNLOADED);
+                result_add_extra(&res, "id=%lld, gen=%lld",
+                                 (long long)user_id, (long long)generation);
+                return res;
+        }
+
         return result_success();
 }
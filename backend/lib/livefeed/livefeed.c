@@ -0,0 +1,67 @@
+/**
+ * @file livefeed.c
+ * @brief Wakeup datagrams to the live feed daemon.
+ *
+ * The socket is opened on the first wakeup and kept for the life of the
+ * process; a CGI writes at most a few posts, a maintenance program many.
+ */
+
+#include "livefeed.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** @brief Datagram socket, -1 until opened. */
+static int notify_fd = -1;
+
+/** @brief Daemon address, valid once notify_tried is set. */
+static struct sockaddr_un notify_addr;
+
+/** @brief Whether opening the socket was already attempted. */
+static bool notify_tried = false;
+
+/**
+ * @brief Socket path in effect, from SFE_LIVE_SOCKET or the default.
+ * @return Path, or NULL when wakeups are disabled
+ */
+const char* livefeed_socket_path(void) {
+        const char* path = getenv("SFE_LIVE_SOCKET");
+        if (!path) path = LIVEFEED_DEFAULT_SOCKET;
+        return *path ? path : NULL;
+}
+
+/**
+ * @brief Open the datagram socket on first use.
+ * @return true if wakeups can be sent.
+ */
+static bool notify_open(void) {
+        if (notify_tried) return notify_fd >= 0;
+        notify_tried = true;
+
+        const char* path = livefeed_socket_path();
+        if (!path || strlen(path) >= sizeof(notify_addr.sun_path)) return false;
+
+        notify_addr.sun_family = AF_UNIX;
+        strcpy(notify_addr.sun_path, path);
+        notify_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                           0);
+        return notify_fd >= 0;
+}
+
+/**
+ * @brief Wake the live feed daemon; call after COMMIT.
+ */
+void livefeed_notify(void) {
+        if (!notify_open()) return;
+
+        /* ENOENT / ECONNREFUSED (no daemon) and EAGAIN (queue full) drop
+         * the wakeup. */
+        uint32_t magic = LIVEFEED_MAGIC;
+        (void)sendto(notify_fd, &magic, sizeof(magic), MSG_NOSIGNAL,
+                     (const struct sockaddr*)&notify_addr,
+                     sizeof(notify_addr));
+}
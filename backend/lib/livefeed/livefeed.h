@@ -0,0 +1,40 @@
+/**
+ * @file livefeed.h
+ * @brief Wake the live feed daemon (maint/livefeed) after new posts.
+ *
+ * The daemon holds the Server-Sent Events connections; writers only tell it
+ * that posts were committed, and it reads every post after the last one it
+ * has seen. A wakeup is one small datagram on a Unix socket
+ * (SFE_LIVE_SOCKET, default /tmp/sfe_live.sock), sent without blocking.
+ * When the daemon is not running, or its queue is full, the datagram is
+ * dropped: a full queue still holds wakeups sent after this commit, so no
+ * post is missed, and the write itself is never slowed down or failed.
+ *
+ * Setting SFE_LIVE_SOCKET empty disables wakeups.
+ */
+
+#ifndef LIVEFEED_H_
+#define LIVEFEED_H_
+
+#include <stdint.h>
+
+/** @brief Socket path used when SFE_LIVE_SOCKET is unset. */
+#define LIVEFEED_DEFAULT_SOCKET "/tmp/sfe_live.sock"
+
+/** @brief The wakeup datagram: "SFL" + version, in host byte order. */
+#define LIVEFEED_MAGIC 0x53464c01u
+
+/**
+ * @brief Wake the live feed daemon; call after COMMIT.
+ *
+ * Best effort: costs one non-blocking sendto() and never fails the caller.
+ */
+void livefeed_notify(void);
+
+/**
+ * @brief Socket path in effect, from SFE_LIVE_SOCKET or the default.
+ * @return Path, or NULL when wakeups are disabled.
+ */
+const char* livefeed_socket_path(void);
+
+#endif// LIVEFEED_H_
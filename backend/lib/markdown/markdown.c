@@ -0,0 +1,532 @@
+/**
+ * @file markdown.c
+ * @brief Single-pass Markdown renderer with an allow-list of HTML output.
+ *
+ * The input is read line by line. A line either continues the open block
+ * or closes it and opens another; its inline content is rendered left to
+ * right straight into the output buffer. Nothing is allocated and no
+ * character is looked at more than a constant number of times, apart from
+ * the bounded link lookahead.
+ */
+
+#include "markdown.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @brief Output bytes per input byte no construct exceeds (see below). */
+#define MD_EXPANSION 10
+
+/** @brief Output bytes beyond MD_EXPANSION per input byte. */
+#define MD_OVERHEAD 64
+
+/*
+ * Why MD_EXPANSION is 10: the costliest constructs per source byte are ">"
+ * on its own line between blank lines (3 bytes -> <blockquote></blockquote>,
+ * 8.3x), an empty code span (`` -> <code></code>, 6.5x), escaped quotes
+ * (" -> &quot;, 6x) and the shortest link ([a](/) -> 36 bytes, 6x). Blocks
+ * still open at the end of the input need at most MD_OVERHEAD more.
+ */
+
+/**
+ * @struct md_out_t
+ * @brief Output cursor; overflow is sticky and reported once at the end.
+ */
+typedef struct {
+        char* p;       /**< Next byte to write */
+        char* end;     /**< End of the buffer, one byte kept for the NUL */
+        bool overflow; /**< A write did not fit */
+} md_out_t;
+
+/**
+ * @enum md_block_t
+ * @brief Block the renderer is inside of.
+ */
+typedef enum {
+        MD_BLOCK_NONE,
+        MD_BLOCK_P,
+        MD_BLOCK_UL,
+        MD_BLOCK_OL,
+        MD_BLOCK_QUOTE,
+        MD_BLOCK_CODE,
+} md_block_t;
+
+/**
+ * @struct md_closer_t
+ * @brief First closing delimiter run at or after a position of a line.
+ *
+ * Searches for a delimiter's closer only ever start further right, so the
+ * previous answer stays valid until the search passes it; this keeps
+ * emphasis matching linear. from is SIZE_MAX before the first search.
+ */
+typedef struct {
+        size_t from; /**< Where the cached search started */
+        size_t pos;  /**< Closer found there, or the line length if none */
+} md_closer_t;
+
+/** @brief Characters that end a run of plain inline text. */
+static const unsigned char md_special[256] = {
+    ['\\'] = 1, ['`'] = 1, ['*'] = 1, ['_'] = 1, ['['] = 1, ['&'] = 1,
+    ['<'] = 1,  ['>'] = 1, ['"'] = 1, ['\''] = 1,
+    [0x00] = 1, [0x01] = 1, [0x02] = 1, [0x03] = 1, [0x04] = 1, [0x05] = 1,
+    [0x06] = 1, [0x07] = 1, [0x08] = 1, [0x0b] = 1, [0x0c] = 1, [0x0d] = 1,
+    [0x0e] = 1, [0x0f] = 1, [0x10] = 1, [0x11] = 1, [0x12] = 1, [0x13] = 1,
+    [0x14] = 1, [0x15] = 1, [0x16] = 1, [0x17] = 1, [0x18] = 1, [0x19] = 1,
+    [0x1a] = 1, [0x1b] = 1, [0x1c] = 1, [0x1d] = 1, [0x1e] = 1, [0x1f] = 1,
+    [0x7f] = 1,
+};
+
+static void put(md_out_t* o, const char* s, size_t n) {
+        if ((size_t)(o->end - o->p) < n) {
+                o->overflow = true;
+                return;
+        }
+        memcpy(o->p, s, n);
+        o->p += n;
+}
+
+#define PUT_LIT(o, lit) put((o), (lit), sizeof(lit) - 1)
+
+/**
+ * @brief Write text with HTML metacharacters escaped and control
+ * characters other than tab dropped.
+ * @param o Output.
+ * @param s Text.
+ * @param n Length of @p s.
+ */
+static void put_escaped(md_out_t* o, const char* s, size_t n) {
+        size_t start = 0;
+        for (size_t i = 0; i < n; ++i) {
+                unsigned char c = (unsigned char)s[i];
+                if (!md_special[c] || c == '\\' || c == '`' || c == '*' ||
+                    c == '_' || c == '[')
+                        continue;
+                put(o, s + start, i - start);
+                start = i + 1;
+                switch (c) {
+                        case '&': PUT_LIT(o, "&amp;"); break;
+                        case '<': PUT_LIT(o, "&lt;"); break;
+                        case '>': PUT_LIT(o, "&gt;"); break;
+                        case '"': PUT_LIT(o, "&quot;"); break;
+                        case '\'': PUT_LIT(o, "&#39;"); break;
+                        default: break; /* control character: dropped */
+                }
+        }
+        put(o, s + start, n - start);
+}
+
+static bool is_space(char c) {
+        return c == ' ' || c == '\t';
+}
+
+static bool is_alnum(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z') || (unsigned char)c >= 0x80;
+}
+
+static bool is_punct(char c) {
+        return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') ||
+               (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+
+/**
+ * @brief Whether the delimiter run s[i, i + r) can close emphasis.
+ *
+ * The run must be exactly @p r characters long and follow a non-space; an
+ * underscore run must also not be followed by a letter or digit, so
+ * snake_case stays literal.
+ */
+static bool is_closer(const char* s, size_t n, size_t i, size_t r) {
+        char c = s[i];
+        if (i == 0 || is_space(s[i - 1]) || s[i - 1] == c) return false;
+        if (i + r > n) return false;
+        for (size_t k = 1; k < r; ++k)
+                if (s[i + k] != c) return false;
+        if (i + r < n && s[i + r] == c) return false;
+        if (c == '_' && i + r < n && is_alnum(s[i + r])) return false;
+        return true;
+}
+
+/**
+ * @brief Position of the first closer of run length @p r for marker @p c
+ * at or after @p from, or @p n if there is none.
+ */
+static size_t find_closer(md_closer_t* cache, const char* s, size_t n,
+                          size_t from, char c, size_t r) {
+        if (from >= cache->from && from <= cache->pos) return cache->pos;
+
+        size_t i = from;
+        while (i < n) {
+                const char* hit = memchr(s + i, c, n - i);
+                if (!hit) {
+                        i = n;
+                        break;
+                }
+                i = (size_t)(hit - s);
+                if (is_closer(s, n, i, r)) break;
+                while (i < n && s[i] == c) ++i;
+        }
+        cache->from = from;
+        cache->pos  = i;
+        return i;
+}
+
+/**
+ * @brief Whether a link URL may be emitted: http(s), mailto, a site path or
+ * a fragment, with no whitespace or control characters. A site path may not
+ * start with "//" or "/\", which browsers resolve as another host.
+ */
+static bool url_allowed(const char* u, size_t n) {
+        if (n == 0) return false;
+        for (size_t i = 0; i < n; ++i)
+                if ((unsigned char)u[i] <= 0x20 || u[i] == 0x7f) return false;
+
+        static const char* const schemes[] = {"http://", "https://",
+                                              "mailto:"};
+        for (size_t k = 0; k < sizeof(schemes) / sizeof(schemes[0]); ++k) {
+                size_t len = strlen(schemes[k]);
+                if (n <= len) continue;
+                size_t j = 0;
+                while (j < len && (u[j] | 0x20) == schemes[k][j]) ++j;
+                if (j == len) return true;
+        }
+        return u[0] == '#' ||
+               (u[0] == '/' && (n == 1 || (u[1] != '/' && u[1] != '\\')));
+}
+
+/**
+ * @brief Try to render a [text](url) link starting at s[i] == '['.
+ * @return Index after the link, or @p i if there is no valid link there.
+ */
+static size_t render_link(md_out_t* o, const char* s, size_t n, size_t i) {
+        size_t text_max = n - i - 1 < MARKDOWN_LINK_TEXT_MAX
+                              ? n - i - 1
+                              : MARKDOWN_LINK_TEXT_MAX;
+        const char* close = memchr(s + i + 1, ']', text_max);
+        if (!close || close == s + i + 1) return i;
+
+        size_t text_end = (size_t)(close - s);
+        if (text_end + 1 >= n || s[text_end + 1] != '(') return i;
+
+        size_t url_start = text_end + 2;
+        size_t url_max   = n - url_start < MARKDOWN_LINK_URL_MAX
+                               ? n - url_start
+                               : MARKDOWN_LINK_URL_MAX;
+        const char* paren = memchr(s + url_start, ')', url_max);
+        if (!paren) return i;
+
+        size_t url_end = (size_t)(paren - s);
+        if (!url_allowed(s + url_start, url_end - url_start)) return i;
+
+        PUT_LIT(o, "<a href=\"");
+        put_escaped(o, s + url_start, url_end - url_start);
+        PUT_LIT(o, "\" rel=\"nofollow ugc\">");
+        put_escaped(o, s + i + 1, text_end - i - 1);
+        PUT_LIT(o, "</a>");
+        return url_end + 1;
+}
+
+/**
+ * @brief Render the inline content of one line.
+ * @param o Output.
+ * @param s Line text, without the newline.
+ * @param n Length of @p s.
+ */
+static void render_inline(md_out_t* o, const char* s, size_t n) {
+        /* Open emphasis, innermost last; each kind is open at most once.
+         * Index 0 is em, 1 is strong; the value is the marker or 0. */
+        char open[2] = {0, 0};
+        int stack[2] = {0, 0};
+        int depth    = 0;
+        md_closer_t closers[2][2];
+        for (int k = 0; k < 4; ++k)
+                closers[k / 2][k % 2] = (md_closer_t){.from = SIZE_MAX};
+
+        size_t i = 0;
+        while (i < n) {
+                size_t run = i;
+                while (run < n && !md_special[(unsigned char)s[run]]) ++run;
+                if (run > i) {
+                        put(o, s + i, run - i);
+                        i = run;
+                        continue;
+                }
+
+                char c = s[i];
+                if (c == '\\' && i + 1 < n && is_punct(s[i + 1])) {
+                        put_escaped(o, s + i + 1, 1);
+                        i += 2;
+                        continue;
+                }
+
+                if (c == '`') {
+                        const char* end = memchr(s + i + 1, '`', n - i - 1);
+                        if (!end) {
+                                put(o, "`", 1);
+                                ++i;
+                                continue;
+                        }
+                        PUT_LIT(o, "<code>");
+                        put_escaped(o, s + i + 1, (size_t)(end - s) - i - 1);
+                        PUT_LIT(o, "</code>");
+                        i = (size_t)(end - s) + 1;
+                        continue;
+                }
+
+                if (c == '*' || c == '_') {
+                        size_t r = 1;
+                        while (i + r < n && s[i + r] == c) ++r;
+                        if (r > 2) {
+                                put(o, s + i, r);
+                                i += r;
+                                continue;
+                        }
+
+                        int kind = (int)r - 1;
+                        if (open[kind] == c && depth > 0 &&
+                            stack[depth - 1] == kind &&
+                            is_closer(s, n, i, r)) {
+                                if (kind) PUT_LIT(o, "</strong>");
+                                else PUT_LIT(o, "</em>");
+                                open[kind] = 0;
+                                --depth;
+                                i += r;
+                                continue;
+                        }
+
+                        bool opens =
+                            !open[kind] && i + r < n && !is_space(s[i + r]) &&
+                            !(c == '_' && i > 0 && is_alnum(s[i - 1])) &&
+                            find_closer(&closers[kind][c == '_'], s, n,
+                                        i + r + 1, c, r) < n;
+                        if (opens) {
+                                if (kind) PUT_LIT(o, "<strong>");
+                                else PUT_LIT(o, "<em>");
+                                open[kind]     = c;
+                                stack[depth++] = kind;
+                        } else {
+                                put(o, s + i, r);
+                        }
+                        i += r;
+                        continue;
+                }
+
+                if (c == '[') {
+                        size_t next = render_link(o, s, n, i);
+                        if (next != i) {
+                                i = next;
+                                continue;
+                        }
+                }
+
+                put_escaped(o, s + i, 1);
+                ++i;
+        }
+
+        while (depth > 0) {
+                if (stack[--depth]) PUT_LIT(o, "</strong>");
+                else PUT_LIT(o, "</em>");
+        }
+}
+
+static void close_block(md_out_t* o, md_block_t* block) {
+        switch (*block) {
+                case MD_BLOCK_P: PUT_LIT(o, "</p>"); break;
+                case MD_BLOCK_UL: PUT_LIT(o, "</ul>"); break;
+                case MD_BLOCK_OL: PUT_LIT(o, "</ol>"); break;
+                case MD_BLOCK_QUOTE: PUT_LIT(o, "</blockquote>"); break;
+                case MD_BLOCK_CODE: PUT_LIT(o, "</code></pre>"); break;
+                case MD_BLOCK_NONE: break;
+        }
+        *block = MD_BLOCK_NONE;
+}
+
+static bool is_fence(const char* s, size_t n) {
+        return n >= 3 && s[0] == '`' && s[1] == '`' && s[2] == '`';
+}
+
+/** @brief Three or more of one of - * _ and nothing else but spaces. */
+static bool is_rule(const char* s, size_t n) {
+        char c     = s[0];
+        size_t cnt = 0;
+        if (c != '-' && c != '*' && c != '_') return false;
+        for (size_t i = 0; i < n; ++i) {
+                if (s[i] == c) ++cnt;
+                else if (!is_space(s[i])) return false;
+        }
+        return cnt >= 3;
+}
+
+/**
+ * @brief Length of an ordered or unordered list marker with its space, or
+ * 0 if the line is not a list item.
+ */
+static size_t list_marker(const char* s, size_t n, md_block_t* kind) {
+        if (n >= 2 && (s[0] == '-' || s[0] == '*' || s[0] == '+') &&
+            is_space(s[1])) {
+                *kind = MD_BLOCK_UL;
+                return 2;
+        }
+        size_t d = 0;
+        while (d < n && d < 9 && s[d] >= '0' && s[d] <= '9') ++d;
+        if (d > 0 && d + 1 < n && (s[d] == '.' || s[d] == ')') &&
+            is_space(s[d + 1])) {
+                *kind = MD_BLOCK_OL;
+                return d + 2;
+        }
+        return 0;
+}
+
+/**
+ * @brief Output buffer size that fits any rendering of @p len input bytes.
+ * @param len Source length.
+ * @return Bytes to provide to markdown_render(), including the NUL.
+ */
+size_t markdown_bound(size_t len) {
+        return len * MD_EXPANSION + MD_OVERHEAD + 1;
+}
+
+/**
+ * @brief Render Markdown to sanitized HTML.
+ * @param src Source text (need not be NUL-terminated).
+ * @param len Length of @p src.
+ * @param out Output buffer.
+ * @param cap Size of @p out; at least markdown_bound(@p len).
+ * @param out_len Set to the length of the HTML, excluding the NUL.
+ * @return Success, or ERR_MARKDOWN_TOO_LARGE when @p len exceeds
+ * MARKDOWN_MAX_INPUT.
+ */
+result_t markdown_render(const char* src, size_t len, char* out, size_t cap,
+                         size_t* out_len) {
+        if (out_len) *out_len = 0;
+        if (!src || !out || !out_len || cap == 0) {
+                result_t res = result_failure("Invalid arguments", NULL,
+                                              ERR_INVALID_INPUT);
+                result_add_extra(&res, "src=%p, out=%p, cap=%zu",
+                                 (const void*)src, (const void*)out, cap);
+                return res;
+        }
+        if (len > MARKDOWN_MAX_INPUT) {
+                result_t res = result_failure("Markdown source too long", NULL,
+                                              ERR_MARKDOWN_TOO_LARGE);
+                result_add_extra(&res, "len=%zu", len);
+                return res;
+        }
+
+        md_out_t o       = {.p = out, .end = out + cap - 1, .overflow = false};
+        md_block_t block = MD_BLOCK_NONE;
+        bool code_first  = false;
+
+        const char* line = src;
+        const char* stop = src + len;
+        while (line < stop) {
+                const char* nl   = memchr(line, '\n', (size_t)(stop - line));
+                const char* next = nl ? nl + 1 : stop;
+                size_t n         = (size_t)((nl ? nl : stop) - line);
+                if (n > 0 && line[n - 1] == '\r') --n;
+
+                if (block == MD_BLOCK_CODE) {
+                        if (is_fence(line, n)) {
+                                close_block(&o, &block);
+                        } else {
+                                if (!code_first) PUT_LIT(&o, "\n");
+                                put_escaped(&o, line, n);
+                                code_first = false;
+                        }
+                        line = next;
+                        continue;
+                }
+
+                const char* s = line;
+                for (int k = 0; k < 3 && n > 0 && *s == ' '; ++k, --n) ++s;
+                line = next;
+
+                size_t blank = 0;
+                while (blank < n && is_space(s[blank])) ++blank;
+                if (blank == n) {
+                        close_block(&o, &block);
+                        continue;
+                }
+
+                if (is_fence(s, n)) {
+                        close_block(&o, &block);
+                        PUT_LIT(&o, "<pre><code>");
+                        block      = MD_BLOCK_CODE;
+                        code_first = true;
+                        continue;
+                }
+
+                if (is_rule(s, n)) {
+                        close_block(&o, &block);
+                        PUT_LIT(&o, "<hr>");
+                        continue;
+                }
+
+                size_t level = 0;
+                while (level < n && level < 7 && s[level] == '#') ++level;
+                if (level >= 1 && level <= 6 &&
+                    (level == n || is_space(s[level]))) {
+                        char tag[6] = {'<', 'h', (char)('0' + level), '>'};
+                        close_block(&o, &block);
+                        put(&o, tag, 4);
+                        size_t skip = level < n ? level + 1 : level;
+                        render_inline(&o, s + skip, n - skip);
+                        tag[1] = '/';
+                        tag[2] = 'h';
+                        tag[3] = (char)('0' + level);
+                        tag[4] = '>';
+                        put(&o, tag, 5);
+                        continue;
+                }
+
+                md_block_t kind = MD_BLOCK_NONE;
+                size_t marker   = list_marker(s, n, &kind);
+                if (marker) {
+                        if (block != kind) {
+                                close_block(&o, &block);
+                                if (kind == MD_BLOCK_UL) PUT_LIT(&o, "<ul>");
+                                else PUT_LIT(&o, "<ol>");
+                                block = kind;
+                        }
+                        PUT_LIT(&o, "<li>");
+                        render_inline(&o, s + marker, n - marker);
+                        PUT_LIT(&o, "</li>");
+                        continue;
+                }
+
+                if (s[0] == '>') {
+                        size_t skip = n > 1 && is_space(s[1]) ? 2 : 1;
+                        if (block == MD_BLOCK_QUOTE) {
+                                PUT_LIT(&o, "<br>");
+                        } else {
+                                close_block(&o, &block);
+                                PUT_LIT(&o, "<blockquote>");
+                                block = MD_BLOCK_QUOTE;
+                        }
+                        render_inline(&o, s + skip, n - skip);
+                        continue;
+                }
+
+                if (block == MD_BLOCK_P) {
+                        PUT_LIT(&o, "<br>");
+                } else {
+                        close_block(&o, &block);
+                        PUT_LIT(&o, "<p>");
+                        block = MD_BLOCK_P;
+                }
+                render_inline(&o, s, n);
+        }
+        close_block(&o, &block);
+
+        if (o.overflow) {
+                result_t res = result_critical_failure(
+                    "Markdown output exceeded its bound", NULL,
+                    ERR_MARKDOWN_OVERFLOW);
+                result_add_extra(&res, "len=%zu, cap=%zu", len, cap);
+                return res;
+        }
+        *o.p     = '\0';
+        *out_len = (size_t)(o.p - out);
+        return result_success();
+}
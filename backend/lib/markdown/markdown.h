@@ -0,0 +1,65 @@
+/**
+ * @file markdown.h
+ * @brief Markdown to sanitized HTML, rendered once when a post is written.
+ *
+ * Like sanitizec, the renderer allows a fixed set of constructs and escapes
+ * everything else: raw HTML is never passed through, only the tags listed
+ * below are produced, and links must be http(s), mailto or site-relative.
+ * Supported syntax:
+ *
+ *  - paragraphs (blank-line separated; single newlines become <br>)
+ *  - # to ###### headings, > quotes, and ---, *** or ___ rules
+ *  - "- ", "* ", "+ " and "1. " list items (one level)
+ *  - ``` fenced code blocks, `code`, *em* / _em_, **strong** / __strong__
+ *  - [text](url) links, backslash escapes
+ *
+ * Rendering is a single pass over the input into one caller-provided
+ * buffer of markdown_bound() bytes, with no allocation at all. Emphasis and
+ * code spans only open when they close on the same line, so output is
+ * always well-formed and the work stays linear in the input size.
+ *
+ * The stored HTML is tagged with MARKDOWN_VERSION; bump it whenever the
+ * output for some input changes, and maint/rerender brings stored posts up
+ * to date.
+ */
+
+#ifndef MARKDOWN_H_
+#define MARKDOWN_H_
+
+#include <stddef.h>
+
+#include "/app/backend/lib/result/result.h"
+
+// Library-specific error codes (3200-3299) live in lib/errors/errors.h
+
+/** @brief Version of the renderer's output, stored with every post. */
+#define MARKDOWN_VERSION 2
+
+/** @brief Longest accepted post source, in bytes. */
+#define MARKDOWN_MAX_INPUT 65536
+
+/** @brief Longest link text and link URL recognized, in bytes. */
+#define MARKDOWN_LINK_TEXT_MAX 256
+#define MARKDOWN_LINK_URL_MAX 2048
+
+/**
+ * @brief Output buffer size that fits any rendering of @p len input bytes.
+ * @param len Source length.
+ * @return Bytes to provide to markdown_render(), including the NUL.
+ */
+size_t markdown_bound(size_t len);
+
+/**
+ * @brief Render Markdown to sanitized HTML.
+ * @param src Source text (need not be NUL-terminated).
+ * @param len Length of @p src.
+ * @param out Output buffer.
+ * @param cap Size of @p out; at least markdown_bound(@p len).
+ * @param out_len Set to the length of the HTML, excluding the NUL.
+ * @return Success, or ERR_MARKDOWN_TOO_LARGE when @p len exceeds
+ * MARKDOWN_MAX_INPUT.
+ */
+result_t markdown_render(const char* src, size_t len, char* out, size_t cap,
+                         size_t* out_len);
+
+#endif// MARKDOWN_H_
@@ -1,8 +0,0 @@
-#ifndef MEMCMP_H_
-#define MEMCMP_H_
-
-#include <stdlib.h>
-
-int memcmp(const void* a, const void* b, size_t len);
-
-#endif// MEMCMP_H_
@@ -0,0 +1,645 @@
+/**
+ * @file metrics.c
+ * @brief Shared-memory counters and histograms, Prometheus rendering.
+ *
+ * The segment is a fixed-layout struct in a file mapped MAP_SHARED by every
+ * process. All-zero bytes are a valid empty segment, so creating it is just
+ * ftruncate(); the magic word doubles as the layout version and is set with
+ * compare-and-swap by whichever process gets there first.
+ *
+ * Series and counters live in open-addressed slot arrays. A slot goes
+ * FREE -> CLAIMING -> READY exactly once; the winner of the FREE -> CLAIMING
+ * CAS writes the key and publishes it with a release store. After that only
+ * atomic adds touch the slot.
+ */
+
+#include "metrics.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/errors/errors.h"
+
+/** @brief Segment layout version; bump on any layout change. */
+#define METRICS_VERSION 2
+
+/** @brief Magic word ("SFM" + version) marking an initialized segment. */
+#define METRICS_MAGIC (0x53464d00u | METRICS_VERSION)
+
+/** @brief Polls before giving up on a slot another process is claiming. */
+#define METRICS_CLAIM_SPINS 1000
+
+/** @brief Histogram upper bounds in microseconds; +Inf is implicit. */
+static const uint64_t bucket_bounds_us[] = {
+    500,    1000,   2500,   5000,    10000,   25000,   50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+#define METRICS_BOUNDS (sizeof(bucket_bounds_us) / sizeof(bucket_bounds_us[0]))
+#define METRICS_BUCKETS (METRICS_BOUNDS + 1)
+
+/**
+ * @enum metrics_kind
+ * @brief What a slot measures.
+ */
+typedef enum metrics_kind {
+        METRICS_KIND_REQUEST = 1, /**< Series: endpoint latency */
+        METRICS_KIND_PHASE   = 2, /**< Series: endpoint/phase latency */
+        METRICS_KIND_DAL     = 3, /**< Series: DAL call latency */
+        METRICS_KIND_STATUS  = 4, /**< Counter: endpoint/HTTP status */
+        METRICS_KIND_ERROR   = 5  /**< Counter: error code */
+} metrics_kind_t;
+
+/**
+ * @enum slot_state
+ * @brief Lifecycle of a slot.
+ */
+enum slot_state { SLOT_FREE = 0, SLOT_CLAIMING = 1, SLOT_READY = 2 };
+
+/**
+ * @struct metrics_key_t
+ * @brief Identity of a slot; immutable once READY.
+ */
+typedef struct {
+        _Atomic uint32_t state;       /**< enum slot_state */
+        uint16_t kind;                /**< metrics_kind_t */
+        uint16_t code;                /**< HTTP status or error code */
+        char name[METRICS_NAME_SIZE]; /**< Endpoint or DAL op */
+        char sub[METRICS_NAME_SIZE];  /**< Phase name, or empty */
+} metrics_key_t;
+
+/**
+ * @struct metrics_series_t
+ * @brief Latency histogram slot.
+ */
+typedef struct {
+        metrics_key_t key;                         /**< Slot identity */
+        _Atomic uint64_t buckets[METRICS_BUCKETS]; /**< Per-bucket counts */
+        _Atomic uint64_t sum_ns;                   /**< Sum of observations */
+} metrics_series_t;
+
+/**
+ * @struct metrics_counter_t
+ * @brief Monotonic counter slot.
+ */
+typedef struct {
+        metrics_key_t key;      /**< Slot identity */
+        _Atomic uint64_t value; /**< Count */
+} metrics_counter_t;
+
+/**
+ * @struct metrics_statement_t
+ * @brief Per-statement profile slot, keyed by normalized SQL text.
+ */
+typedef struct {
+        _Atomic uint32_t state;          /**< enum slot_state */
+        uint32_t hash;                   /**< FNV-1a of sql */
+        char sql[METRICS_SQL_SIZE];      /**< Normalized SQL text */
+        _Atomic uint64_t calls;          /**< Executions */
+        _Atomic uint64_t total_ns;       /**< Sum of execution times */
+        _Atomic uint64_t max_ns;         /**< Slowest execution */
+        _Atomic uint64_t rows;           /**< Result rows produced */
+        _Atomic uint64_t fullscan_steps; /**< Full-scan steps */
+        _Atomic uint64_t sorts;          /**< Sort operations */
+} metrics_statement_t;
+
+/**
+ * @struct metrics_segment_t
+ * @brief The whole shared segment.
+ */
+typedef struct {
+        _Atomic uint32_t magic;       /**< METRICS_MAGIC once initialized */
+        uint32_t reserved;            /**< Zero */
+        _Atomic uint64_t sqlite_busy; /**< SQLITE_BUSY retries */
+        _Atomic uint64_t dropped;     /**< Updates lost to full tables */
+        metrics_series_t series[METRICS_MAX_SERIES];
+        metrics_counter_t counters[METRICS_MAX_COUNTERS];
+        metrics_statement_t statements[METRICS_MAX_STATEMENTS];
+} metrics_segment_t;
+
+/** @brief This process's mapping, NULL if unavailable. */
+static metrics_segment_t* segment = NULL;
+
+/** @brief Whether mapping was already attempted. */
+static bool segment_tried = false;
+
+/**
+ * @brief Map the segment on first use.
+ * @return Mapped segment, or NULL if metrics are unavailable.
+ */
+static metrics_segment_t* segment_get(void) {
+        if (segment_tried) return segment;
+        segment_tried = true;
+
+        const char* path = getenv("SFE_METRICS_FILE");
+        if (!path) path = METRICS_DEFAULT_FILE;
+        if (!*path) return NULL;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        bool sized = false;
+        if (fstat(fd, &st) == 0) {
+                if (st.st_size == 0)
+                        sized = ftruncate(fd, sizeof(metrics_segment_t)) == 0;
+                else
+                        sized = st.st_size == sizeof(metrics_segment_t);
+        }
+        void* p = sized ? mmap(NULL, sizeof(metrics_segment_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED) return NULL;
+
+        metrics_segment_t* seg = p;
+        uint32_t magic         = 0;
+        if (!atomic_compare_exchange_strong(&seg->magic, &magic,
+                                            METRICS_MAGIC) &&
+            magic != METRICS_MAGIC) {
+                munmap(p, sizeof(metrics_segment_t));
+                return NULL;
+        }
+
+        segment = seg;
+        return segment;
+}
+
+/**
+ * @brief Map the metrics segment, creating it if needed.
+ * @return true if metrics are recorded in this process.
+ */
+bool metrics_enabled(void) { return segment_get() != NULL; }
+
+/**
+ * @brief FNV-1a over a slot key.
+ */
+static uint32_t key_hash(metrics_kind_t kind, uint16_t code, const char* name,
+                         const char* sub) {
+        uint32_t h = 2166136261u;
+        h          = (h ^ (uint32_t)kind) * 16777619u;
+        h          = (h ^ code) * 16777619u;
+        for (size_t i = 0; i < METRICS_NAME_SIZE - 1 && name[i]; ++i)
+                h = (h ^ (unsigned char)name[i]) * 16777619u;
+        h = (h ^ 0xff) * 16777619u;
+        for (size_t i = 0; i < METRICS_NAME_SIZE - 1 && sub[i]; ++i)
+                h = (h ^ (unsigned char)sub[i]) * 16777619u;
+        return h;
+}
+
+/**
+ * @brief Whether a READY slot has the given key (names compare truncated).
+ */
+static bool key_matches(const metrics_key_t* k, metrics_kind_t kind,
+                        uint16_t code, const char* name, const char* sub) {
+        return k->kind == kind && k->code == code &&
+               strncmp(k->name, name, METRICS_NAME_SIZE - 1) == 0 &&
+               strncmp(k->sub, sub, METRICS_NAME_SIZE - 1) == 0;
+}
+
+/**
+ * @brief Claim a FREE slot, or wait for a slot being claimed to settle.
+ *
+ * A slot stuck in CLAIMING (its owner was preempted or died) is given up on
+ * after METRICS_CLAIM_SPINS polls.
+ *
+ * @param state Slot state word.
+ * @param claimed Set to true if the caller now owns the slot and must
+ * write its key, then publish it with slot_publish().
+ * @return The slot state observed.
+ */
+static uint32_t slot_acquire(_Atomic uint32_t* state, bool* claimed) {
+        uint32_t s = atomic_load_explicit(state, memory_order_acquire);
+        *claimed   = false;
+
+        if (s == SLOT_FREE &&
+            atomic_compare_exchange_strong(state, &s, SLOT_CLAIMING)) {
+                *claimed = true;
+                return SLOT_CLAIMING;
+        }
+
+        for (int spin = 0; s == SLOT_CLAIMING && spin < METRICS_CLAIM_SPINS;
+             ++spin) {
+                sched_yield();
+                s = atomic_load_explicit(state, memory_order_acquire);
+        }
+        return s;
+}
+
+/**
+ * @brief Make a claimed slot's key visible to other processes.
+ * @param state Slot state word.
+ */
+static void slot_publish(_Atomic uint32_t* state) {
+        atomic_store_explicit(state, SLOT_READY, memory_order_release);
+}
+
+/**
+ * @brief Find the slot for a key, claiming a free one if it is new.
+ *
+ * Linear probing from the key's hash.
+ *
+ * @param seg Mapped segment.
+ * @param base First slot; each slot starts with a metrics_key_t.
+ * @param stride Slot size in bytes.
+ * @param count Number of slots.
+ * @return Slot key, or NULL if the table is full.
+ */
+static metrics_key_t* slot_find(metrics_segment_t* seg, void* base,
+                                size_t stride, size_t count,
+                                metrics_kind_t kind, uint16_t code,
+                                const char* name, const char* sub) {
+        size_t start = key_hash(kind, code, name, sub) % count;
+        for (size_t i = 0; i < count; ++i) {
+                metrics_key_t* k =
+                    (metrics_key_t*)((char*)base +
+                                     ((start + i) % count) * stride);
+                bool claimed;
+                uint32_t state = slot_acquire(&k->state, &claimed);
+                if (claimed) {
+                        k->kind = (uint16_t)kind;
+                        k->code = code;
+                        strncpy(k->name, name, METRICS_NAME_SIZE - 1);
+                        strncpy(k->sub, sub, METRICS_NAME_SIZE - 1);
+                        slot_publish(&k->state);
+                        return k;
+                }
+                if (state == SLOT_READY &&
+                    key_matches(k, kind, code, name, sub))
+                        return k;
+        }
+
+        atomic_fetch_add_explicit(&seg->dropped, 1, memory_order_relaxed);
+        return NULL;
+}
+
+/**
+ * @brief Find the profile slot for a statement, claiming one if it is new.
+ * @param seg Mapped segment.
+ * @param sql Normalized SQL text.
+ * @return Slot, or NULL if the table is full.
+ */
+static metrics_statement_t* statement_find(metrics_segment_t* seg,
+                                           const char* sql) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < METRICS_SQL_SIZE - 1 && sql[i]; ++i)
+                h = (h ^ (unsigned char)sql[i]) * 16777619u;
+
+        for (size_t i = 0; i < METRICS_MAX_STATEMENTS; ++i) {
+                metrics_statement_t* st =
+                    &seg->statements[(h + i) % METRICS_MAX_STATEMENTS];
+                bool claimed;
+                uint32_t state = slot_acquire(&st->state, &claimed);
+                if (claimed) {
+                        st->hash = h;
+                        strncpy(st->sql, sql, METRICS_SQL_SIZE - 1);
+                        slot_publish(&st->state);
+                        return st;
+                }
+                if (state == SLOT_READY && st->hash == h &&
+                    strncmp(st->sql, sql, METRICS_SQL_SIZE - 1) == 0)
+                        return st;
+        }
+
+        atomic_fetch_add_explicit(&seg->dropped, 1, memory_order_relaxed);
+        return NULL;
+}
+
+/**
+ * @brief Add one observation to a histogram series.
+ */
+static void observe(metrics_kind_t kind, const char* name, const char* sub,
+                    uint64_t dur_ns) {
+        metrics_segment_t* seg = segment_get();
+        if (!seg || !name) return;
+
+        metrics_series_t* s = (metrics_series_t*)slot_find(
+            seg, seg->series, sizeof(seg->series[0]), METRICS_MAX_SERIES,
+            kind, 0, name, sub ? sub : "");
+        if (!s) return;
+
+        uint64_t us   = dur_ns / 1000;
+        size_t bucket = 0;
+        while (bucket < METRICS_BOUNDS && us > bucket_bounds_us[bucket])
+                ++bucket;
+
+        atomic_fetch_add_explicit(&s->buckets[bucket], 1,
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->sum_ns, dur_ns, memory_order_relaxed);
+}
+
+/**
+ * @brief Increment a counter slot.
+ */
+static void count(metrics_kind_t kind, const char* name, uint16_t code) {
+        metrics_segment_t* seg = segment_get();
+        if (!seg) return;
+
+        metrics_counter_t* c = (metrics_counter_t*)slot_find(
+            seg, seg->counters, sizeof(seg->counters[0]),
+            METRICS_MAX_COUNTERS, kind, code, name, "");
+        if (c) atomic_fetch_add_explicit(&c->value, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Record a finished request.
+ * @param endpoint Endpoint name, e.g. "register".
+ * @param status HTTP status sent.
+ * @param dur_ns Whole request duration.
+ */
+void metrics_observe_request(const char* endpoint, unsigned int status,
+                             uint64_t dur_ns) {
+        if (!endpoint) return;
+        observe(METRICS_KIND_REQUEST, endpoint, "", dur_ns);
+        count(METRICS_KIND_STATUS, endpoint, (uint16_t)status);
+}
+
+/**
+ * @brief Record one phase of a request (see lib/timing).
+ * @param endpoint Endpoint name.
+ * @param phase Phase name, e.g. "argon2".
+ * @param dur_ns Phase duration.
+ */
+void metrics_observe_phase(const char* endpoint, const char* phase,
+                           uint64_t dur_ns) {
+        if (!phase) return;
+        observe(METRICS_KIND_PHASE, endpoint, phase, dur_ns);
+}
+
+/**
+ * @brief Record one data-access call.
+ * @param op DAL function name, e.g. "user_insert".
+ * @param dur_ns Call duration.
+ */
+void metrics_observe_dal(const char* op, uint64_t dur_ns) {
+        observe(METRICS_KIND_DAL, op, "", dur_ns);
+}
+
+/**
+ * @brief Record one execution of an SQL statement.
+ * @param sql Normalized statement text (truncated to METRICS_SQL_SIZE - 1).
+ * @param dur_ns Execution time reported by SQLite.
+ * @param rows Result rows produced.
+ * @param fullscan_steps SQLITE_STMTSTATUS_FULLSCAN_STEP for this run.
+ * @param sorts SQLITE_STMTSTATUS_SORT for this run.
+ */
+void metrics_observe_statement(const char* sql, uint64_t dur_ns,
+                               uint64_t rows, uint64_t fullscan_steps,
+                               uint64_t sorts) {
+        metrics_segment_t* seg = segment_get();
+        if (!seg || !sql) return;
+
+        metrics_statement_t* st = statement_find(seg, sql);
+        if (!st) return;
+
+        atomic_fetch_add_explicit(&st->calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->total_ns, dur_ns, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->rows, rows, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->fullscan_steps, fullscan_steps,
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->sorts, sorts, memory_order_relaxed);
+
+        uint64_t max = atomic_load_explicit(&st->max_ns, memory_order_relaxed);
+        while (dur_ns > max &&
+               !atomic_compare_exchange_weak_explicit(
+                   &st->max_ns, &max, dur_ns, memory_order_relaxed,
+                   memory_order_relaxed)) {
+        }
+}
+
+/**
+ * @brief Count a failed result by its error code.
+ * @param code Error code from lib/errors.
+ */
+void metrics_count_error(int code) {
+        if (code < 0 || code >= ERROR_CODE_LIMIT) code = 0;
+        count(METRICS_KIND_ERROR, "", (uint16_t)code);
+}
+
+/**
+ * @brief Count one SQLITE_BUSY retry.
+ */
+void metrics_count_sqlite_busy(void) {
+        metrics_segment_t* seg = segment_get();
+        if (seg)
+                atomic_fetch_add_explicit(&seg->sqlite_busy, 1,
+                                          memory_order_relaxed);
+}
+
+/**
+ * @brief Print a label value with Prometheus escaping.
+ */
+static void put_label(FILE* out, const char* s) {
+        for (; *s; ++s) {
+                if (*s == '\\' || *s == '"')
+                        fprintf(out, "\\%c", *s);
+                else if (*s == '\n')
+                        fputs("\\n", out);
+                else
+                        fputc(*s, out);
+        }
+}
+
+/**
+ * @brief Print the label set of a series slot, without braces.
+ */
+static void put_series_labels(FILE* out, const metrics_key_t* k) {
+        if (k->kind == METRICS_KIND_DAL) {
+                fputs("op=\"", out);
+                put_label(out, k->name);
+                fputc('"', out);
+                return;
+        }
+        fputs("endpoint=\"", out);
+        put_label(out, k->name);
+        fputc('"', out);
+        if (k->kind == METRICS_KIND_PHASE) {
+                fputs(",phase=\"", out);
+                put_label(out, k->sub);
+                fputc('"', out);
+        }
+}
+
+/**
+ * @brief Print every READY histogram of one kind.
+ */
+static void write_histograms(FILE* out, metrics_segment_t* seg,
+                             metrics_kind_t kind, const char* metric,
+                             const char* help) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", metric, help,
+                metric);
+
+        for (size_t i = 0; i < METRICS_MAX_SERIES; ++i) {
+                metrics_series_t* s = &seg->series[i];
+                if (atomic_load_explicit(&s->key.state,
+                                         memory_order_acquire) != SLOT_READY ||
+                    s->key.kind != kind)
+                        continue;
+
+                uint64_t cumulative = 0;
+                for (size_t b = 0; b < METRICS_BUCKETS; ++b) {
+                        cumulative += atomic_load_explicit(
+                            &s->buckets[b], memory_order_relaxed);
+                        fprintf(out, "%s_bucket{", metric);
+                        put_series_labels(out, &s->key);
+                        if (b < METRICS_BOUNDS)
+                                fprintf(out, ",le=\"%g\"} %llu\n",
+                                        (double)bucket_bounds_us[b] / 1e6,
+                                        (unsigned long long)cumulative);
+                        else
+                                fprintf(out, ",le=\"+Inf\"} %llu\n",
+                                        (unsigned long long)cumulative);
+                }
+
+                uint64_t sum_ns =
+                    atomic_load_explicit(&s->sum_ns, memory_order_relaxed);
+                fprintf(out, "%s_sum{", metric);
+                put_series_labels(out, &s->key);
+                fprintf(out, "} %.6f\n%s_count{", (double)sum_ns / 1e9,
+                        metric);
+                put_series_labels(out, &s->key);
+                fprintf(out, "} %llu\n", (unsigned long long)cumulative);
+        }
+}
+
+/**
+ * @enum statement_field
+ * @brief Metric families exported per statement.
+ */
+typedef enum statement_field {
+        STATEMENT_CALLS,
+        STATEMENT_SECONDS,
+        STATEMENT_MAX_SECONDS,
+        STATEMENT_ROWS,
+        STATEMENT_FULLSCAN_STEPS,
+        STATEMENT_SORTS,
+        STATEMENT_FIELD_COUNT
+} statement_field_t;
+
+/**
+ * @brief Current value of one field of a statement profile.
+ * @param st Statement slot.
+ * @param f Field.
+ * @return Value, in seconds for the time fields.
+ */
+static double statement_value(metrics_statement_t* st, statement_field_t f) {
+        switch (f) {
+                case STATEMENT_CALLS: return (double)st->calls;
+                case STATEMENT_SECONDS: return (double)st->total_ns / 1e9;
+                case STATEMENT_MAX_SECONDS: return (double)st->max_ns / 1e9;
+                case STATEMENT_ROWS: return (double)st->rows;
+                case STATEMENT_FULLSCAN_STEPS:
+                        return (double)st->fullscan_steps;
+                default: return (double)st->sorts;
+        }
+}
+
+/**
+ * @brief Print every READY statement profile, one metric family at a time.
+ * @param out Output stream.
+ * @param seg Mapped segment.
+ */
+static void write_statements(FILE* out, metrics_segment_t* seg) {
+        static const char* const families[STATEMENT_FIELD_COUNT][3] = {
+            {"sfe_sql_calls_total", "counter", "Statement executions."},
+            {"sfe_sql_seconds_total", "counter",
+             "Time spent executing the statement."},
+            {"sfe_sql_max_seconds", "gauge", "Slowest single execution."},
+            {"sfe_sql_rows_total", "counter", "Result rows produced."},
+            {"sfe_sql_fullscan_steps_total", "counter",
+             "Full table scan steps (missing index)."},
+            {"sfe_sql_sorts_total", "counter",
+             "Sorts (ORDER BY without a usable index)."},
+        };
+
+        for (int f = 0; f < STATEMENT_FIELD_COUNT; ++f) {
+                const char* name = families[f][0];
+                fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name,
+                        families[f][2], name, families[f][1]);
+
+                for (size_t i = 0; i < METRICS_MAX_STATEMENTS; ++i) {
+                        metrics_statement_t* st = &seg->statements[i];
+                        if (atomic_load_explicit(&st->state,
+                                                 memory_order_acquire) !=
+                            SLOT_READY)
+                                continue;
+
+                        fprintf(out, "%s{sql=\"", name);
+                        put_label(out, st->sql);
+                        fprintf(out, "\"} %.15g\n",
+                                statement_value(st, (statement_field_t)f));
+                }
+        }
+}
+
+/**
+ * @brief Write every metric in Prometheus text exposition format.
+ * @param out Output stream.
+ * @return true on success, false if metrics are unavailable.
+ */
+bool metrics_write_prometheus(FILE* out) {
+        metrics_segment_t* seg = segment_get();
+        if (!seg || !out) return false;
+
+        fputs("# HELP sfe_requests_total Requests by endpoint and HTTP "
+              "status.\n# TYPE sfe_requests_total counter\n",
+              out);
+        for (size_t i = 0; i < METRICS_MAX_COUNTERS; ++i) {
+                metrics_counter_t* c = &seg->counters[i];
+                if (atomic_load_explicit(&c->key.state,
+                                         memory_order_acquire) != SLOT_READY ||
+                    c->key.kind != METRICS_KIND_STATUS)
+                        continue;
+                fputs("sfe_requests_total{endpoint=\"", out);
+                put_label(out, c->key.name);
+                fprintf(out, "\",code=\"%u\"} %llu\n", c->key.code,
+                        (unsigned long long)atomic_load_explicit(
+                            &c->value, memory_order_relaxed));
+        }
+
+        write_histograms(out, seg, METRICS_KIND_REQUEST,
+                         "sfe_request_duration_seconds",
+                         "Whole-request latency by endpoint.");
+        write_histograms(out, seg, METRICS_KIND_PHASE,
+                         "sfe_phase_duration_seconds",
+                         "Latency of each request phase.");
+        write_histograms(out, seg, METRICS_KIND_DAL,
+                         "sfe_dal_duration_seconds",
+                         "Latency of data-access calls.");
+
+        write_statements(out, seg);
+
+        fputs("# HELP sfe_errors_total Failed results by error code.\n"
+              "# TYPE sfe_errors_total counter\n",
+              out);
+        for (size_t i = 0; i < METRICS_MAX_COUNTERS; ++i) {
+                metrics_counter_t* c = &seg->counters[i];
+                if (atomic_load_explicit(&c->key.state,
+                                         memory_order_acquire) != SLOT_READY ||
+                    c->key.kind != METRICS_KIND_ERROR)
+                        continue;
+                fprintf(out, "sfe_errors_total{code=\"%u\",name=\"%s\"} %llu\n",
+                        c->key.code, error_lookup(c->key.code)->name,
+                        (unsigned long long)atomic_load_explicit(
+                            &c->value, memory_order_relaxed));
+        }
+
+        fprintf(out,
+                "# HELP sfe_sqlite_busy_retries_total SQLITE_BUSY retries.\n"
+                "# TYPE sfe_sqlite_busy_retries_total counter\n"
+                "sfe_sqlite_busy_retries_total %llu\n"
+                "# HELP sfe_metrics_dropped_total Updates lost to full "
+                "metric tables.\n"
+                "# TYPE sfe_metrics_dropped_total counter\n"
+                "sfe_metrics_dropped_total %llu\n",
+                (unsigned long long)atomic_load_explicit(
+                    &seg->sqlite_busy, memory_order_relaxed),
+                (unsigned long long)atomic_load_explicit(
+                    &seg->dropped, memory_order_relaxed));
+        return !ferror(out);
+}
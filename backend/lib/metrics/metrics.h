@@ -0,0 +1,110 @@
+/**
+ * @file metrics.h
+ * @brief Cross-process request metrics in a shared-memory segment.
+ *
+ * Every CGI process maps the same file (SFE_METRICS_FILE, default
+ * /dev/shm/sfe_metrics) and updates counters and latency histograms in it
+ * with atomic adds, so no locks are taken on the request path. Series are
+ * created on first use by claiming a free slot with compare-and-swap.
+ *
+ * Requests, phases and status codes are fed from timing_finish(); error
+ * codes from response_from_result(); DAL, per-statement and SQLITE_BUSY
+ * figures from lib/dal. metrics.cgi renders the segment in Prometheus text
+ * format.
+ *
+ * When the segment cannot be mapped (or SFE_METRICS_FILE is set to an empty
+ * string) every call is a no-op.
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** @brief Segment path used when SFE_METRICS_FILE is unset. */
+#define METRICS_DEFAULT_FILE "/dev/shm/sfe_metrics"
+
+/** @brief Histogram slots (request, phase and DAL latency series). */
+#define METRICS_MAX_SERIES 128
+
+/** @brief Counter slots (status codes per endpoint, error codes). */
+#define METRICS_MAX_COUNTERS 256
+
+/** @brief Statement slots (per-SQL profiles from lib/dal/db). */
+#define METRICS_MAX_STATEMENTS 64
+
+/** @brief Fixed size of names stored in the segment; longer ones are cut
+ * to METRICS_NAME_SIZE - 1 characters. */
+#define METRICS_NAME_SIZE 16
+
+/** @brief Longest normalized SQL text kept per statement. */
+#define METRICS_SQL_SIZE 192
+
+/**
+ * @brief Map the metrics segment, creating it if needed.
+ *
+ * Called lazily by every other function; calling it directly only serves to
+ * check availability.
+ *
+ * @return true if metrics are recorded in this process.
+ */
+bool metrics_enabled(void);
+
+/**
+ * @brief Record a finished request.
+ * @param endpoint Endpoint name, e.g. "register".
+ * @param status HTTP status sent.
+ * @param dur_ns Whole request duration.
+ */
+void metrics_observe_request(const char* endpoint, unsigned int status,
+                             uint64_t dur_ns);
+
+/**
+ * @brief Record one phase of a request (see lib/timing).
+ * @param endpoint Endpoint name.
+ * @param phase Phase name, e.g. "argon2".
+ * @param dur_ns Phase duration.
+ */
+void metrics_observe_phase(const char* endpoint, const char* phase,
+                           uint64_t dur_ns);
+
+/**
+ * @brief Record one data-access call.
+ * @param op DAL function name, e.g. "user_insert".
+ * @param dur_ns Call duration.
+ */
+void metrics_observe_dal(const char* op, uint64_t dur_ns);
+
+/**
+ * @brief Record one execution of an SQL statement.
+ * @param sql Normalized statement text (truncated to METRICS_SQL_SIZE - 1).
+ * @param dur_ns Execution time reported by SQLite.
+ * @param rows Result rows produced.
+ * @param fullscan_steps SQLITE_STMTSTATUS_FULLSCAN_STEP for this run.
+ * @param sorts SQLITE_STMTSTATUS_SORT for this run.
+ */
+void metrics_observe_statement(const char* sql, uint64_t dur_ns,
+                               uint64_t rows, uint64_t fullscan_steps,
+                               uint64_t sorts);
+
+/**
+ * @brief Count a failed result by its error code.
+ * @param code Error code from lib/errors.
+ */
+void metrics_count_error(int code);
+
+/**
+ * @brief Count one SQLITE_BUSY retry.
+ */
+void metrics_count_sqlite_busy(void);
+
+/**
+ * @brief Write every metric in Prometheus text exposition format.
+ * @param out Output stream.
+ * @return true on success, false if metrics are unavailable.
+ */
+bool metrics_write_prometheus(FILE* out);
+
+#endif// METRICS_H_
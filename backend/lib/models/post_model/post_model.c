@@ -0,0 +1,14 @@
+#include "post_model.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Free a dynamically allocated post_t struct and its fields
+ * @param post Pointer to post_t to free
+ */
+void post_free(post_t* post) {
+        if (!post) return;
+        free(post->body);
+        free(post->body_html);
+        free(post);
+}
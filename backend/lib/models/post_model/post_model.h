@@ -0,0 +1,32 @@
+#ifndef POST_MODEL_H
+#define POST_MODEL_H
+
+#include <stdint.h>
+
+/**
+ * @file post_model.h
+ * @brief Post (reply) record
+ */
+
+/**
+ * @struct post_t
+ * @brief Represents a post in a thread.
+ */
+typedef struct {
+        int id;             /**< Post ID, -1 if unset */
+        int thread_id;      /**< Thread the post belongs to */
+        int user_id;        /**< ID of the author */
+        char* body;         /**< Body text (dynamically allocated) */
+        int64_t created_at; /**< Creation time in Unix seconds */
+        int parent_id;      /**< Post replied to, 0 for a top-level post */
+        int depth;          /**< Nesting level, 0 for a top-level post */
+        char* body_html;    /**< Rendered body (dynamically allocated) */
+} post_t;
+
+/**
+ * @brief Free a dynamically allocated post_t struct and its fields
+ * @param post Pointer to post_t to free
+ */
+void post_free(post_t* post);
+
+#endif// POST_MODEL_H
@@ -0,0 +1,13 @@
+#include "thread_model.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Free a dynamically allocated thread_t struct and its fields
+ * @param thread Pointer to thread_t to free
+ */
+void thread_free(thread_t* thread) {
+        if (!thread) return;
+        free(thread->title);
+        free(thread);
+}
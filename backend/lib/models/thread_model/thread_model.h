@@ -0,0 +1,29 @@
+#ifndef THREAD_MODEL_H
+#define THREAD_MODEL_H
+
+#include <stdint.h>
+
+/**
+ * @file thread_model.h
+ * @brief Discussion thread record
+ */
+
+/**
+ * @struct thread_t
+ * @brief Represents a thread: its author, title and creation time.
+ */
+typedef struct {
+        int id;             /**< Thread ID, -1 if unset */
+        int user_id;        /**< ID of the user who opened it */
+        char* title;        /**< Title string (dynamically allocated) */
+        int64_t created_at; /**< Creation time in Unix seconds */
+        int post_count;     /**< Posts in the thread (kept by triggers) */
+} thread_t;
+
+/**
+ * @brief Free a dynamically allocated thread_t struct and its fields
+ * @param thread Pointer to thread_t to free
+ */
+void thread_free(thread_t* thread);
+
+#endif// THREAD_MODEL_H
@@ -9,21 +9,21 @@
  * @param out_json Pointer to store the JSON string (caller must free)
  * @return result_t indicating success or failure
  */
-result_t* user_to_json(const user_t* user, char** out_json) {
+result_t user_to_json(const user_t* user, char** out_json) {
         if (out_json) {
                 *out_json = NULL;
         }
 
         if (!user) {
-                result_t* res =
+                result_t res =
                     result_failure("User cannot be NULL", NULL, ERR_USER_NULL);
-                result_add_extra(res, "user=%p", (const void*)user);
+                result_add_extra(&res, "user=%p", (const void*)user);
                 return res;
         }
 
         struct json_object* jobj = json_object_new_object();
         if (!jobj) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to create JSON object", NULL, ERR_JSON_CREATE_FAIL);
                 return res;
         }
@@ -47,7 +47,7 @@ result_t* user_to_json(const user_t* user, char** out_json) {
         json_object_put(jobj);
 
         if (!result) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to allocate memory for JSON string", NULL,
                     ERR_MEMORY_ALLOC_FAIL);
                 return res;
@@ -64,38 +64,39 @@ result_t* user_to_json(const user_t* user, char** out_json) {
  * user_free)
  * @return result_t indicating success or failure
  */
-result_t* json_to_user(const char* json_str, user_t** out_user) {
+result_t json_to_user(const char* json_str, user_t** out_user) {
         if (out_user) {
                 *out_user = NULL;
         }
 
         if (!json_str) {
-                result_t* res = result_failure("JSON string cannot be NULL",
-                                               NULL, ERR_USER_NULL);
-                result_add_extra(res, "json_str=%p", (const void*)json_str);
+                result_t res = result_failure("JSON string cannot be NULL",
+                                              NULL, ERR_USER_NULL);
+                result_add_extra(&res, "json_str=%p", (const void*)json_str);
                 return res;
         }
 
         struct json_object* jobj = json_tokener_parse(json_str);
         if (!jobj) {
-                result_t* res = result_failure("Failed to parse JSON string",
-                                               NULL, ERR_JSON_PARSE_FAIL);
-                result_add_extra(res, "json_str=%s", json_str);
+                result_t res = result_failure("Failed to parse JSON string",
+                                              NULL, ERR_JSON_PARSE_FAIL);
+                result_add_extra(&res, "json_str=%s", json_str);
                 return res;
         }
 
         user_t* user = malloc(sizeof(user_t));
         if (!user) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Failed to allocate memory for user", NULL,
                     ERR_MEMORY_ALLOC_FAIL);
                 json_object_put(jobj);
                 return res;
         }
 
-        user->id            = -1;
-        user->username      = NULL;
-        user->password_hash = NULL;
+        user->id               = -1;
+        user->username         = NULL;
+        user->password_hash    = NULL;
+        user->token_generation = 0;
 
         struct json_object* jfield = NULL;
 
@@ -116,10 +117,10 @@ result_t* json_to_user(const char* json_str, user_t** out_user) {
         json_object_put(jobj);
 
         if (!user->username || !user->password_hash) {
-                result_t* res = result_failure(
+                result_t res = result_failure(
                     "Mandatory fields (username or password_hash) missing",
                     NULL, ERR_MANDATORY_FIELDS_MISSING);
-                result_add_extra(res, "username=%p, password_hash=%p",
+                result_add_extra(&res, "username=%p, password_hash=%p",
                                  (const void*)user->username,
                                  (const void*)user->password_hash);
                 user_free(user);
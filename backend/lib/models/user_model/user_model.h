@@ -2,14 +2,11 @@
 #define USER_MODEL_H
 
 #include <json-c/json.h>
+#include <stdint.h>
 
 #include "/app/backend/lib/result/result.h"
 
-// Library-specific error codes (1200-1299)
-#define ERR_USER_NULL 1201
-#define ERR_JSON_CREATE_FAIL 1202
-#define ERR_JSON_PARSE_FAIL 1203
-#define ERR_MANDATORY_FIELDS_MISSING 1204
+// Library-specific error codes (1200-1299) live in lib/errors/errors.h
 
 /**
  * @struct user_t
@@ -20,6 +17,8 @@ typedef struct {
         char* username; /**< Username string (dynamically allocated) */
         char*
             password_hash; /**< Password hash string (dynamically allocated) */
+        /** JWT generation copied into issued tokens; see lib/revoke. */
+        uint32_t token_generation;
 } user_t;
 
 /**
@@ -28,7 +27,7 @@ typedef struct {
  * @param out_json Pointer to store the JSON string (caller must free)
  * @return result_t indicating success or failure
  */
-result_t* user_to_json(const user_t* user, char** out_json);
+result_t user_to_json(const user_t* user, char** out_json);
 
 /**
  * @brief Parse a JSON string into a dynamically allocated user_t struct
@@ -37,7 +36,7 @@ result_t* user_to_json(const user_t* user, char** out_json);
  * user_free)
  * @return result_t indicating success or failure
  */
-result_t* json_to_user(const char* json_str, user_t** out_user);
+result_t json_to_user(const char* json_str, user_t** out_user);
 
 /**
  * @brief Free a dynamically allocated user_t struct and its fields
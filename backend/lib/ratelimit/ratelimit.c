@@ -0,0 +1,308 @@
+/**
+ * @file ratelimit.c
+ * @brief GCRA buckets in a shared open-addressed table.
+ *
+ * A bucket stores its theoretical arrival time (TAT): the monotonic time at
+ * which the client's bucket would be full again. A request is allowed when
+ * pushing the TAT one emission interval further keeps it within `burst`
+ * intervals of now. CLOCK_MONOTONIC is system-wide, so every process agrees
+ * on it, and the segment lives in tmpfs, so it never outlives a reboot.
+ *
+ * Slots are never emptied. A slot whose TAT has passed holds no state (its
+ * bucket is full) and may be taken over by a new key; two processes doing
+ * that at once can briefly duplicate a key, which only loosens its limit.
+ */
+
+#include "ratelimit.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Segment layout version; bump on any layout change. */
+#define RATELIMIT_VERSION 1
+
+/** @brief Magic word ("SFR" + version) marking an initialized segment. */
+#define RATELIMIT_MAGIC (0x53465200u | RATELIMIT_VERSION)
+
+/** @brief Endpoint-wide buckets used when the table is full. */
+#define RATELIMIT_OVERFLOW_SLOTS 64
+
+/**
+ * @struct ratelimit_slot_t
+ * @brief One bucket.
+ */
+typedef struct {
+        _Atomic uint64_t key; /**< Hash of endpoint and client, 0 if unused */
+        _Atomic uint64_t tat; /**< Theoretical arrival time in ns */
+} ratelimit_slot_t;
+
+/**
+ * @struct ratelimit_segment_t
+ * @brief The whole shared segment.
+ */
+typedef struct {
+        _Atomic uint32_t magic; /**< RATELIMIT_MAGIC once initialized */
+        uint32_t reserved;      /**< Zero */
+        ratelimit_slot_t slots[RATELIMIT_SLOTS];
+        ratelimit_slot_t overflow[RATELIMIT_OVERFLOW_SLOTS];
+} ratelimit_segment_t;
+
+/** @brief This process's mapping, NULL if unavailable. */
+static ratelimit_segment_t* segment = NULL;
+
+/** @brief Whether mapping was already attempted. */
+static bool segment_tried = false;
+
+/**
+ * @brief Map the segment on first use.
+ * @return Mapped segment, or NULL if rate limiting is off.
+ */
+static ratelimit_segment_t* segment_get(void) {
+        if (segment_tried) return segment;
+        segment_tried = true;
+
+        const char* enabled = getenv("SFE_RATELIMIT");
+        if (enabled && strcmp(enabled, "0") == 0) return NULL;
+
+        const char* path = getenv("SFE_RATELIMIT_FILE");
+        if (!path) path = RATELIMIT_DEFAULT_FILE;
+        if (!*path) return NULL;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        bool sized = false;
+        if (fstat(fd, &st) == 0) {
+                if (st.st_size == 0)
+                        sized =
+                            ftruncate(fd, sizeof(ratelimit_segment_t)) == 0;
+                else
+                        sized = st.st_size == sizeof(ratelimit_segment_t);
+        }
+        void* p = sized ? mmap(NULL, sizeof(ratelimit_segment_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED) return NULL;
+
+        ratelimit_segment_t* seg = p;
+        uint32_t magic           = 0;
+        if (!atomic_compare_exchange_strong(&seg->magic, &magic,
+                                            RATELIMIT_MAGIC) &&
+            magic != RATELIMIT_MAGIC) {
+                munmap(p, sizeof(ratelimit_segment_t));
+                return NULL;
+        }
+
+        segment = seg;
+        return segment;
+}
+
+/**
+ * @brief FNV-1a (64-bit) continued over a string and its terminator.
+ * @param h Hash so far.
+ * @param s String.
+ * @return Updated hash.
+ */
+static uint64_t hash_str(uint64_t h, const char* s) {
+        for (; *s; ++s) h = (h ^ (unsigned char)*s) * 1099511628211ull;
+        return h * 1099511628211ull;
+}
+
+/**
+ * @brief Find the bucket for a key, taking over an idle slot if it is new.
+ * @param seg Mapped segment.
+ * @param key Non-zero key.
+ * @param now Current monotonic time.
+ * @param create Whether a new key may claim a slot.
+ * @return Bucket, or NULL if the key has none and cannot get one.
+ */
+static ratelimit_slot_t* slot_find(ratelimit_segment_t* seg, uint64_t key,
+                                   uint64_t now, bool create) {
+        ratelimit_slot_t* idle = NULL;
+        uint64_t idle_key      = 0;
+
+        for (size_t i = 0; i < RATELIMIT_PROBES; ++i) {
+                ratelimit_slot_t* s =
+                    &seg->slots[(key + i) & (RATELIMIT_SLOTS - 1)];
+                uint64_t k =
+                    atomic_load_explicit(&s->key, memory_order_relaxed);
+                if (k == key) return s;
+                if (k == 0) {
+                        /* Slots are never emptied: the key is not further
+                         * along the probe sequence. */
+                        if (!create) return NULL;
+                        if (atomic_compare_exchange_strong(&s->key, &k, key))
+                                return s;
+                        if (k == key) return s;
+                }
+                if (!idle &&
+                    atomic_load_explicit(&s->tat, memory_order_relaxed) <
+                        now) {
+                        idle     = s;
+                        idle_key = k;
+                }
+        }
+
+        if (!create || !idle ||
+            !atomic_compare_exchange_strong(&idle->key, &idle_key, key))
+                return NULL;
+        atomic_store_explicit(&idle->tat, 0, memory_order_relaxed);
+        return idle;
+}
+
+/**
+ * @brief Seconds until a bucket with the given TAT admits one request.
+ * @param next TAT after the request.
+ * @param now Current monotonic time.
+ * @param limit Burst tolerance in ns.
+ * @return Whole seconds, rounded up.
+ */
+static uint32_t retry_after(uint64_t next, uint64_t now, uint64_t limit) {
+        uint64_t wait = next - now - limit;
+        return (uint32_t)((wait + 999999999ull) / 1000000000ull);
+}
+
+/**
+ * @brief Charge one request to a bucket.
+ * @param s Bucket.
+ * @param now Current monotonic time.
+ * @param interval Emission interval in ns.
+ * @param limit Burst tolerance in ns.
+ * @param retry_after_s Seconds until allowed, set on refusal (nullable).
+ * @return true if allowed.
+ */
+static bool bucket_take(ratelimit_slot_t* s, uint64_t now, uint64_t interval,
+                        uint64_t limit, uint32_t* retry_after_s) {
+        uint64_t tat = atomic_load_explicit(&s->tat, memory_order_relaxed);
+        for (;;) {
+                /* A TAT far beyond any reachable value is stale (the rule
+                 * was tightened); restart the bucket. */
+                uint64_t base = tat < now || tat - now > 2 * limit ? now : tat;
+                uint64_t next = base + interval;
+                if (next - now > limit) {
+                        if (retry_after_s)
+                                *retry_after_s =
+                                    retry_after(next, now, limit);
+                        return false;
+                }
+                if (atomic_compare_exchange_weak_explicit(
+                        &s->tat, &tat, next, memory_order_relaxed,
+                        memory_order_relaxed))
+                        return true;
+        }
+}
+
+/**
+ * @brief Check a bucket without charging it.
+ * @param s Bucket.
+ * @param now Current monotonic time.
+ * @param interval Emission interval in ns.
+ * @param limit Burst tolerance in ns.
+ * @param retry_after_s Seconds until allowed, set on refusal (nullable).
+ * @return true if a request would be allowed.
+ */
+static bool bucket_peek(ratelimit_slot_t* s, uint64_t now, uint64_t interval,
+                        uint64_t limit, uint32_t* retry_after_s) {
+        uint64_t tat  = atomic_load_explicit(&s->tat, memory_order_relaxed);
+        uint64_t base = tat < now || tat - now > 2 * limit ? now : tat;
+        uint64_t next = base + interval;
+        if (next - now <= limit) return true;
+        if (retry_after_s) *retry_after_s = retry_after(next, now, limit);
+        return false;
+}
+
+/**
+ * @brief Find the bucket a rule and client charge.
+ * @param rule Limit to apply.
+ * @param client Client key (nullable).
+ * @param now Current monotonic time.
+ * @param create Whether a new client may claim a slot.
+ * @return Bucket, or NULL if rate limiting is off or the rule is empty.
+ */
+static ratelimit_slot_t* rule_bucket(const ratelimit_rule_t* rule,
+                                     const char* client, uint64_t now,
+                                     bool create) {
+        if (!rule || !rule->endpoint || rule->per_minute == 0 ||
+            rule->burst == 0)
+                return NULL;
+
+        ratelimit_segment_t* seg = segment_get();
+        if (!seg) return NULL;
+
+        uint64_t h   = hash_str(14695981039346656037ull, rule->endpoint);
+        uint64_t key = hash_str(h, client ? client : "");
+        if (key == 0) key = 1;
+
+        ratelimit_slot_t* s = slot_find(seg, key, now, create);
+        return s ? s : &seg->overflow[h % RATELIMIT_OVERFLOW_SLOTS];
+}
+
+/**
+ * @brief Take one request from a client's bucket.
+ * @param rule Limit to apply.
+ * @param client Client address, normally getenv("REMOTE_ADDR") (nullable).
+ * @param retry_after_s Set to the seconds until a request would be
+ * allowed when refused (nullable).
+ * @return true if the request may proceed.
+ */
+bool ratelimit_allow(const ratelimit_rule_t* rule, const char* client,
+                     uint32_t* retry_after_s) {
+        uint64_t now        = timing_now_ns();
+        ratelimit_slot_t* s = rule_bucket(rule, client, now, true);
+        if (!s) return true;
+
+        uint64_t interval = 60000000000ull / rule->per_minute;
+        return bucket_take(s, now, interval, interval * rule->burst,
+                           retry_after_s);
+}
+
+/**
+ * @brief Check a client's bucket without taking from it.
+ * @param rule Limit to apply.
+ * @param client Client key, e.g. an address or a username (nullable).
+ * @param retry_after_s Set to the seconds until a request would be
+ * allowed when refused (nullable).
+ * @return true if ratelimit_allow() would allow one more request now.
+ */
+bool ratelimit_peek(const ratelimit_rule_t* rule, const char* client,
+                    uint32_t* retry_after_s) {
+        uint64_t now        = timing_now_ns();
+        ratelimit_slot_t* s = rule_bucket(rule, client, now, false);
+        if (!s) return true;
+
+        uint64_t interval = 60000000000ull / rule->per_minute;
+        return bucket_peek(s, now, interval, interval * rule->burst,
+                           retry_after_s);
+}
+
+/**
+ * @brief Take one request from a client's bucket, ignoring the outcome.
+ * @param rule Limit to apply.
+ * @param client Client key, as for ratelimit_peek() (nullable).
+ */
+void ratelimit_charge(const ratelimit_rule_t* rule, const char* client) {
+        (void)ratelimit_allow(rule, client, NULL);
+}
+
+/**
+ * @brief Send the canned 429 response and finish the request timing.
+ * @param timing Request timing (nullable).
+ * @param retry_after_s Value for the Retry-After header.
+ */
+void ratelimit_send_429(timing_t* timing, uint32_t retry_after_s) {
+        printf("Status: 429\r\n"
+               "Content-Type: application/json\r\n"
+               "Retry-After: %u\r\n"
+               "\r\n"
+               "{\"status\":429,\"messages\":[\"Too many requests.\"]}\n",
+               retry_after_s ? retry_after_s : 1);
+        timing_finish(timing, 429);
+}
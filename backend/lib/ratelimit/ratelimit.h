@@ -0,0 +1,97 @@
+/**
+ * @file ratelimit.h
+ * @brief Cross-process per-client rate limiting in a shared-memory table.
+ *
+ * Every CGI process maps the same file (SFE_RATELIMIT_FILE, default
+ * /dev/shm/sfe_ratelimit) holding an open-addressed table of buckets keyed
+ * by endpoint and REMOTE_ADDR. Each bucket is a single GCRA (generic cell
+ * rate algorithm, an exact token bucket) timestamp updated with
+ * compare-and-swap, so a check is a hash, a few loads and one CAS.
+ *
+ * Handlers call ratelimit_allow() before reading the request body and
+ * answer with ratelimit_send_429() when it refuses. When the segment cannot
+ * be mapped, or SFE_RATELIMIT=0, every request is allowed.
+ *
+ * A bucket can also count failures instead of requests: the handler asks
+ * ratelimit_peek() before the expensive work and calls ratelimit_charge()
+ * only when the attempt fails, so successes cost nothing.
+ */
+
+#ifndef RATELIMIT_H_
+#define RATELIMIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Segment path used when SFE_RATELIMIT_FILE is unset. */
+#define RATELIMIT_DEFAULT_FILE "/dev/shm/sfe_ratelimit"
+
+/** @brief Buckets in the table (power of two). */
+#define RATELIMIT_SLOTS 8192
+
+/** @brief Slots probed before falling back to the endpoint-wide bucket. */
+#define RATELIMIT_PROBES 16
+
+/**
+ * @struct ratelimit_rule_t
+ * @brief Limit applied to each client of one endpoint.
+ */
+typedef struct {
+        const char* endpoint; /**< Endpoint name, e.g. "register" */
+        uint32_t per_minute;  /**< Sustained requests per minute */
+        uint32_t burst;       /**< Requests allowed back to back */
+} ratelimit_rule_t;
+
+/**
+ * @brief Take one request from a client's bucket.
+ *
+ * When the table has no room for a new client, the request is charged to a
+ * bucket shared by every such client of the endpoint instead, so a flood
+ * from many addresses is still throttled.
+ *
+ * @param rule Limit to apply.
+ * @param client Client address, normally getenv("REMOTE_ADDR") (nullable).
+ * @param retry_after_s Set to the seconds until a request would be
+ * allowed when refused (nullable).
+ * @return true if the request may proceed.
+ */
+bool ratelimit_allow(const ratelimit_rule_t* rule, const char* client,
+                     uint32_t* retry_after_s);
+
+/**
+ * @brief Check a client's bucket without taking from it.
+ *
+ * A client that has no bucket yet is checked against the endpoint-wide
+ * overflow bucket, which is where ratelimit_charge() puts it when the table
+ * is full.
+ *
+ * @param rule Limit to apply.
+ * @param client Client key, e.g. an address or a username (nullable).
+ * @param retry_after_s Set to the seconds until a request would be
+ * allowed when refused (nullable).
+ * @return true if ratelimit_allow() would allow one more request now.
+ */
+bool ratelimit_peek(const ratelimit_rule_t* rule, const char* client,
+                    uint32_t* retry_after_s);
+
+/**
+ * @brief Take one request from a client's bucket, ignoring the outcome.
+ *
+ * Use after ratelimit_peek() allowed an attempt that then failed. A bucket
+ * that is already empty stays empty; it is not pushed further out.
+ *
+ * @param rule Limit to apply.
+ * @param client Client key, as for ratelimit_peek() (nullable).
+ */
+void ratelimit_charge(const ratelimit_rule_t* rule, const char* client);
+
+/**
+ * @brief Send the canned 429 response and finish the request timing.
+ * @param timing Request timing (nullable).
+ * @param retry_after_s Value for the Retry-After header.
+ */
+void ratelimit_send_429(timing_t* timing, uint32_t retry_after_s);
+
+#endif// RATELIMIT_H_
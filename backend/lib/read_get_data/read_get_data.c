@@ -10,9 +10,9 @@
  * @brief Reads GET query string from environment and allocates a buffer.
  * @param out_query Pointer to store allocated null-terminated buffer (caller
  * must free)
- * @return result_t* indicating success or failure
+ * @return result_t indicating success or failure
  */
-result_t* read_get_data(char** out_query) {
+result_t read_get_data(char** out_query) {
         if (!out_query)
                 return result_failure("Output pointer NULL", NULL,
                                       ERR_GET_NULL_INPUT);
@@ -42,3 +42,70 @@ result_t* read_get_data(char** out_query) {
 
         return result_success();
 }
+
+/**
+ * @brief Value of one hex digit.
+ * @param c Character
+ * @return 0-15, or -1 if @p c is not a hex digit
+ */
+static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+}
+
+/**
+ * @brief Find a parameter in a query string and URL-decode its value.
+ * @param query Query string, e.g. getenv("QUERY_STRING") (nullable)
+ * @param name Parameter name
+ * @param out Buffer for the decoded, null-terminated value
+ * @param cap Capacity of @p out
+ * @return Success, ERR_GET_PARAM_MISSING when absent, or
+ * ERR_GET_PARAM_TOO_LONG when the decoded value does not fit
+ */
+result_t read_get_param(const char* query, const char* name, char* out,
+                        size_t cap) {
+        if (!name || !out || cap == 0)
+                return result_failure("Invalid arguments", NULL,
+                                      ERR_GET_NULL_INPUT);
+        out[0] = '\0';
+
+        size_t name_len = strlen(name);
+        const char* p   = query;
+        while (p && *p) {
+                const char* end = strchr(p, '&');
+                if (!end) end = p + strlen(p);
+
+                if ((size_t)(end - p) > name_len &&
+                    strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+                        size_t len = 0;
+                        for (const char* v = p + name_len + 1; v < end; ++v) {
+                                if (len + 1 >= cap) {
+                                        out[0] = '\0';
+                                        return result_failure(
+                                            "Query parameter too long", NULL,
+                                            ERR_GET_PARAM_TOO_LONG);
+                                }
+                                int hi = v + 2 < end ? hex_value(v[1]) : -1;
+                                int lo = v + 2 < end ? hex_value(v[2]) : -1;
+                                if (*v == '%' && hi >= 0 && lo >= 0) {
+                                        out[len++] = (char)(hi << 4 | lo);
+                                        v += 2;
+                                } else {
+                                        out[len++] = *v == '+' ? ' ' : *v;
+                                }
+                        }
+                        out[len] = '\0';
+                        return result_success();
+                }
+                if ((size_t)(end - p) == name_len &&
+                    strncmp(p, name, name_len) == 0)
+                        return result_success();
+
+                p = *end ? end + 1 : end;
+        }
+
+        return result_failure("Query parameter missing", NULL,
+                              ERR_GET_PARAM_MISSING);
+}
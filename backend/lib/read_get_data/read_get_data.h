@@ -1,9 +1,27 @@
 #ifndef READ_GET_DATA_H_
 #define READ_GET_DATA_H_
 
+#include <stddef.h>
+
 #include "/app/backend/lib/result/result.h"
 
-#define ERR_GET_NULL_INPUT 3001
-result_t* read_get_data(char** out_query);
+// Error codes (3000-3099) live in lib/errors/errors.h
+result_t read_get_data(char** out_query);
+
+/**
+ * @brief Find a parameter in a query string and URL-decode its value.
+ *
+ * Decodes %XX escapes and '+' as a space. The first occurrence of @p name
+ * wins.
+ *
+ * @param query Query string, e.g. getenv("QUERY_STRING") (nullable)
+ * @param name Parameter name
+ * @param out Buffer for the decoded, null-terminated value
+ * @param cap Capacity of @p out
+ * @return Success, ERR_GET_PARAM_MISSING when absent, or
+ * ERR_GET_PARAM_TOO_LONG when the decoded value does not fit
+ */
+result_t read_get_param(const char* query, const char* name, char* out,
+                        size_t cap);
 
 #endif// READ_GET_DATA_H_
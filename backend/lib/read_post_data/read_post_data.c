@@ -6,20 +6,21 @@
 
 /**
  * @brief Reads POST data from stdin based on CONTENT_LENGTH.
- * @param out_body Pointer to store allocated null-terminated buffer (caller
- * must free).
+ * @param out_body Pointer to store allocated null-terminated buffer (owned by
+ * @p arena, or caller must free when @p arena is NULL).
+ * @param arena Request arena to allocate the body from (nullable).
  * @return result_t indicating success or failure with details.
  */
-result_t* read_post_data(char** out_body) {
+result_t read_post_data(char** out_body, arena_t* arena) {
         if (out_body) {
                 *out_body = NULL;
         }
 
         const char* len_str = getenv("CONTENT_LENGTH");
         if (!len_str) {
-                result_t* res = result_failure("CONTENT_LENGTH not set", NULL,
-                                               ERR_INVALID_CONTENT_LENGTH);
-                result_add_extra(res, "len_str=%p", (const void*)len_str);
+                result_t res = result_failure("CONTENT_LENGTH not set", NULL,
+                                              ERR_INVALID_CONTENT_LENGTH);
+                result_add_extra(&res, "len_str=%p", (const void*)len_str);
                 return res;
         }
 
@@ -27,28 +28,28 @@ result_t* read_post_data(char** out_body) {
         errno    = 0;
         long len = strtol(len_str, &endptr, 10);
         if (errno != 0 || *endptr != '\0' || len <= 0 || len > 65536) {
-                result_t* res = result_failure("Invalid CONTENT_LENGTH", NULL,
-                                               ERR_INVALID_CONTENT_LENGTH);
-                result_add_extra(res, "len_str=%s, len=%ld, errno=%d", len_str,
+                result_t res = result_failure("Invalid CONTENT_LENGTH", NULL,
+                                              ERR_INVALID_CONTENT_LENGTH);
+                result_add_extra(&res, "len_str=%s, len=%ld, errno=%d", len_str,
                                  len, errno);
                 return res;
         }
 
-        char* body = malloc(len + 1);
+        char* body = arena_alloc(arena, (size_t)len + 1);
         if (!body) {
-                result_t* res = result_critical_failure(
+                result_t res = result_critical_failure(
                     "Memory allocation failed", NULL, ERR_MEMORY_ALLOC_FAIL);
-                result_add_extra(res, "requested_size=%ld", len + 1);
+                result_add_extra(&res, "requested_size=%ld", len + 1);
                 return res;
         }
 
         size_t read_len = fread(body, 1, len, stdin);
         if (read_len != (size_t)len) {
-                result_t* res = result_failure("Failed to read POST data", NULL,
-                                               ERR_READ_FAIL);
-                result_add_extra(res, "read_len=%zu, expected=%ld, errno=%d",
+                result_t res = result_failure("Failed to read POST data", NULL,
+                                              ERR_READ_FAIL);
+                result_add_extra(&res, "read_len=%zu, expected=%ld, errno=%d",
                                  read_len, len, errno);
-                free(body);
+                arena_free(arena, body);
                 return res;
         }
 
@@ -4,73 +4,196 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "/app/backend/lib/metrics/metrics.h"
+
+/** @brief Initial capacity of the serialized messages buffer. */
+#define RESPONSE_INITIAL_CAP 256
+
 /**
- * @brief Initializes a response object with a given HTTP code.
+ * @brief Tags the request for tools/allocprof when it is preloaded.
+ *
+ * The profiler exports SFE_ALLOCPROF_ACTIVE and reads the tags back from
+ * the environment when the process exits.
+ *
+ * @param key Environment variable to set
+ * @param value Tag value
+ */
+static void response_allocprof_tag(const char* key, const char* value) {
+        static int active = -1;
+        if (active < 0) active = getenv("SFE_ALLOCPROF_ACTIVE") != NULL;
+        if (active) setenv(key, value, 1);
+}
+
+/**
+ * @brief Ensures the messages buffer can hold @p extra more bytes.
  *
- * Sets up the root JSON object and messages array. If re-initializing,
- * any previous JSON objects are freed.
+ * Arena-backed buffers grow by copying into a fresh arena block; heap buffers
+ * grow with realloc().
  *
  * @param resp Pointer to the response_t object
- * @param http_code HTTP status code to set
+ * @param extra Number of additional bytes required
+ * @return true if the buffer has room, false on allocation failure
  */
-void response_init(response_t* resp, unsigned int http_code) {
-        if (!resp) return;
+static bool response_reserve(response_t* resp, size_t extra) {
+        if (resp->messages_cap - resp->messages_len >= extra) return true;
 
-        if (resp->root) {
-                json_object_put(resp->root);
-                resp->root     = NULL;
-                resp->messages = NULL;
+        size_t cap = resp->messages_cap ? resp->messages_cap
+                                        : RESPONSE_INITIAL_CAP;
+        while (cap - resp->messages_len < extra) {
+                if (cap > (size_t)-1 / 2) return false;
+                cap *= 2;
         }
 
-        resp->response_code = http_code;
-        resp->response_sent = false;
-
-        resp->root = json_object_new_object();
-        if (!resp->root) {
-                resp->messages = NULL;
-                return;
+        char* buf = NULL;
+        if (resp->arena) {
+                buf = arena_alloc(resp->arena, cap);
+                if (buf && resp->messages_len)
+                        memcpy(buf, resp->messages, resp->messages_len);
+        } else {
+                buf = realloc(resp->messages, cap);
         }
+        if (!buf) return false;
 
-        json_object_object_add(resp->root, "status",
-                               json_object_new_int((int)http_code));
+        resp->messages     = buf;
+        resp->messages_cap = cap;
+        return true;
+}
 
-        resp->messages = json_object_new_array();
-        if (resp->messages) {
-                json_object_object_add(resp->root, "messages", resp->messages);
-        }
+/**
+ * @brief Appends raw bytes to the messages buffer.
+ *
+ * @param resp Pointer to the response_t object
+ * @param data Bytes to append
+ * @param len Number of bytes
+ * @return true on success, false on allocation failure
+ */
+static bool response_put(response_t* resp, const char* data, size_t len) {
+        if (!response_reserve(resp, len)) return false;
+        memcpy(resp->messages + resp->messages_len, data, len);
+        resp->messages_len += len;
+        return true;
 }
 
 /**
- * @brief Appends a string message to the response's JSON array.
+ * @brief Appends @p msg as a JSON string literal, escaping it the same way
+ * json-c does.
  *
  * @param resp Pointer to the response_t object
- * @param msg C string to append
+ * @param msg C string to encode
+ * @return true on success, false on allocation failure
  */
-void response_append_str(response_t* resp, const char* msg) {
-        if (!resp || !msg) return;
+static bool response_put_json_string(response_t* resp, const char* msg) {
+        static const char hex[] = "0123456789abcdef";
+
+        if (!response_put(resp, "\"", 1)) return false;
 
-        if (!resp->messages && resp->root) {
-                resp->messages = json_object_new_array();
-                if (resp->messages) {
-                        json_object_object_add(resp->root, "messages",
-                                               resp->messages);
+        const char* run = msg;
+        for (const char* p = msg; *p; ++p) {
+                unsigned char c = (unsigned char)*p;
+                char esc[6];
+                size_t esc_len = 2;
+
+                esc[0] = '\\';
+                switch (c) {
+                        case '"': esc[1] = '"'; break;
+                        case '\\': esc[1] = '\\'; break;
+                        case '/': esc[1] = '/'; break;
+                        case '\b': esc[1] = 'b'; break;
+                        case '\f': esc[1] = 'f'; break;
+                        case '\n': esc[1] = 'n'; break;
+                        case '\r': esc[1] = 'r'; break;
+                        case '\t': esc[1] = 't'; break;
+                        default:
+                                if (c >= 0x20) continue;
+                                esc[1]  = 'u';
+                                esc[2]  = '0';
+                                esc[3]  = '0';
+                                esc[4]  = hex[c >> 4];
+                                esc[5]  = hex[c & 0x0f];
+                                esc_len = 6;
+                                break;
                 }
+
+                if (!response_put(resp, run, (size_t)(p - run)) ||
+                    !response_put(resp, esc, esc_len))
+                        return false;
+                run = p + 1;
         }
 
-        if (!resp->messages) return;
+        return response_put(resp, run, strlen(run)) &&
+               response_put(resp, "\"", 1);
+}
+
+/**
+ * @brief Starts a new element in the messages array, emitting a separator
+ * when needed.
+ *
+ * @param resp Pointer to the response_t object
+ * @return Buffer length before the element, used to roll back on failure
+ */
+static size_t response_begin_element(response_t* resp) {
+        size_t mark = resp->messages_len;
+        if (mark > 0) response_put(resp, ",", 1);
+        return mark;
+}
+
+/**
+ * @brief Initializes a response object backed by a request arena.
+ *
+ * @param resp Pointer to the response_t object
+ * @param arena Request arena for message storage (nullable)
+ * @param http_code HTTP status code to set
+ */
+void response_init_arena(response_t* resp, arena_t* arena,
+                         unsigned int http_code) {
+        if (!resp) return;
 
-        json_object* jstr = json_object_new_string(msg);
-        if (!jstr) return;
+        resp->arena         = arena;
+        resp->messages      = NULL;
+        resp->messages_len  = 0;
+        resp->messages_cap  = 0;
+        resp->response_code = http_code;
+        resp->response_sent = false;
+        resp->headers_len   = 0;
+        resp->timing        = NULL;
+}
 
-        if (json_object_array_add(resp->messages, jstr) != 0) {
-                json_object_put(jstr);
-        }
+/**
+ * @brief Initializes a response object with a given HTTP code.
+ *
+ * Discards previously appended messages but keeps the buffer, so
+ * re-initializing on an error path does not allocate.
+ *
+ * @param resp Pointer to the response_t object
+ * @param http_code HTTP status code to set
+ */
+void response_init(response_t* resp, unsigned int http_code) {
+        if (!resp) return;
+
+        resp->response_code = http_code;
+        resp->response_sent = false;
+        resp->messages_len  = 0;
+        resp->headers_len   = 0;
+}
+
+/**
+ * @brief Appends a string message to the response's JSON array.
+ *
+ * @param resp Pointer to the response_t object
+ * @param msg C string to append
+ */
+void response_append_str(response_t* resp, const char* msg) {
+        if (!resp || !msg) return;
+
+        size_t mark = response_begin_element(resp);
+        if (!response_put_json_string(resp, msg)) resp->messages_len = mark;
 }
 
 /**
- * @brief Safely appends a JSON object to the response's JSON array.
+ * @brief Appends a JSON object to the response's JSON array.
  *
- * Increments the refcount of the object so that the response owns a reference.
+ * The object is serialized right away, so the response holds no reference
+ * to it afterwards.
  *
  * @param resp Pointer to the response_t object
  * @param obj JSON object to append
@@ -78,82 +201,185 @@ void response_append_str(response_t* resp, const char* msg) {
 void response_append_json(response_t* resp, struct json_object* obj) {
         if (!resp || !obj) return;
 
-        if (!resp->messages && resp->root) {
-                resp->messages = json_object_new_array();
-                if (resp->messages) {
-                        json_object_object_add(resp->root, "messages",
-                                               resp->messages);
-                }
+        const char* json =
+            json_object_to_json_string_ext(obj, JSON_C_TO_STRING_PLAIN);
+        if (!json) return;
+
+        size_t mark = response_begin_element(resp);
+        if (!response_put(resp, json, strlen(json)))
+                resp->messages_len = mark;
+}
+
+/**
+ * @brief Appends already serialized elements to the response's JSON array.
+ *
+ * @param resp Pointer to the response_t object
+ * @param elements Serialized elements, without the enclosing brackets
+ * @param len Length of @p elements
+ * @return true if appended, false on allocation failure
+ */
+bool response_append_raw(response_t* resp, const char* elements, size_t len) {
+        if (!resp || !elements) return false;
+        if (len == 0) return true;
+
+        size_t mark = response_begin_element(resp);
+        if (!response_put(resp, elements, len)) {
+                resp->messages_len = mark;
+                return false;
         }
+        return true;
+}
 
-        if (!resp->messages) return;
+/**
+ * @brief Adds a response header.
+ *
+ * @param resp Pointer to the response_t object
+ * @param name Header name
+ * @param value Header value; CR and LF are rejected
+ * @return true if added, false if invalid or out of room
+ */
+bool response_add_header(response_t* resp, const char* name,
+                         const char* value) {
+        if (!resp || !name || !value || !*name) return false;
+        if (strpbrk(name, "\r\n:") || strpbrk(value, "\r\n")) return false;
 
-        struct json_object* obj_ref = json_object_get(obj);
-        if (!obj_ref) return;
+        size_t room = sizeof(resp->headers) - resp->headers_len;
+        int n = snprintf(resp->headers + resp->headers_len, room, "%s: %s\r\n",
+                         name, value);
+        if (n < 0 || (size_t)n >= room) {
+                resp->headers[resp->headers_len] = '\0';
+                return false;
+        }
+        resp->headers_len += (size_t)n;
+        return true;
+}
 
-        if (json_object_array_add(resp->messages, obj_ref) != 0) {
-                json_object_put(obj_ref);
+/**
+ * @brief Whether an If-None-Match list names @p etag.
+ *
+ * Entries are separated by commas; a W/ prefix is ignored (weak
+ * comparison), and a lone "*" matches anything.
+ *
+ * @param list Header value
+ * @param etag Tag to look for, quotes included
+ * @return true if listed
+ */
+static bool response_etag_listed(const char* list, const char* etag) {
+        size_t etag_len = strlen(etag);
+        const char* p   = list;
+        while (*p) {
+                while (*p == ' ' || *p == '\t' || *p == ',') ++p;
+                if (!*p) break;
+
+                const char* end = strchr(p, ',');
+                if (!end) end = p + strlen(p);
+                const char* last = end;
+                while (last > p && (last[-1] == ' ' || last[-1] == '\t'))
+                        --last;
+
+                if (last - p == 1 && *p == '*') return true;
+                if (last - p > 2 && p[0] == 'W' && p[1] == '/') p += 2;
+                if ((size_t)(last - p) == etag_len &&
+                    memcmp(p, etag, etag_len) == 0)
+                        return true;
+                p = end;
         }
+        return false;
+}
+
+/**
+ * @brief Answers a conditional GET when the client's copy is current.
+ *
+ * @param resp Pointer to the response_t object
+ * @param etag Current strong tag, quotes included
+ * @return true if @p resp is now a 304
+ */
+bool response_not_modified(response_t* resp, const char* etag) {
+        if (!resp || !etag || !*etag) return false;
+
+        const char* list = getenv("HTTP_IF_NONE_MATCH");
+        if (!list || !response_etag_listed(list, etag)) return false;
+
+        response_init(resp, 304);
+        response_add_header(resp, "ETag", etag);
+        return true;
+}
+
+/**
+ * @brief Attaches request timing to a response.
+ *
+ * @param resp Pointer to the response_t object
+ * @param timing Timing started with timing_init() (nullable)
+ */
+void response_set_timing(response_t* resp, timing_t* timing) {
+        if (resp) resp->timing = timing;
+}
+
+/**
+ * @brief Turns a failed result into its canned response.
+ *
+ * @param resp Pointer to the response_t object
+ * @param res Failed result
+ */
+void response_from_result(response_t* resp, const result_t* res) {
+        if (!resp) return;
+
+        const error_info_t* info = result_error_info(res);
+        if (!info) info = error_lookup(0);
+
+        result_log(res);
+        metrics_count_error(info->code);
+        response_allocprof_tag("SFE_ALLOCPROF_ERROR", info->name);
+        response_init(resp, info->http_status);
+        response_append_str(resp, info->public_message);
 }
 
 /**
  * @brief Sends the HTTP response (prints JSON payload).
  *
- * Prints HTTP-style headers and the serialized JSON payload. Ensures
- * the response is only sent once.
+ * Prints HTTP-style headers and the serialized JSON payload; a 304 gets
+ * no body, nor a Content-Type. Ensures the response is only sent once,
+ * then finishes the attached timing.
  *
  * @param resp Pointer to the response_t object
  */
 void response_send(response_t* resp) {
         if (!resp || resp->response_sent) return;
 
-        if (!resp->root) {
-                resp->root = json_object_new_object();
-                if (!resp->root) {
-                        resp->response_sent = true;
-                        return;
-                }
-                json_object_object_add(
-                    resp->root, "status",
-                    json_object_new_int((int)resp->response_code));
-        }
+        char server_timing[512];
+        size_t timing_len = timing_format_header(resp->timing, server_timing,
+                                                 sizeof(server_timing));
 
-        if (!resp->messages) {
-                resp->messages = json_object_new_array();
-                if (resp->messages) {
-                        json_object_object_add(resp->root, "messages",
-                                               resp->messages);
-                }
-        }
-
-        const char* payload =
-            json_object_to_json_string_ext(resp->root, JSON_C_TO_STRING_PLAIN);
-        if (!payload) {
-                resp->response_sent = true;
-                return;
-        }
+        bool has_body = resp->response_code != 304;
 
         printf("Status: %u\r\n", resp->response_code);
-        printf("Content-Type: application/json\r\n\r\n");
-        printf("%s\n", payload);
+        if (has_body) printf("Content-Type: application/json\r\n");
+        if (timing_len) printf("Server-Timing: %s\r\n", server_timing);
+        printf("%.*s\r\n", (int)resp->headers_len, resp->headers);
+        if (has_body)
+                printf("{\"status\":%u,\"messages\":[%.*s]}\n",
+                       resp->response_code, (int)resp->messages_len,
+                       resp->messages ? resp->messages : "");
 
         resp->response_sent = true;
+        timing_finish(resp->timing, resp->response_code);
+
+        char status[16];
+        snprintf(status, sizeof(status), "%u", resp->response_code);
+        response_allocprof_tag("SFE_ALLOCPROF_STATUS", status);
 }
 
 /**
  * @brief Frees all resources held by a response object.
  *
- * Drops all JSON object references and resets pointers to NULL.
- *
  * @param resp Pointer to the response_t object
  */
 void response_free(response_t* resp) {
         if (!resp) return;
 
-        if (resp->root) {
-                json_object_put(resp->root);
-                resp->root = NULL;
-        }
+        arena_free(resp->arena, resp->messages);
         resp->messages      = NULL;
+        resp->messages_len  = 0;
+        resp->messages_cap  = 0;
         resp->response_sent = false;
 }
@@ -3,6 +3,14 @@
 
 #include <json-c/json.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "/app/backend/lib/arena/arena.h"
+#include "/app/backend/lib/result/result.h"
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Room for extra header lines ("Name: value\r\n") per response. */
+#define RESPONSE_HEADERS_SIZE 512
 
 /**
  * @struct response_t
@@ -11,21 +19,44 @@
  * Encapsulates response metadata and JSON payload:
  * - status code
  * - sent flag
- * - root JSON object (contains status + messages)
- * - messages array
+ * - backing arena (NULL for heap)
+ * - messages array, kept pre-serialized so no json-c tree is built
+ * - extra header lines, stored inline so adding one never allocates
+ * - optional request timing, rendered as Server-Timing on send
+ *
+ * A response must be zero-initialized (`response_t resp = {0};`) or set up
+ * with response_init_arena() before its first response_init().
  */
 typedef struct {
-        unsigned int response_code;   /**< HTTP status code */
-        bool response_sent;           /**< Flag if response already sent */
-        struct json_object* root;     /**< Root JSON object */
-        struct json_object* messages; /**< "messages" JSON array */
+        unsigned int response_code; /**< HTTP status code */
+        bool response_sent;         /**< Flag if response already sent */
+        arena_t* arena;             /**< Arena backing messages (nullable) */
+        char* messages;     /**< Serialized "messages" elements, no brackets */
+        size_t messages_len; /**< Bytes used in messages */
+        size_t messages_cap; /**< Capacity of messages */
+        char headers[RESPONSE_HEADERS_SIZE]; /**< Extra header lines */
+        size_t headers_len; /**< Bytes used in headers */
+        timing_t* timing;   /**< Request timing (nullable) */
 } response_t;
 
+/**
+ * @brief Initializes a response object backed by a request arena.
+ *
+ * Use once per request before any response_init(); later re-initializations
+ * keep the arena.
+ *
+ * @param resp Pointer to the response object.
+ * @param arena Request arena for message storage (nullable).
+ * @param http_code HTTP status code to set.
+ */
+void response_init_arena(response_t* resp, arena_t* arena,
+                         unsigned int http_code);
+
 /**
  * @brief Initializes a response object with a given HTTP code.
  *
- * Creates a new JSON root object with "status" and "messages".
- * If the response already has allocated JSON, it will be freed.
+ * Sets the status and discards any previously appended messages, keeping the
+ * allocated buffer and arena for reuse.
  *
  * @param resp Pointer to the response object.
  * @param http_code HTTP status code to set.
@@ -48,15 +79,84 @@ void response_append_str(response_t* resp, const char* msg);
  * Example: [{"key": "value"}]
  *
  * @param resp Pointer to the response object.
- * @param obj JSON object to append. Its reference count is incremented.
+ * @param obj JSON object to append. It is serialized immediately, so the
+ * caller keeps ownership.
  */
 void response_append_json(response_t* resp, struct json_object* obj);
 
+/**
+ * @brief Appends already serialized elements to the response's JSON array.
+ *
+ * Used to replay a payload saved from another response's messages (see
+ * lib/cache); @p elements is copied as is, so it must be valid JSON values
+ * separated by commas.
+ *
+ * @param resp Pointer to the response object.
+ * @param elements Serialized elements, without the enclosing brackets.
+ * @param len Length of @p elements.
+ * @return true if appended, false on allocation failure.
+ */
+bool response_append_raw(response_t* resp, const char* elements, size_t len);
+
+/**
+ * @brief Adds a response header.
+ *
+ * Headers are cleared by response_init(), so add them after choosing the
+ * final status.
+ *
+ * @param resp Pointer to the response object.
+ * @param name Header name, e.g. "Retry-After".
+ * @param value Header value; CR and LF are rejected.
+ * @return true if added, false if invalid or out of room.
+ */
+bool response_add_header(response_t* resp, const char* name,
+                         const char* value);
+
+/**
+ * @brief Answers a conditional GET when the client's copy is current.
+ *
+ * Compares @p etag with the request's If-None-Match header (the CGI
+ * variable HTTP_IF_NONE_MATCH), using the weak comparison RFC 9110 asks
+ * for; "*" matches any tag. On a match @p resp is re-initialized as a 304
+ * carrying the ETag, ready for response_send(), which then prints no body.
+ * Call it as soon as the tag is known, before any SQL or serialization.
+ *
+ * @param resp Pointer to the response object.
+ * @param etag Current strong tag, quotes included (see cache_etag()).
+ * @return true if @p resp is now a 304, false if the request must be served.
+ */
+bool response_not_modified(response_t* resp, const char* etag);
+
+/**
+ * @brief Attaches request timing to a response.
+ *
+ * response_send() then emits the Server-Timing header (when enabled) and
+ * finishes the timing, writing its trace record.
+ *
+ * @param resp Pointer to the response object.
+ * @param timing Timing started with timing_init() (nullable).
+ */
+void response_set_timing(response_t* resp, timing_t* timing);
+
+/**
+ * @brief Turns a failed result into its canned response.
+ *
+ * Looks the error code up in the error registry and re-initializes @p resp
+ * with the registered HTTP status and public message, logging the failure
+ * according to its severity.
+ *
+ * @param resp Pointer to the response object.
+ * @param res Failed result (a success yields a bare 500).
+ */
+void response_from_result(response_t* resp, const result_t* res);
+
 /**
  * @brief Sends the HTTP response, printing headers and the JSON payload.
  *
- * Marks the response as sent and prevents further modifications.
- * Typically prints to stdout for CGI-style apps.
+ * A 304 is sent with headers only. Marks the response as sent and prevents
+ * further modifications.
+ * Typically prints to stdout for CGI-style apps. Finishes the attached
+ * timing, if any.
  *
  * @param resp Pointer to the response object.
  */
@@ -65,7 +165,8 @@ void response_send(response_t* resp);
 /**
  * @brief Frees all resources held by a response object.
  *
- * Releases JSON objects (root + messages).
+ * Releases the heap message buffer; arena-backed buffers are left for the
+ * arena.
  *
  * @param resp Pointer to the response object.
  */
@@ -5,8 +5,9 @@
  *
  * This module defines a standardized result object for representing
  * success, failure, and critical failure states in a consistent manner.
- * It also provides JSON conversion and convenience macros that capture
- * contextual information automatically.
+ * Results are plain values: they are returned by value, never allocated and
+ * never freed. Failures point at a static per-call-site error descriptor
+ * that the convenience macros emit, so building one costs a few stores.
  */
 
 #ifndef RESULT_H_
@@ -14,8 +15,11 @@
 
 #include <json-c/json.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "/app/backend/lib/errors/errors.h"
+
 /**
  * @enum result_code
  * @brief Result status codes.
@@ -29,83 +33,99 @@ typedef enum result_code {
 
 /**
  * @struct error_t
- * @brief Structure holding detailed information about an error.
+ * @brief Static descriptor of one error site.
  *
- * Each field is heap-allocated; caller is responsible for cleanup
- * through result_free().
+ * One descriptor is emitted per result_failure()/result_critical_failure()
+ * call site and lives in read-only storage; all strings are literals.
  */
 typedef struct {
-        int code;          /**< Library-specific error code */
-        char* message;     /**< Human-readable error message */
-        char* failed_file; /**< Source file where error occurred */
-        char* failed_func; /**< Function name where error occurred */
-        char* extra_info;  /**< Optional additional context or details */
+        int code;                /**< Library-specific error code */
+        const char* message;     /**< Human-readable error message */
+        const char* failed_file; /**< Source file where error occurred */
+        const char* failed_func; /**< Function name where error occurred */
 } error_t;
 
+/** @brief Capacity of the inline extra_info buffer, including the NUL. */
+#define RESULT_EXTRA_INFO_SIZE 96
+
 /**
  * @struct result_t
  * @brief Represents the result of an operation, including optional error info.
  *
- * Uses a union to minimize memory usage. For successful operations, no
- * error_t structure is allocated.
+ * Returned by value. extra_info is only filled while extra logging is
+ * enabled (see result_set_log_extra()) and is truncated to fit.
  */
 typedef struct {
-        result_code_t code; /**< Status code representing success or failure */
-
-        union {
-                struct {
-                } success; /**< Placeholder for success (no additional data) */
-
-                error_t error; /**< Error information for failures */
-        } data;
+        result_code_t code;   /**< Status code (success or failure) */
+        const error_t* error; /**< Error descriptor, NULL on success */
+        char extra_info[RESULT_EXTRA_INFO_SIZE]; /**< Optional details */
 } result_t;
 
 /**
- * @brief Create a new success result.
+ * @brief Whether result_add_extra() formats anything. Read through the macro;
+ * change it with result_set_log_extra().
+ */
+extern bool result_log_extra;
+
+/**
+ * @brief Enable or disable formatting of extra_info.
+ *
+ * Disabled by default so the hot path never pays for vsnprintf(); debug
+ * builds of the endpoints turn it on before serializing results.
  *
- * @return Pointer to a heap-allocated success result_t.
+ * @param enabled true to record extra_info.
  */
-result_t* result_new_success(void);
+void result_set_log_extra(bool enabled);
 
 /**
- * @brief Create a new failure result with contextual information.
+ * @brief Create a success result.
  *
- * @param message     Error message.
- * @param extra_info  Additional details (nullable).
- * @param error_code  Library-specific error code.
- * @param failed_file Source file where the error occurred.
- * @param failed_func Function name where the error occurred.
- * @return Pointer to a heap-allocated failure result_t.
+ * @return Success result_t.
  */
-result_t* result_new_failure(const char* message, const char* extra_info,
-                             int error_code, const char* failed_file,
-                             const char* failed_func);
+static inline result_t result_new_success(void) {
+        result_t r;
+        r.code          = RESULT_SUCCESS;
+        r.error         = NULL;
+        r.extra_info[0] = '\0';
+        return r;
+}
 
 /**
- * @brief Create a new critical failure result with contextual information.
+ * @brief Create a failure result from a static error descriptor.
  *
- * @param message     Error message.
- * @param extra_info  Additional details (nullable).
- * @param error_code  Library-specific error code.
- * @param failed_file Source file where the error occurred.
- * @param failed_func Function name where the error occurred.
- * @return Pointer to a heap-allocated critical failure result_t.
+ * @param error       Static error descriptor.
+ * @param extra_info  Additional details (nullable, recorded only while extra
+ *                    logging is enabled).
+ * @return Failure result_t.
  */
-result_t* result_new_critical_failure(const char* message,
-                                      const char* extra_info, int error_code,
-                                      const char* failed_file,
-                                      const char* failed_func);
+result_t result_new_failure(const error_t* error, const char* extra_info);
 
 /**
- * @brief Free memory associated with a result_t object.
+ * @brief Create a critical failure result from a static error descriptor.
  *
- * @param res Pointer to result_t to free (nullable).
+ * @param error       Static error descriptor.
+ * @param extra_info  Additional details (nullable, recorded only while extra
+ *                    logging is enabled).
+ * @return Critical failure result_t.
+ */
+result_t result_new_critical_failure(const error_t* error,
+                                     const char* extra_info);
+
+/**
+ * @def RESULT_ERROR_SITE
+ * @brief Emit a static error descriptor for the current call site and yield
+ * its address. @p msg must be a string literal and @p code a constant.
  */
-void result_free(result_t* res);
+#define RESULT_ERROR_SITE(msg, code)                                \
+        ({                                                          \
+                static const error_t result_site_ = {               \
+                    (code), (msg), __FILE__, __func__};             \
+                &result_site_;                                      \
+        })
 
 /**
  * @def result_success
- * @brief Convenience macro to create a success result capturing caller context.
+ * @brief Convenience macro to create a success result.
  */
 #define result_success() result_new_success()
 
@@ -114,7 +134,7 @@ void result_free(result_t* res);
  * @brief Convenience macro to create a failure result capturing caller context.
  */
 #define result_failure(msg, extra, code) \
-        result_new_failure((msg), (extra), (code), __FILE__, __func__)
+        result_new_failure(RESULT_ERROR_SITE(msg, code), (extra))
 
 /**
  * @def result_critical_failure
@@ -122,19 +142,30 @@ void result_free(result_t* res);
  * context.
  */
 #define result_critical_failure(msg, extra, code) \
-        result_new_critical_failure((msg), (extra), (code), __FILE__, __func__)
+        result_new_critical_failure(RESULT_ERROR_SITE(msg, code), (extra))
 
 /**
- * @brief Append formatted extra information to an existing result.
+ * @brief Format extra information into a result's inline buffer.
  *
  * Uses printf-style formatting. If res is NULL or not a failure, the call is
- * ignored.
+ * ignored. Prefer the result_add_extra() macro, which skips the call
+ * entirely while extra logging is disabled.
  *
  * @param res    Result object to modify.
  * @param format Format string.
  * @param ...    Variadic arguments for formatting.
  */
-void result_add_extra(result_t* res, const char* format, ...);
+void result_format_extra(result_t* res, const char* format, ...);
+
+/**
+ * @def result_add_extra
+ * @brief Lazily append formatted extra information to a result.
+ */
+#define result_add_extra(res, ...)                                  \
+        do {                                                        \
+                if (result_log_extra)                               \
+                        result_format_extra((res), __VA_ARGS__);    \
+        } while (0)
 
 /**
  * @brief Convert a result_t object into a JSON representation.
@@ -147,13 +178,22 @@ void result_add_extra(result_t* res, const char* format, ...);
  */
 struct json_object* result_to_json(const result_t* res);
 
-/** @name Common Error Codes
- *  @brief Predefined library-level error codes.
- *  @{
+/**
+ * @brief Registry entry for a result's error code.
+ *
+ * @param res Result to inspect.
+ * @return Registry entry; NULL for successes.
+ */
+const error_info_t* result_error_info(const result_t* res);
+
+/**
+ * @brief Write a failure to stderr (the web server's error log) when its
+ * registry severity warrants it.
+ *
+ * Client mistakes (ERROR_SEVERITY_INFO) are not logged.
+ *
+ * @param res Result to log (nullable).
  */
-#define ERR_MEMORY_ALLOC_FAIL 999 /**< Memory allocation failure */
-#define ERR_HEX_DECODE_FAIL 998   /**< Hex decode operation failed */
-#define ERR_TEST_FAIL 9999        /**< Generic test failure */
-/** @} */
+void result_log(const result_t* res);
 
 #endif /* RESULT_H_ */
@@ -1,10 +1,9 @@
 #include "result_test.h"
 
-result_t* test_fail(void) {
-        result_t* rc = result_failure("test failuire", NULL, ERR_TEST_FAIL);
-        if (!rc) return NULL;
+result_t test_fail(void) {
+        result_t rc = result_failure("test failuire", NULL, ERR_TEST_FAIL);
 
         int test_var = 5;
-        result_add_extra(rc, "internal variable test_var = %i", test_var);
+        result_add_extra(&rc, "internal variable test_var = %i", test_var);
         return rc;
 }
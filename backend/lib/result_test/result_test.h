@@ -2,6 +2,6 @@
 #define RESULT_TEST_H_
 #include "/app/backend/lib/result/result.h"
 
-result_t* test_fail(void);
+result_t test_fail(void);
 
 #endif// RESULT_TEST_H_
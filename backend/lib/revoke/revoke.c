@@ -0,0 +1,136 @@
+/**
+ * @file revoke.c
+ * @brief Per-user token generations in a shared sparse array.
+ *
+ * The segment is sized once to hold every entry; tmpfs allocates a page only
+ * when an entry in it is first written, and every process maps it the same
+ * way, so an unrevoked user costs nothing and a check touches one page.
+ */
+
+#include "revoke.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Segment layout version; bump on any layout change. */
+#define REVOKE_VERSION 1
+
+/** @brief Magic word ("SFV" + version) marking an initialized segment. */
+#define REVOKE_MAGIC (0x53465600u | REVOKE_VERSION)
+
+/**
+ * @struct revoke_segment_t
+ * @brief The whole shared segment.
+ */
+typedef struct {
+        _Atomic uint32_t magic;  /**< REVOKE_MAGIC once initialized */
+        _Atomic uint32_t loaded; /**< 1 once filled from SQLite */
+        /** Current generation by user id; entry 0 is unused. */
+        _Atomic uint32_t generations[REVOKE_MAX_USERS];
+} revoke_segment_t;
+
+/** @brief This process's mapping, NULL if unavailable. */
+static revoke_segment_t* segment = NULL;
+
+/** @brief Whether mapping was already attempted. */
+static bool segment_tried = false;
+
+/**
+ * @brief Map the segment on first use.
+ * @return Mapped segment, or NULL if revocation is off.
+ */
+static revoke_segment_t* segment_get(void) {
+        if (segment_tried) return segment;
+        segment_tried = true;
+
+        const char* enabled = getenv("SFE_REVOKE");
+        if (enabled && strcmp(enabled, "0") == 0) return NULL;
+
+        const char* path = getenv("SFE_REVOKE_FILE");
+        if (!path) path = REVOKE_DEFAULT_FILE;
+        if (!*path) return NULL;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return NULL;
+
+        struct stat st;
+        bool sized = false;
+        if (fstat(fd, &st) == 0) {
+                if (st.st_size == 0)
+                        sized = ftruncate(fd, sizeof(revoke_segment_t)) == 0;
+                else
+                        sized = st.st_size == sizeof(revoke_segment_t);
+        }
+        void* p = sized ? mmap(NULL, sizeof(revoke_segment_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED) return NULL;
+
+        revoke_segment_t* seg = p;
+        uint32_t magic        = 0;
+        if (!atomic_compare_exchange_strong(&seg->magic, &magic,
+                                            REVOKE_MAGIC) &&
+            magic != REVOKE_MAGIC) {
+                munmap(p, sizeof(revoke_segment_t));
+                return NULL;
+        }
+
+        segment = seg;
+        return segment;
+}
+
+/**
+ * @brief Check a token's generation against its user's current one.
+ * @param user_id User id from the token.
+ * @param generation Token generation ("gen" claim, 0 if absent).
+ * @return REVOKE_VALID, REVOKE_REVOKED, REVOKE_UNLOADED or REVOKE_OFF.
+ */
+revoke_status_t revoke_check(int64_t user_id, uint32_t generation) {
+        revoke_segment_t* seg = segment_get();
+        if (!seg) return REVOKE_OFF;
+        if (!atomic_load_explicit(&seg->loaded, memory_order_acquire))
+                return REVOKE_UNLOADED;
+        if (user_id <= 0 || user_id >= REVOKE_MAX_USERS) return REVOKE_VALID;
+
+        uint32_t current = atomic_load_explicit(
+            &seg->generations[user_id], memory_order_relaxed);
+        return generation < current ? REVOKE_REVOKED : REVOKE_VALID;
+}
+
+/**
+ * @brief Raise a user's current generation; lower values are ignored.
+ * @param user_id User id.
+ * @param generation New generation.
+ * @return false if revocation is off or the id is out of range.
+ */
+bool revoke_set(int64_t user_id, uint32_t generation) {
+        revoke_segment_t* seg = segment_get();
+        if (!seg || user_id <= 0 || user_id >= REVOKE_MAX_USERS) return false;
+
+        _Atomic uint32_t* entry = &seg->generations[user_id];
+        uint32_t current        = atomic_load(entry);
+        while (current < generation &&
+               !atomic_compare_exchange_weak_explicit(entry, &current,
+                                                      generation,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+        }
+        return true;
+}
+
+/**
+ * @brief Mark the array as filled from SQLite; revoke_check() then answers.
+ * @return false if revocation is off.
+ */
+bool revoke_mark_loaded(void) {
+        revoke_segment_t* seg = segment_get();
+        if (!seg) return false;
+        atomic_store_explicit(&seg->loaded, 1, memory_order_release);
+        return true;
+}
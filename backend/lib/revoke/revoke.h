@@ -0,0 +1,71 @@
+/**
+ * @file revoke.h
+ * @brief Cross-process JWT revocation by per-user token generation.
+ *
+ * Every user has a token generation, stored in users.token_generation and
+ * copied into each JWT as the "gen" claim. Revoking a user's sessions bumps
+ * the generation, and a token whose generation is below the current one is
+ * rejected. The current generations live in a shared-memory array indexed
+ * by user id (SFE_REVOKE_FILE, default /dev/shm/sfe_revoke), so val_jwt()
+ * checks a token with one atomic load and no SQL.
+ *
+ * The array is a sparse file: only pages holding a revoked user take memory,
+ * whatever the number of users or live tokens. maint/revoke -l fills it from
+ * SQLite at start and marks it loaded; until then revoke_check() answers
+ * REVOKE_UNLOADED, so a restart can never let a revoked token through.
+ * Ids of REVOKE_MAX_USERS and above cannot be revoked.
+ *
+ * When the segment cannot be mapped, or SFE_REVOKE=0, revocation is off and
+ * every signed token is accepted.
+ */
+
+#ifndef REVOKE_H_
+#define REVOKE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Segment path used when SFE_REVOKE_FILE is unset. */
+#define REVOKE_DEFAULT_FILE "/dev/shm/sfe_revoke"
+
+/** @brief Entries in the generation array: user ids 1 to this minus one. */
+#define REVOKE_MAX_USERS (1u << 24)
+
+/**
+ * @enum revoke_status
+ * @brief Outcome of revoke_check().
+ */
+typedef enum revoke_status {
+        REVOKE_OFF      = 0, /**< Revocation disabled; accept */
+        REVOKE_VALID    = 1, /**< Generation is current */
+        REVOKE_REVOKED  = 2, /**< Generation was revoked */
+        REVOKE_UNLOADED = 3  /**< Not loaded from SQLite yet; reject */
+} revoke_status_t;
+
+/**
+ * @brief Check a token's generation against its user's current one.
+ * @param user_id User id from the token.
+ * @param generation Token generation ("gen" claim, 0 if absent).
+ * @return REVOKE_VALID, REVOKE_REVOKED, REVOKE_UNLOADED or REVOKE_OFF.
+ */
+revoke_status_t revoke_check(int64_t user_id, uint32_t generation);
+
+/**
+ * @brief Raise a user's current generation; lower values are ignored.
+ *
+ * Call after the new generation is committed to SQLite, so a reload never
+ * goes backwards.
+ *
+ * @param user_id User id.
+ * @param generation New generation.
+ * @return false if revocation is off or the id is out of range.
+ */
+bool revoke_set(int64_t user_id, uint32_t generation);
+
+/**
+ * @brief Mark the array as filled from SQLite; revoke_check() then answers.
+ * @return false if revocation is off.
+ */
+bool revoke_mark_loaded(void);
+
+#endif// REVOKE_H_
@@ -0,0 +1,143 @@
+/**
+ * @file timing.c
+ * @brief Server-Timing rendering and binary trace output.
+ */
+
+#include "timing.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/metrics/metrics.h"
+
+_Static_assert(sizeof(timing_trace_header_t) == 40,
+               "trace header layout changed; bump TIMING_TRACE_VERSION");
+_Static_assert(sizeof(timing_trace_span_t) == 24,
+               "trace span layout changed; bump TIMING_TRACE_VERSION");
+
+/**
+ * @brief Whether an environment flag is set to something other than "0".
+ * @param name Variable name.
+ * @return true if enabled.
+ */
+static bool env_flag(const char* name) {
+        const char* v = getenv(name);
+        return v && *v && strcmp(v, "0") != 0;
+}
+
+/**
+ * @brief Start timing a request.
+ *
+ * @param t Timing state to initialize.
+ * @param endpoint Static endpoint name (truncated to 15 bytes in traces).
+ */
+void timing_init(timing_t* t, const char* endpoint) {
+        if (!t) return;
+
+        t->server_timing = env_flag("SFE_SERVER_TIMING");
+        t->trace_fd      = -1;
+        t->endpoint      = endpoint ? endpoint : "";
+        t->count         = 0;
+
+        const char* trace_path = getenv("SFE_TRACE_FILE");
+        if (trace_path && *trace_path) {
+                t->trace_fd = open(trace_path,
+                                   O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                                   0600);
+        }
+
+        t->active =
+            t->server_timing || t->trace_fd >= 0 || metrics_enabled();
+        if (!t->active) return;
+
+        struct timespec wall;
+        clock_gettime(CLOCK_REALTIME, &wall);
+        t->wall_ns  = (uint64_t)wall.tv_sec * 1000000000ull +
+                      (uint64_t)wall.tv_nsec;
+        t->start_ns = timing_now_ns();
+}
+
+/**
+ * @brief Render the Server-Timing header value.
+ *
+ * @param t Timing state.
+ * @param buf Output buffer.
+ * @param cap Capacity of @p buf.
+ * @return Length written, or 0 if the header is disabled or did not fit.
+ */
+size_t timing_format_header(const timing_t* t, char* buf, size_t cap) {
+        if (!t || !t->server_timing || !buf || cap == 0) return 0;
+
+        uint64_t total_ns = timing_now_ns() - t->start_ns;
+        size_t len        = 0;
+        for (size_t i = 0; i <= t->count; ++i) {
+                const char* name = "total";
+                uint64_t dur_ns  = total_ns;
+                if (i < t->count) {
+                        name   = t->spans[i].name;
+                        dur_ns = t->spans[i].dur_ns;
+                }
+
+                int n = snprintf(buf + len, cap - len, "%s%s;dur=%.3f",
+                                 i ? ", " : "", name, (double)dur_ns / 1e6);
+                if (n < 0 || (size_t)n >= cap - len) return 0;
+                len += (size_t)n;
+        }
+        return len;
+}
+
+/**
+ * @brief Finish the request: feed the metrics segment, append the trace
+ * record and close the file.
+ *
+ * The record is written with a single write() on an O_APPEND descriptor,
+ * so concurrent CGI processes do not interleave their records.
+ *
+ * @param t Timing state (nullable).
+ * @param status HTTP status that was sent.
+ */
+void timing_finish(timing_t* t, unsigned int status) {
+        if (!t || !t->active) return;
+        t->active = false;
+
+        uint64_t total_ns = timing_now_ns() - t->start_ns;
+        metrics_observe_request(t->endpoint, status, total_ns);
+        for (size_t i = 0; i < t->count; ++i)
+                metrics_observe_phase(t->endpoint, t->spans[i].name,
+                                      t->spans[i].dur_ns);
+
+        if (t->trace_fd < 0) return;
+
+        struct {
+                timing_trace_header_t header;
+                timing_trace_span_t spans[TIMING_MAX_SPANS];
+        } rec;
+        memset(&rec, 0, sizeof(rec));
+
+        rec.header.magic      = TIMING_TRACE_MAGIC;
+        rec.header.version    = TIMING_TRACE_VERSION;
+        rec.header.span_count = (uint16_t)t->count;
+        rec.header.wall_ns    = t->wall_ns;
+        rec.header.total_us   = (uint32_t)(total_ns / 1000);
+        rec.header.status     = (uint16_t)status;
+        strncpy(rec.header.endpoint, t->endpoint, TIMING_NAME_SIZE - 1);
+
+        for (size_t i = 0; i < t->count; ++i) {
+                const timing_span_t* s = &t->spans[i];
+                strncpy(rec.spans[i].name, s->name ? s->name : "",
+                        TIMING_NAME_SIZE - 1);
+                rec.spans[i].start_us =
+                    (uint32_t)((s->start_ns - t->start_ns) / 1000);
+                rec.spans[i].dur_us = (uint32_t)(s->dur_ns / 1000);
+        }
+
+        size_t len = sizeof(rec.header) + t->count * sizeof(rec.spans[0]);
+        ssize_t n  = write(t->trace_fd, &rec, len);
+        (void)n;
+
+        close(t->trace_fd);
+        t->trace_fd = -1;
+}
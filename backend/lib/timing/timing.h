@@ -0,0 +1,158 @@
+/**
+ * @file timing.h
+ * @brief Per-request phase timing with Server-Timing and trace-file output.
+ *
+ * A handler initializes one timing_t per request and wraps each phase in
+ * timing_begin()/timing_end(). Output is opt-in via the CGI environment:
+ *
+ *  - SFE_SERVER_TIMING=1 adds a `Server-Timing` header to the response.
+ *  - SFE_TRACE_FILE=/path appends one binary record per request to /path
+ *    (see timing_trace_header_t); tools/trace_stats aggregates it.
+ *
+ * Whenever the metrics segment is available (lib/metrics), finished
+ * requests and their phases are also recorded there. With all three off,
+ * timing_begin() is an inlined flag test that never reads the clock.
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/** @brief Most spans recorded per request; extra spans are dropped. */
+#define TIMING_MAX_SPANS 16
+
+/** @brief Fixed size of span and endpoint names in trace records. */
+#define TIMING_NAME_SIZE 16
+
+/** @brief Span handle returned when timing is off or spans ran out. */
+#define TIMING_NONE ((size_t)-1)
+
+/** @brief Trace record magic ("SFTR", little-endian). */
+#define TIMING_TRACE_MAGIC 0x52544653u
+
+/** @brief Trace record layout version. */
+#define TIMING_TRACE_VERSION 1
+
+/**
+ * @struct timing_span_t
+ * @brief One measured phase.
+ */
+typedef struct {
+        const char* name;  /**< Static phase name, e.g. "argon2" */
+        uint64_t start_ns; /**< Monotonic start time */
+        uint64_t dur_ns;   /**< Duration, 0 while still open */
+} timing_span_t;
+
+/**
+ * @struct timing_t
+ * @brief Phase timings of one request.
+ */
+typedef struct timing {
+        bool active;                           /**< Any output enabled */
+        bool server_timing;                    /**< Send Server-Timing */
+        int trace_fd;                          /**< Trace file, or -1 */
+        const char* endpoint;                  /**< Static endpoint name */
+        uint64_t start_ns;                     /**< Monotonic request start */
+        uint64_t wall_ns;                      /**< Realtime request start */
+        size_t count;                          /**< Spans used */
+        timing_span_t spans[TIMING_MAX_SPANS]; /**< Recorded spans */
+} timing_t;
+
+/**
+ * @struct timing_trace_header_t
+ * @brief Fixed-size header of a trace record, followed by span_count
+ * timing_trace_span_t entries. Fields are in host byte order.
+ */
+typedef struct {
+        uint32_t magic;                  /**< TIMING_TRACE_MAGIC */
+        uint16_t version;                /**< TIMING_TRACE_VERSION */
+        uint16_t span_count;             /**< Spans that follow */
+        uint64_t wall_ns;                /**< Request start, CLOCK_REALTIME */
+        uint32_t total_us;               /**< Whole request duration */
+        uint16_t status;                 /**< HTTP status sent */
+        uint16_t reserved;               /**< Zero */
+        char endpoint[TIMING_NAME_SIZE]; /**< NUL-padded endpoint name */
+} timing_trace_header_t;
+
+/**
+ * @struct timing_trace_span_t
+ * @brief One span in a trace record.
+ */
+typedef struct {
+        char name[TIMING_NAME_SIZE]; /**< NUL-padded phase name */
+        uint32_t start_us;           /**< Offset from request start */
+        uint32_t dur_us;             /**< Duration */
+} timing_trace_span_t;
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ * @return Current time in ns.
+ */
+static inline uint64_t timing_now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Start timing a request.
+ *
+ * Reads SFE_SERVER_TIMING and SFE_TRACE_FILE and maps the metrics
+ * segment; with all of them off the request is not timed at all.
+ *
+ * @param t Timing state to initialize.
+ * @param endpoint Static endpoint name (truncated to 15 bytes in traces).
+ */
+void timing_init(timing_t* t, const char* endpoint);
+
+/**
+ * @brief Open a span.
+ * @param t Timing state (nullable).
+ * @param name Static phase name; use a token (no spaces, commas or ';').
+ * @return Span handle for timing_end(), or TIMING_NONE.
+ */
+static inline size_t timing_begin(timing_t* t, const char* name) {
+        if (!t || !t->active || t->count == TIMING_MAX_SPANS)
+                return TIMING_NONE;
+        timing_span_t* s = &t->spans[t->count];
+        s->name          = name;
+        s->start_ns      = timing_now_ns();
+        s->dur_ns        = 0;
+        return t->count++;
+}
+
+/**
+ * @brief Close a span.
+ * @param t Timing state (nullable).
+ * @param span Handle from timing_begin().
+ */
+static inline void timing_end(timing_t* t, size_t span) {
+        if (!t || span == TIMING_NONE) return;
+        t->spans[span].dur_ns = timing_now_ns() - t->spans[span].start_ns;
+}
+
+/**
+ * @brief Render the Server-Timing header value.
+ *
+ * Produces e.g. "read;dur=0.041, argon2;dur=212.503, total;dur=214.9".
+ *
+ * @param t Timing state.
+ * @param buf Output buffer.
+ * @param cap Capacity of @p buf.
+ * @return Length written, or 0 if the header is disabled or did not fit.
+ */
+size_t timing_format_header(const timing_t* t, char* buf, size_t cap);
+
+/**
+ * @brief Finish the request: feed the metrics segment, append the trace
+ * record and close the file. Only the first call has an effect.
+ * @param t Timing state (nullable).
+ * @param status HTTP status that was sent.
+ */
+void timing_finish(timing_t* t, unsigned int status);
+
+#endif// TIMING_H_
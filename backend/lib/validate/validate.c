@@ -0,0 +1,186 @@
+/**
+ * @file validate.c
+ * @brief Character-class validators with AVX2/SSE2 kernels.
+ *
+ * The vector kernels test 32 (AVX2) or 16 (SSE2) bytes per step by
+ * building a per-lane "in class" mask out of signed range compares; bytes
+ * >= 0x80 are negative as signed chars and so fall outside every ASCII
+ * range for free. Whatever is left (and every byte on compilers without
+ * SIMD, such as tcc) goes through the scalar predicate.
+ */
+
+#include "validate.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @enum char_class
+ * @brief Character classes understood by validate_span().
+ */
+typedef enum char_class {
+        CLASS_ALNUM,    /**< [0-9A-Za-z] */
+        CLASS_HEX,      /**< [0-9A-Fa-f] */
+        CLASS_BASE64URL /**< [0-9A-Za-z_-] */
+} char_class_t;
+
+/**
+ * @brief Scalar class membership test.
+ * @param c Byte to test.
+ * @param cls Character class.
+ * @return true if @p c belongs to @p cls.
+ */
+static inline bool in_class(unsigned char c, char_class_t cls) {
+        bool digit = c >= '0' && c <= '9';
+        switch (cls) {
+                case CLASS_HEX:
+                        return digit || (c >= 'a' && c <= 'f') ||
+                               (c >= 'A' && c <= 'F');
+                case CLASS_BASE64URL:
+                        if (c == '-' || c == '_') return true;
+                        /* fall through */
+                case CLASS_ALNUM:
+                default:
+                        return digit || (c >= 'a' && c <= 'z') ||
+                               (c >= 'A' && c <= 'Z');
+        }
+}
+
+#if defined(__AVX2__)
+/**
+ * @brief Lane mask of bytes within [lo, hi] (ASCII bounds only).
+ * @param v Input vector.
+ * @param lo Lower bound (inclusive).
+ * @param hi Upper bound (inclusive).
+ * @return 0xff in every lane whose byte is in range.
+ */
+static inline __m256i range256(__m256i v, char lo, char hi) {
+        return _mm256_and_si256(
+            _mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)(lo - 1))),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(hi + 1)), v));
+}
+
+/**
+ * @brief Test whether all 32 bytes of a block belong to a class.
+ * @param p Block start (unaligned).
+ * @param cls Character class.
+ * @return true if every byte matches.
+ */
+static inline bool block_in_class(const char* p, char_class_t cls) {
+        __m256i v  = _mm256_loadu_si256((const __m256i*)p);
+        __m256i ok = range256(v, '0', '9');
+        if (cls == CLASS_HEX) {
+                ok = _mm256_or_si256(ok, range256(v, 'a', 'f'));
+                ok = _mm256_or_si256(ok, range256(v, 'A', 'F'));
+        } else {
+                ok = _mm256_or_si256(ok, range256(v, 'a', 'z'));
+                ok = _mm256_or_si256(ok, range256(v, 'A', 'Z'));
+        }
+        if (cls == CLASS_BASE64URL) {
+                ok = _mm256_or_si256(
+                    ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+                ok = _mm256_or_si256(
+                    ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        }
+        return (unsigned)_mm256_movemask_epi8(ok) == 0xffffffffu;
+}
+
+#define BLOCK_SIZE 32
+#elif defined(__SSE2__)
+/**
+ * @brief Lane mask of bytes within [lo, hi] (ASCII bounds only).
+ * @param v Input vector.
+ * @param lo Lower bound (inclusive).
+ * @param hi Upper bound (inclusive).
+ * @return 0xff in every lane whose byte is in range.
+ */
+static inline __m128i range128(__m128i v, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1))),
+                             _mm_cmpgt_epi8(_mm_set1_epi8((char)(hi + 1)), v));
+}
+
+/**
+ * @brief Test whether all 16 bytes of a block belong to a class.
+ * @param p Block start (unaligned).
+ * @param cls Character class.
+ * @return true if every byte matches.
+ */
+static inline bool block_in_class(const char* p, char_class_t cls) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)p);
+        __m128i ok = range128(v, '0', '9');
+        if (cls == CLASS_HEX) {
+                ok = _mm_or_si128(ok, range128(v, 'a', 'f'));
+                ok = _mm_or_si128(ok, range128(v, 'A', 'F'));
+        } else {
+                ok = _mm_or_si128(ok, range128(v, 'a', 'z'));
+                ok = _mm_or_si128(ok, range128(v, 'A', 'Z'));
+        }
+        if (cls == CLASS_BASE64URL) {
+                ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+                ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        }
+        return _mm_movemask_epi8(ok) == 0xffff;
+}
+
+#define BLOCK_SIZE 16
+#endif
+
+/**
+ * @brief Check that every byte of a span belongs to a class, failing fast.
+ * @param s Input bytes.
+ * @param len Number of bytes.
+ * @param cls Character class.
+ * @return true if every byte matches.
+ */
+static inline bool validate_span(const char* s, size_t len,
+                                 char_class_t cls) {
+        if (!s) return len == 0;
+
+        size_t i = 0;
+#if defined(BLOCK_SIZE)
+        for (; i + BLOCK_SIZE <= len; i += BLOCK_SIZE) {
+                if (!block_in_class(s + i, cls)) return false;
+        }
+#endif
+        for (; i < len; ++i) {
+                if (!in_class((unsigned char)s[i], cls)) return false;
+        }
+        return true;
+}
+
+/**
+ * @brief Check that a span contains only [0-9A-Za-z].
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is alphanumeric.
+ */
+bool is_alnum(const char* s, size_t len) {
+        return validate_span(s, len, CLASS_ALNUM);
+}
+
+/**
+ * @brief Check that a span contains only [0-9A-Fa-f].
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is a hex digit.
+ */
+bool is_hex(const char* s, size_t len) {
+        return validate_span(s, len, CLASS_HEX);
+}
+
+/**
+ * @brief Check that a span contains only the base64url alphabet
+ * [0-9A-Za-z_-] (no padding).
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is in the base64url alphabet.
+ */
+bool is_base64url(const char* s, size_t len) {
+        return validate_span(s, len, CLASS_BASE64URL);
+}
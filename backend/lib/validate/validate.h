@@ -0,0 +1,45 @@
+/**
+ * @file validate.h
+ * @brief Non-allocating character-class validators for untrusted input.
+ *
+ * Each validator answers "does every byte of this span belong to the class"
+ * in one pass, stopping at the first offending block. Spans are
+ * length-bounded, so an embedded NUL is simply a byte outside the class.
+ * An empty span (len == 0) is valid; callers enforce their own minimums.
+ */
+
+#ifndef VALIDATE_H_
+#define VALIDATE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Check that a span contains only [0-9A-Za-z].
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is alphanumeric.
+ */
+bool is_alnum(const char* s, size_t len);
+
+/**
+ * @brief Check that a span contains only [0-9A-Fa-f].
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is a hex digit.
+ */
+bool is_hex(const char* s, size_t len);
+
+/**
+ * @brief Check that a span contains only the base64url alphabet
+ * [0-9A-Za-z_-] (no padding).
+ *
+ * @param s   Input bytes (may be NULL only if @p len is 0).
+ * @param len Number of bytes to check.
+ * @return true if every byte is in the base64url alphabet.
+ */
+bool is_base64url(const char* s, size_t len);
+
+#endif// VALIDATE_H_
@@ -0,0 +1,300 @@
+/**
+ * @file login.c
+ * @brief CGI endpoint for logging in; answers with a JWT.
+ *
+ * Every failure looks the same from outside (401, one message) and costs the
+ * same Argon2 verification: an unknown username is one index probe plus a
+ * verify against a dummy hash of the default profile. Repeated failures are
+ * counted per client address and per account in lib/ratelimit and turned
+ * away with 429 before Argon2 or the admission queue is reached.
+ */
+
+#include <ctype.h>
+#include <json-c/json.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/admission/admission.h"
+#include "lib/arena/arena.h"
+#include "lib/csrf/csrf.h"
+#include "lib/dal/db/db.h"
+#include "lib/dal/user/user.h"
+#include "lib/deadline/deadline.h"
+#include "lib/hash_password/hash_password.h"
+#include "lib/jwt/jwt.h"
+#include "lib/models/user_model/user_model.h"
+#include "lib/ratelimit/ratelimit.h"
+#include "lib/read_post_data/read_post_data.h"
+#include "lib/response/response.h"
+#include "lib/result/result.h"
+#include "lib/timing/timing.h"
+#include "lib/validate/validate.h"
+
+#define DB_PATH "/data/sfe.db"
+#define DEBUG 0
+
+/** @brief Size of the stack block backing the request arena. */
+#define REQUEST_ARENA_SIZE 16384
+
+/** @brief Longest username register.cgi accepts. */
+#define USERNAME_MAX_LENGTH 12
+
+/** @brief Time budget of a login, from arrival to response. */
+#define LOGIN_DEADLINE_MS 5000
+
+/** @brief Time left that is needed to start the Argon2 verification. */
+#define LOGIN_HASH_MIN_MS 1000
+
+/** @brief The only message a failed login gets. */
+#define LOGIN_FAILED "Invalid username or password."
+
+/** @brief Login attempts per client address, successful or not. */
+static const ratelimit_rule_t login_limit = {
+    .endpoint = "login", .per_minute = 30, .burst = 20};
+
+/** @brief Failed logins per client address. */
+static const ratelimit_rule_t login_ip_failures = {
+    .endpoint = "login_fail_ip", .per_minute = 20, .burst = 10};
+
+/** @brief Failed logins per account, from any address. */
+static const ratelimit_rule_t login_account_failures = {
+    .endpoint = "login_fail_user", .per_minute = 5, .burst = 10};
+
+static void free_memory(sqlite3* db, struct json_object* jobj, char* token,
+                        arena_t* arena) {
+        db_close(db);
+        if (jobj) json_object_put(jobj);
+        free(token);
+        arena_destroy(arena);
+}
+
+/**
+ * @brief Account key for the failure buckets: the username in lower case,
+ * as usernames compare without case.
+ * @param username Username as sent.
+ * @param out Receives the key; empty if the name cannot be registered.
+ * @return true if the name could exist (alphanumeric, not too long).
+ */
+static bool account_key(const char* username,
+                        char out[USERNAME_MAX_LENGTH + 1]) {
+        out[0]     = '\0';
+        size_t len = strnlen(username, USERNAME_MAX_LENGTH + 1);
+        if (len == 0 || len > USERNAME_MAX_LENGTH || !is_alnum(username, len))
+                return false;
+        for (size_t i = 0; i < len; ++i)
+                out[i] = (char)tolower((unsigned char)username[i]);
+        out[len] = '\0';
+        return true;
+}
+
+/**
+ * @brief Count a failed login against the address and the account, and
+ * send the 401.
+ * @param resp Response to send.
+ * @param client Client address (nullable).
+ * @param account Account key, empty for names that cannot exist.
+ */
+static void login_fail(response_t* resp, const char* client,
+                       const char* account) {
+        ratelimit_charge(&login_ip_failures, client);
+        if (*account) ratelimit_charge(&login_account_failures, account);
+        response_init(resp, 401);
+        response_append_str(resp, LOGIN_FAILED);
+        response_send(resp);
+}
+
+int main(void) {
+        timing_t timing;
+        timing_init(&timing, "login");
+
+        deadline_t deadline;
+        deadline_init(&deadline, LOGIN_DEADLINE_MS);
+
+        const char* method = getenv("REQUEST_METHOD");
+        const char* client = getenv("REMOTE_ADDR");
+
+        char *body = NULL, *token = NULL;
+        struct json_object* jobj = NULL;
+        user_t* user             = NULL;
+        sqlite3* db              = NULL;
+
+        unsigned char arena_buf[REQUEST_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, arena_buf, sizeof(arena_buf));
+
+        response_t resp;
+        response_init_arena(&resp, &arena, 200);
+        response_set_timing(&resp, &timing);
+
+        if (!method || strcmp(method, "POST") != 0) {
+                response_init(&resp, 405);
+                response_append_str(&resp, "Method Not Allowed");
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        uint32_t retry_after = 0;
+        if (!ratelimit_allow(&login_limit, client, &retry_after)) {
+                ratelimit_send_429(&timing, retry_after);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        size_t span  = timing_begin(&timing, "read");
+        result_t res = read_post_data(&body, &arena);
+        timing_end(&timing, span);
+        if (res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        span = timing_begin(&timing, "parse");
+        jobj = json_tokener_parse(body);
+        timing_end(&timing, span);
+        if (!jobj) {
+                response_init(&resp, 400);
+                response_append_str(&resp, "Malformed JSON");
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        struct json_object *j_csrf = NULL, *j_username = NULL,
+                           *j_password = NULL;
+        if (!json_object_object_get_ex(jobj, "csrf", &j_csrf) ||
+            !json_object_object_get_ex(jobj, "username", &j_username) ||
+            !json_object_object_get_ex(jobj, "password", &j_password)) {
+                response_init(&resp, 400);
+                response_append_str(
+                    &resp, "Missing csrf, username, or password field.");
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        const char* csrf_token_raw = json_object_get_string(j_csrf);
+        const char* username       = json_object_get_string(j_username);
+        const char* password       = json_object_get_string(j_password);
+
+        if (!csrf_token_raw || !username || !password) {
+                response_init(&resp, 400);
+                response_append_str(
+                    &resp, "Missing or invalid csrf, username, or password.");
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        span              = timing_begin(&timing, "csrf");
+        result_t csrf_res = csrf_validate_token(csrf_token_raw);
+        timing_end(&timing, span);
+        if (csrf_res.code != RESULT_SUCCESS) {
+                response_init(&resp, 400);
+                response_append_str(&resp, "Invalid CSRF token");
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        /* Throttled clients and accounts stop here, before queueing for an
+         * expensive slot. */
+        char account[USERNAME_MAX_LENGTH + 1];
+        bool plausible = account_key(username, account);
+        if (!ratelimit_peek(&login_ip_failures, client, &retry_after) ||
+            (plausible && !ratelimit_peek(&login_account_failures, account,
+                                          &retry_after))) {
+                ratelimit_send_429(&timing, retry_after);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        /* No account can have this name: nothing to look up or to hide. */
+        if (!plausible) {
+                login_fail(&resp, client, account);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        span          = timing_begin(&timing, "queue");
+        bool admitted = admission_enter(ADMISSION_EXPENSIVE, &retry_after);
+        timing_end(&timing, span);
+        if (!admitted) {
+                admission_send_503(&timing, retry_after);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        span            = timing_begin(&timing, "db_open");
+        result_t db_res = db_open(DB_PATH, &db);
+        timing_end(&timing, span);
+        if (db_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &db_res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+        db_set_deadline(db, &deadline);
+
+        span              = timing_begin(&timing, "fetch");
+        result_t user_res = user_fetch_by_username(db, username, &user, &arena);
+        timing_end(&timing, span);
+        if (user_res.code != RESULT_SUCCESS &&
+            !(user_res.error && user_res.error->code == ERR_USER_NOT_FOUND)) {
+                response_from_result(&resp, &user_res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        result_t deadline_res = deadline_check(&deadline, LOGIN_HASH_MIN_MS);
+        if (deadline_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &deadline_res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        span = timing_begin(&timing, "argon2");
+        result_t verify_res =
+            user && user->password_hash
+                ? verify_password(password, user->password_hash)
+                : verify_password_dummy(password);
+        timing_end(&timing, span);
+        if (verify_res.code != RESULT_SUCCESS && verify_res.error &&
+            verify_res.error->code == ERR_HASH_MISMATCH) {
+                login_fail(&resp, client, account);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+        if (verify_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &verify_res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        char id[24];
+        snprintf(id, sizeof(id), "%d", user->id);
+        span             = timing_begin(&timing, "jwt");
+        result_t jwt_res = issue_jwt(id, user->token_generation, &token);
+        timing_end(&timing, span);
+        if (jwt_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &jwt_res);
+                response_send(&resp);
+                free_memory(db, jobj, token, &arena);
+                return 0;
+        }
+
+        response_init(&resp, 200);
+        response_append_str(&resp, token);
+
+        response_send(&resp);
+        free_memory(db, jobj, token, &arena);
+        return 0;
+}
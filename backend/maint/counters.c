@@ -0,0 +1,78 @@
+/**
+ * @file counters.c
+ * @brief Verify and repair the materialized thread and post counters.
+ *
+ * Requests read counters (threads.post_count, user_stats, forum_stats)
+ * instead of running COUNT(*); triggers keep them exact. This program
+ * recomputes every counter from the rows and reports drift, e.g. after a
+ * manual edit with the triggers dropped or a restore of a partial backup.
+ * It reads all threads and posts in one transaction, so run it off-peak.
+ *
+ * One JSON line per counter, e.g.
+ *   {"counter":"thread_posts","checked":1000,"drifted":1,"repaired":false,
+ *    "sample":{"id":7,"stored":41,"actual":42}}
+ *
+ * Exit status: 0 no drift (or repaired), 1 error, 3 drift found.
+ *
+ * Usage:
+ *   counters [-d db] [-r]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/dal/stats/stats.h"
+#include "/app/backend/lib/result/result.h"
+
+#define DB_PATH "/data/sfe.db"
+
+/** @brief Exit status when drift was found and not repaired. */
+#define EXIT_DRIFT 3
+
+int main(int argc, char** argv) {
+        const char* db_path = DB_PATH;
+        bool repair         = false;
+
+        int opt;
+        while ((opt = getopt(argc, argv, "d:rh")) != -1) {
+                switch (opt) {
+                        case 'd': db_path = optarg; break;
+                        case 'r': repair = true; break;
+                        default:
+                                fprintf(stderr, "usage: %s [-d db] [-r]\n",
+                                        argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+
+        sqlite3* db = NULL;
+        stats_drift_t drift[STATS_COUNTER_COUNT];
+        result_t res = db_open(db_path, &db);
+        if (res.code == RESULT_SUCCESS) res = stats_check(db, repair, drift);
+        db_close(db);
+        if (res.code != RESULT_SUCCESS) {
+                result_log(&res);
+                return 1;
+        }
+
+        bool drifted = false;
+        for (int i = 0; i < STATS_COUNTER_COUNT; ++i) {
+                const stats_drift_t* d = &drift[i];
+                printf("{\"counter\":\"%s\",\"checked\":%lld,\"drifted\":%lld,"
+                       "\"repaired\":%s",
+                       d->counter, (long long)d->checked,
+                       (long long)d->drifted,
+                       repair && d->drifted ? "true" : "false");
+                if (d->drifted)
+                        printf(",\"sample\":{\"id\":%lld,\"stored\":%lld,"
+                               "\"actual\":%lld}",
+                               (long long)d->sample_id,
+                               (long long)d->sample_stored,
+                               (long long)d->sample_actual);
+                printf("}\n");
+                drifted = drifted || d->drifted > 0;
+        }
+        return drifted && !repair ? EXIT_DRIFT : 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file fts_maint.c
+ * @brief Background upkeep of the posts_fts search index.
+ *
+ * Writers never merge the index (automerge is 0, see sqlite_entrypoint.sh),
+ * so each post insert only adds a small segment. This program does the
+ * merging instead, off the request path:
+ *
+ *  - merge: bounded 'merge' steps, each its own short write transaction,
+ *    with a pause between steps so writers get the lock in between; stops
+ *    when nothing is left to merge or the time budget is spent.
+ *  - optimize: rewrite the whole index as one segment. Costly, so watch
+ *    mode only runs it once a day in the quiet hour.
+ *  - rebuild: recreate the index from posts.
+ *
+ * Each run prints one JSON line, e.g.
+ *   {"op":"merge","steps":3,"done":true,"ms":41.2,"ok":true}
+ *
+ * Usage:
+ *   fts_maint [-d db] [-p pages] [-t seconds] [-s ms] [-o | -r]
+ *   fts_maint -w interval [-H hour] [-d db] [-p pages] [-t seconds] [-s ms]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/dal/search/search.h"
+#include "/app/backend/lib/result/result.h"
+#include "/app/backend/lib/timing/timing.h"
+
+#define DB_PATH "/data/sfe.db"
+
+/**
+ * @struct maint_opts_t
+ * @brief Command-line settings.
+ */
+typedef struct {
+        const char* db_path; /**< Database file */
+        int pages;           /**< Merge work per step, in index pages */
+        int budget_s;        /**< Time budget of one merge run */
+        int pause_ms;        /**< Pause between merge steps */
+        int interval_s;      /**< Watch mode period, 0 for a single run */
+        int optimize_hour;   /**< Local hour for the daily optimize, -1 off */
+        char op;             /**< 'm'erge, 'o'ptimize or 'r'ebuild */
+} maint_opts_t;
+
+/**
+ * @brief Run one maintenance operation and print its JSON line.
+ * @param o Settings.
+ * @param op 'm', 'o' or 'r'.
+ * @return true on success.
+ */
+static bool run_once(const maint_opts_t* o, char op) {
+        uint64_t start = timing_now_ns();
+        int steps      = 0;
+        bool done      = true;
+
+        sqlite3* db  = NULL;
+        result_t res = db_open(o->db_path, &db);
+        if (res.code == RESULT_SUCCESS) {
+                if (op == 'o') {
+                        res = search_optimize(db);
+                } else if (op == 'r') {
+                        res = search_rebuild(db);
+                } else {
+                        uint64_t stop =
+                            start + (uint64_t)o->budget_s * 1000000000ull;
+                        do {
+                                if (steps > 0)
+                                        usleep((useconds_t)o->pause_ms * 1000);
+                                res = search_merge(db, o->pages, &done);
+                                ++steps;
+                        } while (res.code == RESULT_SUCCESS && !done &&
+                                 timing_now_ns() < stop);
+                }
+        }
+        db_close(db);
+
+        bool ok = res.code == RESULT_SUCCESS;
+        if (!ok) result_log(&res);
+
+        printf("{\"op\":\"%s\",\"steps\":%d,\"done\":%s,\"ms\":%.1f,"
+               "\"ok\":%s}\n",
+               op == 'o' ? "optimize" : op == 'r' ? "rebuild" : "merge", steps,
+               done ? "true" : "false",
+               (double)(timing_now_ns() - start) / 1e6, ok ? "true" : "false");
+        fflush(stdout);
+        return ok;
+}
+
+/**
+ * @brief Merge every interval; optimize once a day in the quiet hour.
+ * @param o Settings.
+ */
+static void watch(const maint_opts_t* o) {
+        int optimized_day = -1;
+        for (;;) {
+                time_t now = time(NULL);
+                struct tm tm;
+                localtime_r(&now, &tm);
+
+                if (tm.tm_hour == o->optimize_hour &&
+                    tm.tm_yday != optimized_day) {
+                        if (run_once(o, 'o')) optimized_day = tm.tm_yday;
+                } else {
+                        run_once(o, 'm');
+                }
+                sleep((unsigned)o->interval_s);
+        }
+}
+
+int main(int argc, char** argv) {
+        maint_opts_t o = {
+            .db_path       = DB_PATH,
+            .pages         = 256,
+            .budget_s      = 10,
+            .pause_ms      = 50,
+            .interval_s    = 0,
+            .optimize_hour = 4,
+            .op            = 'm',
+        };
+
+        int opt;
+        while ((opt = getopt(argc, argv, "d:p:t:s:w:H:orh")) != -1) {
+                switch (opt) {
+                        case 'd': o.db_path = optarg; break;
+                        case 'p': o.pages = atoi(optarg); break;
+                        case 't': o.budget_s = atoi(optarg); break;
+                        case 's': o.pause_ms = atoi(optarg); break;
+                        case 'w': o.interval_s = atoi(optarg); break;
+                        case 'H': o.optimize_hour = atoi(optarg); break;
+                        case 'o':
+                        case 'r': o.op = (char)opt; break;
+                        default:
+                                fprintf(stderr,
+                                        "usage: %s [-d db] [-p pages] "
+                                        "[-t seconds] [-s ms] [-o | -r]\n"
+                                        "       %s -w interval [-H hour] "
+                                        "[-d db] [-p pages] [-t seconds] "
+                                        "[-s ms]\n",
+                                        argv[0], argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+        if (o.pages <= 0) o.pages = 256;
+        if (o.budget_s <= 0) o.budget_s = 10;
+        if (o.pause_ms < 0) o.pause_ms = 0;
+
+        if (o.interval_s > 0) {
+                watch(&o);
+                return 0;
+        }
+        return run_once(&o, o.op) ? 0 : 1;
+}
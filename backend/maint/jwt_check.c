@@ -0,0 +1,42 @@
+/**
+ * @file jwt_check.c
+ * @brief Check one JWT the way an endpoint would, with val_jwt().
+ *
+ * Reads the token from the first line of stdin (not argv, so it stays out
+ * of the process list), validates its signature, expiry and revocation, and
+ * prints one JSON line with the HTTP status an endpoint would answer and,
+ * for a valid token, its claims, e.g.
+ *   {"status":200,"claims":{"id":"42","gen":1,"iat":1760000000,...}}
+ *   {"status":401,"claims":null}
+ *
+ * Exits 0 for a valid token and 1 otherwise. tests/revoke drives it.
+ *
+ * Usage:
+ *   jwt_check < token
+ */
+
+#include <json-c/json.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "/app/backend/lib/jwt/jwt.h"
+#include "/app/backend/lib/result/result.h"
+
+int main(void) {
+        char token[JWT_MAX_LENGTH + 2];
+        if (!fgets(token, sizeof(token), stdin)) token[0] = '\0';
+        token[strcspn(token, "\r\n")] = '\0';
+
+        struct json_object* claims = NULL;
+        result_t res               = val_jwt(token, &claims);
+        int status =
+            res.code == RESULT_SUCCESS ? 200
+                                       : result_error_info(&res)->http_status;
+
+        printf("{\"status\":%d,\"claims\":%s}\n", status,
+               claims ? json_object_to_json_string_ext(claims,
+                                                       JSON_C_TO_STRING_PLAIN)
+                      : "null");
+        if (claims) json_object_put(claims);
+        return res.code == RESULT_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,777 @@
+/**
+ * @file livefeed.c
+ * @brief Server-Sent Events feed of new posts, one stream per thread.
+ *
+ * A CGI process per connection cannot hold thousands of clients that mostly
+ * wait, so the feed is this single event-loop process instead. lighttpd
+ * proxies GET /api/live?thread=<id> to it (web/lighttpd.conf); each
+ * connection then costs a client_t and a socket, and nothing runs for it
+ * until something is sent.
+ *
+ * post_insert() wakes it with a datagram on a Unix socket (lib/livefeed)
+ * after each commit. It then reads every post after the last one it has
+ * seen, in id order, so a dropped wakeup loses nothing. A post whose thread
+ * has subscribers is serialized once into a reference-counted event, and
+ * that same buffer is written to every subscriber of the thread. A subscriber
+ * whose socket is full keeps references to the events it still owes;
+ * one that falls LIVE_QUEUE events behind is disconnected and reconnects
+ * (EventSource does so by itself after the advertised retry delay).
+ *
+ * Events look like
+ *   id: 42
+ *   event: post
+ *   data: {"id":42,"thread_id":7,"parent_id":0,"user_id":3,
+ *          "created_at":1700000000,"depth":0,"body_html":"<p>Hi</p>"}
+ * (data is one line), and a comment line every heartbeat period keeps
+ * proxies from timing the stream out and finds dead peers. Posts written
+ * while a client is disconnected are not replayed.
+ *
+ * On SIGTERM or SIGINT it prints one JSON line and exits, e.g.
+ *   {"op":"livefeed","events":120,"sent":5400,"slow":2,"peak_clients":950,
+ *    "ok":true}
+ *
+ * Usage:
+ *   livefeed [-d db] [-p port] [-s socket] [-c max_clients] [-k seconds]
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <json-c/json.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/dal/post/post.h"
+#include "/app/backend/lib/livefeed/livefeed.h"
+#include "/app/backend/lib/read_get_data/read_get_data.h"
+#include "/app/backend/lib/result/result.h"
+
+#define DB_PATH "/data/sfe.db"
+
+/** @brief Loopback port lighttpd proxies to. */
+#define LIVE_DEFAULT_PORT 8081
+
+/** @brief Connections served at once unless -c says otherwise. */
+#define LIVE_DEFAULT_CLIENTS 10000
+
+/** @brief Seconds between heartbeat comments unless -k says otherwise. */
+#define LIVE_DEFAULT_HEARTBEAT_S 15
+
+/** @brief Longest request head, in bytes. */
+#define LIVE_HEAD_MAX 8192
+
+/** @brief Seconds a client may take to send its request head. */
+#define LIVE_HEAD_TIMEOUT_S 10
+
+/** @brief Events a subscriber may owe before it is disconnected. */
+#define LIVE_QUEUE 32
+
+/** @brief Subscriber hash chains (power of two), keyed by thread. */
+#define LIVE_BUCKETS 4096
+
+/** @brief Wakeup datagrams drained per catch-up. */
+#define LIVE_WAKEUP_BATCH 64
+
+/** @brief Milliseconds EventSource waits before reconnecting. */
+#define LIVE_RETRY_MS 3000
+
+/**
+ * @struct event_t
+ * @brief Bytes written to one or more clients, freed with the last ref.
+ */
+typedef struct {
+        uint32_t refs; /**< Owners: the creator and every queue holding it */
+        size_t len;    /**< Bytes in data */
+        char data[];   /**< Wire bytes */
+} event_t;
+
+/**
+ * @struct client_t
+ * @brief One connection, from accept() to close.
+ */
+typedef struct client {
+        int fd;                     /**< Socket */
+        bool streaming;             /**< Head parsed, subscribed */
+        bool closed;                /**< Waiting to be freed */
+        bool close_after;           /**< Close once the queue drains */
+        bool read_eof;              /**< Peer shut down its sending side */
+        uint32_t epoll_mask;        /**< Events currently registered */
+        int64_t thread_id;          /**< Subscribed thread */
+        time_t since;               /**< Accept time */
+        char* head;                 /**< Request head while reading it */
+        size_t head_len;            /**< Bytes in head */
+        event_t* queue[LIVE_QUEUE]; /**< Events not fully written, in order */
+        size_t queue_first;         /**< Index of the oldest queued event */
+        size_t queue_len;           /**< Queued events */
+        size_t offset;              /**< Bytes of the oldest already written */
+        struct client* prev;        /**< All-clients list */
+        struct client* next;        /**< All-clients list */
+        struct client* sub_prev;    /**< Subscribers of the same bucket */
+        struct client* sub_next;    /**< Subscribers of the same bucket */
+} client_t;
+
+/**
+ * @struct live_t
+ * @brief Daemon state.
+ */
+typedef struct {
+        int epoll_fd;                    /**< Event loop */
+        int listen_fd;                   /**< HTTP listener */
+        int notify_fd;                   /**< Datagram socket for wakeups */
+        sqlite3* db;                     /**< Read connection */
+        size_t max_clients;              /**< Connection limit */
+        client_t* clients;               /**< Every open connection */
+        client_t* graveyard;             /**< Closed, freed after the batch */
+        client_t* buckets[LIVE_BUCKETS]; /**< Subscribers by thread hash */
+        size_t client_count;             /**< Open connections */
+        size_t subscribers;              /**< Connections streaming */
+        int last_id;                     /**< Newest post already handled */
+        event_t* hello;                  /**< Stream response head, shared */
+        uint64_t events;                 /**< Posts broadcast */
+        uint64_t sent;                   /**< Events queued to clients */
+        uint64_t slow;                   /**< Clients dropped for lagging */
+        size_t peak_clients;             /**< Most connections at once */
+} live_t;
+
+/** @brief epoll tag of the listener (clients are tagged by pointer). */
+static char listen_tag;
+
+/** @brief epoll tag of the wakeup socket. */
+static char notify_tag;
+
+/** @brief Set by SIGTERM / SIGINT. */
+static volatile sig_atomic_t stopping = 0;
+
+static void on_signal(int sig) {
+        (void)sig;
+        stopping = 1;
+}
+
+/**
+ * @brief Allocate an event holding @p len bytes, with one reference.
+ * @return Event, or NULL when out of memory.
+ */
+static event_t* event_new(const char* data, size_t len) {
+        event_t* ev = malloc(sizeof(event_t) + len);
+        if (!ev) return NULL;
+        ev->refs = 1;
+        ev->len  = len;
+        memcpy(ev->data, data, len);
+        return ev;
+}
+
+static void event_unref(event_t* ev) {
+        if (ev && --ev->refs == 0) free(ev);
+}
+
+/**
+ * @brief Bucket of a thread's subscribers.
+ */
+static client_t** bucket_of(live_t* live, int64_t thread_id) {
+        uint64_t h = (uint64_t)thread_id * 0x9e3779b97f4a7c15ull;
+        return &live->buckets[(h >> 32) & (LIVE_BUCKETS - 1)];
+}
+
+/**
+ * @brief Register the events @p c needs: input until EOF, output while
+ * events are queued.
+ */
+static void client_watch(live_t* live, client_t* c) {
+        uint32_t mask = 0;
+        if (!c->read_eof) mask |= EPOLLIN;
+        if (c->queue_len) mask |= EPOLLOUT;
+        if (mask == c->epoll_mask) return;
+
+        struct epoll_event ev = {.events = mask, .data.ptr = c};
+        epoll_ctl(live->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->epoll_mask = mask;
+}
+
+/**
+ * @brief Close a connection; it is freed after the current batch, since
+ * later epoll entries of the batch may still point at it.
+ */
+static void client_close(live_t* live, client_t* c) {
+        if (c->closed) return;
+        c->closed = true;
+        close(c->fd);
+
+        if (c->prev) c->prev->next = c->next;
+        else live->clients = c->next;
+        if (c->next) c->next->prev = c->prev;
+
+        if (c->streaming) {
+                --live->subscribers;
+                if (c->sub_prev) c->sub_prev->sub_next = c->sub_next;
+                else *bucket_of(live, c->thread_id) = c->sub_next;
+                if (c->sub_next) c->sub_next->sub_prev = c->sub_prev;
+        }
+
+        for (size_t i = 0; i < c->queue_len; ++i)
+                event_unref(c->queue[(c->queue_first + i) % LIVE_QUEUE]);
+        c->queue_len = 0;
+        free(c->head);
+        c->head = NULL;
+
+        --live->client_count;
+        c->next         = live->graveyard;
+        live->graveyard = c;
+}
+
+/**
+ * @brief Write queued events until the queue is empty or the socket full.
+ */
+static void client_flush(live_t* live, client_t* c) {
+        while (c->queue_len) {
+                event_t* ev = c->queue[c->queue_first];
+                ssize_t n   = send(c->fd, ev->data + c->offset,
+                                   ev->len - c->offset,
+                                   MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (n < 0) {
+                        if (errno == EINTR) continue;
+                        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                        client_close(live, c);
+                        return;
+                }
+                c->offset += (size_t)n;
+                if (c->offset < ev->len) continue;
+
+                event_unref(ev);
+                c->queue_first = (c->queue_first + 1) % LIVE_QUEUE;
+                --c->queue_len;
+                c->offset = 0;
+        }
+
+        if (!c->queue_len && c->close_after) {
+                /* Unread request bytes (a POST body) would make close()
+                 * reset the connection, maybe before the reply is read. */
+                char scratch[512];
+                shutdown(c->fd, SHUT_WR);
+                while (recv(c->fd, scratch, sizeof(scratch), MSG_DONTWAIT) > 0)
+                        ;
+                client_close(live, c);
+                return;
+        }
+        client_watch(live, c);
+}
+
+/**
+ * @brief Queue @p ev for @p c and try to write it right away.
+ *
+ * A client with LIVE_QUEUE events outstanding is disconnected instead.
+ */
+static void client_push(live_t* live, client_t* c, event_t* ev) {
+        if (c->closed) return;
+        if (c->queue_len == LIVE_QUEUE) {
+                ++live->slow;
+                client_close(live, c);
+                return;
+        }
+        ++ev->refs;
+        c->queue[(c->queue_first + c->queue_len) % LIVE_QUEUE] = ev;
+        ++c->queue_len;
+        ++live->sent;
+        if (c->queue_len == 1) client_flush(live, c);
+}
+
+/**
+ * @brief Answer with a JSON error in the API's usual shape, then close.
+ */
+static void client_reply(live_t* live, client_t* c, unsigned int status,
+                         const char* reason, const char* message) {
+        char body[256];
+        int body_len = snprintf(body, sizeof(body),
+                                "{\"status\":%u,\"messages\":[\"%s\"]}\n",
+                                status, message);
+        char buf[512];
+        int n = snprintf(buf, sizeof(buf),
+                         "HTTP/1.0 %u %s\r\n"
+                         "Content-Type: application/json\r\n"
+                         "Content-Length: %d\r\n"
+                         "Connection: close\r\n"
+                         "\r\n%s",
+                         status, reason, body_len, body);
+
+        event_t* ev = event_new(buf, (size_t)n);
+        if (!ev) {
+                client_close(live, c);
+                return;
+        }
+        c->close_after = true;
+        client_push(live, c, ev);
+        event_unref(ev);
+}
+
+/**
+ * @brief Parse a complete request head and subscribe the client.
+ */
+static void client_start(live_t* live, client_t* c) {
+        /* "GET /api/live?thread=7 HTTP/1.1" */
+        char* line_end = strstr(c->head, "\r\n");
+        *line_end      = '\0';
+        char* target   = strchr(c->head, ' ');
+        char* version  = target ? strchr(target + 1, ' ') : NULL;
+        if (!target || !version) {
+                client_reply(live, c, 400, "Bad Request", "Bad request.");
+                return;
+        }
+        *target++ = '\0';
+        *version  = '\0';
+
+        if (strcmp(c->head, "GET") != 0) {
+                client_reply(live, c, 405, "Method Not Allowed",
+                             "Method Not Allowed");
+                return;
+        }
+
+        char* query = strchr(target, '?');
+        if (query) *query++ = '\0';
+        if (strcmp(target, "/api/live") != 0) {
+                client_reply(live, c, 404, "Not Found", "Not found.");
+                return;
+        }
+
+        char buf[16];
+        char* end    = NULL;
+        result_t res = read_get_param(query, "thread", buf, sizeof(buf));
+        long thread  = res.code == RESULT_SUCCESS ? strtol(buf, &end, 10) : 0;
+        if (res.code != RESULT_SUCCESS || end == buf || *end || thread < 1 ||
+            thread > INT32_MAX) {
+                client_reply(live, c, 400, "Bad Request", "Invalid thread.");
+                return;
+        }
+
+        free(c->head);
+        c->head      = NULL;
+        c->streaming = true;
+        c->thread_id = thread;
+        ++live->subscribers;
+
+        client_t** bucket = bucket_of(live, thread);
+        c->sub_next       = *bucket;
+        if (*bucket) (*bucket)->sub_prev = c;
+        *bucket = c;
+
+        client_push(live, c, live->hello);
+}
+
+/**
+ * @brief Read from a client: its request head, or anything it sends once
+ * streaming (ignored; only EOF matters).
+ */
+static void client_read(live_t* live, client_t* c) {
+        for (;;) {
+                char scratch[512];
+                char* dst  = scratch;
+                size_t cap = sizeof(scratch);
+                if (!c->streaming) {
+                        dst = c->head + c->head_len;
+                        cap = LIVE_HEAD_MAX - c->head_len;
+                }
+
+                ssize_t n = recv(c->fd, dst, cap, 0);
+                if (n < 0) {
+                        if (errno == EINTR) continue;
+                        if (errno != EAGAIN && errno != EWOULDBLOCK)
+                                client_close(live, c);
+                        return;
+                }
+                if (n == 0) {
+                        /* A proxy may shut down its side after sending the
+                         * request; the stream goes on until a write fails. */
+                        if (!c->streaming) {
+                                client_close(live, c);
+                                return;
+                        }
+                        c->read_eof = true;
+                        client_watch(live, c);
+                        return;
+                }
+                if (c->streaming) continue;
+
+                c->head_len += (size_t)n;
+                c->head[c->head_len] = '\0';
+                if (strstr(c->head, "\r\n\r\n")) {
+                        client_start(live, c);
+                        return;
+                }
+                if (c->head_len == LIVE_HEAD_MAX) {
+                        client_reply(live, c, 431,
+                                     "Request Header Fields Too Large",
+                                     "Request too large.");
+                        return;
+                }
+        }
+}
+
+/**
+ * @brief Accept every pending connection.
+ */
+static void accept_clients(live_t* live) {
+        for (;;) {
+                int fd = accept(live->listen_fd, NULL, NULL);
+                if (fd < 0) {
+                        if (errno == EINTR) continue;
+                        if (errno != EAGAIN && errno != EWOULDBLOCK)
+                                perror("livefeed: accept");
+                        return;
+                }
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+
+                client_t* c = calloc(1, sizeof(client_t));
+                char* head  = c ? malloc(LIVE_HEAD_MAX + 1) : NULL;
+                if (!c || !head) {
+                        free(c);
+                        close(fd);
+                        continue;
+                }
+                c->fd    = fd;
+                c->head  = head;
+                c->since = time(NULL);
+
+                struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+                if (epoll_ctl(live->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                        free(head);
+                        free(c);
+                        close(fd);
+                        continue;
+                }
+                c->epoll_mask = EPOLLIN;
+
+                c->next = live->clients;
+                if (live->clients) live->clients->prev = c;
+                live->clients = c;
+                ++live->client_count;
+                if (live->client_count > live->peak_clients)
+                        live->peak_clients = live->client_count;
+
+                if (live->client_count > live->max_clients)
+                        client_reply(live, c, 503, "Service Unavailable",
+                                     "Too many live connections.");
+        }
+}
+
+/**
+ * @brief Whether any client is subscribed to a thread.
+ */
+static bool has_subscribers(live_t* live, int64_t thread_id) {
+        for (client_t* c = *bucket_of(live, thread_id); c; c = c->sub_next)
+                if (c->thread_id == thread_id) return true;
+        return false;
+}
+
+/**
+ * @brief Serialize a post as one SSE event.
+ * @return Event with one reference, or NULL when out of memory.
+ */
+static event_t* post_event(const post_t* post) {
+        struct json_object* jobj = json_object_new_object();
+        if (!jobj) return NULL;
+        json_object_object_add(jobj, "id", json_object_new_int(post->id));
+        json_object_object_add(jobj, "thread_id",
+                               json_object_new_int(post->thread_id));
+        json_object_object_add(jobj, "parent_id",
+                               json_object_new_int(post->parent_id));
+        json_object_object_add(jobj, "user_id",
+                               json_object_new_int(post->user_id));
+        json_object_object_add(jobj, "created_at",
+                               json_object_new_int64(post->created_at));
+        json_object_object_add(jobj, "depth", json_object_new_int(post->depth));
+        json_object_object_add(jobj, "body_html",
+                               json_object_new_string(post->body_html));
+
+        /* Plain json-c output escapes newlines, so data is a single line. */
+        const char* json =
+            json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_PLAIN);
+        size_t cap  = strlen(json) + 64;
+        char* buf   = malloc(cap);
+        event_t* ev = NULL;
+        if (buf) {
+                int n = snprintf(buf, cap, "id: %d\nevent: post\ndata: %s\n\n",
+                                 post->id, json);
+                ev    = event_new(buf, (size_t)n);
+        }
+        free(buf);
+        json_object_put(jobj);
+        return ev;
+}
+
+/**
+ * @brief Send one event to every subscriber of a thread.
+ */
+static void broadcast_thread(live_t* live, int64_t thread_id, event_t* ev) {
+        client_t* next = NULL;
+        for (client_t* c = *bucket_of(live, thread_id); c; c = next) {
+                next = c->sub_next;
+                if (c->thread_id == thread_id) client_push(live, c, ev);
+        }
+}
+
+/**
+ * @brief Drain the wakeups and broadcast every post written since the last
+ * catch-up.
+ *
+ * With nobody subscribed the posts are skipped without being read.
+ */
+static void catch_up(live_t* live) {
+        uint32_t magic;
+        for (int i = 0; i < LIVE_WAKEUP_BATCH; ++i)
+                if (recv(live->notify_fd, &magic, sizeof(magic), 0) < 0 &&
+                    errno != EINTR)
+                        break;
+
+        result_t res;
+        if (live->subscribers == 0) {
+                int last = 0;
+                res      = post_last_id(live->db, &last);
+                if (res.code != RESULT_SUCCESS) result_log(&res);
+                else if (last > live->last_id) live->last_id = last;
+                return;
+        }
+
+        bool more = true;
+        while (more) {
+                post_page_t page;
+                res = post_list_since(live->db, live->last_id, DB_PAGE_MAX,
+                                      &page, NULL);
+                if (res.code != RESULT_SUCCESS) {
+                        result_log(&res);
+                        return;
+                }
+                for (size_t i = 0; i < page.count; ++i) {
+                        const post_t* post = &page.items[i];
+                        live->last_id      = post->id;
+                        if (!has_subscribers(live, post->thread_id)) continue;
+
+                        event_t* ev = post_event(post);
+                        if (!ev) continue;
+                        ++live->events;
+                        broadcast_thread(live, post->thread_id, ev);
+                        event_unref(ev);
+                }
+                more = page.has_more;
+                post_page_free(&page);
+        }
+}
+
+/**
+ * @brief Send a heartbeat to every stream and drop stalled request heads.
+ */
+static void heartbeat(live_t* live) {
+        event_t* ev = event_new(": keepalive\n\n", 13);
+        time_t now  = time(NULL);
+
+        client_t* next = NULL;
+        for (client_t* c = live->clients; c; c = next) {
+                next = c->next;
+                if (c->streaming) {
+                        if (ev) client_push(live, c, ev);
+                } else if (now - c->since > LIVE_HEAD_TIMEOUT_S) {
+                        client_close(live, c);
+                }
+        }
+        event_unref(ev);
+}
+
+/**
+ * @brief Free the clients closed during the last batch.
+ */
+static void bury_clients(live_t* live) {
+        while (live->graveyard) {
+                client_t* c     = live->graveyard;
+                live->graveyard = c->next;
+                free(c);
+        }
+}
+
+/**
+ * @brief Bind the loopback HTTP listener.
+ * @return Listening socket, or -1.
+ */
+static int open_listener(int port) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr = {
+            .sin_family      = AF_INET,
+            .sin_port        = htons((uint16_t)port),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(fd, SOMAXCONN) != 0) {
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+/**
+ * @brief Bind the datagram socket writers send wakeups to.
+ * @return Socket, or -1.
+ */
+static int open_notify(const char* path) {
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+        strcpy(addr.sun_path, path);
+
+        int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        /* A socket file left by a previous run refuses bind(). */
+        unlink(path);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+/**
+ * @brief Raise the descriptor limit as far as allowed.
+ * @return Descriptors available.
+ */
+static size_t raise_fd_limit(void) {
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return 1024;
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+        return rl.rlim_cur == RLIM_INFINITY ? (size_t)1 << 20
+                                            : (size_t)rl.rlim_cur;
+}
+
+int main(int argc, char** argv) {
+        const char* db_path     = DB_PATH;
+        const char* socket_path = livefeed_socket_path();
+        int port                = LIVE_DEFAULT_PORT;
+        long max_clients        = LIVE_DEFAULT_CLIENTS;
+        int heartbeat_s         = LIVE_DEFAULT_HEARTBEAT_S;
+
+        int opt;
+        while ((opt = getopt(argc, argv, "d:p:s:c:k:h")) != -1) {
+                switch (opt) {
+                        case 'd': db_path = optarg; break;
+                        case 'p': port = atoi(optarg); break;
+                        case 's': socket_path = optarg; break;
+                        case 'c': max_clients = atol(optarg); break;
+                        case 'k': heartbeat_s = atoi(optarg); break;
+                        default:
+                                fprintf(stderr,
+                                        "usage: %s [-d db] [-p port] "
+                                        "[-s socket] [-c max_clients] "
+                                        "[-k seconds]\n",
+                                        argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+        if (max_clients <= 0) max_clients = LIVE_DEFAULT_CLIENTS;
+        if (heartbeat_s <= 0) heartbeat_s = LIVE_DEFAULT_HEARTBEAT_S;
+        if (!socket_path || !*socket_path) {
+                fprintf(stderr, "livefeed: wakeups are disabled\n");
+                return 2;
+        }
+
+        /* Keep a few descriptors for the database, listener and epoll. */
+        size_t fds = raise_fd_limit();
+        if (fds < 64) fds = 64;
+        if ((size_t)max_clients > fds - 32) max_clients = (long)(fds - 32);
+
+        signal(SIGPIPE, SIG_IGN);
+        struct sigaction sa = {.sa_handler = on_signal};
+        sigaction(SIGTERM, &sa, NULL);
+        sigaction(SIGINT, &sa, NULL);
+
+        static live_t live;
+        live.max_clients = (size_t)max_clients;
+        live.epoll_fd    = epoll_create1(EPOLL_CLOEXEC);
+        live.listen_fd   = open_listener(port);
+        live.notify_fd   = open_notify(socket_path);
+
+        char hello[256];
+        int hello_len = snprintf(hello, sizeof(hello),
+                                 "HTTP/1.0 200 OK\r\n"
+                                 "Content-Type: text/event-stream\r\n"
+                                 "Cache-Control: no-cache\r\n"
+                                 "X-Accel-Buffering: no\r\n"
+                                 "\r\n"
+                                 "retry: %d\n\n",
+                                 LIVE_RETRY_MS);
+        live.hello = event_new(hello, (size_t)hello_len);
+
+        result_t res = db_open(db_path, &live.db);
+        if (res.code == RESULT_SUCCESS)
+                res = post_last_id(live.db, &live.last_id);
+        if (res.code != RESULT_SUCCESS || live.epoll_fd < 0 ||
+            live.listen_fd < 0 || live.notify_fd < 0 || !live.hello) {
+                if (res.code != RESULT_SUCCESS) result_log(&res);
+                else perror("livefeed: setup");
+                db_close(live.db);
+                printf("{\"op\":\"livefeed\",\"ok\":false}\n");
+                return 1;
+        }
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &listen_tag};
+        epoll_ctl(live.epoll_fd, EPOLL_CTL_ADD, live.listen_fd, &ev);
+        ev.data.ptr = &notify_tag;
+        epoll_ctl(live.epoll_fd, EPOLL_CTL_ADD, live.notify_fd, &ev);
+
+        time_t next_beat = time(NULL) + heartbeat_s;
+        struct epoll_event ready[256];
+        while (!stopping) {
+                int n = epoll_wait(live.epoll_fd, ready, 256, 1000);
+                for (int i = 0; i < n; ++i) {
+                        void* tag = ready[i].data.ptr;
+                        if (tag == &listen_tag) {
+                                accept_clients(&live);
+                                continue;
+                        }
+                        if (tag == &notify_tag) {
+                                catch_up(&live);
+                                continue;
+                        }
+
+                        client_t* c = tag;
+                        if (c->closed) continue;
+                        if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+                                client_close(&live, c);
+                                continue;
+                        }
+                        if (ready[i].events & EPOLLIN) client_read(&live, c);
+                        if (!c->closed && (ready[i].events & EPOLLOUT))
+                                client_flush(&live, c);
+                }
+
+                if (time(NULL) >= next_beat) {
+                        heartbeat(&live);
+                        next_beat = time(NULL) + heartbeat_s;
+                }
+                bury_clients(&live);
+        }
+
+        while (live.clients) client_close(&live, live.clients);
+        bury_clients(&live);
+        event_unref(live.hello);
+        unlink(socket_path);
+        db_close(live.db);
+
+        printf("{\"op\":\"livefeed\",\"events\":%llu,\"sent\":%llu,"
+               "\"slow\":%llu,\"peak_clients\":%zu,\"ok\":true}\n",
+               (unsigned long long)live.events, (unsigned long long)live.sent,
+               (unsigned long long)live.slow, live.peak_clients);
+        return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file rerender.c
+ * @brief Bring stored post HTML up to the current Markdown renderer.
+ *
+ * Posts are rendered once when written and keep that HTML, tagged with the
+ * MARKDOWN_VERSION that produced it. After a deploy bumps the version, this
+ * program re-renders the older posts in the background: a batch per short
+ * write transaction, with a pause between batches so writers get the lock
+ * in between. Until a post is reached it is served with its old HTML.
+ *
+ * Runs until no stale post is left or the time budget is spent, and prints
+ * one JSON line, e.g.
+ *   {"op":"rerender","version":2,"batches":12,"rendered":1150,"done":true,
+ *    "ms":830.4,"ok":true}
+ *
+ * Usage:
+ *   rerender [-d db] [-b batch] [-s ms] [-t seconds]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/dal/post/post.h"
+#include "/app/backend/lib/markdown/markdown.h"
+#include "/app/backend/lib/result/result.h"
+#include "/app/backend/lib/timing/timing.h"
+
+#define DB_PATH "/data/sfe.db"
+
+int main(int argc, char** argv) {
+        const char* db_path = DB_PATH;
+        int batch           = 100;
+        int pause_ms        = 50;
+        int budget_s        = 0;
+
+        int opt;
+        while ((opt = getopt(argc, argv, "d:b:s:t:h")) != -1) {
+                switch (opt) {
+                        case 'd': db_path = optarg; break;
+                        case 'b': batch = atoi(optarg); break;
+                        case 's': pause_ms = atoi(optarg); break;
+                        case 't': budget_s = atoi(optarg); break;
+                        default:
+                                fprintf(stderr,
+                                        "usage: %s [-d db] [-b batch] [-s ms] "
+                                        "[-t seconds]\n",
+                                        argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+        if (batch <= 0) batch = 100;
+        if (pause_ms < 0) pause_ms = 0;
+
+        uint64_t start = timing_now_ns();
+        uint64_t stop  = start + (uint64_t)budget_s * 1000000000ull;
+        int batches    = 0;
+        long rendered  = 0;
+        bool done      = false;
+
+        sqlite3* db  = NULL;
+        result_t res = db_open(db_path, &db);
+        while (res.code == RESULT_SUCCESS && !done &&
+               (budget_s <= 0 || timing_now_ns() < stop)) {
+                if (batches > 0) usleep((useconds_t)pause_ms * 1000);
+                int count = 0;
+                res       = post_rerender_stale(db, batch, &count);
+                rendered += count;
+                done = count < batch;
+                ++batches;
+        }
+        db_close(db);
+
+        bool ok = res.code == RESULT_SUCCESS;
+        if (!ok) result_log(&res);
+
+        printf("{\"op\":\"rerender\",\"version\":%d,\"batches\":%d,"
+               "\"rendered\":%ld,\"done\":%s,\"ms\":%.1f,\"ok\":%s}\n",
+               MARKDOWN_VERSION, batches, rendered, done ? "true" : "false",
+               (double)(timing_now_ns() - start) / 1e6, ok ? "true" : "false");
+        return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file revoke.c
+ * @brief Load and change the JWT revocation segment (lib/revoke).
+ *
+ * -l copies every user's token generation from SQLite into the shared
+ * segment and marks it loaded; entrypoint.sh runs it before lighttpd
+ * starts, as val_jwt() refuses every token until then. -u revokes all
+ * tokens issued so far to one user, e.g. after a password reset; it fails
+ * unless the segment took the new generation, so ok:true means the old
+ * tokens are rejected. With SFE_REVOKE=0 a load has nothing to fill and
+ * succeeds; any other failure exits non-zero, so a start script can refuse
+ * to serve without the list.
+ *
+ * Prints one JSON line, e.g.
+ *   {"op":"load","users":1520,"ms":12.7,"ok":true}
+ *   {"op":"revoke","user":42,"generation":3,"ms":1.1,"ok":true}
+ *
+ * Usage:
+ *   revoke [-d db] -l
+ *   revoke [-d db] -u user_id
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/dal/db/db.h"
+#include "/app/backend/lib/dal/user/user.h"
+#include "/app/backend/lib/result/result.h"
+#include "/app/backend/lib/revoke/revoke.h"
+#include "/app/backend/lib/timing/timing.h"
+
+#define DB_PATH "/data/sfe.db"
+
+int main(int argc, char** argv) {
+        const char* db_path = DB_PATH;
+        bool load           = false;
+        int user_id         = 0;
+
+        int opt;
+        while ((opt = getopt(argc, argv, "d:lu:h")) != -1) {
+                switch (opt) {
+                        case 'd': db_path = optarg; break;
+                        case 'l': load = true; break;
+                        case 'u': user_id = atoi(optarg); break;
+                        default:
+                                fprintf(stderr,
+                                        "usage: %s [-d db] -l | -u user_id\n",
+                                        argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+        if (load == (user_id > 0)) {
+                fprintf(stderr, "usage: %s [-d db] -l | -u user_id\n",
+                        argv[0]);
+                return 2;
+        }
+
+        uint64_t start      = timing_now_ns();
+        size_t users        = 0;
+        uint32_t generation = 0;
+
+        sqlite3* db  = NULL;
+        result_t res = db_open(db_path, &db);
+        if (res.code == RESULT_SUCCESS) {
+                if (load)
+                        res = user_load_generations(db, &users);
+                else
+                        res = user_revoke_sessions(db, user_id, &generation);
+        }
+        db_close(db);
+
+        const char* enabled = getenv("SFE_REVOKE");
+        bool disabled       = enabled && strcmp(enabled, "0") == 0;
+
+        bool ok = res.code == RESULT_SUCCESS;
+        if (ok && load && !revoke_mark_loaded() && !disabled) {
+                fprintf(stderr, "revoke: segment unavailable\n");
+                ok = false;
+        }
+        if (!ok && res.code != RESULT_SUCCESS) result_log(&res);
+
+        double ms = (double)(timing_now_ns() - start) / 1e6;
+        if (load)
+                printf("{\"op\":\"load\",\"users\":%zu,\"ms\":%.1f,"
+                       "\"ok\":%s}\n",
+                       users, ms, ok ? "true" : "false");
+        else
+                printf("{\"op\":\"revoke\",\"user\":%d,\"generation\":%u,"
+                       "\"ms\":%.1f,\"ok\":%s}\n",
+                       user_id, generation, ms, ok ? "true" : "false");
+        return ok ? 0 : 1;
+}
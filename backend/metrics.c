@@ -0,0 +1,39 @@
+/**
+ * @file metrics.c
+ * @brief CGI endpoint exposing the shared metrics segment to Prometheus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/metrics/metrics.h"
+#include "lib/response/response.h"
+
+int main(void) {
+        response_t resp = {0};
+
+        const char* method = getenv("REQUEST_METHOD");
+        if (!method || strcmp(method, "GET") != 0) {
+                response_init(&resp, 405);
+                response_append_str(&resp, "Method Not Allowed");
+                response_send(&resp);
+                response_free(&resp);
+                return 0;
+        }
+
+        if (!metrics_enabled()) {
+                response_init(&resp, 503);
+                response_append_str(&resp, "Metrics unavailable.");
+                response_send(&resp);
+                response_free(&resp);
+                return 0;
+        }
+
+        printf("Status: 200\r\n");
+        printf("Content-Type: text/plain; version=0.0.4\r\n");
+        printf("Cache-Control: no-store\r\n");
+        printf("\r\n");
+        metrics_write_prometheus(stdout);
+        return 0;
+}
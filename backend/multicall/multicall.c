@@ -0,0 +1,93 @@
+/**
+ * @file multicall.c
+ * @brief Busybox-style entry point of the release build.
+ *
+ * `generate_build.sh release` compiles every top-level CGI source with
+ * -Dmain=sfe_applet_<name> and links them, with lib/, into one optimized
+ * binary, release/sfe. Each <name>.cgi is a symlink to it, so all endpoints
+ * share one executable in the page cache and one dynamic-linking setup.
+ *
+ * The applet is chosen from the basename of argv[0] without ".cgi". When
+ * the binary is run as `sfe` itself, SCRIPT_NAME is tried next, then
+ * argv[1] (`release/sfe register`) for manual testing.
+ *
+ * SFE_APPLETS is supplied by the build as a list of APPLET(name) entries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "/app/backend/lib/response/response.h"
+
+#ifndef SFE_APPLETS
+#error "SFE_APPLETS must list the applets, e.g. -DSFE_APPLETS='APPLET(csrf)'"
+#endif
+
+/** @brief Longest applet name accepted, without ".cgi". */
+#define MULTICALL_NAME_SIZE 64
+
+#define APPLET(name) int sfe_applet_##name(void);
+SFE_APPLETS
+#undef APPLET
+
+/**
+ * @struct applet_t
+ * @brief One endpoint linked into the binary.
+ */
+typedef struct {
+        const char* name;  /**< CGI name without ".cgi" */
+        int (*main)(void); /**< The endpoint's original main() */
+} applet_t;
+
+static const applet_t applets[] = {
+#define APPLET(name) {#name, sfe_applet_##name},
+    SFE_APPLETS
+#undef APPLET
+};
+
+/**
+ * @brief Look up the applet for a path such as "/api/register.cgi".
+ * @param path argv[0], SCRIPT_NAME or a bare name (nullable).
+ * @return Applet, or NULL if none matches.
+ */
+static const applet_t* multicall_find(const char* path) {
+        if (!path || !*path) return NULL;
+
+        const char* base = strrchr(path, '/');
+        base             = base ? base + 1 : path;
+
+        size_t len = strlen(base);
+        if (len > 4 && strcmp(base + len - 4, ".cgi") == 0) len -= 4;
+        if (len == 0 || len >= MULTICALL_NAME_SIZE) return NULL;
+
+        for (size_t i = 0; i < sizeof(applets) / sizeof(applets[0]); ++i) {
+                if (strlen(applets[i].name) == len &&
+                    memcmp(applets[i].name, base, len) == 0)
+                        return &applets[i];
+        }
+        return NULL;
+}
+
+int main(int argc, char** argv) {
+        const applet_t* applet = multicall_find(argc > 0 ? argv[0] : NULL);
+        if (!applet) applet = multicall_find(getenv("SCRIPT_NAME"));
+        if (!applet && argc > 1) applet = multicall_find(argv[1]);
+        if (applet) return applet->main();
+
+        if (getenv("GATEWAY_INTERFACE")) {
+                response_t resp = {0};
+                response_init(&resp, 404);
+                response_append_str(&resp, "Not Found");
+                response_send(&resp);
+                response_free(&resp);
+                return 1;
+        }
+
+        fprintf(stderr, "usage: %s <applet>\napplets:",
+                argc > 0 ? argv[0] : "sfe");
+        for (size_t i = 0; i < sizeof(applets) / sizeof(applets[0]); ++i)
+                fprintf(stderr, " %s", applets[i].name);
+        fputc('\n', stderr);
+        return 127;
+}
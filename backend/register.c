@@ -5,100 +5,126 @@
 
 #include <ctype.h>
 #include <json-c/json.h>
-#include <sanitizec.h>
 #include <sqlite3.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "lib/admission/admission.h"
+#include "lib/arena/arena.h"
 #include "lib/csrf/csrf.h"
+#include "lib/dal/db/db.h"
 #include "lib/dal/user/user.h"
+#include "lib/deadline/deadline.h"
 #include "lib/hash_password/hash_password.h"
 #include "lib/models/user_model/user_model.h"
+#include "lib/ratelimit/ratelimit.h"
 #include "lib/read_post_data/read_post_data.h"
 #include "lib/response/response.h"
 #include "lib/result/result.h"
+#include "lib/timing/timing.h"
+#include "lib/validate/validate.h"
 
 #define DB_PATH "/data/sfe.db"
 #define DEBUG 0
 
-static void free_memory(sqlite3* db, char* body, struct json_object* jobj,
-                        char* username_sanitized, char* password_hash,
-                        user_t* inserted_user, result_t* res,
-                        result_t* csrf_res, result_t* hash_res,
-                        result_t* user_res) {
-        if (db) sqlite3_close(db);
-        if (body) free(body);
+/** @brief Size of the stack block backing the request arena. */
+#define REQUEST_ARENA_SIZE 16384
+
+/** @brief Longest accepted username. */
+#define USERNAME_MAX_LENGTH 12
+
+/** @brief Time budget of a registration, from arrival to response. */
+#define REGISTER_DEADLINE_MS 5000
+
+/** @brief Time left that is needed to start the Argon2 hash. */
+#define REGISTER_HASH_MIN_MS 1000
+
+/** @brief Registrations per client address; each costs an Argon2 hash. */
+static const ratelimit_rule_t register_limit = {
+    .endpoint = "register", .per_minute = 10, .burst = 10};
+
+static void free_memory(sqlite3* db, struct json_object* jobj, arena_t* arena) {
+        db_close(db);
         if (jobj) json_object_put(jobj);
-        if (username_sanitized) free(username_sanitized);
-        if (password_hash) free(password_hash);
-        if (inserted_user) user_free(inserted_user);
-        if (res) result_free(res);
-        if (csrf_res) result_free(csrf_res);
-        if (hash_res) result_free(hash_res);
-        if (user_res) result_free(user_res);
+        arena_destroy(arena);
 }
 
-const char* validate_username(const char* str) {
+static const char* validate_username(const char* str) {
         if (!str || *str == '\0') return "Username is empty.";
-        size_t len = strlen(str);
-        if (len > 12) return "Username too long (12 characters max).";
+        size_t len = strnlen(str, USERNAME_MAX_LENGTH + 1);
+        if (len > USERNAME_MAX_LENGTH)
+                return "Username too long (12 characters max).";
+        if (!is_alnum(str, len)) return "Username must be alphanumeric.";
         return NULL;
 }
 
 int main(void) {
+        timing_t timing;
+        timing_init(&timing, "register");
+
+        deadline_t deadline;
+        deadline_init(&deadline, REGISTER_DEADLINE_MS);
+
         const char* method = getenv("REQUEST_METHOD");
 
-        char *username_sanitized = NULL, *password_hash = NULL, *body = NULL;
+        char *password_hash = NULL, *body = NULL;
         struct json_object* jobj = NULL;
         user_t* inserted_user    = NULL;
         sqlite3* db              = NULL;
 
-        result_t *res = NULL, *csrf_res = NULL, *hash_res = NULL,
-                 *user_res = NULL;
+        unsigned char arena_buf[REQUEST_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, arena_buf, sizeof(arena_buf));
 
         response_t resp;
-        response_init(&resp, 200);
+        response_init_arena(&resp, &arena, 200);
+        response_set_timing(&resp, &timing);
 
         if (!method || strcmp(method, "POST") != 0) {
                 response_init(&resp, 405);
                 response_append_str(&resp, "Method Not Allowed");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
+                return 0;
+        }
+
+        uint32_t retry_after = 0;
+        if (!ratelimit_allow(&register_limit, getenv("REMOTE_ADDR"),
+                             &retry_after)) {
+                ratelimit_send_429(&timing, retry_after);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
-        res = read_post_data(&body);
-        if (res->code != RESULT_SUCCESS) {
-                response_init(&resp,
-                              res->data.error.code == ERR_INVALID_CONTENT_LENGTH
-                                  ? 400
-                                  : 500);
-                switch (res->data.error.code) {
-                        case ERR_INVALID_CONTENT_LENGTH:
-                                response_append_str(
-                                    &resp, "Invalid Content Length for POST");
-                                break;
-                        default:
-                                response_append_str(&resp,
-                                                    "Internal Server Error");
-                                break;
-                }
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
+        size_t span   = timing_begin(&timing, "queue");
+        bool admitted = admission_enter(ADMISSION_EXPENSIVE, &retry_after);
+        timing_end(&timing, span);
+        if (!admitted) {
+                admission_send_503(&timing, retry_after);
+                free_memory(db, jobj, &arena);
+                return 0;
+        }
+
+        span         = timing_begin(&timing, "read");
+        result_t res = read_post_data(&body, &arena);
+        timing_end(&timing, span);
+        if (res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
+        span = timing_begin(&timing, "parse");
         jobj = json_tokener_parse(body);
+        timing_end(&timing, span);
         if (!jobj) {
                 response_init(&resp, 400);
                 response_append_str(&resp, "Malformed JSON");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
@@ -110,9 +136,8 @@ int main(void) {
                 response_init(&resp, 400);
                 response_append_str(
                     &resp, "Missing csrf, username, or password field.");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
@@ -124,19 +149,19 @@ int main(void) {
                 response_init(&resp, 400);
                 response_append_str(
                     &resp, "Missing or invalid csrf, username, or password.");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
-        csrf_res = csrf_validate_token(csrf_token_raw);
-        if (csrf_res->code != RESULT_SUCCESS) {
+        span              = timing_begin(&timing, "csrf");
+        result_t csrf_res = csrf_validate_token(csrf_token_raw);
+        timing_end(&timing, span);
+        if (csrf_res.code != RESULT_SUCCESS) {
                 response_init(&resp, 400);
                 response_append_str(&resp, "Invalid CSRF token");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
@@ -144,9 +169,8 @@ int main(void) {
                 response_init(&resp, 400);
                 response_append_str(&resp,
                                     "Password must be at least 6 characters.");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
@@ -154,105 +178,60 @@ int main(void) {
         if (validation_err) {
                 response_init(&resp, 400);
                 response_append_str(&resp, validation_err);
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
-        username_sanitized = sanitizec_apply(
-            username_raw, SANITIZEC_RULE_ALPHANUMERIC_ONLY, NULL);
-        if (!username_sanitized) {
-                response_init(&resp, 400);
-                response_append_str(&resp, "Username sanitization failed");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
-                response_send(&resp);
-                return 0;
-        }
-
-        if (strcmp(username_raw, username_sanitized) != 0) {
-                response_init(&resp, 400);
-                response_append_str(&resp, "Username must be alphanumeric.");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
+        result_t deadline_res = deadline_check(&deadline, REGISTER_HASH_MIN_MS);
+        if (deadline_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &deadline_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
-        hash_res = hash_password(password, &password_hash);
-        if (hash_res->code != RESULT_SUCCESS) {
-                response_init(&resp, 500);
-                response_append_str(&resp, "Internal Server Error");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
+        span              = timing_begin(&timing, "argon2");
+        result_t hash_res = hash_password(password, &password_hash, &arena);
+        timing_end(&timing, span);
+        if (hash_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &hash_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
         user_t user = {
             .id            = -1,
-            .username      = username_sanitized,
+            .username      = (char*)username_raw,
             .password_hash = password_hash,
         };
 
-        if (sqlite3_open(DB_PATH, &db) != SQLITE_OK) {
-                response_init(&resp, 500);
-                response_append_str(&resp, "Internal Server Error");
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
+        span            = timing_begin(&timing, "db_open");
+        result_t db_res = db_open(DB_PATH, &db);
+        timing_end(&timing, span);
+        if (db_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &db_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
+        db_set_deadline(db, &deadline);
 
-        user_res = user_insert(db, &user, &inserted_user);
-        if (user_res->code != RESULT_SUCCESS) {
-                response_init(
-                    &resp, (user_res->data.error.code == ERR_SQL_PREPARE_FAIL ||
-                            user_res->data.error.code == ERR_SQL_STEP_FAIL ||
-                            user_res->data.error.code == ERR_SQL_BIND_FAIL)
-                               ? 500
-                               : 400);
-
-                switch (user_res->data.error.code) {
-                        case ERR_USER_DUPLICATE:
-                                response_append_str(&resp,
-                                                    "Username already exists.");
-                                break;
-                        case ERR_SQL_PREPARE_FAIL:
-                        case ERR_SQL_STEP_FAIL:
-                        case ERR_SQL_BIND_FAIL:
-                                response_append_str(&resp,
-                                                    "Internal Server Error");
-                                break;
-                        case ERR_USER_NOT_FOUND:
-                                response_append_str(&resp,
-                                                    "User registration failed");
-                                break;
-                        default:
-                                if (user_res->data.error.message &&
-                                    strstr(user_res->data.error.message,
-                                           "UNIQUE constraint failed")) {
-                                        response_append_str(
-                                            &resp, "Username already exists.");
-                                } else {
-                                        response_append_str(
-                                            &resp, "User registration failed");
-                                }
-                                break;
-                }
-
-                free_memory(db, body, jobj, username_sanitized, password_hash,
-                            inserted_user, res, csrf_res, hash_res, user_res);
+        span              = timing_begin(&timing, "insert");
+        result_t user_res = user_insert(db, &user, &inserted_user, &arena);
+        timing_end(&timing, span);
+        if (user_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &user_res);
                 response_send(&resp);
+                free_memory(db, jobj, &arena);
                 return 0;
         }
 
         response_init(&resp, 201);
         response_append_str(&resp, "User registered successfully.");
 
-        free_memory(db, body, jobj, username_sanitized, password_hash,
-                    inserted_user, res, csrf_res, hash_res, user_res);
         response_send(&resp);
+        free_memory(db, jobj, &arena);
         return 0;
 }
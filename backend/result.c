@@ -8,16 +8,13 @@
 #if DEBUG
 
 int main(void) {
-        result_t* rc = test_fail();
-        if (!rc) return 1;
+        result_set_log_extra(true);
+        result_t rc = test_fail();
 
-        json_object* res_json = result_to_json(rc);
-        if (!res_json) {
-                result_free(rc);
-                return 1;
-        }
+        json_object* res_json = result_to_json(&rc);
+        if (!res_json) return 1;
 
-        response_t resp;
+        response_t resp = {0};
         response_init(&resp, 500);
         response_append_json(&resp, res_json);
         json_object_put(res_json);
@@ -25,7 +22,6 @@ int main(void) {
         response_send(&resp);
         response_free(&resp);
 
-        result_free(rc);
         return 0;
 }
 
@@ -35,7 +31,7 @@ int main(void) {
  * @return 0 on completion
  */
 int main(void) {
-        response_t resp;
+        response_t resp = {0};
         response_init(&resp, 404);
         response_append_str(&resp, "Debug endpoint not available");
         response_send(&resp);
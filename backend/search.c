@@ -0,0 +1,259 @@
+/**
+ * @file search.c
+ * @brief CGI endpoint for full-text search over posts.
+ *
+ * GET /api/search.cgi?q=<text>[&offset=<n>][&limit=<n>]
+ *
+ * Pages are cached (lib/cache) by text, offset and limit until the next
+ * post is written, so repeated searches skip SQL and serialization. Pages
+ * carry an ETag from the same post generation; a request whose
+ * If-None-Match still matches gets a bodyless 304 before any lookup.
+ */
+
+#include <json-c/json.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/admission/admission.h"
+#include "lib/arena/arena.h"
+#include "lib/cache/cache.h"
+#include "lib/dal/db/db.h"
+#include "lib/dal/search/search.h"
+#include "lib/deadline/deadline.h"
+#include "lib/ratelimit/ratelimit.h"
+#include "lib/read_get_data/read_get_data.h"
+#include "lib/response/response.h"
+#include "lib/result/result.h"
+#include "lib/timing/timing.h"
+
+#define DB_PATH "/data/sfe.db"
+
+/** @brief Size of the stack block backing the request arena. */
+#define REQUEST_ARENA_SIZE 16384
+
+/** @brief Longest accepted search text, in bytes. */
+#define SEARCH_QUERY_MAX 256
+
+/** @brief Page size when the request gives none. */
+#define SEARCH_DEFAULT_LIMIT 20
+
+/** @brief Time budget of a search; bounds queries on very common terms. */
+#define SEARCH_DEADLINE_MS 2000
+
+/** @brief Cached pages depend on every post. */
+static const cache_scope_t search_scopes[] = {{CACHE_SCOPE_POSTS, 0}};
+
+/** @brief Searches per client address. */
+static const ratelimit_rule_t search_limit = {
+    .endpoint = "search", .per_minute = 120, .burst = 30};
+
+static void free_memory(sqlite3* db, struct json_object* jobj, arena_t* arena,
+                        cache_entry_t* cache) {
+        cache_release(cache);
+        db_close(db);
+        if (jobj) json_object_put(jobj);
+        arena_destroy(arena);
+}
+
+/**
+ * @brief Read an optional non-negative integer parameter.
+ * @param query Query string
+ * @param name Parameter name
+ * @param out Set to the value; left unchanged when the parameter is absent
+ * @return false if the parameter is present but not a valid number
+ */
+static bool read_int_param(const char* query, const char* name, int* out) {
+        char buf[16];
+        result_t res = read_get_param(query, name, buf, sizeof(buf));
+        if (res.code != RESULT_SUCCESS)
+                return res.error && res.error->code == ERR_GET_PARAM_MISSING;
+
+        char* end = NULL;
+        long v    = strtol(buf, &end, 10);
+        if (end == buf || *end || v < 0 || v > 1000000) return false;
+        *out = (int)v;
+        return true;
+}
+
+/**
+ * @brief Serialize a search page as the response payload.
+ * @param page Search results
+ * @param offset Offset the page starts at
+ * @return New JSON object (caller must put), or NULL when out of memory
+ */
+static struct json_object* page_to_json(const search_page_t* page,
+                                        int offset) {
+        struct json_object* jobj    = json_object_new_object();
+        struct json_object* results = json_object_new_array();
+        if (!jobj || !results) {
+                if (jobj) json_object_put(jobj);
+                if (results) json_object_put(results);
+                return NULL;
+        }
+
+        for (size_t i = 0; i < page->count; ++i) {
+                const search_hit_t* hit = &page->items[i];
+                struct json_object* jhit = json_object_new_object();
+                if (!jhit) break;
+                json_object_object_add(jhit, "post_id",
+                                       json_object_new_int(hit->post_id));
+                json_object_object_add(jhit, "thread_id",
+                                       json_object_new_int(hit->thread_id));
+                json_object_object_add(jhit, "user_id",
+                                       json_object_new_int(hit->user_id));
+                json_object_object_add(jhit, "created_at",
+                                       json_object_new_int64(hit->created_at));
+                json_object_object_add(jhit, "score",
+                                       json_object_new_double(hit->score));
+                json_object_object_add(jhit, "snippet",
+                                       json_object_new_string(hit->snippet));
+                json_object_array_add(results, jhit);
+        }
+
+        json_object_object_add(jobj, "results", results);
+        json_object_object_add(jobj, "has_more",
+                               json_object_new_boolean(page->has_more));
+        if (page->has_more)
+                json_object_object_add(
+                    jobj, "next_offset",
+                    json_object_new_int(offset + (int)page->count));
+        return jobj;
+}
+
+int main(void) {
+        timing_t timing;
+        timing_init(&timing, "search");
+
+        deadline_t deadline;
+        deadline_init(&deadline, SEARCH_DEADLINE_MS);
+
+        const char* method = getenv("REQUEST_METHOD");
+        const char* query  = getenv("QUERY_STRING");
+
+        struct json_object* jobj = NULL;
+        sqlite3* db              = NULL;
+        cache_entry_t cache      = {0};
+
+        unsigned char arena_buf[REQUEST_ARENA_SIZE];
+        arena_t arena;
+        arena_init(&arena, arena_buf, sizeof(arena_buf));
+
+        response_t resp;
+        response_init_arena(&resp, &arena, 200);
+        response_set_timing(&resp, &timing);
+
+        if (!method || strcmp(method, "GET") != 0) {
+                response_init(&resp, 405);
+                response_append_str(&resp, "Method Not Allowed");
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        uint32_t retry_after = 0;
+        if (!ratelimit_allow(&search_limit, getenv("REMOTE_ADDR"),
+                             &retry_after)) {
+                ratelimit_send_429(&timing, retry_after);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        char text[SEARCH_QUERY_MAX];
+        result_t res = read_get_param(query, "q", text, sizeof(text));
+        if (res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &res);
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        int offset = 0, limit = SEARCH_DEFAULT_LIMIT;
+        if (!read_int_param(query, "offset", &offset) ||
+            !read_int_param(query, "limit", &limit) ||
+            offset > SEARCH_MAX_OFFSET || limit < 1 || limit > DB_PAGE_MAX) {
+                response_init(&resp, 400);
+                response_append_str(&resp, "Invalid offset or limit.");
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        /* Defaults are filled in and parameter order is gone, so equal
+         * searches share one entry; the text goes last and may hold any
+         * byte. */
+        char key[SEARCH_QUERY_MAX + 32];
+        snprintf(key, sizeof(key), "search\n%d\n%d\n%s", offset, limit, text);
+        char etag[CACHE_ETAG_SIZE];
+        bool tagged = cache_etag(key, search_scopes, 1, etag);
+        if (tagged && response_not_modified(&resp, etag)) {
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        size_t span = timing_begin(&timing, "cache");
+        cache_status_t cached =
+            cache_lookup(&cache, key, search_scopes, 1, &resp);
+        timing_end(&timing, span);
+        if (cached == CACHE_HIT) {
+                if (tagged) response_add_header(&resp, "ETag", etag);
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        span          = timing_begin(&timing, "queue");
+        bool admitted = admission_enter(ADMISSION_CHEAP, &retry_after);
+        timing_end(&timing, span);
+        if (!admitted) {
+                admission_send_503(&timing, retry_after);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        span            = timing_begin(&timing, "db_open");
+        result_t db_res = db_open(DB_PATH, &db);
+        timing_end(&timing, span);
+        if (db_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &db_res);
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+        db_set_deadline(db, &deadline);
+
+        search_page_t page;
+        span                = timing_begin(&timing, "search");
+        result_t search_res =
+            search_posts(db, text, offset, limit, &page, &arena);
+        timing_end(&timing, span);
+        if (search_res.code != RESULT_SUCCESS) {
+                response_from_result(&resp, &search_res);
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        span = timing_begin(&timing, "serialize");
+        jobj = page_to_json(&page, offset);
+        timing_end(&timing, span);
+        if (!jobj) {
+                response_init(&resp, 500);
+                response_append_str(&resp, ERROR_MSG_INTERNAL);
+                response_send(&resp);
+                free_memory(db, jobj, &arena, &cache);
+                return 0;
+        }
+
+        response_init(&resp, 200);
+        response_append_json(&resp, jobj);
+        if (tagged) response_add_header(&resp, "ETag", etag);
+        cache_store(&cache, &resp);
+
+        response_send(&resp);
+        free_memory(db, jobj, &arena, &cache);
+        return 0;
+}
@@ -4,14 +4,191 @@ DB_PATH="/data/sfe.db"
 
 mkdir -p /data
 
+# Columns added after a database was created. CREATE TABLE IF NOT EXISTS
+# below leaves an existing table as it is, so add them here first; the
+# indexes further down need them.
+has_users=$(sqlite3 "$DB_PATH" \
+    "SELECT COUNT(*) FROM pragma_table_info('users');")
+has_generation=$(sqlite3 "$DB_PATH" \
+    "SELECT COUNT(*) FROM pragma_table_info('users')
+     WHERE name = 'token_generation';")
+if [ "$has_users" -gt 0 ] && [ "$has_generation" -eq 0 ]; then
+    sqlite3 "$DB_PATH" "ALTER TABLE users
+        ADD COLUMN token_generation INTEGER NOT NULL DEFAULT 0;"
+fi
+
 sqlite3 "$DB_PATH" <<EOF
 -- Users table
 CREATE TABLE IF NOT EXISTS users (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
     username TEXT NOT NULL UNIQUE,
     password_hash TEXT NOT NULL,
-    created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+    token_generation INTEGER NOT NULL DEFAULT 0
+);
+
+-- Login and duplicate checks look usernames up case-insensitively; without
+-- this index user_fetch_by_username is a full table scan.
+CREATE INDEX IF NOT EXISTS users_username_nocase
+    ON users (username COLLATE NOCASE);
+
+-- token_generation is copied into every JWT; bumping it revokes the user's
+-- tokens (lib/revoke). maint/revoke -l reloads the non-zero ones into shared
+-- memory at start through this index, so a reload reads only users who
+-- revoked, however many users there are.
+CREATE INDEX IF NOT EXISTS users_revoked
+    ON users (token_generation) WHERE token_generation > 0;
+
+-- Threads and posts. created_at is Unix seconds, so a keyset cursor
+-- (created_at, id) is two integers; id breaks ties within a second.
+CREATE TABLE IF NOT EXISTS threads (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    user_id INTEGER NOT NULL REFERENCES users (id),
+    title TEXT NOT NULL,
+    created_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')),
+    post_count INTEGER NOT NULL DEFAULT 0
+);
+
+-- thread_list reads this backwards from the cursor.
+CREATE INDEX IF NOT EXISTS threads_created
+    ON threads (created_at, id);
+
+CREATE TABLE IF NOT EXISTS posts (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    thread_id INTEGER NOT NULL REFERENCES threads (id),
+    user_id INTEGER NOT NULL REFERENCES users (id),
+    body TEXT NOT NULL,
+    created_at INTEGER NOT NULL DEFAULT (strftime('%s', 'now')),
+    parent_id INTEGER REFERENCES posts (id),
+    depth INTEGER NOT NULL DEFAULT 0,
+    path TEXT NOT NULL DEFAULT '',
+    body_html TEXT NOT NULL DEFAULT '',
+    render_version INTEGER NOT NULL DEFAULT 0
 );
+
+-- post_list_by_thread seeks to (thread_id, cursor) and reads LIMIT entries
+-- in order. The index holds the whole sort key and the rowid, so no OFFSET
+-- rows are ever skipped and only the page's rows are fetched.
+CREATE INDEX IF NOT EXISTS posts_thread_created
+    ON posts (thread_id, created_at, id);
+
+-- Reply trees. path is the ids of a post's ancestors and of the post itself,
+-- each as 8 hex digits, so sorting by path lists a thread depth-first with
+-- siblings oldest first, and a subtree is the range [path, path || 'g').
+-- post_list_tree / post_list_subtree read it straight off this index; depth
+-- is in the index so a depth limit skips entries without reading the rows.
+CREATE INDEX IF NOT EXISTS posts_thread_path
+    ON posts (thread_id, path, depth);
+
+-- The path needs the new id, so it is set right after the insert.
+CREATE TRIGGER IF NOT EXISTS posts_path AFTER INSERT ON posts BEGIN
+    UPDATE posts SET path = COALESCE(
+        (SELECT path FROM posts WHERE id = new.parent_id), '')
+        || printf('%08x', new.id)
+    WHERE id = new.id;
+END;
+
+-- body_html is body rendered by lib/markdown when the post is written, so
+-- reads never parse Markdown. render_version is the MARKDOWN_VERSION that
+-- produced it; maint/rerender walks this index to redo posts rendered by an
+-- older version. Changing body without body_html marks the HTML stale.
+CREATE INDEX IF NOT EXISTS posts_render_version
+    ON posts (render_version);
+
+CREATE TRIGGER IF NOT EXISTS posts_render_stale AFTER UPDATE OF body ON posts
+WHEN new.body_html IS old.body_html BEGIN
+    UPDATE posts SET render_version = 0 WHERE id = new.id;
+END;
+
+-- Full-text index over post bodies (lib/dal/search). External content: the
+-- text lives only in posts, and the triggers below keep the index in step
+-- with every insert, update and delete. prefix = '2 3' serves "ab*" and
+-- "abc*" queries from dedicated prefix indexes.
+CREATE VIRTUAL TABLE IF NOT EXISTS posts_fts USING fts5 (
+    body,
+    content = 'posts',
+    content_rowid = 'id',
+    tokenize = 'unicode61 remove_diacritics 2',
+    prefix = '2 3'
+);
+
+CREATE TRIGGER IF NOT EXISTS posts_fts_insert AFTER INSERT ON posts BEGIN
+    INSERT INTO posts_fts (rowid, body) VALUES (new.id, new.body);
+END;
+
+CREATE TRIGGER IF NOT EXISTS posts_fts_delete AFTER DELETE ON posts BEGIN
+    INSERT INTO posts_fts (posts_fts, rowid, body)
+        VALUES ('delete', old.id, old.body);
+END;
+
+CREATE TRIGGER IF NOT EXISTS posts_fts_update AFTER UPDATE OF body ON posts
+BEGIN
+    INSERT INTO posts_fts (posts_fts, rowid, body)
+        VALUES ('delete', old.id, old.body);
+    INSERT INTO posts_fts (rowid, body) VALUES (new.id, new.body);
+END;
+
+-- Counters shown on index pages, so that no request runs COUNT(*):
+-- threads.post_count above, posts and threads per user, and forum totals.
+-- The triggers below keep them in the writing transaction; maint/counters
+-- recomputes them offline and reports drift.
+CREATE TABLE IF NOT EXISTS user_stats (
+    user_id INTEGER PRIMARY KEY REFERENCES users (id),
+    thread_count INTEGER NOT NULL DEFAULT 0,
+    post_count INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE TABLE IF NOT EXISTS forum_stats (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    thread_count INTEGER NOT NULL DEFAULT 0,
+    post_count INTEGER NOT NULL DEFAULT 0
+);
+
+INSERT OR IGNORE INTO forum_stats (id) VALUES (1);
+
+CREATE TRIGGER IF NOT EXISTS threads_count_insert AFTER INSERT ON threads
+BEGIN
+    INSERT INTO user_stats (user_id, thread_count) VALUES (new.user_id, 1)
+        ON CONFLICT (user_id) DO UPDATE SET thread_count = thread_count + 1;
+    UPDATE forum_stats SET thread_count = thread_count + 1 WHERE id = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS threads_count_delete AFTER DELETE ON threads
+BEGIN
+    UPDATE user_stats SET thread_count = thread_count - 1
+        WHERE user_id = old.user_id;
+    UPDATE forum_stats SET thread_count = thread_count - 1 WHERE id = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS posts_count_insert AFTER INSERT ON posts BEGIN
+    UPDATE threads SET post_count = post_count + 1 WHERE id = new.thread_id;
+    INSERT INTO user_stats (user_id, post_count) VALUES (new.user_id, 1)
+        ON CONFLICT (user_id) DO UPDATE SET post_count = post_count + 1;
+    UPDATE forum_stats SET post_count = post_count + 1 WHERE id = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS posts_count_delete AFTER DELETE ON posts BEGIN
+    UPDATE threads SET post_count = post_count - 1 WHERE id = old.thread_id;
+    UPDATE user_stats SET post_count = post_count - 1
+        WHERE user_id = old.user_id;
+    UPDATE forum_stats SET post_count = post_count - 1 WHERE id = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS posts_count_move
+AFTER UPDATE OF thread_id, user_id ON posts BEGIN
+    UPDATE threads SET post_count = post_count - 1 WHERE id = old.thread_id;
+    UPDATE threads SET post_count = post_count + 1 WHERE id = new.thread_id;
+    UPDATE user_stats SET post_count = post_count - 1
+        WHERE user_id = old.user_id;
+    INSERT INTO user_stats (user_id, post_count) VALUES (new.user_id, 1)
+        ON CONFLICT (user_id) DO UPDATE SET post_count = post_count + 1;
+END;
+
+-- Writers never merge index segments (automerge 0), so a post insert only
+-- writes its own small segment; maint/fts_maint merges in the background.
+-- crisismerge is the safety net should it stop running.
+INSERT INTO posts_fts (posts_fts, rank) VALUES ('automerge', 0);
+INSERT INTO posts_fts (posts_fts, rank) VALUES ('crisismerge', 64);
 EOF
 
 chown nobody:nogroup /data/sfe.db
@@ -0,0 +1,449 @@
+/**
+ * @file allocprof.c
+ * @brief LD_PRELOAD allocation profiler for the CGI binaries.
+ *
+ * Interposes malloc, calloc, realloc, free, posix_memalign, aligned_alloc
+ * and anonymous mmap/munmap (libsodium maps Argon2's working memory
+ * directly), and appends one JSON line per process, i.e. per CGI request,
+ * when the process exits:
+ *
+ *   {"endpoint":"register","status":"201","error":"","allocs":412,
+ *    "frees":398,"bytes":74562,"peak_live_bytes":51840,"mmaps":1,
+ *    "peak_mapped_bytes":268435456,"max_rss_kb":266712,
+ *    "top":[{"site":"crypto_pwhash+0x6d","allocs":1,"bytes":268435456},...]}
+ *
+ * The endpoint comes from SCRIPT_NAME. status and error are tags the
+ * backend sets through SFE_ALLOCPROF_* environment variables once it sees
+ * SFE_ALLOCPROF_ACTIVE, which the constructor below exports (see
+ * lib/response). Call sites are return addresses resolved with dladdr();
+ * binaries need -rdynamic for their own functions to get names.
+ *
+ * Environment:
+ *   SFE_ALLOCPROF_FILE  append records here instead of stderr
+ *   SFE_ALLOCPROF_TOP   call sites listed per record (default 5)
+ *
+ * Usage (lighttpd): setenv.add-environment = (
+ *     "LD_PRELOAD" => "/app/backend/tools/allocprof.so",
+ *     "SFE_ALLOCPROF_FILE" => "/tmp/allocprof.jsonl" )
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+/** @brief Distinct call sites tracked; later sites count as "other". */
+#define ALLOCPROF_MAX_SITES 512
+
+/** @brief Default number of call sites reported. */
+#define ALLOCPROF_DEFAULT_TOP 5
+
+/** @brief Upper bound for SFE_ALLOCPROF_TOP. */
+#define ALLOCPROF_MAX_TOP 32
+
+/**
+ * @struct site_t
+ * @brief Allocations attributed to one return address.
+ */
+typedef struct {
+        uintptr_t pc;    /**< Return address, 0 if unused */
+        uint64_t allocs; /**< Allocation calls */
+        uint64_t bytes;  /**< Bytes requested */
+} site_t;
+
+static void* (*real_malloc)(size_t)                            = NULL;
+static void* (*real_calloc)(size_t, size_t)                    = NULL;
+static void* (*real_realloc)(void*, size_t)                    = NULL;
+static void (*real_free)(void*)                                = NULL;
+static int (*real_posix_memalign)(void**, size_t, size_t)      = NULL;
+static void* (*real_aligned_alloc)(size_t, size_t)             = NULL;
+static void* (*real_mmap)(void*, size_t, int, int, int, off_t) = NULL;
+static int (*real_munmap)(void*, size_t)                       = NULL;
+
+/*
+ * dlsym() may itself call calloc() before real_calloc is known; serve
+ * those few requests from a static block that free() ignores.
+ */
+static unsigned char bootstrap[4096] __attribute__((aligned(16)));
+static size_t bootstrap_used = 0;
+static bool resolving        = false;
+
+static _Atomic uint64_t n_allocs;
+static _Atomic uint64_t n_frees;
+static _Atomic uint64_t n_mmaps;
+static _Atomic uint64_t n_bytes;
+static _Atomic int64_t live_bytes;
+static _Atomic int64_t peak_live;
+static _Atomic int64_t mapped_bytes;
+static _Atomic int64_t peak_mapped;
+
+static site_t sites[ALLOCPROF_MAX_SITES];
+static site_t other_site;
+static atomic_flag sites_lock = ATOMIC_FLAG_INIT;
+
+/* Set while writing the report so its own allocations are not counted. */
+static bool reporting = false;
+
+/**
+ * @brief Resolve the libc entry points once.
+ */
+static void resolve(void) {
+        if (real_malloc || resolving) return;
+        resolving   = true;
+        real_malloc = (void* (*)(size_t))dlsym(RTLD_NEXT, "malloc");
+        real_calloc = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+        real_realloc =
+            (void* (*)(void*, size_t))dlsym(RTLD_NEXT, "realloc");
+        real_free = (void (*)(void*))dlsym(RTLD_NEXT, "free");
+        real_posix_memalign = (int (*)(void**, size_t, size_t))dlsym(
+            RTLD_NEXT, "posix_memalign");
+        real_aligned_alloc =
+            (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "aligned_alloc");
+        real_mmap = (void* (*)(void*, size_t, int, int, int, off_t))dlsym(
+            RTLD_NEXT, "mmap");
+        real_munmap = (int (*)(void*, size_t))dlsym(RTLD_NEXT, "munmap");
+        resolving   = false;
+        if (!real_malloc || !real_calloc || !real_realloc || !real_free ||
+            !real_mmap || !real_munmap) {
+                fputs("allocprof: cannot resolve libc allocator\n", stderr);
+                abort();
+        }
+}
+
+/**
+ * @brief Allocate from the bootstrap block.
+ * @param size Requested size.
+ * @return Zeroed memory or NULL when exhausted.
+ */
+static void* bootstrap_alloc(size_t size) {
+        size = (size + 15) & ~(size_t)15;
+        if (bootstrap_used + size > sizeof(bootstrap)) return NULL;
+        void* p = bootstrap + bootstrap_used;
+        bootstrap_used += size;
+        return p;
+}
+
+/**
+ * @brief Whether a pointer came from the bootstrap block.
+ * @param p Pointer to test.
+ * @return true if @p p lies inside the block.
+ */
+static bool from_bootstrap(const void* p) {
+        const unsigned char* c = (const unsigned char*)p;
+        return c >= bootstrap && c < bootstrap + sizeof(bootstrap);
+}
+
+/**
+ * @brief Raise a peak to at least @p value.
+ * @param peak Peak to update.
+ * @param value Candidate value.
+ */
+static void raise_peak(_Atomic int64_t* peak, int64_t value) {
+        int64_t cur = atomic_load_explicit(peak, memory_order_relaxed);
+        while (value > cur &&
+               !atomic_compare_exchange_weak_explicit(
+                   peak, &cur, value, memory_order_relaxed,
+                   memory_order_relaxed)) {
+        }
+}
+
+/**
+ * @brief Attribute an allocation to its call site.
+ * @param pc Return address of the allocation call.
+ * @param size Bytes requested.
+ */
+static void note_site(uintptr_t pc, size_t size) {
+        while (atomic_flag_test_and_set_explicit(&sites_lock,
+                                                 memory_order_acquire)) {
+        }
+
+        site_t* s = &other_site;
+        size_t h  = (size_t)((pc >> 4) * 0x9e3779b97f4a7c15ull) %
+                   ALLOCPROF_MAX_SITES;
+        for (size_t i = 0; i < ALLOCPROF_MAX_SITES; ++i) {
+                site_t* c = &sites[(h + i) % ALLOCPROF_MAX_SITES];
+                if (c->pc == pc || c->pc == 0) {
+                        c->pc = pc;
+                        s     = c;
+                        break;
+                }
+        }
+        s->allocs++;
+        s->bytes += size;
+
+        atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+}
+
+/**
+ * @brief Record a successful heap allocation.
+ * @param p New block.
+ * @param size Bytes requested.
+ * @param pc Call site.
+ */
+static void note_alloc(void* p, size_t size, uintptr_t pc) {
+        if (!p || reporting) return;
+        int64_t usable = (int64_t)malloc_usable_size(p);
+        atomic_fetch_add_explicit(&n_allocs, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&n_bytes, size, memory_order_relaxed);
+        raise_peak(&peak_live, atomic_fetch_add_explicit(
+                                   &live_bytes, usable,
+                                   memory_order_relaxed) +
+                                   usable);
+        note_site(pc, size);
+}
+
+/**
+ * @brief Record a heap block about to be released.
+ * @param p Block (nullable).
+ */
+static void note_free(void* p) {
+        if (!p || reporting) return;
+        atomic_fetch_add_explicit(&n_frees, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&live_bytes,
+                                  (int64_t)malloc_usable_size(p),
+                                  memory_order_relaxed);
+}
+
+#define CALLER ((uintptr_t)__builtin_return_address(0))
+
+void* malloc(size_t size) {
+        if (!real_malloc) {
+                if (resolving) return bootstrap_alloc(size);
+                resolve();
+        }
+        void* p = real_malloc(size);
+        note_alloc(p, size, CALLER);
+        return p;
+}
+
+void* calloc(size_t n, size_t size) {
+        if (!real_calloc) {
+                if (resolving) return bootstrap_alloc(n * size);
+                resolve();
+        }
+        void* p = real_calloc(n, size);
+        note_alloc(p, n * size, CALLER);
+        return p;
+}
+
+void* realloc(void* p, size_t size) {
+        if (!real_realloc) resolve();
+        if (from_bootstrap(p)) {
+                /* Bootstrap sizes are not recorded; copy no further than
+                 * the end of the block, which bounds the old allocation. */
+                size_t room = (size_t)(bootstrap + sizeof(bootstrap) -
+                                       (const unsigned char*)p);
+                void* q     = real_malloc(size);
+                if (q) memcpy(q, p, size < room ? size : room);
+                note_alloc(q, size, CALLER);
+                return q;
+        }
+        int64_t old = p ? (int64_t)malloc_usable_size(p) : 0;
+        void* q     = real_realloc(p, size);
+        if (!q) return NULL;
+        if (!reporting) {
+                atomic_fetch_sub_explicit(&live_bytes, old,
+                                          memory_order_relaxed);
+                if (p) atomic_fetch_add_explicit(&n_frees, 1,
+                                                 memory_order_relaxed);
+        }
+        note_alloc(q, size, CALLER);
+        return q;
+}
+
+void free(void* p) {
+        if (!p || from_bootstrap(p)) return;
+        if (!real_free) resolve();
+        note_free(p);
+        real_free(p);
+}
+
+int posix_memalign(void** out, size_t align, size_t size) {
+        if (!real_malloc) resolve();
+        if (!real_posix_memalign) return ENOMEM;
+        int rc = real_posix_memalign(out, align, size);
+        if (rc == 0) note_alloc(*out, size, CALLER);
+        return rc;
+}
+
+void* aligned_alloc(size_t align, size_t size) {
+        if (!real_malloc) resolve();
+        if (!real_aligned_alloc) return NULL;
+        void* p = real_aligned_alloc(align, size);
+        note_alloc(p, size, CALLER);
+        return p;
+}
+
+void* mmap(void* addr, size_t len, int prot, int flags, int fd, off_t off) {
+        if (!real_mmap) resolve();
+        void* p = real_mmap(addr, len, prot, flags, fd, off);
+        if (p != MAP_FAILED && (flags & MAP_ANONYMOUS) && !reporting) {
+                raise_peak(&peak_mapped,
+                           atomic_fetch_add_explicit(&mapped_bytes,
+                                                     (int64_t)len,
+                                                     memory_order_relaxed) +
+                               (int64_t)len);
+                atomic_fetch_add_explicit(&n_mmaps, 1, memory_order_relaxed);
+                note_site(CALLER, len);
+        }
+        return p;
+}
+
+int munmap(void* addr, size_t len) {
+        if (!real_munmap) resolve();
+        int rc = real_munmap(addr, len);
+        /* File mappings are never counted, so clamp instead of tracking
+         * every range. */
+        if (rc == 0 && !reporting &&
+            atomic_fetch_sub_explicit(&mapped_bytes, (int64_t)len,
+                                      memory_order_relaxed) < (int64_t)len)
+                atomic_store_explicit(&mapped_bytes, 0, memory_order_relaxed);
+        return rc;
+}
+
+/**
+ * @brief Print a JSON string value, escaping quotes and backslashes.
+ * @param out Output stream.
+ * @param s String (nullable, printed as "").
+ */
+static void put_json_string(FILE* out, const char* s) {
+        fputc('"', out);
+        for (; s && *s; ++s) {
+                if (*s == '"' || *s == '\\') fputc('\\', out);
+                if ((unsigned char)*s >= 0x20) fputc(*s, out);
+        }
+        fputc('"', out);
+}
+
+/**
+ * @brief Name of the endpoint this process served.
+ * @param buf Output buffer.
+ * @param cap Capacity of @p buf.
+ */
+static void endpoint_name(char* buf, size_t cap) {
+        const char* script = getenv("SCRIPT_NAME");
+        const char* base   = script ? strrchr(script, '/') : NULL;
+        base               = base ? base + 1 : script;
+        if (!base || !*base) base = program_invocation_short_name;
+        snprintf(buf, cap, "%s", base);
+        char* ext = strstr(buf, ".cgi");
+        if (ext) *ext = '\0';
+}
+
+/**
+ * @brief Print one call site as a JSON object.
+ * @param out Output stream.
+ * @param s Call site.
+ */
+static void put_site(FILE* out, const site_t* s) {
+        char name[160] = "other";
+        Dl_info info;
+        if (s != &other_site) {
+                if (dladdr((void*)s->pc, &info) && info.dli_sname)
+                        snprintf(name, sizeof(name), "%s+0x%lx",
+                                 info.dli_sname,
+                                 (unsigned long)(s->pc -
+                                                 (uintptr_t)info.dli_saddr));
+                else if (info.dli_fname)
+                        snprintf(name, sizeof(name), "%s+0x%lx",
+                                 strrchr(info.dli_fname, '/')
+                                     ? strrchr(info.dli_fname, '/') + 1
+                                     : info.dli_fname,
+                                 (unsigned long)(s->pc -
+                                                 (uintptr_t)info.dli_fbase));
+                else
+                        snprintf(name, sizeof(name), "0x%lx",
+                                 (unsigned long)s->pc);
+        }
+        fputs("{\"site\":", out);
+        put_json_string(out, name);
+        fprintf(out, ",\"allocs\":%llu,\"bytes\":%llu}",
+                (unsigned long long)s->allocs,
+                (unsigned long long)s->bytes);
+}
+
+/**
+ * @brief Export SFE_ALLOCPROF_ACTIVE so the backend starts tagging.
+ */
+__attribute__((constructor)) static void allocprof_init(void) {
+        resolve();
+        setenv("SFE_ALLOCPROF_ACTIVE", "1", 1);
+}
+
+/**
+ * @brief Append this process's record.
+ */
+__attribute__((destructor)) static void allocprof_report(void) {
+        reporting = true;
+
+        const char* top_env = getenv("SFE_ALLOCPROF_TOP");
+        int top = top_env ? atoi(top_env) : ALLOCPROF_DEFAULT_TOP;
+        if (top < 0) top = 0;
+        if (top > ALLOCPROF_MAX_TOP) top = ALLOCPROF_MAX_TOP;
+
+        /* Partial selection sort of the heaviest sites by bytes. */
+        const site_t* best[ALLOCPROF_MAX_TOP + 1];
+        int n_best = 0;
+        for (size_t i = 0; i <= ALLOCPROF_MAX_SITES; ++i) {
+                const site_t* s =
+                    i < ALLOCPROF_MAX_SITES ? &sites[i] : &other_site;
+                if (s->allocs == 0) continue;
+                int j = n_best < top ? n_best++ : top;
+                if (j == top && (top == 0 || best[top - 1]->bytes >= s->bytes))
+                        continue;
+                if (j == top) j = top - 1;
+                while (j > 0 && best[j - 1]->bytes < s->bytes) {
+                        best[j] = best[j - 1];
+                        --j;
+                }
+                best[j] = s;
+        }
+
+        struct rusage ru;
+        long max_rss_kb = getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : 0;
+
+        char endpoint[64];
+        endpoint_name(endpoint, sizeof(endpoint));
+
+        const char* path = getenv("SFE_ALLOCPROF_FILE");
+        FILE* out        = path && *path ? fopen(path, "a") : NULL;
+        if (!out) out = stderr;
+
+        /* One fprintf per field, but a single buffered write per record. */
+        char buf[8192];
+        setvbuf(out, buf, _IOFBF, sizeof(buf));
+
+        fputs("{\"endpoint\":", out);
+        put_json_string(out, endpoint);
+        fputs(",\"status\":", out);
+        put_json_string(out, getenv("SFE_ALLOCPROF_STATUS"));
+        fputs(",\"error\":", out);
+        put_json_string(out, getenv("SFE_ALLOCPROF_ERROR"));
+        fprintf(out,
+                ",\"allocs\":%llu,\"frees\":%llu,\"bytes\":%llu,"
+                "\"peak_live_bytes\":%lld,\"mmaps\":%llu,"
+                "\"peak_mapped_bytes\":%lld,\"max_rss_kb\":%ld,\"top\":[",
+                (unsigned long long)n_allocs, (unsigned long long)n_frees,
+                (unsigned long long)n_bytes, (long long)peak_live,
+                (unsigned long long)n_mmaps, (long long)peak_mapped,
+                max_rss_kb);
+        for (int i = 0; i < n_best; ++i) {
+                if (i) fputc(',', out);
+                put_site(out, best[i]);
+        }
+        fputs("]}\n", out);
+
+        if (out != stderr)
+                fclose(out);
+        else
+                fflush(out);
+}
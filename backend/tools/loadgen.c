@@ -0,0 +1,891 @@
+/**
+ * @file loadgen.c
+ * @brief Native load generator for the backend API.
+ *
+ * Drives a weighted mix of scenarios against a running instance:
+ *
+ *  - csrf:      GET csrf.cgi
+ *  - register:  GET csrf.cgi, then POST register.cgi with a fresh username
+ *  - duplicate: GET csrf.cgi, then POST register.cgi with a taken username
+ *  - badcsrf:   POST register.cgi with a well-formed but forged token
+ *
+ * With -r 0 every worker is closed-loop (next request as soon as the
+ * previous one finishes). With -r N arrivals are open-loop: each worker
+ * follows a Poisson schedule at N / concurrency req/s, and latency is
+ * measured from the scheduled start, so a stalled server shows up as queueing
+ * delay instead of silently lowering the offered load.
+ *
+ * Latencies go into log-linear histograms (~1.6% resolution, HDR-style). The
+ * report is one JSON object on stdout with throughput, per-scenario
+ * percentiles, status-code and transport-error breakdowns, and the peak /
+ * mean RSS of the server processes named with -P (or pids given with -p).
+ *
+ * The target is any base URL, so the same run can be pointed at each
+ * deployment mode and compared; -l labels the report.
+ *
+ * Usage:
+ *   loadgen -u http://localhost:8080/api [-c 8] [-r 0] [-d 10]
+ *           [-m register:70,duplicate:20,badcsrf:10] [-P lighttpd] [-p pid]
+ *           [-l label] [-t timeout_ms]
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @brief Largest response kept per request (headers + body). */
+#define RESP_BUF_SIZE 8192
+
+/**
+ * @brief Histogram precision: values below HIST_SUB_COUNT are exact, above
+ * that each power of two is split into HIST_SUB_COUNT / 2 buckets.
+ */
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+
+/** @brief Highest power of two tracked (2^40 us is ~12 days). */
+#define HIST_MAX_EXP 40
+#define HIST_BUCKETS \
+        ((HIST_MAX_EXP - HIST_SUB_BITS + 3) * (HIST_SUB_COUNT / 2))
+
+/** @brief Hex length of a CSRF token (CSRF_TOKEN_HEX_SIZE in lib/csrf). */
+#define CSRF_TOKEN_HEX_LEN 144
+
+/** @brief Upper bounds on command-line lists. */
+#define MAX_THREADS 1024
+#define MAX_PIDS 16
+#define MAX_NAMES 8
+
+/** @brief RSS sampling period. */
+#define RSS_SAMPLE_MS 100
+
+/**
+ * @enum scenario
+ * @brief Request mixes the generator can issue.
+ */
+typedef enum scenario {
+        SCEN_CSRF = 0,  /**< Fetch a CSRF token */
+        SCEN_REGISTER,  /**< Token + successful registration */
+        SCEN_DUPLICATE, /**< Token + registration of a taken name */
+        SCEN_BAD_CSRF,  /**< Registration with a forged token */
+        SCEN_COUNT
+} scenario_t;
+
+static const char* const scenario_names[SCEN_COUNT] = {
+    "csrf", "register", "duplicate", "badcsrf"};
+
+/** @brief HTTP status each scenario's final request should return. */
+static const int scenario_expected[SCEN_COUNT] = {200, 201, 400, 400};
+
+/**
+ * @enum transport_error
+ * @brief Failures below the HTTP layer.
+ */
+typedef enum transport_error {
+        TERR_CONNECT = 0, /**< socket/connect failed or timed out */
+        TERR_SEND,        /**< Request could not be written */
+        TERR_RECV,        /**< Read failed or timed out */
+        TERR_PARSE,       /**< No status line / token in the response */
+        TERR_COUNT
+} transport_error_t;
+
+static const char* const transport_error_names[TERR_COUNT] = {
+    "connect", "send", "recv", "parse"};
+
+/**
+ * @struct histogram_t
+ * @brief Log-linear latency histogram in microseconds.
+ */
+typedef struct {
+        uint64_t counts[HIST_BUCKETS]; /**< Samples per bucket */
+        uint64_t total;                /**< Number of samples */
+        uint64_t max;                  /**< Largest sample */
+        double sum;                    /**< Sum of samples */
+} histogram_t;
+
+/**
+ * @struct scenario_stats_t
+ * @brief Outcome counters for one scenario.
+ */
+typedef struct {
+        histogram_t latency;            /**< End-to-end latency */
+        uint64_t ok;                    /**< Expected status received */
+        uint64_t status[600];           /**< Final HTTP status counts */
+        uint64_t transport[TERR_COUNT]; /**< Transport failures */
+} scenario_stats_t;
+
+/**
+ * @struct worker_t
+ * @brief Per-thread state; merged after the run.
+ */
+typedef struct {
+        pthread_t thread;                   /**< Thread handle */
+        unsigned int id;                    /**< Worker index */
+        uint64_t rng;                       /**< xorshift64 state */
+        scenario_stats_t stats[SCEN_COUNT]; /**< Per-scenario outcomes */
+} worker_t;
+
+/**
+ * @struct config_t
+ * @brief Parsed command line.
+ */
+typedef struct {
+        char host[256];                   /**< Target host */
+        char port[8];                     /**< Target port */
+        char prefix[256];                 /**< Path prefix, e.g. "/api" */
+        const char* url;                  /**< Base URL as given */
+        const char* label;                /**< Free-form report label */
+        unsigned int concurrency;         /**< Worker threads */
+        double rate;                      /**< Arrivals/s, 0 = closed loop */
+        double duration;                  /**< Run length in seconds */
+        int timeout_ms;                   /**< Per-socket-operation timeout */
+        unsigned int weights[SCEN_COUNT]; /**< Mix weights */
+        unsigned int weight_total;        /**< Sum of weights */
+        pid_t pids[MAX_PIDS];             /**< Server pids for RSS */
+        size_t n_pids;                    /**< Number of pids */
+        const char* names[MAX_NAMES];     /**< Process names for RSS */
+        size_t n_names;                   /**< Number of names */
+} config_t;
+
+static config_t cfg;
+static struct addrinfo* target_addr = NULL;
+static char run_id[4];
+static char dup_username[16];
+static atomic_uint_fast64_t username_seq;
+static atomic_bool stop_sampler;
+
+/* RSS samples, written by the sampler thread only. */
+static uint64_t rss_peak_kb = 0;
+static double rss_sum_kb    = 0;
+static uint64_t rss_samples = 0;
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ * @return Current time in ns.
+ */
+static uint64_t now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Sleep until an absolute monotonic time.
+ * @param deadline_ns Wake-up time in ns.
+ */
+static void sleep_until(uint64_t deadline_ns) {
+        struct timespec ts = {
+            .tv_sec  = (time_t)(deadline_ns / 1000000000ull),
+            .tv_nsec = (long)(deadline_ns % 1000000000ull),
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+               EINTR) {
+        }
+}
+
+/**
+ * @brief xorshift64 step.
+ * @param state Generator state (non-zero).
+ * @return Next pseudo-random value.
+ */
+static uint64_t rng_next(uint64_t* state) {
+        uint64_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return *state = x;
+}
+
+/**
+ * @brief Uniform double in (0, 1].
+ * @param state Generator state.
+ * @return Random value.
+ */
+static double rng_unit(uint64_t* state) {
+        return ((double)(rng_next(state) >> 11) + 1.0) / 9007199254740992.0;
+}
+
+/**
+ * @brief Map a latency to its histogram bucket.
+ * @param us Latency in microseconds.
+ * @return Bucket index.
+ */
+static size_t hist_index(uint64_t us) {
+        if (us < HIST_SUB_COUNT) return (size_t)us;
+        unsigned int msb = 63u - (unsigned int)__builtin_clzll(us);
+        if (msb > HIST_MAX_EXP) return HIST_BUCKETS - 1;
+        unsigned int shift = msb - HIST_SUB_BITS + 1;
+        size_t sub         = (size_t)(us >> shift) - HIST_SUB_COUNT / 2;
+        return (size_t)shift * (HIST_SUB_COUNT / 2) + HIST_SUB_COUNT / 2 +
+               sub;
+}
+
+/**
+ * @brief Highest latency that maps to a bucket.
+ * @param idx Bucket index.
+ * @return Upper bound in microseconds.
+ */
+static uint64_t hist_upper(size_t idx) {
+        if (idx < HIST_SUB_COUNT) return (uint64_t)idx;
+        size_t half        = HIST_SUB_COUNT / 2;
+        unsigned int shift = (unsigned int)((idx - half) / half);
+        uint64_t sub       = (uint64_t)((idx - half) % half) + half;
+        return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * @brief Record one latency sample.
+ * @param h Histogram.
+ * @param us Latency in microseconds.
+ */
+static void hist_record(histogram_t* h, uint64_t us) {
+        size_t idx = hist_index(us);
+        if (idx >= HIST_BUCKETS) idx = HIST_BUCKETS - 1;
+        h->counts[idx]++;
+        h->total++;
+        h->sum += (double)us;
+        if (us > h->max) h->max = us;
+}
+
+/**
+ * @brief Add one histogram into another.
+ * @param dst Accumulator.
+ * @param src Histogram to add.
+ */
+static void hist_merge(histogram_t* dst, const histogram_t* src) {
+        for (size_t i = 0; i < HIST_BUCKETS; ++i)
+                dst->counts[i] += src->counts[i];
+        dst->total += src->total;
+        dst->sum += src->sum;
+        if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * @brief Latency at a percentile (bucket upper bound, capped at max).
+ * @param h Histogram.
+ * @param pct Percentile in [0, 100].
+ * @return Latency in microseconds.
+ */
+static uint64_t hist_percentile(const histogram_t* h, double pct) {
+        if (h->total == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(pct / 100.0 * (double)h->total);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HIST_BUCKETS; ++i) {
+                seen += h->counts[i];
+                if (seen >= rank) {
+                        uint64_t v = hist_upper(i);
+                        return v < h->max ? v : h->max;
+                }
+        }
+        return h->max;
+}
+
+/**
+ * @brief Split http://host[:port][/prefix] into cfg fields.
+ * @param url Base URL.
+ * @return true on success.
+ */
+static bool parse_url(const char* url) {
+        const char* p = url;
+        if (strncmp(p, "http://", 7) != 0) return false;
+        p += 7;
+
+        const char* host_end = p + strcspn(p, ":/");
+        size_t host_len      = (size_t)(host_end - p);
+        if (host_len == 0 || host_len >= sizeof(cfg.host)) return false;
+        memcpy(cfg.host, p, host_len);
+        cfg.host[host_len] = '\0';
+        p                  = host_end;
+
+        snprintf(cfg.port, sizeof(cfg.port), "80");
+        if (*p == ':') {
+                ++p;
+                size_t port_len = strcspn(p, "/");
+                if (port_len == 0 || port_len >= sizeof(cfg.port))
+                        return false;
+                memcpy(cfg.port, p, port_len);
+                cfg.port[port_len] = '\0';
+                p += port_len;
+        }
+
+        size_t prefix_len = strlen(p);
+        while (prefix_len > 0 && p[prefix_len - 1] == '/') --prefix_len;
+        if (prefix_len >= sizeof(cfg.prefix)) return false;
+        memcpy(cfg.prefix, p, prefix_len);
+        cfg.prefix[prefix_len] = '\0';
+        return true;
+}
+
+/**
+ * @brief Parse a mix such as "register:70,badcsrf:30".
+ * @param spec Mix specification.
+ * @return true on success.
+ */
+static bool parse_mix(const char* spec) {
+        memset(cfg.weights, 0, sizeof(cfg.weights));
+        cfg.weight_total = 0;
+
+        char buf[256];
+        if (strlen(spec) >= sizeof(buf)) return false;
+        strcpy(buf, spec);
+
+        char* save = NULL;
+        for (char* tok = strtok_r(buf, ",", &save); tok;
+             tok       = strtok_r(NULL, ",", &save)) {
+                char* colon = strchr(tok, ':');
+                if (!colon) return false;
+                *colon = '\0';
+
+                int scen = -1;
+                for (int i = 0; i < SCEN_COUNT; ++i)
+                        if (strcmp(tok, scenario_names[i]) == 0) scen = i;
+                if (scen < 0) return false;
+
+                unsigned long w = strtoul(colon + 1, NULL, 10);
+                cfg.weights[scen] += (unsigned int)w;
+                cfg.weight_total += (unsigned int)w;
+        }
+        return cfg.weight_total > 0;
+}
+
+/**
+ * @brief Issue one HTTP/1.1 request on a fresh connection.
+ * @param method "GET" or "POST".
+ * @param endpoint Path below the prefix, e.g. "csrf.cgi".
+ * @param body Request body (NULL for none).
+ * @param resp Buffer receiving the raw response (NUL-terminated).
+ * @param status Receives the HTTP status code.
+ * @return -1 on success, otherwise a transport_error_t.
+ */
+static int http_request(const char* method, const char* endpoint,
+                        const char* body, char* resp, int* status) {
+        int fd = socket(target_addr->ai_family, target_addr->ai_socktype,
+                        target_addr->ai_protocol);
+        if (fd < 0) return TERR_CONNECT;
+
+        struct timeval tv = {
+            .tv_sec  = cfg.timeout_ms / 1000,
+            .tv_usec = (cfg.timeout_ms % 1000) * 1000,
+        };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        if (connect(fd, target_addr->ai_addr, target_addr->ai_addrlen) != 0) {
+                close(fd);
+                return TERR_CONNECT;
+        }
+
+        char req[1024];
+        size_t body_len = body ? strlen(body) : 0;
+        int req_len     = snprintf(req, sizeof(req),
+                                   "%s %s/%s HTTP/1.1\r\n"
+                                   "Host: %s:%s\r\n"
+                                   "Content-Type: application/json\r\n"
+                                   "Content-Length: %zu\r\n"
+                                   "Connection: close\r\n\r\n%s",
+                                   method, cfg.prefix, endpoint, cfg.host,
+                                   cfg.port, body_len, body ? body : "");
+        if (req_len < 0 || (size_t)req_len >= sizeof(req)) {
+                close(fd);
+                return TERR_SEND;
+        }
+
+        for (int sent = 0; sent < req_len;) {
+                ssize_t n = send(fd, req + sent, (size_t)(req_len - sent),
+                                 MSG_NOSIGNAL);
+                if (n <= 0) {
+                        close(fd);
+                        return TERR_SEND;
+                }
+                sent += (int)n;
+        }
+
+        size_t used = 0;
+        for (;;) {
+                if (used == RESP_BUF_SIZE - 1) {
+                        /* Keep draining so the server is not blocked. */
+                        char sink[1024];
+                        ssize_t n = recv(fd, sink, sizeof(sink), 0);
+                        if (n <= 0) break;
+                        continue;
+                }
+                ssize_t n = recv(fd, resp + used, RESP_BUF_SIZE - 1 - used, 0);
+                if (n == 0) break;
+                if (n < 0) {
+                        close(fd);
+                        return TERR_RECV;
+                }
+                used += (size_t)n;
+        }
+        close(fd);
+        resp[used] = '\0';
+
+        if (sscanf(resp, "HTTP/%*d.%*d %d", status) != 1 || *status < 100 ||
+            *status > 599)
+                return TERR_PARSE;
+        return -1;
+}
+
+/**
+ * @brief Pull the token out of a csrf.cgi response.
+ * @param resp Raw HTTP response.
+ * @param token Output buffer.
+ * @param cap Capacity of @p token.
+ * @return true if a token was found.
+ */
+static bool extract_token(const char* resp, char* token, size_t cap) {
+        const char* start = strstr(resp, "\"messages\"");
+        if (!start || !(start = strchr(start, '['))) return false;
+        if (!(start = strchr(start, '"'))) return false;
+        ++start;
+        size_t len = strcspn(start, "\"");
+        if (len == 0 || len >= cap) return false;
+        memcpy(token, start, len);
+        token[len] = '\0';
+        return true;
+}
+
+/**
+ * @brief Write a fresh 12-character alphanumeric username.
+ * @param out Buffer of at least 13 bytes.
+ */
+static void next_username(char* out) {
+        static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        uint64_t seq               = atomic_fetch_add(&username_seq, 1);
+        char* p                    = out;
+        *p++                       = 'l';
+        *p++                       = 'g';
+        memcpy(p, run_id, 3);
+        p += 3;
+        for (int i = 6; i >= 0; --i) {
+                p[i] = digits[seq % 36];
+                seq /= 36;
+        }
+        p[7] = '\0';
+}
+
+/**
+ * @brief Run one scenario end to end.
+ * @param scen Scenario.
+ * @param resp Scratch response buffer.
+ * @param status Receives the final HTTP status.
+ * @return -1 on success, otherwise a transport_error_t.
+ */
+static int run_scenario(scenario_t scen, char* resp, int* status) {
+        char token[512];
+        char body[1024];
+
+        if (scen == SCEN_BAD_CSRF) {
+                /* Right length and alphabet, wrong HMAC. */
+                char forged[CSRF_TOKEN_HEX_LEN + 1];
+                memset(forged, '0', CSRF_TOKEN_HEX_LEN);
+                forged[CSRF_TOKEN_HEX_LEN] = '\0';
+                snprintf(body, sizeof(body),
+                         "{\"csrf\":\"%s\",\"username\":\"lgforged\","
+                         "\"password\":\"hunter22\"}",
+                         forged);
+                return http_request("POST", "register.cgi", body, resp,
+                                    status);
+        }
+
+        int err = http_request("GET", "csrf.cgi", NULL, resp, status);
+        if (err >= 0 || scen == SCEN_CSRF) return err;
+        if (*status != 200 || !extract_token(resp, token, sizeof(token)))
+                return TERR_PARSE;
+
+        char username[16];
+        if (scen == SCEN_DUPLICATE)
+                snprintf(username, sizeof(username), "%s", dup_username);
+        else
+                next_username(username);
+
+        snprintf(body, sizeof(body),
+                 "{\"csrf\":\"%s\",\"username\":\"%s\","
+                 "\"password\":\"hunter22\"}",
+                 token, username);
+        return http_request("POST", "register.cgi", body, resp, status);
+}
+
+/**
+ * @brief Pick a scenario according to the mix weights.
+ * @param rng Generator state.
+ * @return Scenario.
+ */
+static scenario_t pick_scenario(uint64_t* rng) {
+        unsigned int r = (unsigned int)(rng_next(rng) % cfg.weight_total);
+        for (int i = 0; i < SCEN_COUNT; ++i) {
+                if (r < cfg.weights[i]) return (scenario_t)i;
+                r -= cfg.weights[i];
+        }
+        return SCEN_CSRF;
+}
+
+/** @brief Common start time for every worker. */
+static uint64_t run_start_ns;
+
+/**
+ * @brief Worker loop.
+ * @param arg worker_t.
+ * @return NULL.
+ */
+static void* worker_main(void* arg) {
+        worker_t* w = arg;
+        char* resp  = malloc(RESP_BUF_SIZE);
+        if (!resp) return NULL;
+
+        uint64_t end_ns  = run_start_ns + (uint64_t)(cfg.duration * 1e9);
+        double per_rate  = cfg.rate / (double)cfg.concurrency;
+        uint64_t next_ns = run_start_ns;
+
+        for (;;) {
+                uint64_t start_ns;
+                if (per_rate > 0.0) {
+                        double gap_s = -log(rng_unit(&w->rng)) / per_rate;
+                        next_ns += (uint64_t)(gap_s * 1e9);
+                        if (next_ns >= end_ns) break;
+                        sleep_until(next_ns);
+                        start_ns = next_ns;
+                } else {
+                        start_ns = now_ns();
+                        if (start_ns >= end_ns) break;
+                }
+
+                scenario_t scen     = pick_scenario(&w->rng);
+                scenario_stats_t* s = &w->stats[scen];
+                int status          = 0;
+                int err             = run_scenario(scen, resp, &status);
+
+                hist_record(&s->latency, (now_ns() - start_ns) / 1000);
+                if (err >= 0) {
+                        s->transport[err]++;
+                        continue;
+                }
+                s->status[status]++;
+                if (status == scenario_expected[scen]) s->ok++;
+        }
+
+        free(resp);
+        return NULL;
+}
+
+/**
+ * @brief Read VmRSS of a process.
+ * @param pid Process id.
+ * @return RSS in kB, or 0 if unavailable.
+ */
+static uint64_t read_rss_kb(pid_t pid) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+        FILE* f = fopen(path, "r");
+        if (!f) return 0;
+
+        char line[256];
+        uint64_t kb = 0;
+        while (fgets(line, sizeof(line), f)) {
+                if (sscanf(line, "VmRSS: %llu", (unsigned long long*)&kb) == 1)
+                        break;
+        }
+        fclose(f);
+        return kb;
+}
+
+/**
+ * @brief Whether a process's comm matches one of the -P names.
+ * @param pid Process id.
+ * @return true on match.
+ */
+static bool comm_matches(pid_t pid) {
+        char path[64];
+        char comm[64];
+        snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+        FILE* f = fopen(path, "r");
+        if (!f) return false;
+        bool ok = fgets(comm, sizeof(comm), f) != NULL;
+        fclose(f);
+        if (!ok) return false;
+        comm[strcspn(comm, "\n")] = '\0';
+        for (size_t i = 0; i < cfg.n_names; ++i)
+                if (strncmp(comm, cfg.names[i], 15) == 0) return true;
+        return false;
+}
+
+/**
+ * @brief Sum RSS over the selected server processes.
+ * @return Total RSS in kB.
+ */
+static uint64_t sample_rss_kb(void) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < cfg.n_pids; ++i)
+                total += read_rss_kb(cfg.pids[i]);
+
+        if (cfg.n_names == 0) return total;
+        DIR* proc = opendir("/proc");
+        if (!proc) return total;
+        struct dirent* de;
+        while ((de = readdir(proc))) {
+                char* end = NULL;
+                long pid  = strtol(de->d_name, &end, 10);
+                if (*end != '\0' || pid <= 0) continue;
+                if (comm_matches((pid_t)pid)) total += read_rss_kb((pid_t)pid);
+        }
+        closedir(proc);
+        return total;
+}
+
+/**
+ * @brief RSS sampler thread.
+ * @param arg Unused.
+ * @return NULL.
+ */
+static void* sampler_main(void* arg) {
+        (void)arg;
+        while (!atomic_load(&stop_sampler)) {
+                uint64_t kb = sample_rss_kb();
+                if (kb > rss_peak_kb) rss_peak_kb = kb;
+                rss_sum_kb += (double)kb;
+                rss_samples++;
+                sleep_until(now_ns() + RSS_SAMPLE_MS * 1000000ull);
+        }
+        return NULL;
+}
+
+/**
+ * @brief Print the JSON report.
+ * @param totals Merged per-scenario statistics.
+ * @param elapsed_s Wall-clock run time.
+ */
+static void report(const scenario_stats_t* totals, double elapsed_s) {
+        histogram_t all = {0};
+        uint64_t ok     = 0;
+        for (int i = 0; i < SCEN_COUNT; ++i) {
+                hist_merge(&all, &totals[i].latency);
+                ok += totals[i].ok;
+        }
+
+        printf("{\"label\":\"%s\",\"url\":\"%s\",\"concurrency\":%u,"
+               "\"rate\":%.1f,\"mode\":\"%s\",\"duration_s\":%.2f,"
+               "\"scenarios_run\":%llu,\"ok\":%llu,\"throughput_rps\":%.1f,",
+               cfg.label, cfg.url, cfg.concurrency, cfg.rate,
+               cfg.rate > 0.0 ? "open" : "closed", elapsed_s,
+               (unsigned long long)all.total, (unsigned long long)ok,
+               (double)all.total / elapsed_s);
+        printf("\"latency_us\":{\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+               "\"p999\":%llu,\"max\":%llu},",
+               (unsigned long long)hist_percentile(&all, 50),
+               (unsigned long long)hist_percentile(&all, 90),
+               (unsigned long long)hist_percentile(&all, 99),
+               (unsigned long long)hist_percentile(&all, 99.9),
+               (unsigned long long)all.max);
+
+        printf("\"scenarios\":[");
+        bool first_scen = true;
+        for (int i = 0; i < SCEN_COUNT; ++i) {
+                const scenario_stats_t* s = &totals[i];
+                if (s->latency.total == 0) continue;
+                printf("%s{\"name\":\"%s\",\"count\":%llu,\"ok\":%llu,"
+                       "\"mean_us\":%.0f,\"p50_us\":%llu,\"p90_us\":%llu,"
+                       "\"p99_us\":%llu,\"p999_us\":%llu,\"max_us\":%llu,"
+                       "\"status\":{",
+                       first_scen ? "" : ",", scenario_names[i],
+                       (unsigned long long)s->latency.total,
+                       (unsigned long long)s->ok,
+                       s->latency.sum / (double)s->latency.total,
+                       (unsigned long long)hist_percentile(&s->latency, 50),
+                       (unsigned long long)hist_percentile(&s->latency, 90),
+                       (unsigned long long)hist_percentile(&s->latency, 99),
+                       (unsigned long long)hist_percentile(&s->latency, 99.9),
+                       (unsigned long long)s->latency.max);
+                first_scen = false;
+
+                bool first = true;
+                for (int code = 100; code < 600; ++code) {
+                        if (!s->status[code]) continue;
+                        printf("%s\"%d\":%llu", first ? "" : ",", code,
+                               (unsigned long long)s->status[code]);
+                        first = false;
+                }
+                printf("},\"transport_errors\":{");
+                for (int e = 0; e < TERR_COUNT; ++e) {
+                        printf("%s\"%s\":%llu", e ? "," : "",
+                               transport_error_names[e],
+                               (unsigned long long)s->transport[e]);
+                }
+                printf("}}");
+        }
+        printf("],");
+
+        printf("\"server_rss_kb\":{\"peak\":%llu,\"mean\":%.0f,"
+               "\"samples\":%llu}}\n",
+               (unsigned long long)rss_peak_kb,
+               rss_samples ? rss_sum_kb / (double)rss_samples : 0.0,
+               (unsigned long long)rss_samples);
+}
+
+/**
+ * @brief Print usage and exit.
+ * @param argv0 Program name.
+ */
+static void usage(const char* argv0) {
+        fprintf(stderr,
+                "usage: %s -u http://host:port/prefix [-c concurrency] "
+                "[-r rate] [-d seconds]\n"
+                "          [-m csrf:N,register:N,duplicate:N,badcsrf:N] "
+                "[-p pid]... [-P name]...\n"
+                "          [-l label] [-t timeout_ms]\n",
+                argv0);
+        exit(2);
+}
+
+int main(int argc, char** argv) {
+        cfg.url         = "http://localhost:8080/api";
+        cfg.label       = "";
+        cfg.concurrency = 8;
+        cfg.rate        = 0.0;
+        cfg.duration    = 10.0;
+        cfg.timeout_ms  = 10000;
+        parse_mix("register:70,duplicate:20,badcsrf:10");
+
+        int opt;
+        while ((opt = getopt(argc, argv, "u:c:r:d:m:p:P:l:t:h")) != -1) {
+                switch (opt) {
+                        case 'u':
+                                cfg.url = optarg;
+                                break;
+                        case 'c':
+                                cfg.concurrency =
+                                    (unsigned int)strtoul(optarg, NULL, 10);
+                                break;
+                        case 'r':
+                                cfg.rate = strtod(optarg, NULL);
+                                break;
+                        case 'd':
+                                cfg.duration = strtod(optarg, NULL);
+                                break;
+                        case 'm':
+                                if (!parse_mix(optarg)) usage(argv[0]);
+                                break;
+                        case 'p':
+                                if (cfg.n_pids == MAX_PIDS) usage(argv[0]);
+                                cfg.pids[cfg.n_pids++] =
+                                    (pid_t)strtol(optarg, NULL, 10);
+                                break;
+                        case 'P':
+                                if (cfg.n_names == MAX_NAMES) usage(argv[0]);
+                                cfg.names[cfg.n_names++] = optarg;
+                                break;
+                        case 'l':
+                                cfg.label = optarg;
+                                break;
+                        case 't':
+                                cfg.timeout_ms = atoi(optarg);
+                                break;
+                        default:
+                                usage(argv[0]);
+                }
+        }
+
+        if (!parse_url(cfg.url) || cfg.concurrency == 0 ||
+            cfg.concurrency > MAX_THREADS || cfg.duration <= 0.0 ||
+            cfg.rate < 0.0 || cfg.timeout_ms <= 0)
+                usage(argv[0]);
+
+        struct addrinfo hints = {0};
+        hints.ai_family       = AF_UNSPEC;
+        hints.ai_socktype     = SOCK_STREAM;
+        int gai = getaddrinfo(cfg.host, cfg.port, &hints, &target_addr);
+        if (gai != 0) {
+                fprintf(stderr, "loadgen: %s: %s\n", cfg.host,
+                        gai_strerror(gai));
+                return 1;
+        }
+
+        static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        uint64_t seed              = now_ns() ^ ((uint64_t)getpid() << 32);
+        for (int i = 0; i < 3; ++i) run_id[i] = digits[(seed >> (i * 6)) % 36];
+        run_id[3] = '\0';
+        snprintf(dup_username, sizeof(dup_username), "lgdup%s", run_id);
+
+        /* Make sure the duplicate target exists before timing starts. */
+        if (cfg.weights[SCEN_DUPLICATE] > 0) {
+                char* resp = malloc(RESP_BUF_SIZE);
+                char token[512];
+                char body[1024];
+                int status = 0;
+                if (resp &&
+                    http_request("GET", "csrf.cgi", NULL, resp, &status) < 0 &&
+                    extract_token(resp, token, sizeof(token))) {
+                        snprintf(body, sizeof(body),
+                                 "{\"csrf\":\"%s\",\"username\":\"%s\","
+                                 "\"password\":\"hunter22\"}",
+                                 token, dup_username);
+                        http_request("POST", "register.cgi", body, resp,
+                                     &status);
+                }
+                free(resp);
+        }
+
+        worker_t* workers = calloc(cfg.concurrency, sizeof(worker_t));
+        if (!workers) {
+                fprintf(stderr, "loadgen: out of memory\n");
+                return 1;
+        }
+
+        pthread_t sampler;
+        bool sampling = cfg.n_pids > 0 || cfg.n_names > 0;
+        if (sampling) pthread_create(&sampler, NULL, sampler_main, NULL);
+
+        run_start_ns = now_ns();
+        for (unsigned int i = 0; i < cfg.concurrency; ++i) {
+                workers[i].id  = i;
+                workers[i].rng = (seed + 0x9e3779b97f4a7c15ull * (i + 1)) | 1;
+                pthread_create(&workers[i].thread, NULL, worker_main,
+                               &workers[i]);
+        }
+        for (unsigned int i = 0; i < cfg.concurrency; ++i)
+                pthread_join(workers[i].thread, NULL);
+        double elapsed_s = (double)(now_ns() - run_start_ns) / 1e9;
+
+        if (sampling) {
+                atomic_store(&stop_sampler, true);
+                pthread_join(sampler, NULL);
+        }
+
+        scenario_stats_t* totals = calloc(SCEN_COUNT, sizeof(*totals));
+        if (!totals) {
+                fprintf(stderr, "loadgen: out of memory\n");
+                return 1;
+        }
+        for (unsigned int i = 0; i < cfg.concurrency; ++i) {
+                for (int s = 0; s < SCEN_COUNT; ++s) {
+                        const scenario_stats_t* src = &workers[i].stats[s];
+                        hist_merge(&totals[s].latency, &src->latency);
+                        totals[s].ok += src->ok;
+                        for (int c = 0; c < 600; ++c)
+                                totals[s].status[c] += src->status[c];
+                        for (int e = 0; e < TERR_COUNT; ++e)
+                                totals[s].transport[e] += src->transport[e];
+                }
+        }
+
+        report(totals, elapsed_s);
+
+        free(totals);
+        free(workers);
+        freeaddrinfo(target_addr);
+        return 0;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file trace_stats.c
+ * @brief Aggregates SFE_TRACE_FILE records into per-phase latency stats.
+ *
+ * Reads the binary records written by lib/timing (one per request) and
+ * prints one JSON object per endpoint and phase, plus a "total" phase per
+ * endpoint covering the whole request:
+ *
+ *   {"endpoint":"register","phase":"argon2","count":812,"mean_ms":211.4,
+ *    "p50_ms":209.8,"p90_ms":224.0,"p99_ms":251.3,"max_ms":270.9}
+ *
+ * Usage:
+ *   trace_stats [-e endpoint] [trace_file ...]   (stdin if no file given)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "/app/backend/lib/timing/timing.h"
+
+/** @brief Upper bound on distinct endpoint/phase pairs. */
+#define MAX_SERIES 256
+
+/**
+ * @struct series_t
+ * @brief All durations seen for one endpoint/phase pair.
+ */
+typedef struct {
+        char endpoint[TIMING_NAME_SIZE]; /**< NUL-terminated endpoint */
+        char phase[TIMING_NAME_SIZE];    /**< NUL-terminated phase */
+        uint32_t* us;                    /**< Durations in microseconds */
+        size_t count;                    /**< Durations stored */
+        size_t cap;                      /**< Capacity of us */
+} series_t;
+
+static series_t series[MAX_SERIES];
+static size_t series_count         = 0;
+static const char* endpoint_filter = NULL;
+static uint64_t bad_records        = 0;
+
+/**
+ * @brief Find or create the series for an endpoint/phase pair.
+ * @param endpoint NUL-padded endpoint name (TIMING_NAME_SIZE bytes).
+ * @param phase NUL-padded phase name (TIMING_NAME_SIZE bytes).
+ * @return Series, or NULL if MAX_SERIES is exhausted.
+ */
+static series_t* series_get(const char* endpoint, const char* phase) {
+        for (size_t i = 0; i < series_count; ++i) {
+                if (strncmp(series[i].endpoint, endpoint, TIMING_NAME_SIZE) ==
+                        0 &&
+                    strncmp(series[i].phase, phase, TIMING_NAME_SIZE) == 0)
+                        return &series[i];
+        }
+        if (series_count == MAX_SERIES) return NULL;
+
+        series_t* s = &series[series_count++];
+        memcpy(s->endpoint, endpoint, TIMING_NAME_SIZE);
+        memcpy(s->phase, phase, TIMING_NAME_SIZE);
+        s->endpoint[TIMING_NAME_SIZE - 1] = '\0';
+        s->phase[TIMING_NAME_SIZE - 1]    = '\0';
+        return s;
+}
+
+/**
+ * @brief Append one duration to a series.
+ * @param s Series (nullable).
+ * @param us Duration in microseconds.
+ * @return false on allocation failure.
+ */
+static bool series_add(series_t* s, uint32_t us) {
+        if (!s) return true;
+        if (s->count == s->cap) {
+                size_t cap       = s->cap ? s->cap * 2 : 256;
+                uint32_t* us_new = realloc(s->us, cap * sizeof(*s->us));
+                if (!us_new) return false;
+                s->us  = us_new;
+                s->cap = cap;
+        }
+        s->us[s->count++] = us;
+        return true;
+}
+
+/**
+ * @brief Read exactly @p len bytes.
+ * @param f Input stream.
+ * @param buf Destination.
+ * @param len Bytes to read.
+ * @return true if all bytes were read.
+ */
+static bool read_exact(FILE* f, void* buf, size_t len) {
+        return fread(buf, 1, len, f) == len;
+}
+
+/**
+ * @brief Consume every record in a stream.
+ *
+ * Stops at the first record with a bad magic or version, since the stream
+ * cannot be resynchronized after that.
+ *
+ * @param f Input stream.
+ * @param name Stream name for diagnostics.
+ * @return false on allocation failure.
+ */
+static bool consume(FILE* f, const char* name) {
+        timing_trace_header_t hdr;
+        timing_trace_span_t spans[TIMING_MAX_SPANS];
+        char total[TIMING_NAME_SIZE] = "total";
+
+        while (read_exact(f, &hdr, sizeof(hdr))) {
+                if (hdr.magic != TIMING_TRACE_MAGIC ||
+                    hdr.version != TIMING_TRACE_VERSION ||
+                    hdr.span_count > TIMING_MAX_SPANS) {
+                        fprintf(stderr, "%s: bad record, stopping\n", name);
+                        ++bad_records;
+                        return true;
+                }
+                if (!read_exact(f, spans, hdr.span_count * sizeof(spans[0]))) {
+                        fprintf(stderr, "%s: truncated record\n", name);
+                        ++bad_records;
+                        return true;
+                }
+
+                hdr.endpoint[TIMING_NAME_SIZE - 1] = '\0';
+                if (endpoint_filter &&
+                    strcmp(hdr.endpoint, endpoint_filter) != 0)
+                        continue;
+
+                for (uint16_t i = 0; i < hdr.span_count; ++i) {
+                        if (!series_add(series_get(hdr.endpoint, spans[i].name),
+                                        spans[i].dur_us))
+                                return false;
+                }
+                if (!series_add(series_get(hdr.endpoint, total), hdr.total_us))
+                        return false;
+        }
+        return true;
+}
+
+/**
+ * @brief qsort comparator for uint32_t.
+ */
+static int cmp_u32(const void* a, const void* b) {
+        uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+        return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array.
+ * @param v Sorted values.
+ * @param n Number of values (> 0).
+ * @param pct Percentile in [0, 100].
+ * @return Value at the percentile.
+ */
+static uint32_t percentile(const uint32_t* v, size_t n, double pct) {
+        size_t rank = (size_t)(pct / 100.0 * (double)n + 0.999999);
+        if (rank == 0) rank = 1;
+        if (rank > n) rank = n;
+        return v[rank - 1];
+}
+
+/**
+ * @brief Print one series as a JSON line.
+ * @param s Series with at least one value.
+ */
+static void print_series(series_t* s) {
+        qsort(s->us, s->count, sizeof(*s->us), cmp_u32);
+
+        double sum = 0;
+        for (size_t i = 0; i < s->count; ++i) sum += s->us[i];
+
+        printf("{\"endpoint\":\"%s\",\"phase\":\"%s\",\"count\":%zu,"
+               "\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,"
+               "\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+               s->endpoint, s->phase, s->count, sum / s->count / 1000.0,
+               percentile(s->us, s->count, 50) / 1000.0,
+               percentile(s->us, s->count, 90) / 1000.0,
+               percentile(s->us, s->count, 99) / 1000.0,
+               s->us[s->count - 1] / 1000.0);
+}
+
+int main(int argc, char** argv) {
+        int opt;
+        while ((opt = getopt(argc, argv, "e:h")) != -1) {
+                switch (opt) {
+                        case 'e': endpoint_filter = optarg; break;
+                        default:
+                                fprintf(stderr,
+                                        "usage: %s [-e endpoint] "
+                                        "[trace_file ...]\n",
+                                        argv[0]);
+                                return opt == 'h' ? 0 : 2;
+                }
+        }
+
+        bool ok = true;
+        if (optind == argc) {
+                ok = consume(stdin, "<stdin>");
+        } else {
+                for (int i = optind; i < argc && ok; ++i) {
+                        FILE* f = fopen(argv[i], "rb");
+                        if (!f) {
+                                perror(argv[i]);
+                                return 1;
+                        }
+                        ok = consume(f, argv[i]);
+                        fclose(f);
+                }
+        }
+        if (!ok) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+        }
+
+        for (size_t i = 0; i < series_count; ++i) {
+                print_series(&series[i]);
+                free(series[i].us);
+        }
+        return bad_records ? 1 : 0;
+}
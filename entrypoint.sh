@@ -4,6 +4,30 @@ chmod +x /app/backend/sqlite_entrypoint.sh
 chmod +x /app/backend/doxygen_entrypoint.sh
 
 /app/backend/sqlite_entrypoint.sh
+
+# Load token generations into the JWT revocation segment before any request
+# can arrive: val_jwt() refuses every token until it is loaded (see
+# backend/maint/revoke.c). Runs as the CGI user, who must be able to map it;
+# without the segment no token could ever be accepted, so a failed load
+# stops the start.
+su -s /bin/sh nobody -c "/app/backend/maint/revoke -l" || exit 1
+
+# Merge the search index every minute and optimize it once a day at 04:00,
+# off the request path (see backend/maint/fts_maint.c). Runs as the CGI user
+# so a journal it leaves behind stays usable by the CGIs.
+su -s /bin/sh nobody -c "/app/backend/maint/fts_maint -w 60 -H 4" \
+    > /dev/null &
+
+# Re-render posts stored with HTML from an older Markdown renderer; only a
+# deploy changes the renderer, so once per start is enough (see
+# backend/maint/rerender.c).
+su -s /bin/sh nobody -c "/app/backend/maint/rerender" > /dev/null &
+
+# Serve /api/live: the Server-Sent Events feed of new posts, woken by the
+# post DAL over /tmp/sfe_live.sock; lighttpd proxies to it on port 8081 (see
+# backend/maint/livefeed.c).
+su -s /bin/sh nobody -c "/app/backend/maint/livefeed" > /dev/null &
+
 cd /app/backend/
 /app/backend/doxygen_entrypoint.sh
 mv html docs
@@ -4,7 +4,7 @@
 set -eu
 
 # List of test modules
-tests="test csrf register"
+tests="test csrf register revoke login metrics ratelimit search live markdown"
 
 for t in $tests; do
     script="tests/$t/main.sh"
@@ -0,0 +1,35 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# /api/live is served by maint/livefeed through lighttpd's proxy. A stream
+# never ends by itself, so curl is cut off with --max-time (exit code 28).
+
+# 1. Subscribe to a thread -> 200 event stream with the retry delay
+echo ">>> Test 1: GET /live?thread=1 streams events"
+headers=$(mktemp)
+body=$(curl -s -N --max-time 2 -D "$headers" "$BASE_URL/live?thread=1" || true)
+status=$(tr -d '\r' < "$headers" | sed -n '1s/^HTTP\/[0-9.]* \([0-9]*\).*/\1/p')
+if [ "$status" = "200" ] &&
+   tr -d '\r' < "$headers" | grep -qi '^Content-Type: text/event-stream' &&
+   printf '%s\n' "$body" | grep -qx 'retry: [0-9]*'; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+rm -f "$headers"
+echo
+
+# 2. No thread -> 400
+echo ">>> Test 2: GET /live without a thread"
+run_get "live" '{"status":400,"messages":["Invalid thread."]}' "400"
+
+# 3. Thread that is not a number -> 400
+echo ">>> Test 3: GET /live?thread=abc"
+run_get "live?thread=abc" '{"status":400,"messages":["Invalid thread."]}' "400"
+
+# 4. POST -> 405
+echo ">>> Test 4: POST /live?thread=1"
+run_post "live?thread=1" '{}' '["Method Not Allowed"]' "405"
@@ -0,0 +1,91 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+csrf_token=""
+
+make_payload() {
+    printf '{"csrf":"%s","username":"%s","password":"%s"}' "$1" "$2" "$3"
+}
+
+# The account may be left over from an earlier run.
+get_csrf_token
+echo ">>> Setup: register loginuser"
+curl -s -o /dev/null -X POST -H "Content-Type: application/json" \
+    -d "$(make_payload "$csrf_token" "loginuser" "secure123")" \
+    "$BASE_URL/register.cgi"
+
+# 1. Successful login -> 200 with a JWT
+get_csrf_token
+echo ">>> Test 1: Successful login"
+body=$(curl -s -X POST -H "Content-Type: application/json" \
+    -d "$(make_payload "$csrf_token" "loginuser" "secure123")" \
+    "$BASE_URL/login.cgi")
+token=$(printf '%s' "$body" | jq -r '.messages[0] // empty')
+if [ "$(printf '%s' "$body" | jq -r '.status')" = "200" ] &&
+   printf '%s' "$token" | grep -Eq '^[A-Za-z0-9_-]+\.[A-Za-z0-9_-]+\.[A-Za-z0-9_-]+$'; then
+    echo "[PASS]"
+else
+    echo "Gotten body: $body"
+    echo "[FAIL]"
+fi
+echo
+
+# 2. Usernames compare without case
+get_csrf_token
+echo ">>> Test 2: Login with a differently cased username"
+body=$(curl -s -X POST -H "Content-Type: application/json" \
+    -d "$(make_payload "$csrf_token" "LoginUser" "secure123")" \
+    "$BASE_URL/login.cgi")
+if [ "$(printf '%s' "$body" | jq -r '.status')" = "200" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten body: $body"
+    echo "[FAIL]"
+fi
+echo
+
+# 3. Wrong password
+get_csrf_token
+echo ">>> Test 3: Wrong password"
+run_post "login.cgi" "$(make_payload "$csrf_token" "loginuser" "wrong12")" \
+          '["Invalid username or password."]' "401"
+
+# 4. Unknown user gets the same answer
+get_csrf_token
+echo ">>> Test 4: Unknown user"
+run_post "login.cgi" "$(make_payload "$csrf_token" "nosuchuser" "wrong12")" \
+          '["Invalid username or password."]' "401"
+
+# 5. Invalid CSRF
+echo ">>> Test 5: Invalid CSRF"
+run_post "login.cgi" "$(make_payload "INVALIDTOKEN" "loginuser" "secure123")" \
+          '["Invalid CSRF token"]' "400"
+
+# 6. GET is not allowed
+echo ">>> Test 6: GET /login.cgi"
+run_get "login.cgi" '{"status":405,"messages":["Method Not Allowed"]}' "405"
+
+# 7. Repeated failures are throttled before Argon2 -> 429 with Retry-After
+echo ">>> Test 7: Repeated failed logins until throttled"
+headers=$(mktemp)
+status=""
+i=0
+while [ "$i" -lt 15 ]; do
+    get_csrf_token > /dev/null
+    status=$(curl -s -D "$headers" -o /dev/null -w "%{http_code}" -X POST \
+        -H "Content-Type: application/json" \
+        -d "$(make_payload "$csrf_token" "loginuser" "wrong12")" \
+        "$BASE_URL/login.cgi")
+    [ "$status" = "429" ] && break
+    i=$((i + 1))
+done
+if [ "$status" = "429" ] && grep -qi '^Retry-After: [1-9]' "$headers"; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+rm -f "$headers"
+echo
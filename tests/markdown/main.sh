@@ -0,0 +1,66 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# No endpoint writes posts yet, so posts are inserted with the sqlite3 shell
+# inside the server, left unrendered (render_version 0), and rendered by
+# maint/rerender. SFE_EXEC runs a command there, as the CGI user; the default
+# matches start_server.sh.
+SFE_EXEC="${SFE_EXEC:-docker exec -i -u nobody sfe}"
+DB="/data/sfe.db"
+
+sql() {
+    printf '%s\n' "$1" | $SFE_EXEC sqlite3 -cmd ".timeout 5000" "$DB"
+}
+
+thread_id=$(sql "INSERT INTO threads (user_id, title)
+    VALUES (1, 'markdown test') RETURNING id;")
+
+# Insert an unrendered post with the given body and print its id.
+insert_post() {
+    sql "$(printf "INSERT INTO posts (thread_id, user_id, body)
+        VALUES (%s, 1, '%s') RETURNING id;" "$thread_id" "$1")"
+}
+
+offsite_backslash=$(insert_post '[a](/\evil.com)')
+offsite_slashes=$(insert_post '[b](//evil.com)')
+site_path=$(insert_post '[c](/threads/1)')
+
+$SFE_EXEC /app/backend/maint/rerender > /dev/null
+
+# check_link <test name> <post id> <expected href, empty for no link>
+check_link() {
+    printf '>>> %s\n' "$1"
+    html=$(sql "SELECT body_html FROM posts WHERE id = $2;")
+    if [ -n "$3" ]; then
+        case "$html" in
+            *"<a href=\"$3\""*) ok=true ;;
+            *) ok=false ;;
+        esac
+    else
+        case "$html" in
+            *"<a "*) ok=false ;;
+            *) ok=true ;;
+        esac
+    fi
+    if [ "$ok" = "true" ]; then
+        echo "[PASS]"
+    else
+        printf 'Gotten HTML: %s\n' "$html"
+        echo "[FAIL]"
+    fi
+    echo
+}
+
+# 1. Browsers read "/\host" as "//host": not a site path
+check_link "Test 1: [a](/\\evil.com) is not linked" "$offsite_backslash" ""
+
+# 2. Protocol-relative URLs are not site paths either
+check_link "Test 2: [b](//evil.com) is not linked" "$offsite_slashes" ""
+
+# 3. A plain site path is linked
+check_link "Test 3: [c](/threads/1) is linked" "$site_path" "/threads/1"
+
+sql "DELETE FROM posts WHERE thread_id = $thread_id;
+    DELETE FROM threads WHERE id = $thread_id;" > /dev/null
@@ -0,0 +1,27 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# 1. Generate some traffic so the counters are non-empty
+echo ">>> Warm-up: GET /csrf.cgi"
+curl -s -o /dev/null "$BASE_URL/csrf.cgi"
+
+# 2. GET metrics.cgi -> Prometheus text with the csrf request counted
+echo ">>> Test 1: GET /metrics.cgi"
+resp=$(curl -s -w "\n[STATUS]%{http_code}" "$BASE_URL/metrics.cgi")
+body=$(printf '%s' "$resp" | sed '$d')
+status=$(printf '%s' "$resp" | tail -n1 | sed 's/^\[STATUS]//')
+if [ "$status" = "200" ] &&
+   printf '%s\n' "$body" | grep -q '^sfe_requests_total{endpoint="csrf",code="200"} [1-9]' &&
+   printf '%s\n' "$body" | grep -q '^# TYPE sfe_request_duration_seconds histogram'; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+echo
+
+# 3. POST metrics.cgi -> 405
+echo ">>> Test 2: POST /metrics.cgi"
+run_post "metrics.cgi" '{}' '["Method Not Allowed"]' "405"
@@ -0,0 +1,44 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# register.cgi allows a burst of 10 requests per client address; the limit
+# is checked before the body is read, so cheap malformed requests count.
+
+# 1. Drain the bucket -> 429 with Retry-After
+echo ">>> Test 1: POST /register.cgi until rate limited"
+headers=$(mktemp)
+status=""
+body=""
+i=0
+while [ "$i" -lt 15 ]; do
+    resp=$(curl -s -D "$headers" -X POST \
+        -H "Content-Type: application/json" -d '{}' \
+        -w "\n[STATUS]%{http_code}" "$BASE_URL/register.cgi")
+    body=$(printf '%s' "$resp" | sed '$d')
+    status=$(printf '%s' "$resp" | tail -n1 | sed 's/^\[STATUS]//')
+    [ "$status" = "429" ] && break
+    i=$((i + 1))
+done
+if [ "$status" = "429" ] &&
+   grep -qi '^Retry-After: [1-9]' "$headers" &&
+   [ "$(printf '%s' "$body" | jq -c '.messages')" = '["Too many requests."]' ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+rm -f "$headers"
+echo
+
+# 2. Other endpoints are not affected
+echo ">>> Test 2: GET /csrf.cgi while register is limited"
+status=$(curl -s -o /dev/null -w "%{http_code}" "$BASE_URL/csrf.cgi")
+if [ "$status" = "200" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+echo
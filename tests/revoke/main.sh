@@ -0,0 +1,95 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# No endpoint consumes tokens yet, so tokens from login.cgi are checked with
+# maint/jwt_check and revoked with maint/revoke inside the server. SFE_EXEC
+# runs a command there, as the CGI user; the default matches start_server.sh.
+SFE_EXEC="${SFE_EXEC:-docker exec -i -u nobody sfe}"
+
+csrf_token=""
+
+make_payload() {
+    printf '{"csrf":"%s","username":"%s","password":"%s"}' "$1" "$2" "$3"
+}
+
+# Log in as revokeuser and print the token.
+login_token() {
+    get_csrf_token > /dev/null
+    curl -s -X POST -H "Content-Type: application/json" \
+        -d "$(make_payload "$csrf_token" "revokeuser" "secure123")" \
+        "$BASE_URL/login.cgi" | jq -r '.messages[0] // empty'
+}
+
+# Print the status jwt_check gives a token (200 valid, 401 rejected, 503 if
+# the revocation list was never loaded).
+check_status() {
+    printf '%s\n' "$1" | $SFE_EXEC /app/backend/maint/jwt_check |
+        jq -r '.status' 2>/dev/null || true
+}
+
+# The account may be left over from an earlier run.
+get_csrf_token
+echo ">>> Setup: register revokeuser and log in"
+curl -s -o /dev/null -X POST -H "Content-Type: application/json" \
+    -d "$(make_payload "$csrf_token" "revokeuser" "secure123")" \
+    "$BASE_URL/register.cgi"
+old_token=$(login_token)
+
+# 1. A fresh token is accepted (also fails if the list was never loaded)
+echo ">>> Test 1: Token from login.cgi passes val_jwt"
+status=$(check_status "$old_token")
+if [ "$status" = "200" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+echo
+
+# 2. Revoking the user rejects the token
+echo ">>> Test 2: Token is rejected after maint/revoke -u"
+user_id=$(printf '%s\n' "$old_token" |
+    $SFE_EXEC /app/backend/maint/jwt_check | jq -r '.claims.id // empty')
+revoked=$($SFE_EXEC /app/backend/maint/revoke -u "$user_id" | jq -r '.ok')
+status=$(check_status "$old_token")
+if [ "$revoked" = "true" ] && [ "$status" = "401" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten revoke ok: $revoked, status: $status"
+    echo "[FAIL]"
+fi
+echo
+
+# 3. A token from a new login passes again
+echo ">>> Test 3: Token from a new login passes"
+new_token=$(login_token)
+status=$(check_status "$new_token")
+if [ -n "$new_token" ] && [ "$status" = "200" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+echo
+
+# 4. An id the segment cannot hold is refused before anything is written,
+# rather than reported as revoked (REVOKE_MAX_USERS is 1 << 24)
+echo ">>> Test 4: maint/revoke -u fails for an id beyond the segment"
+if out=$($SFE_EXEC /app/backend/maint/revoke -u 16777216 2>&1); then
+    rc=0
+else
+    rc=$?
+fi
+case "$out" in
+    *ERR_JWT_REVOKE_FAIL*) refused=true ;;
+    *) refused=false ;;
+esac
+if [ "$rc" -ne 0 ] && [ "$refused" = "true" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten exit: $rc, output: $out"
+    echo "[FAIL]"
+fi
+echo
@@ -0,0 +1,113 @@
+#!/bin/sh
+set -eu
+
+. ./test_manager_misc.sh
+
+# search.cgi is a GET endpoint; error replies carry a "messages" array.
+check_search() {
+    url="$1"
+    expected_messages="$2"
+    expected_status="$3"
+
+    echo ">>> GET $BASE_URL/$url"
+    resp=$(curl -s -w "\n[STATUS]%{http_code}" "$BASE_URL/$url")
+    body=$(printf '%s' "$resp" | sed '$d')
+    status=$(printf '%s' "$resp" | tail -n1 | sed 's/^\[STATUS]//')
+    messages=$(printf '%s' "$body" | jq -c '.messages' 2>/dev/null || echo "(no messages)")
+
+    echo "Expected messages: $expected_messages"
+    echo "Gotten messages:   $messages"
+    echo "Expected status:   $expected_status"
+    echo "Gotten status:     $status"
+
+    if [ "$messages" = "$expected_messages" ] && [ "$status" = "$expected_status" ]; then
+        echo "[PASS]"
+    else
+        echo "[FAIL]"
+    fi
+    echo
+}
+
+# 1. No q parameter
+echo ">>> Test 1: GET /search.cgi without q"
+check_search "search.cgi" '["Missing query parameter."]' "400"
+
+# 2. Only punctuation -> nothing to search for
+echo ">>> Test 2: GET /search.cgi with no searchable terms"
+check_search "search.cgi?q=%22*%28%29" \
+             '["Search query has no searchable terms."]' "400"
+
+# 3. Out of range paging
+echo ">>> Test 3: GET /search.cgi with limit=0"
+check_search "search.cgi?q=hello&limit=0" '["Invalid offset or limit."]' "400"
+
+echo ">>> Test 4: GET /search.cgi with offset past the maximum"
+check_search "search.cgi?q=hello&offset=100000" \
+             '["Invalid offset or limit."]' "400"
+
+# 5. FTS5 syntax is searched as plain text, never parsed
+echo ">>> Test 5: GET /search.cgi with FTS5 operators in q"
+resp=$(curl -s -w "\n[STATUS]%{http_code}" \
+    "$BASE_URL/search.cgi?q=zzqx+OR+NEAR%28a+b%29+body%3Ax")
+body=$(printf '%s' "$resp" | sed '$d')
+status=$(printf '%s' "$resp" | tail -n1 | sed 's/^\[STATUS]//')
+if [ "$status" = "200" ] &&
+   [ "$(printf '%s' "$body" | jq -c '.messages[0].results')" = '[]' ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "Gotten body:   $body"
+    echo "[FAIL]"
+fi
+echo
+
+# 6. Wrong method
+echo ">>> Test 6: POST /search.cgi"
+status=$(curl -s -o /dev/null -w "%{http_code}" -X POST "$BASE_URL/search.cgi")
+if [ "$status" = "405" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten status: $status"
+    echo "[FAIL]"
+fi
+echo
+
+# 7. Repeated searches are served from the cache, whatever the parameter
+# order; a fresh term keeps earlier runs from pre-filling the entry.
+echo ">>> Test 7: repeated GET /search.cgi is a cache hit"
+term="cachetest$$x$(date +%s)"
+cache_header() {
+    curl -s -D - -o /dev/null "$BASE_URL/search.cgi?$1" |
+        tr -d '\r' | sed -n 's/^X-Cache: //p'
+}
+first=$(cache_header "q=$term")
+second=$(cache_header "q=$term")
+reordered=$(cache_header "limit=20&q=$term&offset=0")
+if [ "$first" = "MISS" ] && [ "$second" = "HIT" ] &&
+   [ "$reordered" = "HIT" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten X-Cache: $first, $second, $reordered"
+    echo "[FAIL]"
+fi
+echo
+
+echo ">>> Test 8: GET /search.cgi with a current If-None-Match -> 304"
+etag=$(curl -s -D - -o /dev/null "$BASE_URL/search.cgi?q=$term" |
+    tr -d '\r' | sed -n 's/^ETag: //p')
+headers=$(mktemp)
+body=$(curl -s -D "$headers" -H "If-None-Match: $etag" \
+    "$BASE_URL/search.cgi?q=$term")
+status=$(tr -d '\r' < "$headers" | sed -n '1s/^HTTP\/[0-9.]* \([0-9]*\).*/\1/p')
+stale=$(curl -s -o /dev/null -w "%{http_code}" \
+    -H 'If-None-Match: "0000000000000000"' "$BASE_URL/search.cgi?q=$term")
+if [ -n "$etag" ] && [ "$status" = "304" ] && [ -z "$body" ] &&
+   tr -d '\r' < "$headers" | grep -qx "ETag: $etag" &&
+   [ "$stale" = "200" ]; then
+    echo "[PASS]"
+else
+    echo "Gotten ETag: $etag, status: $status, stale tag: $stale"
+    echo "[FAIL]"
+fi
+rm -f "$headers"
+echo